@@ -2,13 +2,39 @@
 #include "HttpModule.h"
 #include "Interfaces/IHttpRequest.h"
 #include "Interfaces/IHttpResponse.h"
-#include "Engine/Engine.h"
-#include "TimerManager.h"
+#include "Containers/Ticker.h"
+#include "KidTrace.h"
+#include "KidCoreAdapter.h"
+#include "KidCoreRetry.h"
 
 namespace
 {
-    constexpr int32 MaxRetries = 3;
-    constexpr float DefaultRetryDelay = 5.0f;
+    // which responses are retried and when is decided by the engine-agnostic core
+    constexpr KidCore::FRetryPolicy RetryPolicy{};
+    constexpr int32 MaxRetries = RetryPolicy.MaxRetries;
+
+    // Ends the request's trace span when the callback is invoked, so the span covers retries too
+    TFunction<void(FHttpResponsePtr, bool)> TraceRequest(const TCHAR* Verb, const FString& Url, 
+            TFunction<void(FHttpResponsePtr, bool)> Callback)
+    {
+        FString SpanName = FKidTrace::BeginRequest(Verb, Url);
+        if (SpanName.IsEmpty())
+        {
+            return Callback;
+        }
+
+        return [SpanName = MoveTemp(SpanName), Callback = MoveTemp(Callback)](FHttpResponsePtr Response, bool bWasSuccessful)
+        {
+            FKidTrace::EndRequest(SpanName, Response.IsValid() ? Response->GetResponseCode() : 0);
+            Callback(Response, bWasSuccessful);
+        };
+    }
+}
+
+FOnKidEndpointResponse& HttpRequestHelper::OnEndpointResponse()
+{
+    static FOnKidEndpointResponse EndpointResponse;
+    return EndpointResponse;
 }
 
 void HttpRequestHelper::ScheduleRetry(TSharedRef<IHttpRequest, ESPMode::ThreadSafe> Request, TFunction<void(TSharedPtr<IHttpResponse, ESPMode::ThreadSafe>, bool)> Callback, int RetryCount, float RetryDelay)
@@ -20,70 +46,67 @@ void HttpRequestHelper::ScheduleRetry(TSharedRef<IHttpRequest, ESPMode::ThreadSa
         return;
     }
 
-    UWorld* World = GEngine->GameViewport->GetWorld();
-    if (World)
+    // the core ticker runs without a game viewport, e.g. in commandlets and on dedicated servers
+    FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda([Request, Callback, RetryCount](float DeltaTime)
     {
-        FTimerDelegate TimerDelegate;
-        TimerDelegate.BindLambda([Request, Callback, RetryCount]()
-        {
-            RetryRequest(Request, Callback, RetryCount - 1); // Use default delay
-        });
-
-        FTimerHandle TimerHandle;
-        World->GetTimerManager().SetTimer(TimerHandle, TimerDelegate, RetryDelay, false);
-    }
-    else
-    {
-        UE_LOG(LogTemp, Error, TEXT("World context is null"));
-        Callback(nullptr, false);
-    }
+        RetryRequest(Request, Callback, RetryCount - 1);
+        return false;
+    }), RetryDelay);
 }
 
 void HttpRequestHelper::RetryRequest(TSharedRef<IHttpRequest, ESPMode::ThreadSafe> Request, TFunction<void(TSharedPtr<IHttpResponse, ESPMode::ThreadSafe>, bool)> Callback, int RetryCount)
 {
     Request->OnProcessRequestComplete().BindLambda([Callback, Request, RetryCount](FHttpRequestPtr RequestPtr, FHttpResponsePtr Response, bool bWasSuccessful) mutable
     {
-        if (bWasSuccessful && Response.IsValid())
+        KID_TRACE_SCOPE(HttpRequestHelper_OnRequestComplete);
+        if (!RequestPtr.IsValid() || RequestPtr->GetFailureReason() != EHttpFailureReason::Cancelled)
+        {
+            const bool bEndpointHealthy = bWasSuccessful && Response.IsValid() && Response->GetResponseCode() < 500;
+            OnEndpointResponse().Broadcast(Request->GetURL(), bEndpointHealthy);
+        }
+
+        const bool bHasResponse = bWasSuccessful && Response.IsValid();
+        const KidCore::FRetryDecision Decision = RetryPolicy.Decide(bHasResponse, bHasResponse ? Response->GetResponseCode() : 0,
+                    bHasResponse ? KidToUtf8(Response->GetHeader(TEXT("Retry-After"))) : std::string(), RetryCount);
+        switch (Decision.Action)
         {
-            if (Response->GetResponseCode() == 200 || Response->GetResponseCode() == 304)
+        case KidCore::ERetryAction::Succeed:
+            UE_LOG(LogTemp, Log, TEXT("Call succeeded: %s"), *Response->GetContentAsString());
+            Callback(Response, true);
+            break;
+
+        case KidCore::ERetryAction::Retry:
+            UE_LOG(LogTemp, Warning, TEXT("Received 429 Too Many Requests, retrying in %f seconds..."), Decision.DelaySeconds);
+            ScheduleRetry(Request, Callback, RetryCount, Decision.DelaySeconds);
+            break;
+
+        case KidCore::ERetryAction::Fail:
+            if (!bHasResponse)
             {
-                UE_LOG(LogTemp, Log, TEXT("Call succeeded: %s"), *Response->GetContentAsString());
-                Callback(Response, true);
+                UE_LOG(LogTemp, Error, TEXT("Call failed: response is invalid"));
+                Callback(Response, false);
             }
             else if (Response->GetResponseCode() == 429)
             {
-                FString RetryAfterHeader = Response->GetHeader("Retry-After");
-                float RetryDelay = DefaultRetryDelay;
-
-                if (!RetryAfterHeader.IsEmpty())
-                {
-                    RetryDelay = FCString::Atof(*RetryAfterHeader);
-                    if (RetryDelay <= 0) {
-                        RetryDelay = DefaultRetryDelay;
-                    }
-                }
-
-                UE_LOG(LogTemp, Warning, TEXT("Received 429 Too Many Requests, retrying in %f seconds..."), RetryDelay);
-                ScheduleRetry(Request, Callback, RetryCount, RetryDelay);
+                UE_LOG(LogTemp, Error, TEXT("Maximum retries reached"));
+                Callback(nullptr, false);
             }
             else
             {
                 UE_LOG(LogTemp, Error, TEXT("Call failed: %s"), *Response->GetContentAsString());
                 Callback(Response, false);
             }
-        }
-        else
-        {
-            UE_LOG(LogTemp, Error, TEXT("Call failed: response is invalid"));
-            Callback(Response, false);
+            break;
         }
     });
 
+    KID_TRACE_SCOPE(HttpRequestHelper_ProcessRequest);
     Request->ProcessRequest();
 }
 
-void HttpRequestHelper::GetRequest(const FString& Url, TFunction<void(TSharedPtr<IHttpResponse, ESPMode::ThreadSafe>, bool)> Callback)
+FHttpRequestPtr HttpRequestHelper::GetRequest(const FString& Url, TFunction<void(TSharedPtr<IHttpResponse, ESPMode::ThreadSafe>, bool)> Callback)
 {
+    Callback = TraceRequest(TEXT("GET"), Url, MoveTemp(Callback));
     UE_LOG(LogTemp, Log, TEXT("Call to %s"), *Url);
     TSharedRef<IHttpRequest, ESPMode::ThreadSafe> Request = FHttpModule::Get().CreateRequest();
     Request->SetURL(Url);
@@ -92,14 +115,17 @@ void HttpRequestHelper::GetRequest(const FString& Url, TFunction<void(TSharedPtr
     Request->SetHeader("accept", "application/json");
 
     RetryRequest(Request, Callback, MaxRetries);
+    return Request;
 }
 
-void HttpRequestHelper::GetRequestWithAuth(const FString& Url, const FString& AuthToken, TFunction<void(TSharedPtr<IHttpResponse, ESPMode::ThreadSafe>, bool)> Callback)
+FHttpRequestPtr HttpRequestHelper::GetRequestWithAuth(const FString& Url, const FString& AuthToken, TFunction<void(TSharedPtr<IHttpResponse, ESPMode::ThreadSafe>, bool)> Callback, float TimeoutSeconds)
 {
+    Callback = TraceRequest(TEXT("GET"), Url, MoveTemp(Callback));
     if (AuthToken.IsEmpty())
     {
         UE_LOG(LogTemp, Error, TEXT("AuthToken is empty!"));
-        return;
+        Callback(nullptr, false);
+        return nullptr;
     }
     UE_LOG(LogTemp, Log, TEXT("Call to %s"), *Url);
     TSharedRef<IHttpRequest, ESPMode::ThreadSafe> Request = FHttpModule::Get().CreateRequest();
@@ -108,25 +134,110 @@ void HttpRequestHelper::GetRequestWithAuth(const FString& Url, const FString& Au
     Request->SetHeader("Authorization", "Bearer " + AuthToken);
     Request->SetHeader("Content-Type", "application/json");
     Request->SetHeader("accept", "application/json");
+    if (TimeoutSeconds > 0.0f)
+    {
+        Request->SetTimeout(TimeoutSeconds);
+    }
 
     RetryRequest(Request, Callback, MaxRetries);
+    return Request;
 }
 
-void HttpRequestHelper::PostRequestWithAuth(const FString& Url, const FString& ContentJsonString, const FString& AuthToken, TFunction<void(TSharedPtr<IHttpResponse, ESPMode::ThreadSafe>, bool)> Callback)
+FHttpRequestPtr HttpRequestHelper::PostRequestWithAuth(const FString& Url, const FString& ContentJsonString, const FString& AuthToken, TFunction<void(TSharedPtr<IHttpResponse, ESPMode::ThreadSafe>, bool)> Callback)
 {
+    Callback = TraceRequest(TEXT("POST"), Url, MoveTemp(Callback));
     if (AuthToken.IsEmpty())
     {
         UE_LOG(LogTemp, Error, TEXT("AuthToken is empty!"));
-        return;
+        Callback(nullptr, false);
+        return nullptr;
     }
     UE_LOG(LogTemp, Log, TEXT("Call to %s with body %s"), *Url, *ContentJsonString);
+    TSharedRef<IHttpRequest, ESPMode::ThreadSafe> Request = CreatePostRequest(Url, AuthToken);
+    Request->SetContentAsString(ContentJsonString);
+
+    RetryRequest(Request, Callback, MaxRetries);
+    return Request;
+}
+
+FHttpRequestPtr HttpRequestHelper::PostRequestWithAuth(const FString& Url, TConstArrayView<uint8> Content, const FString& AuthToken, TFunction<void(TSharedPtr<IHttpResponse, ESPMode::ThreadSafe>, bool)> Callback)
+{
+    Callback = TraceRequest(TEXT("POST"), Url, MoveTemp(Callback));
+    if (AuthToken.IsEmpty())
+    {
+        UE_LOG(LogTemp, Error, TEXT("AuthToken is empty!"));
+        Callback(nullptr, false);
+        return nullptr;
+    }
+    if (UE_LOG_ACTIVE(LogTemp, Log))
+    {
+        FUTF8ToTCHAR Body(reinterpret_cast<const UTF8CHAR*>(Content.GetData()), Content.Num());
+        UE_LOG(LogTemp, Log, TEXT("Call to %s with body %.*s"), *Url, Body.Length(), Body.Get());
+    }
+    TSharedRef<IHttpRequest, ESPMode::ThreadSafe> Request = CreatePostRequest(Url, AuthToken);
+    Request->SetContent(TArray<uint8>(Content));
+
+    RetryRequest(Request, Callback, MaxRetries);
+    return Request;
+}
+
+TSharedRef<IHttpRequest, ESPMode::ThreadSafe> HttpRequestHelper::CreatePostRequest(const FString& Url, const FString& AuthToken)
+{
     TSharedRef<IHttpRequest, ESPMode::ThreadSafe> Request = FHttpModule::Get().CreateRequest();
     Request->SetURL(Url);
     Request->SetVerb("POST");
     Request->SetHeader("Authorization", "Bearer " + AuthToken);
     Request->SetHeader("Content-Type", "application/json");
     Request->SetHeader("accept", "application/json");
-    Request->SetContentAsString(ContentJsonString);
+    return Request;
+}
 
-    RetryRequest(Request, Callback, MaxRetries);
+TFuture<FKidHttpResult> HttpRequestHelper::GetRequestWithAuthAsync(const FString& Url, const FString& AuthToken, const FKidFlowPtr& Flow)
+{
+    TSharedRef<TKidPromise<FKidHttpResult>> Promise = MakeShared<TKidPromise<FKidHttpResult>>();
+    TFuture<FKidHttpResult> Future = Promise->GetFuture();
+
+    FHttpRequestPtr Request = GetRequestWithAuth(Url, AuthToken, [Promise](FHttpResponsePtr Response, bool bWasSuccessful)
+    {
+        Promise->SetValue(FKidHttpResult{ Response, bWasSuccessful });
+    });
+
+    if (Flow.IsValid() && Request.IsValid())
+    {
+        Flow->TrackRequest(Request);
+    }
+    return Future;
+}
+
+TFuture<FKidHttpResult> HttpRequestHelper::PostRequestWithAuthAsync(const FString& Url, const FString& ContentJsonString, const FString& AuthToken, const FKidFlowPtr& Flow)
+{
+    return TrackAsync([&](TFunction<void(FHttpResponsePtr, bool)> Callback)
+    {
+        return PostRequestWithAuth(Url, ContentJsonString, AuthToken, MoveTemp(Callback));
+    }, Flow);
+}
+
+TFuture<FKidHttpResult> HttpRequestHelper::PostRequestWithAuthAsync(const FString& Url, TConstArrayView<uint8> Content, const FString& AuthToken, const FKidFlowPtr& Flow)
+{
+    return TrackAsync([&](TFunction<void(FHttpResponsePtr, bool)> Callback)
+    {
+        return PostRequestWithAuth(Url, Content, AuthToken, MoveTemp(Callback));
+    }, Flow);
+}
+
+TFuture<FKidHttpResult> HttpRequestHelper::TrackAsync(TFunctionRef<FHttpRequestPtr(TFunction<void(FHttpResponsePtr, bool)>)> Issue, const FKidFlowPtr& Flow)
+{
+    TSharedRef<TKidPromise<FKidHttpResult>> Promise = MakeShared<TKidPromise<FKidHttpResult>>();
+    TFuture<FKidHttpResult> Future = Promise->GetFuture();
+
+    FHttpRequestPtr Request = Issue([Promise](FHttpResponsePtr Response, bool bWasSuccessful)
+    {
+        Promise->SetValue(FKidHttpResult{ Response, bWasSuccessful });
+    });
+
+    if (Flow.IsValid() && Request.IsValid())
+    {
+        Flow->TrackRequest(Request);
+    }
+    return Future;
 }
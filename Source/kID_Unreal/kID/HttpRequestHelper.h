@@ -2,18 +2,52 @@
 
 #include "CoreMinimal.h"
 #include "Http.h"
+#include "KidFlow.h"
+
+struct FKidHttpResult
+{
+    FHttpResponsePtr Response;
+    bool bWasSuccessful = false;
+
+    // the server answered 200 or 304; any other status is reported as a failure
+    bool IsOk() const { return bWasSuccessful && Response.IsValid(); }
+};
+
+// Reported for every attempt that reaches an end other than being cancelled.  The endpoint is
+// unhealthy when it could not be reached, timed out or answered with a server error.
+DECLARE_MULTICAST_DELEGATE_TwoParams(FOnKidEndpointResponse, const FString& /*Url*/, bool /*bEndpointHealthy*/);
 
 class HttpRequestHelper 
 {
 public:
-    static void GetRequest(const FString& Url, 
-        TFunction<void(TSharedPtr<IHttpResponse, ESPMode::ThreadSafe>, bool)> Callback);
-    static void GetRequestWithAuth(const FString& Url, const FString& AuthToken, 
+    static FOnKidEndpointResponse& OnEndpointResponse();
+
+    // The callback is always invoked exactly once.  The returned request is null if it could not be issued.
+    static FHttpRequestPtr GetRequest(const FString& Url, 
         TFunction<void(TSharedPtr<IHttpResponse, ESPMode::ThreadSafe>, bool)> Callback);
-    static void PostRequestWithAuth(const FString& Url, const FString& ContentJsonString, 
+    // A TimeoutSeconds above zero overrides the default HTTP timeout, for long polls.
+    static FHttpRequestPtr GetRequestWithAuth(const FString& Url, const FString& AuthToken, 
+        TFunction<void(TSharedPtr<IHttpResponse, ESPMode::ThreadSafe>, bool)> Callback, float TimeoutSeconds = 0.0f);
+    static FHttpRequestPtr PostRequestWithAuth(const FString& Url, const FString& ContentJsonString, 
+        const FString& AuthToken, TFunction<void(TSharedPtr<IHttpResponse, ESPMode::ThreadSafe>, bool)> Callback);
+    // Takes a UTF-8 body, e.g. from KidSerializeRequest, which is copied into the request once.
+    static FHttpRequestPtr PostRequestWithAuth(const FString& Url, TConstArrayView<uint8> Content, 
         const FString& AuthToken, TFunction<void(TSharedPtr<IHttpResponse, ESPMode::ThreadSafe>, bool)> Callback);
 
+    // Future based variants used by kID flows.  The request is tracked by the flow, if given, so 
+    // that cancelling the flow cancels the request.
+    static TFuture<FKidHttpResult> GetRequestWithAuthAsync(const FString& Url, const FString& AuthToken, 
+        const FKidFlowPtr& Flow = nullptr);
+    static TFuture<FKidHttpResult> PostRequestWithAuthAsync(const FString& Url, const FString& ContentJsonString, 
+        const FString& AuthToken, const FKidFlowPtr& Flow = nullptr);
+    static TFuture<FKidHttpResult> PostRequestWithAuthAsync(const FString& Url, TConstArrayView<uint8> Content, 
+        const FString& AuthToken, const FKidFlowPtr& Flow = nullptr);
+
 private:
+    static TSharedRef<IHttpRequest, ESPMode::ThreadSafe> CreatePostRequest(const FString& Url, const FString& AuthToken);
+    static TFuture<FKidHttpResult> TrackAsync(TFunctionRef<FHttpRequestPtr(TFunction<void(FHttpResponsePtr, bool)>)> Issue,
+        const FKidFlowPtr& Flow);
+
     static void ScheduleRetry(TSharedRef<IHttpRequest, ESPMode::ThreadSafe> Request, 
             TFunction<void(TSharedPtr<IHttpResponse, ESPMode::ThreadSafe>, bool)> Callback, 
             int RetryCount, float RetryDelay);
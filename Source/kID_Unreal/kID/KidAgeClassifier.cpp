@@ -0,0 +1,165 @@
+#include "KidAgeClassifier.h"
+#include "KidRequirementsCache.h"
+#include "Math/VectorRegister.h"
+
+namespace
+{
+    // players classified per pass, sized so the scratch arrays stay on the stack
+    constexpr int32 ChunkSize = 256;
+
+    int32 MakeMonthDay(int32 Month, int32 Day)
+    {
+        return Month * 100 + Day;
+    }
+}
+
+FKidDate FKidDate::Today()
+{
+    const FDateTime Now = FDateTime::UtcNow();
+    FKidDate Date;
+    Date.Year = Now.GetYear();
+    Date.Month = Now.GetMonth();
+    Date.Day = Now.GetDay();
+    return Date;
+}
+
+const TCHAR* LexToString(EKidAgeBand Band)
+{
+    switch (Band)
+    {
+    case EKidAgeBand::Invalid:                return TEXT("Invalid");
+    case EKidAgeBand::BelowMinimumAge:        return TEXT("BelowMinimumAge");
+    case EKidAgeBand::BelowDigitalConsentAge: return TEXT("BelowDigitalConsentAge");
+    case EKidAgeBand::BelowCivilAge:          return TEXT("BelowCivilAge");
+    case EKidAgeBand::Adult:                  return TEXT("Adult");
+    }
+    return TEXT("Unknown");
+}
+
+bool FKidAgeClassifier::ParseDate(FStringView Text, FKidDate& OutDate)
+{
+    return KidCore::ParseDate(Text.GetData(), static_cast<size_t>(Text.Len()), OutDate);
+}
+
+int32 FKidAgeClassifier::CalculateAge(const FKidDate& DateOfBirth, const FKidDate& Today)
+{
+    return KidCore::CalculateAge(DateOfBirth, Today);
+}
+
+FString FKidAgeClassifier::MakeKey(const FString& Jurisdiction)
+{
+    return Jurisdiction.TrimStartAndEnd().ToUpper();
+}
+
+int32 FKidAgeClassifier::SetJurisdiction(const FString& Jurisdiction, const FKidAgeGateRequirements& Requirements)
+{
+    const FString Key = MakeKey(Jurisdiction);
+    int32 Index = INDEX_NONE;
+    if (const int32* Existing = JurisdictionIndices.Find(Key))
+    {
+        Index = *Existing;
+    }
+    else
+    {
+        Index = MinimumAges.AddDefaulted();
+        DigitalConsentAges.AddDefaulted();
+        CivilAges.AddDefaulted();
+        JurisdictionIndices.Add(Key, Index);
+    }
+
+    const KidCore::FAgeThresholds Thresholds = KidCore::FAgeThresholds{ Requirements.MinimumAge, 
+                Requirements.DigitalConsentAge, Requirements.CivilAge }.Normalized();
+    MinimumAges[Index] = Thresholds.MinimumAge;
+    DigitalConsentAges[Index] = Thresholds.DigitalConsentAge;
+    CivilAges[Index] = Thresholds.CivilAge;
+    return Index;
+}
+
+void FKidAgeClassifier::AddJurisdictions(const FKidRequirementsCache& Cache)
+{
+    Cache.ForEachCached([this](const FString& Jurisdiction, const FKidAgeGateRequirements& Requirements)
+    {
+        SetJurisdiction(Jurisdiction, Requirements);
+    });
+}
+
+int32 FKidAgeClassifier::FindJurisdiction(const FString& Jurisdiction) const
+{
+    const int32* Index = JurisdictionIndices.Find(MakeKey(Jurisdiction));
+    return Index ? *Index : INDEX_NONE;
+}
+
+void FKidAgeClassifier::Classify(TConstArrayView<FStringView> DatesOfBirth, TConstArrayView<int32> Jurisdictions, 
+        const FKidDate& Today, TArrayView<EKidAgeBand> OutBands) const
+{
+    check(DatesOfBirth.Num() == Jurisdictions.Num() && DatesOfBirth.Num() == OutBands.Num());
+
+    // structure of arrays, so four players load into one register per field
+    alignas(16) int32 Years[ChunkSize];
+    alignas(16) int32 MonthDays[ChunkSize];
+    alignas(16) int32 ValidMasks[ChunkSize];
+    alignas(16) int32 Minimums[ChunkSize];
+    alignas(16) int32 DigitalConsents[ChunkSize];
+    alignas(16) int32 Civils[ChunkSize];
+    alignas(16) int32 Bands[ChunkSize];
+
+    const VectorRegister4Int TodayYear = VectorIntSet1(Today.Year);
+    const VectorRegister4Int TodayMonthDay = VectorIntSet1(MakeMonthDay(Today.Month, Today.Day));
+    const VectorRegister4Int One = VectorIntSet1(1);
+
+    for (int32 ChunkStart = 0; ChunkStart < DatesOfBirth.Num(); ChunkStart += ChunkSize)
+    {
+        const int32 Count = FMath::Min(ChunkSize, DatesOfBirth.Num() - ChunkStart);
+
+        // parse and gather the thresholds; invalid players and the padding up to a multiple of
+        // four get a zero mask, which turns their band into Invalid
+        const int32 PaddedCount = Align(Count, 4);
+        for (int32 Index = 0; Index < PaddedCount; ++Index)
+        {
+            FKidDate Date;
+            const int32 Jurisdiction = Index < Count ? Jurisdictions[ChunkStart + Index] : INDEX_NONE;
+            const bool bValid = MinimumAges.IsValidIndex(Jurisdiction) && ParseDate(DatesOfBirth[ChunkStart + Index], Date);
+
+            Years[Index] = Date.Year;
+            MonthDays[Index] = MakeMonthDay(Date.Month, Date.Day);
+            ValidMasks[Index] = bValid ? -1 : 0;
+            Minimums[Index] = bValid ? MinimumAges[Jurisdiction] : 0;
+            DigitalConsents[Index] = bValid ? DigitalConsentAges[Jurisdiction] : 0;
+            Civils[Index] = bValid ? CivilAges[Jurisdiction] : 0;
+        }
+
+        for (int32 Index = 0; Index < PaddedCount; Index += 4)
+        {
+            // comparisons yield -1 in the lanes where they hold, so a pending birthday takes a year
+            // off and each threshold reached takes one off the band count
+            const VectorRegister4Int Age = VectorIntAdd(
+                        VectorIntSubtract(TodayYear, VectorIntLoad(&Years[Index])),
+                        VectorIntCompareGT(VectorIntLoad(&MonthDays[Index]), TodayMonthDay));
+
+            const VectorRegister4Int Reached = VectorIntAdd(
+                        VectorIntAdd(VectorIntCompareGE(Age, VectorIntLoad(&Minimums[Index])), 
+                                     VectorIntCompareGE(Age, VectorIntLoad(&DigitalConsents[Index]))),
+                        VectorIntCompareGE(Age, VectorIntLoad(&Civils[Index])));
+
+            const VectorRegister4Int Band = VectorIntAnd(VectorIntSubtract(One, Reached), VectorIntLoad(&ValidMasks[Index]));
+            VectorIntStore(Band, &Bands[Index]);
+        }
+
+        for (int32 Index = 0; Index < Count; ++Index)
+        {
+            OutBands[ChunkStart + Index] = static_cast<EKidAgeBand>(Bands[Index]);
+        }
+    }
+}
+
+EKidAgeBand FKidAgeClassifier::Classify(FStringView DateOfBirth, int32 Jurisdiction, const FKidDate& Today) const
+{
+    FKidDate Date;
+    if (!MinimumAges.IsValidIndex(Jurisdiction) || !ParseDate(DateOfBirth, Date))
+    {
+        return EKidAgeBand::Invalid;
+    }
+
+    return KidCore::ClassifyAge(CalculateAge(Date, Today), 
+                KidCore::FAgeThresholds{ MinimumAges[Jurisdiction], DigitalConsentAges[Jurisdiction], CivilAges[Jurisdiction] });
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "KidCorePolicy.h"
+
+struct FKidAgeGateRequirements;
+class FKidRequirementsCache;
+
+struct FKidDate : KidCore::FDate
+{
+    static FKidDate Today();
+};
+
+// Where an age falls relative to the thresholds of a jurisdiction, defined by the engine-agnostic core
+using EKidAgeBand = KidCore::EAgeBand;
+
+const TCHAR* LexToString(EKidAgeBand Band);
+
+// Classifies dates of birth into age bands in bulk, for servers handling many players at once.
+//
+// The thresholds of every jurisdiction are precomputed into parallel arrays, so classifying a
+// player is a table lookup and three comparisons.  Dates are parsed in place by the core without
+// allocating and the comparisons run four players at a time on the SIMD unit.
+class FKidAgeClassifier
+{
+public:
+    // Parses YYYY-MM-DD (also with '.' or '/' separators, optionally followed by a time) or a bare
+    // YYYY, without allocating.
+    static bool ParseDate(FStringView Text, FKidDate& OutDate);
+
+    // Whole years between the two dates.  A birthday with only the year known counts as passed.
+    static int32 CalculateAge(const FKidDate& DateOfBirth, const FKidDate& Today);
+
+    // Adds or replaces the thresholds of a jurisdiction and returns its index.  Thresholds are
+    // made non-decreasing, minimum age first, so the bands never overlap.
+    int32 SetJurisdiction(const FString& Jurisdiction, const FKidAgeGateRequirements& Requirements);
+
+    // adds every jurisdiction the cache holds requirements for
+    void AddJurisdictions(const FKidRequirementsCache& Cache);
+
+    // INDEX_NONE if unknown.  Resolve each distinct jurisdiction once, not once per player.
+    int32 FindJurisdiction(const FString& Jurisdiction) const;
+    int32 NumJurisdictions() const { return MinimumAges.Num(); }
+
+    // Classifies each date of birth against the jurisdiction at the same index.  All three views
+    // must have the same size.
+    void Classify(TConstArrayView<FStringView> DatesOfBirth, TConstArrayView<int32> Jurisdictions, 
+            const FKidDate& Today, TArrayView<EKidAgeBand> OutBands) const;
+
+    EKidAgeBand Classify(FStringView DateOfBirth, int32 Jurisdiction, const FKidDate& Today) const;
+
+private:
+    static FString MakeKey(const FString& Jurisdiction);
+
+    TMap<FString, int32> JurisdictionIndices;
+    TArray<int32> MinimumAges;
+    TArray<int32> DigitalConsentAges;
+    TArray<int32> CivilAges;
+};
@@ -0,0 +1,160 @@
+#include "CoreMinimal.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
+#include "KidAgeClassifier.h"
+#include "KidRequirementsCache.h"
+
+#if !UE_BUILD_SHIPPING
+
+// Compares the batch age classifier against classifying one player at a time the way the client
+// does: FDateTime parsing with fallbacks and a lookup of the jurisdiction's requirements for
+// every player.  Both run over the same generated players and must agree.
+//
+//   kid.Benchmark.AgeClassifier [Players=1000000] [Jurisdictions=64]
+namespace
+{
+    int32 CalculateAgeOnePlayer(const FString& DateOfBirth, const FDateTime& Now)
+    {
+        FDateTime DOB;
+        if (FDateTime::Parse(DateOfBirth, DOB) || FDateTime::ParseIso8601(*DateOfBirth, DOB))
+        {
+            int32 Age = Now.GetYear() - DOB.GetYear();
+            if (Now.GetMonth() < DOB.GetMonth() || (Now.GetMonth() == DOB.GetMonth() && Now.GetDay() < DOB.GetDay()))
+            {
+                Age--;
+            }
+            return Age;
+        }
+
+        int32 Year;
+        return LexTryParseString(Year, *DateOfBirth) ? Now.GetYear() - Year : INDEX_NONE;
+    }
+
+    EKidAgeBand ClassifyOnePlayer(const FString& DateOfBirth, const FString& Jurisdiction, 
+            const TMap<FString, FKidAgeGateRequirements>& RequirementsByJurisdiction, const FDateTime& Now)
+    {
+        const FKidAgeGateRequirements* Requirements = RequirementsByJurisdiction.Find(Jurisdiction);
+        const int32 Age = CalculateAgeOnePlayer(DateOfBirth, Now);
+        if (!Requirements || Age == INDEX_NONE)
+        {
+            return EKidAgeBand::Invalid;
+        }
+        if (Age < Requirements->MinimumAge)
+        {
+            return EKidAgeBand::BelowMinimumAge;
+        }
+        if (Age < Requirements->DigitalConsentAge)
+        {
+            return EKidAgeBand::BelowDigitalConsentAge;
+        }
+        return Age < Requirements->CivilAge ? EKidAgeBand::BelowCivilAge : EKidAgeBand::Adult;
+    }
+
+    void RunAgeClassifierBenchmark(int32 NumPlayers, int32 NumJurisdictions)
+    {
+        FRandomStream Random(1234);
+
+        TMap<FString, FKidAgeGateRequirements> RequirementsByJurisdiction;
+        TArray<FString> JurisdictionNames;
+        for (int32 Index = 0; Index < NumJurisdictions; ++Index)
+        {
+            FKidAgeGateRequirements Requirements;
+            Requirements.MinimumAge = Random.RandRange(0, 13);
+            Requirements.DigitalConsentAge = Random.RandRange(13, 16);
+            Requirements.CivilAge = Random.RandRange(18, 21);
+            JurisdictionNames.Add(FString::Printf(TEXT("J%d"), Index));
+            RequirementsByJurisdiction.Add(JurisdictionNames.Last(), Requirements);
+        }
+
+        // mostly full dates, some years only and a few that cannot be parsed
+        TArray<FString> DatesOfBirth;
+        TArray<FString> PlayerJurisdictions;
+        DatesOfBirth.Reserve(NumPlayers);
+        PlayerJurisdictions.Reserve(NumPlayers);
+        for (int32 Index = 0; Index < NumPlayers; ++Index)
+        {
+            const int32 Kind = Random.RandRange(0, 99);
+            const int32 Year = Random.RandRange(1950, 2024);
+            if (Kind < 94)
+            {
+                DatesOfBirth.Add(FString::Printf(TEXT("%04d-%02d-%02d"), Year, Random.RandRange(1, 12), Random.RandRange(1, 28)));
+            }
+            else if (Kind < 99)
+            {
+                DatesOfBirth.Add(FString::Printf(TEXT("%04d"), Year));
+            }
+            else
+            {
+                DatesOfBirth.Add(TEXT("not a date"));
+            }
+            PlayerJurisdictions.Add(JurisdictionNames[Random.RandRange(0, NumJurisdictions - 1)]);
+        }
+
+        const FDateTime Now = FDateTime::UtcNow();
+        TArray<EKidAgeBand> ExpectedBands;
+        ExpectedBands.SetNumUninitialized(NumPlayers);
+        const double OnePlayerStart = FPlatformTime::Seconds();
+        for (int32 Index = 0; Index < NumPlayers; ++Index)
+        {
+            ExpectedBands[Index] = ClassifyOnePlayer(DatesOfBirth[Index], PlayerJurisdictions[Index], RequirementsByJurisdiction, Now);
+        }
+        const double OnePlayerSeconds = FPlatformTime::Seconds() - OnePlayerStart;
+
+        // the table is built once per requirements update and the jurisdictions resolved once per
+        // player, so neither is part of the timed classification
+        FKidAgeClassifier Classifier;
+        for (const TPair<FString, FKidAgeGateRequirements>& Pair : RequirementsByJurisdiction)
+        {
+            Classifier.SetJurisdiction(Pair.Key, Pair.Value);
+        }
+
+        TArray<FStringView> DateViews;
+        TArray<int32> JurisdictionIndices;
+        DateViews.Reserve(NumPlayers);
+        JurisdictionIndices.Reserve(NumPlayers);
+        for (int32 Index = 0; Index < NumPlayers; ++Index)
+        {
+            DateViews.Add(DatesOfBirth[Index]);
+            JurisdictionIndices.Add(Classifier.FindJurisdiction(PlayerJurisdictions[Index]));
+        }
+
+        TArray<EKidAgeBand> Bands;
+        Bands.SetNumUninitialized(NumPlayers);
+        const double BatchStart = FPlatformTime::Seconds();
+        Classifier.Classify(DateViews, JurisdictionIndices, FKidDate{ Now.GetYear(), Now.GetMonth(), Now.GetDay() }, Bands);
+        const double BatchSeconds = FPlatformTime::Seconds() - BatchStart;
+
+        int32 NumMismatches = 0;
+        int32 BandCounts[5] = {};
+        for (int32 Index = 0; Index < NumPlayers; ++Index)
+        {
+            NumMismatches += Bands[Index] != ExpectedBands[Index] ? 1 : 0;
+            ++BandCounts[static_cast<int32>(Bands[Index])];
+        }
+
+        UE_LOG(LogTemp, Display, TEXT("kID age classifier, %d players in %d jurisdictions: one at a time %.1f ns per player, ")
+                    TEXT("batch %.1f ns per player (%.1fx)"),
+                    NumPlayers, NumJurisdictions, OnePlayerSeconds * 1e9 / NumPlayers, BatchSeconds * 1e9 / NumPlayers,
+                    OnePlayerSeconds / FMath::Max(BatchSeconds, 1e-9));
+        UE_LOG(LogTemp, Display, TEXT("kID age classifier bands: %d invalid, %d below minimum age, %d below digital consent age, ")
+                    TEXT("%d below civil age, %d adult"), BandCounts[0], BandCounts[1], BandCounts[2], BandCounts[3], BandCounts[4]);
+
+        if (NumMismatches > 0)
+        {
+            UE_LOG(LogTemp, Error, TEXT("kID age classifier disagreed with one at a time classification for %d players"), NumMismatches);
+        }
+    }
+}
+
+static FAutoConsoleCommand KidAgeClassifierBenchmarkCommand(
+    TEXT("kid.Benchmark.AgeClassifier"),
+    TEXT("Compares batch age classification against classifying one player at a time. ")
+    TEXT("Arguments: [Players=1000000] [Jurisdictions=64]"),
+    FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+    {
+        const int32 NumPlayers = FMath::Max(1, Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 1000000);
+        const int32 NumJurisdictions = FMath::Max(1, Args.Num() > 1 ? FCString::Atoi(*Args[1]) : 64);
+        RunAgeClassifierBenchmark(NumPlayers, NumJurisdictions);
+    }));
+
+#endif
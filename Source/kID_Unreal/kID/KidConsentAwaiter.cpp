@@ -0,0 +1,207 @@
+#include "KidConsentAwaiter.h"
+#include "HttpRequestHelper.h"
+#include "KidCoreRetry.h"
+#include "KidJsonDecoder.h"
+#include "Misc/CoreDelegates.h"
+
+FKidConsentAwaiter::FKidConsentAwaiter(const FString& InBaseUrl, const FString& InAuthToken, const FSettings& InSettings)
+    : BaseUrl(InBaseUrl)
+    , AuthToken(InAuthToken)
+    , Settings(InSettings)
+{
+}
+
+FKidConsentAwaiter::~FKidConsentAwaiter()
+{
+    StopRequest();
+    FCoreDelegates::ApplicationWillEnterBackgroundDelegate.Remove(EnterBackgroundHandle);
+    FCoreDelegates::ApplicationHasEnteredForegroundDelegate.Remove(EnterForegroundHandle);
+}
+
+void FKidConsentAwaiter::Start(const FString& InChallengeId, FDateTime StartTime, int32 TimeoutSeconds,
+                TFunction<void(const FKidConsentResult&)> InOnResolved)
+{
+    Cancel();
+
+    ChallengeId = InChallengeId;
+    Deadline = StartTime + FTimespan::FromSeconds(TimeoutSeconds);
+    OnResolved = MoveTemp(InOnResolved);
+    bActive = true;
+    bPaused = false;
+    ConsecutiveErrors = 0;
+
+    EnterBackgroundHandle = FCoreDelegates::ApplicationWillEnterBackgroundDelegate.AddSP(this, &FKidConsentAwaiter::HandleEnterBackground);
+    EnterForegroundHandle = FCoreDelegates::ApplicationHasEnteredForegroundDelegate.AddSP(this, &FKidConsentAwaiter::HandleEnterForeground);
+
+    IssueAwait();
+}
+
+void FKidConsentAwaiter::Cancel()
+{
+    if (bActive)
+    {
+        Resolve(EKidConsentStatus::Cancelled);
+    }
+}
+
+void FKidConsentAwaiter::IssueAwait()
+{
+    if (!bActive || bPaused)
+    {
+        return;
+    }
+
+    // hold the request on the server for as long as the deadline allows.  Once the deadline has
+    // passed, a final zero-length await still picks up a result that arrived in the meantime.
+    const double RemainingSeconds = (Deadline - FDateTime::UtcNow()).GetTotalSeconds();
+    const int32 AwaitSeconds = FMath::Clamp(FMath::FloorToInt32(RemainingSeconds), 0, Settings.MaxAwaitSeconds);
+
+    FString Url = FString::Printf(TEXT("%s/challenge/await?challengeId=%s&timeout=%d"),
+                *BaseUrl, *ChallengeId, AwaitSeconds);
+
+    const int32 Serial = ++RequestSerial;
+    RequestCount++;
+
+    TWeakPtr<FKidConsentAwaiter, ESPMode::ThreadSafe> WeakThis = AsShared();
+    InFlightRequest = HttpRequestHelper::GetRequestWithAuth(Url, AuthToken, [WeakThis, Serial](FHttpResponsePtr Response, bool bWasSuccessful)
+    {
+        if (TSharedPtr<FKidConsentAwaiter, ESPMode::ThreadSafe> This = WeakThis.Pin())
+        {
+            This->OnAwaitComplete(Serial, Response, bWasSuccessful);
+        }
+    }, AwaitSeconds + 10.0f);
+}
+
+void FKidConsentAwaiter::OnAwaitComplete(int32 Serial, FHttpResponsePtr Response, bool bWasSuccessful)
+{
+    // responses to requests that were cancelled or superseded are ignored
+    if (!bActive || Serial != RequestSerial)
+    {
+        return;
+    }
+    InFlightRequest.Reset();
+
+    if (bPaused)
+    {
+        return;
+    }
+
+    if (!bWasSuccessful || !Response.IsValid())
+    {
+        ErrorCount++;
+        ConsecutiveErrors++;
+        ScheduleRetry();
+        return;
+    }
+    ConsecutiveErrors = 0;
+
+    FKidChallengeStatus ChallengeStatus;
+    if (FKidJsonDecoder::Decode(Response->GetContent(), ChallengeStatus))
+    {
+        if (ChallengeStatus.Status == TEXT("PASS"))
+        {
+            Resolve(EKidConsentStatus::Granted, ChallengeStatus.SessionId, ChallengeStatus.ApproverEmail);
+            return;
+        }
+        else if (ChallengeStatus.Status == TEXT("FAIL"))
+        {
+            Resolve(EKidConsentStatus::Denied);
+            return;
+        }
+    }
+
+    // the long poll timed out without a result, so ask again straight away
+    if (FDateTime::UtcNow() < Deadline)
+    {
+        IssueAwait();
+    }
+    else
+    {
+        Resolve(EKidConsentStatus::TimedOut);
+    }
+}
+
+void FKidConsentAwaiter::ScheduleRetry()
+{
+    if (FDateTime::UtcNow() >= Deadline)
+    {
+        Resolve(EKidConsentStatus::TimedOut);
+        return;
+    }
+
+    const float Delay = KidCore::GetBackoffDelay(Settings.InitialBackoffSeconds, Settings.MaxBackoffSeconds, ConsecutiveErrors, FMath::FRand());
+    UE_LOG(LogTemp, Warning, TEXT("Waiting for consent failed %d times in a row, retrying in %.1f seconds"), ConsecutiveErrors, Delay);
+
+    TWeakPtr<FKidConsentAwaiter, ESPMode::ThreadSafe> WeakThis = AsShared();
+    RetryHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda([WeakThis](float DeltaTime)
+    {
+        if (TSharedPtr<FKidConsentAwaiter, ESPMode::ThreadSafe> This = WeakThis.Pin())
+        {
+            This->RetryHandle.Reset();
+            This->IssueAwait();
+        }
+        return false;
+    }), Delay);
+}
+
+void FKidConsentAwaiter::Resolve(EKidConsentStatus Status, const FString& SessionId, const FString& ApproverEmail)
+{
+    bActive = false;
+    StopRequest();
+
+    FCoreDelegates::ApplicationWillEnterBackgroundDelegate.Remove(EnterBackgroundHandle);
+    FCoreDelegates::ApplicationHasEnteredForegroundDelegate.Remove(EnterForegroundHandle);
+    EnterBackgroundHandle.Reset();
+    EnterForegroundHandle.Reset();
+
+    FKidConsentResult Result;
+    Result.Status = Status;
+    Result.SessionId = SessionId;
+    Result.ApproverEmail = ApproverEmail;
+
+    TFunction<void(const FKidConsentResult&)> Callback = MoveTemp(OnResolved);
+    OnResolved = nullptr;
+    if (Callback)
+    {
+        Callback(Result);
+    }
+}
+
+void FKidConsentAwaiter::StopRequest()
+{
+    RequestSerial++;
+
+    if (RetryHandle.IsValid())
+    {
+        FTSTicker::GetCoreTicker().RemoveTicker(RetryHandle);
+        RetryHandle.Reset();
+    }
+
+    FHttpRequestPtr Request = MoveTemp(InFlightRequest);
+    InFlightRequest.Reset();
+    if (Request.IsValid() && Request->GetStatus() == EHttpRequestStatus::Processing)
+    {
+        Request->CancelRequest();
+    }
+}
+
+void FKidConsentAwaiter::HandleEnterBackground()
+{
+    if (bActive && !bPaused)
+    {
+        UE_LOG(LogTemp, Log, TEXT("Pausing the wait for consent while in the background."));
+        bPaused = true;
+        StopRequest();
+    }
+}
+
+void FKidConsentAwaiter::HandleEnterForeground()
+{
+    if (bActive && bPaused)
+    {
+        UE_LOG(LogTemp, Log, TEXT("Resuming the wait for consent."));
+        bPaused = false;
+        ConsecutiveErrors = 0;
+        IssueAwait();
+    }
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+#include "Interfaces/IHttpRequest.h"
+#include "KidConsentChannel.h"
+
+// Waits for a consent challenge to be resolved using /challenge/await as a long poll.
+//
+// Every await asks the server to hold the request for as long as the remaining deadline allows
+// (capped at MaxAwaitSeconds) and is re-issued immediately when it times out without a result,
+// so there is no gap between polls.  Only errors back off, exponentially.  While the application
+// is in the background the request in flight is cancelled, and it resumes straight away when the
+// application returns to the foreground.
+class FKidConsentAwaiter : public IKidConsentChannel, public TSharedFromThis<FKidConsentAwaiter, ESPMode::ThreadSafe>
+{
+public:
+    struct FSettings
+    {
+        int32 MaxAwaitSeconds = 30;
+        float InitialBackoffSeconds = 1.0f;
+        float MaxBackoffSeconds = 30.0f;
+    };
+
+    FKidConsentAwaiter(const FString& InBaseUrl, const FString& InAuthToken, const FSettings& InSettings);
+    virtual ~FKidConsentAwaiter();
+
+    // IKidConsentChannel
+    virtual void Start(const FString& InChallengeId, FDateTime StartTime, int32 TimeoutSeconds,
+                TFunction<void(const FKidConsentResult&)> InOnResolved) override;
+    virtual void Cancel() override;
+    virtual bool IsActive() const override { return bActive; }
+    virtual int32 GetRequestCount() const override { return RequestCount; }
+
+    const FString& GetChallengeId() const { return ChallengeId; }
+    int32 GetErrorCount() const { return ErrorCount; }
+
+private:
+    void IssueAwait();
+    void OnAwaitComplete(int32 Serial, FHttpResponsePtr Response, bool bWasSuccessful);
+    void ScheduleRetry();
+    void Resolve(EKidConsentStatus Status, const FString& SessionId = FString(), const FString& ApproverEmail = FString());
+    void StopRequest();
+
+    void HandleEnterBackground();
+    void HandleEnterForeground();
+
+    FString BaseUrl;
+    FString AuthToken;
+    FSettings Settings;
+
+    FString ChallengeId;
+    FDateTime Deadline;
+    TFunction<void(const FKidConsentResult&)> OnResolved;
+
+    bool bActive = false;
+    bool bPaused = false;
+    int32 ConsecutiveErrors = 0;
+    int32 RequestSerial = 0;
+
+    FHttpRequestPtr InFlightRequest;
+    FTSTicker::FDelegateHandle RetryHandle;
+    FDelegateHandle EnterBackgroundHandle;
+    FDelegateHandle EnterForegroundHandle;
+
+    int32 RequestCount = 0;
+    int32 ErrorCount = 0;
+};
@@ -0,0 +1,377 @@
+#include "KidConsentAwaiterService.h"
+#include "HttpRequestHelper.h"
+#include "KidCoreRetry.h"
+#include "KidJsonDecoder.h"
+#include "Misc/CoreDelegates.h"
+
+FKidConsentAwaiterService::FKidConsentAwaiterService(const FString& InBaseUrl, const FString& InAuthToken, const FSettings& InSettings)
+    : BaseUrl(InBaseUrl)
+    , AuthToken(InAuthToken)
+    , Settings(InSettings)
+{
+    Settings.MaxConcurrentRequests = FMath::Max(1, Settings.MaxConcurrentRequests);
+    Settings.MaxRequestsPerSecond = FMath::Max(0.01f, Settings.MaxRequestsPerSecond);
+
+    // AsShared is not available yet, and the destructor removes these
+    EnterBackgroundHandle = FCoreDelegates::ApplicationWillEnterBackgroundDelegate.AddRaw(this, &FKidConsentAwaiterService::HandleEnterBackground);
+    EnterForegroundHandle = FCoreDelegates::ApplicationHasEnteredForegroundDelegate.AddRaw(this, &FKidConsentAwaiterService::HandleEnterForeground);
+}
+
+FKidConsentAwaiterService::~FKidConsentAwaiterService()
+{
+    FCoreDelegates::ApplicationWillEnterBackgroundDelegate.Remove(EnterBackgroundHandle);
+    FCoreDelegates::ApplicationHasEnteredForegroundDelegate.Remove(EnterForegroundHandle);
+
+    if (PumpHandle.IsValid())
+    {
+        FTSTicker::GetCoreTicker().RemoveTicker(PumpHandle);
+    }
+    for (TPair<FString, FWatchRef>& Pair : Watches)
+    {
+        StopRequest(*Pair.Value);
+    }
+}
+
+void FKidConsentAwaiterService::SetEndpoint(const FString& InBaseUrl, const FString& InAuthToken)
+{
+    BaseUrl = InBaseUrl;
+    AuthToken = InAuthToken;
+}
+
+void FKidConsentAwaiterService::Watch(const FString& ChallengeId, FDateTime StartTime, int32 TimeoutSeconds,
+                TFunction<void(const FKidConsentResult&)> OnResolved)
+{
+    Unwatch(ChallengeId);
+
+    FWatchRef Watch = MakeShared<FWatch, ESPMode::ThreadSafe>();
+    Watch->ChallengeId = ChallengeId;
+    Watch->Deadline = StartTime + FTimespan::FromSeconds(TimeoutSeconds);
+    Watch->OnResolved = MoveTemp(OnResolved);
+
+    Watches.Add(ChallengeId, Watch);
+    Queue.Add(Watch);
+    Pump();
+}
+
+void FKidConsentAwaiterService::Unwatch(const FString& ChallengeId)
+{
+    if (const FWatchRef* Watch = Watches.Find(ChallengeId))
+    {
+        Resolve(*Watch, EKidConsentStatus::Cancelled);
+    }
+}
+
+void FKidConsentAwaiterService::UnwatchAll()
+{
+    TArray<FWatchRef> All;
+    Watches.GenerateValueArray(All);
+    for (const FWatchRef& Watch : All)
+    {
+        Resolve(Watch, EKidConsentStatus::Cancelled);
+    }
+}
+
+void FKidConsentAwaiterService::Pump()
+{
+    // issuing or resolving can call back in here, e.g. when a request fails straight away or a
+    // callback watches another challenge, so nested calls only ask the outer one to go round again
+    if (bPumping)
+    {
+        bPumpAgain = true;
+        return;
+    }
+    TGuardValue<bool> PumpingGuard(bPumping, true);
+
+    double Wait = -1.0;
+    do
+    {
+        bPumpAgain = false;
+        Wait = -1.0;
+        while (!bPaused && NumInFlight < Settings.MaxConcurrentRequests && Queue.Num() > 0)
+        {
+            const double Now = FPlatformTime::Seconds();
+            if (Now < NextIssueTime)
+            {
+                Wait = NextIssueTime - Now;
+                break;
+            }
+
+            // the least recently polled challenge that is not backing off
+            const int32 Index = Queue.IndexOfByPredicate([Now](const FWatchRef& Watch) { return Watch->RetryTime <= Now; });
+            if (Index == INDEX_NONE)
+            {
+                double EarliestRetry = TNumericLimits<double>::Max();
+                for (const FWatchRef& Watch : Queue)
+                {
+                    EarliestRetry = FMath::Min(EarliestRetry, Watch->RetryTime);
+                }
+                Wait = EarliestRetry - Now;
+                break;
+            }
+
+            FWatchRef Watch = Queue[Index];
+            Queue.RemoveAt(Index);
+            NextIssueTime = Now + 1.0 / Settings.MaxRequestsPerSecond;
+            Issue(Watch);
+        }
+    }
+    while (bPumpAgain);
+
+    // when every slot is taken, the next completion pumps instead
+    if (Wait >= 0.0)
+    {
+        SchedulePump(Wait);
+    }
+}
+
+void FKidConsentAwaiterService::SchedulePump(double Delay)
+{
+    const double PumpTime = FPlatformTime::Seconds() + Delay;
+    if (PumpHandle.IsValid())
+    {
+        if (ScheduledPumpTime <= PumpTime)
+        {
+            return;
+        }
+        FTSTicker::GetCoreTicker().RemoveTicker(PumpHandle);
+    }
+
+    ScheduledPumpTime = PumpTime;
+    TWeakPtr<FKidConsentAwaiterService, ESPMode::ThreadSafe> WeakThis = AsShared();
+    PumpHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda([WeakThis](float DeltaTime)
+    {
+        if (TSharedPtr<FKidConsentAwaiterService, ESPMode::ThreadSafe> This = WeakThis.Pin())
+        {
+            This->PumpHandle.Reset();
+            This->Pump();
+        }
+        return false;
+    }), static_cast<float>(Delay));
+}
+
+void FKidConsentAwaiterService::Issue(const FWatchRef& Watch)
+{
+    // While every challenge can hold a slot, each holds a full long poll.  Beyond that the slots
+    // are shared out so every challenge is revisited within about MaxAwaitSeconds, but a hold is
+    // never shorter than the slots can sustain at MaxRequestsPerSecond.  Once the deadline has
+    // passed, a final zero-length await still picks up a result that arrived in the meantime.
+    const int32 NumWatched = Watches.Num();
+    double HoldSeconds = Settings.MaxAwaitSeconds;
+    if (NumWatched > Settings.MaxConcurrentRequests)
+    {
+        HoldSeconds = FMath::Max(HoldSeconds * Settings.MaxConcurrentRequests / NumWatched,
+                    Settings.MaxConcurrentRequests / Settings.MaxRequestsPerSecond);
+    }
+    const double RemainingSeconds = (Watch->Deadline - FDateTime::UtcNow()).GetTotalSeconds();
+    const int32 AwaitSeconds = FMath::Clamp(FMath::FloorToInt32(FMath::Min(RemainingSeconds, HoldSeconds)), 0, Settings.MaxAwaitSeconds);
+
+    FString Url = FString::Printf(TEXT("%s/challenge/await?challengeId=%s&timeout=%d"),
+                *BaseUrl, *Watch->ChallengeId, AwaitSeconds);
+
+    const int32 Serial = ++Watch->Serial;
+    NumInFlight++;
+    RequestCount++;
+
+    // a request that fails straight away has already been completed by the time the helper returns
+    TWeakPtr<FKidConsentAwaiterService, ESPMode::ThreadSafe> WeakThis = AsShared();
+    FHttpRequestPtr Request = HttpRequestHelper::GetRequestWithAuth(Url, AuthToken, [WeakThis, Watch, Serial](FHttpResponsePtr Response, bool bWasSuccessful)
+    {
+        if (TSharedPtr<FKidConsentAwaiterService, ESPMode::ThreadSafe> This = WeakThis.Pin())
+        {
+            This->OnAwaitComplete(Watch, Serial, Response, bWasSuccessful);
+        }
+    }, AwaitSeconds + 10.0f);
+
+    if (Watch->Serial == Serial)
+    {
+        Watch->Request = Request;
+    }
+}
+
+void FKidConsentAwaiterService::OnAwaitComplete(const FWatchRef& Watch, int32 Serial, FHttpResponsePtr Response, bool bWasSuccessful)
+{
+    // responses to requests that were cancelled or superseded are ignored
+    const FWatchRef* Current = Watches.Find(Watch->ChallengeId);
+    if (Serial != Watch->Serial || !Current || *Current != Watch)
+    {
+        return;
+    }
+    Watch->Serial++;
+    Watch->Request.Reset();
+    NumInFlight--;
+
+    if (!bWasSuccessful || !Response.IsValid())
+    {
+        ErrorCount++;
+        Watch->ConsecutiveErrors++;
+        if (FDateTime::UtcNow() >= Watch->Deadline)
+        {
+            Resolve(Watch, EKidConsentStatus::TimedOut);
+        }
+        else
+        {
+            const float Delay = KidCore::GetBackoffDelay(Settings.InitialBackoffSeconds, Settings.MaxBackoffSeconds, Watch->ConsecutiveErrors, FMath::FRand());
+            UE_LOG(LogTemp, Warning, TEXT("Waiting for consent on %s failed %d times in a row, retrying in %.1f seconds"),
+                        *Watch->ChallengeId, Watch->ConsecutiveErrors, Delay);
+
+            Watch->RetryTime = FPlatformTime::Seconds() + Delay;
+            Queue.Add(Watch);
+        }
+        Pump();
+        return;
+    }
+    Watch->ConsecutiveErrors = 0;
+
+    FKidChallengeStatus ChallengeStatus;
+    if (FKidJsonDecoder::Decode(Response->GetContent(), ChallengeStatus) && ChallengeStatus.Status == TEXT("PASS"))
+    {
+        Resolve(Watch, EKidConsentStatus::Granted, ChallengeStatus.SessionId, ChallengeStatus.ApproverEmail);
+    }
+    else if (ChallengeStatus.Status == TEXT("FAIL"))
+    {
+        Resolve(Watch, EKidConsentStatus::Denied);
+    }
+    else if (FDateTime::UtcNow() >= Watch->Deadline)
+    {
+        Resolve(Watch, EKidConsentStatus::TimedOut);
+    }
+    else
+    {
+        // no result yet, so go to the back of the queue behind every other challenge
+        Queue.Add(Watch);
+    }
+    Pump();
+}
+
+void FKidConsentAwaiterService::Resolve(const FWatchRef& Watch, EKidConsentStatus Status, const FString& SessionId, const FString& ApproverEmail)
+{
+    StopRequest(*Watch);
+    Watches.Remove(Watch->ChallengeId);
+    Queue.Remove(Watch);
+
+    FKidConsentResult Result;
+    Result.Status = Status;
+    Result.SessionId = SessionId;
+    Result.ApproverEmail = ApproverEmail;
+
+    TFunction<void(const FKidConsentResult&)> Callback = MoveTemp(Watch->OnResolved);
+    Watch->OnResolved = nullptr;
+    if (Callback)
+    {
+        Callback(Result);
+    }
+}
+
+void FKidConsentAwaiterService::StopRequest(FWatch& Watch)
+{
+    Watch.Serial++;
+
+    FHttpRequestPtr Request = MoveTemp(Watch.Request);
+    Watch.Request.Reset();
+    if (Request.IsValid())
+    {
+        NumInFlight--;
+        if (Request->GetStatus() == EHttpRequestStatus::Processing)
+        {
+            Request->CancelRequest();
+        }
+    }
+}
+
+void FKidConsentAwaiterService::HandleEnterBackground()
+{
+    if (bPaused)
+    {
+        return;
+    }
+    bPaused = true;
+
+    if (Watches.Num() > 0)
+    {
+        UE_LOG(LogTemp, Log, TEXT("Pausing the wait for consent on %d challenges while in the background."), Watches.Num());
+    }
+
+    // the awaits that were cut short go first when the application comes back
+    TArray<FWatchRef> Interrupted;
+    for (TPair<FString, FWatchRef>& Pair : Watches)
+    {
+        if (Pair.Value->Request.IsValid())
+        {
+            StopRequest(*Pair.Value);
+            Interrupted.Add(Pair.Value);
+        }
+    }
+    Queue.Insert(Interrupted, 0);
+
+    if (PumpHandle.IsValid())
+    {
+        FTSTicker::GetCoreTicker().RemoveTicker(PumpHandle);
+        PumpHandle.Reset();
+    }
+}
+
+void FKidConsentAwaiterService::HandleEnterForeground()
+{
+    if (!bPaused)
+    {
+        return;
+    }
+    bPaused = false;
+
+    if (Watches.Num() > 0)
+    {
+        UE_LOG(LogTemp, Log, TEXT("Resuming the wait for consent on %d challenges."), Watches.Num());
+    }
+    for (const FWatchRef& Watch : Queue)
+    {
+        Watch->ConsecutiveErrors = 0;
+        Watch->RetryTime = 0.0;
+    }
+    Pump();
+}
+
+FKidServiceConsentChannel::FKidServiceConsentChannel(const TSharedRef<FKidConsentAwaiterService, ESPMode::ThreadSafe>& InService)
+    : Service(InService)
+{
+}
+
+FKidServiceConsentChannel::~FKidServiceConsentChannel()
+{
+    Cancel();
+}
+
+void FKidServiceConsentChannel::Start(const FString& InChallengeId, FDateTime StartTime, int32 TimeoutSeconds,
+                TFunction<void(const FKidConsentResult&)> InOnResolved)
+{
+    Cancel();
+
+    ChallengeId = InChallengeId;
+    RequestCountAtStart = Service->GetRequestCount();
+    bActive = true;
+
+    const int32 StartSerial = ++Serial;
+    TWeakPtr<FKidServiceConsentChannel, ESPMode::ThreadSafe> WeakThis = AsShared();
+    Service->Watch(ChallengeId, StartTime, TimeoutSeconds, [WeakThis, StartSerial, OnResolved = MoveTemp(InOnResolved)](const FKidConsentResult& Result)
+    {
+        if (TSharedPtr<FKidServiceConsentChannel, ESPMode::ThreadSafe> This = WeakThis.Pin())
+        {
+            if (This->Serial == StartSerial)
+            {
+                This->bActive = false;
+            }
+        }
+        if (OnResolved)
+        {
+            OnResolved(Result);
+        }
+    });
+}
+
+void FKidServiceConsentChannel::Cancel()
+{
+    if (bActive)
+    {
+        bActive = false;
+        Service->Unwatch(ChallengeId);
+    }
+}
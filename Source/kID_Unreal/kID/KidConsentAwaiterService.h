@@ -0,0 +1,119 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+#include "Interfaces/IHttpRequest.h"
+#include "KidConsentChannel.h"
+
+// Waits on every outstanding consent challenge with one scheduler, instead of a long poll loop per
+// challenge.
+//
+// Challenges take turns in least recently polled order, with at most MaxConcurrentRequests
+// /challenge/await calls in flight and at most MaxRequestsPerSecond issued.  While there are no
+// more challenges than requests allowed in flight, each one holds a full long poll as
+// FKidConsentAwaiter would.  Beyond that the hold of each await shrinks so every challenge is
+// still visited regularly, but never below what keeps the request rate within the budget, so the
+// rate stays flat however many challenges are waiting.  Errors back off per challenge, and all
+// requests are cancelled while the application is in the background.
+class FKidConsentAwaiterService : public TSharedFromThis<FKidConsentAwaiterService, ESPMode::ThreadSafe>
+{
+public:
+    struct FSettings
+    {
+        int32 MaxConcurrentRequests = 8;
+        float MaxRequestsPerSecond = 4.0f;
+        int32 MaxAwaitSeconds = 30;
+        float InitialBackoffSeconds = 1.0f;
+        float MaxBackoffSeconds = 30.0f;
+    };
+
+    FKidConsentAwaiterService(const FString& InBaseUrl, const FString& InAuthToken, const FSettings& InSettings);
+    ~FKidConsentAwaiterService();
+
+    // applies to awaits issued from now on
+    void SetEndpoint(const FString& InBaseUrl, const FString& InAuthToken);
+
+    // OnResolved is called exactly once.  Watching a challenge that is already watched cancels the
+    // earlier watch.
+    void Watch(const FString& ChallengeId, FDateTime StartTime, int32 TimeoutSeconds, TFunction<void(const FKidConsentResult&)> OnResolved);
+    void Unwatch(const FString& ChallengeId);
+    void UnwatchAll();
+
+    bool IsWatching(const FString& ChallengeId) const { return Watches.Contains(ChallengeId); }
+    int32 GetNumWatched() const { return Watches.Num(); }
+    int32 GetNumInFlight() const { return NumInFlight; }
+    int32 GetRequestCount() const { return RequestCount; }
+    int32 GetErrorCount() const { return ErrorCount; }
+
+private:
+    struct FWatch
+    {
+        FString ChallengeId;
+        FDateTime Deadline;
+        TFunction<void(const FKidConsentResult&)> OnResolved;
+        FHttpRequestPtr Request;
+        int32 Serial = 0;
+        int32 ConsecutiveErrors = 0;
+        double RetryTime = 0.0;
+    };
+    using FWatchRef = TSharedRef<FWatch, ESPMode::ThreadSafe>;
+
+    void Pump();
+    void SchedulePump(double Delay);
+    void Issue(const FWatchRef& Watch);
+    void OnAwaitComplete(const FWatchRef& Watch, int32 Serial, FHttpResponsePtr Response, bool bWasSuccessful);
+    void Requeue(const FWatchRef& Watch);
+    void Resolve(const FWatchRef& Watch, EKidConsentStatus Status, const FString& SessionId = FString(), const FString& ApproverEmail = FString());
+    void StopRequest(FWatch& Watch);
+
+    void HandleEnterBackground();
+    void HandleEnterForeground();
+
+    FString BaseUrl;
+    FString AuthToken;
+    FSettings Settings;
+
+    TMap<FString, FWatchRef> Watches;
+
+    // challenges waiting for their next await, least recently polled first
+    TArray<FWatchRef> Queue;
+
+    int32 NumInFlight = 0;
+    double NextIssueTime = 0.0;
+    bool bPaused = false;
+    bool bPumping = false;
+    bool bPumpAgain = false;
+
+    FTSTicker::FDelegateHandle PumpHandle;
+    double ScheduledPumpTime = 0.0;
+    FDelegateHandle EnterBackgroundHandle;
+    FDelegateHandle EnterForegroundHandle;
+
+    int32 RequestCount = 0;
+    int32 ErrorCount = 0;
+};
+
+// IKidConsentChannel for one challenge at a time on a shared service, so code written against a
+// channel, e.g. the push channel's fallback, can share the service's budget.
+class FKidServiceConsentChannel : public IKidConsentChannel, public TSharedFromThis<FKidServiceConsentChannel, ESPMode::ThreadSafe>
+{
+public:
+    explicit FKidServiceConsentChannel(const TSharedRef<FKidConsentAwaiterService, ESPMode::ThreadSafe>& InService);
+    virtual ~FKidServiceConsentChannel();
+
+    // IKidConsentChannel
+    virtual void Start(const FString& InChallengeId, FDateTime StartTime, int32 TimeoutSeconds,
+                TFunction<void(const FKidConsentResult&)> InOnResolved) override;
+    virtual void Cancel() override;
+    virtual bool IsActive() const override { return bActive; }
+
+    // awaits issued by the shared service for every challenge since this channel was started
+    virtual int32 GetRequestCount() const override { return Service->GetRequestCount() - RequestCountAtStart; }
+
+private:
+    TSharedRef<FKidConsentAwaiterService, ESPMode::ThreadSafe> Service;
+    FString ChallengeId;
+    int32 RequestCountAtStart = 0;
+    int32 Serial = 0;
+    bool bActive = false;
+};
@@ -0,0 +1,246 @@
+#include "CoreMinimal.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
+#include "Containers/Ticker.h"
+#include "KidMockServer.h"
+#include "KidConsentAwaiter.h"
+#include "KidConsentAwaiterService.h"
+#include "KidPushConsentChannel.h"
+
+#if !UE_BUILD_SHIPPING
+
+// Compares end-to-end consent latency and connection cost of long polling against push, and
+// against one awaiter service shared by every challenge, using the local stand-in server.  Each
+// phase starts a number of challenges at once, resolves them at staggered times and measures how
+// long each channel takes to report the result, and how many requests per second that cost.
+//
+//   kid.Benchmark.Consent [Challenges=50] [LatencyMs=50] [ResolveAfterSeconds=2]
+class FKidConsentBenchmark : public TSharedFromThis<FKidConsentBenchmark, ESPMode::ThreadSafe>
+{
+public:
+    FKidConsentBenchmark(int32 InNumChallenges, double InLatencySeconds, double InResolveAfterSeconds)
+        : NumChallenges(InNumChallenges)
+        , LatencySeconds(InLatencySeconds)
+        , ResolveAfterSeconds(InResolveAfterSeconds)
+    {
+    }
+
+    ~FKidConsentBenchmark()
+    {
+        FTSTicker::GetCoreTicker().RemoveTicker(TickHandle);
+    }
+
+    bool Start()
+    {
+        Server = MakeUnique<FKidMockServer>();
+        Server->SetLatencySeconds(LatencySeconds);
+        if (!Server->Start(0))
+        {
+            return false;
+        }
+
+        StartPhase(EPhase::LongPoll);
+
+        TWeakPtr<FKidConsentBenchmark, ESPMode::ThreadSafe> WeakThis = AsShared();
+        TickHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda([WeakThis](float DeltaTime)
+        {
+            TSharedPtr<FKidConsentBenchmark, ESPMode::ThreadSafe> This = WeakThis.Pin();
+            return This && This->Tick();
+        }));
+        return true;
+    }
+
+    bool IsFinished() const { return bFinished; }
+
+private:
+    enum class EPhase : uint8
+    {
+        LongPoll,
+        Push,
+        Service
+    };
+
+    struct FChallengeRun
+    {
+        TSharedPtr<IKidConsentChannel> Channel;
+        double ResolveAt = 0.0;
+        double ResolvedAt = 0.0;
+        double ReportedAt = 0.0;
+    };
+
+    void StartPhase(EPhase InPhase)
+    {
+        Phase = InPhase;
+        Runs.Reset();
+        Runs.SetNum(NumChallenges);
+        OpenConnectionSamples = 0;
+        OpenConnectionSum = 0;
+        RequestsAtStart = Server->GetRequestCount();
+        PhaseStartTime = FPlatformTime::Seconds();
+
+        // the service is built with the default FSettings, so a default run has more challenges than
+        // MaxConcurrentRequests awaiter slots and most of them queue for one
+        Service.Reset();
+        if (Phase == EPhase::Service)
+        {
+            Service = MakeShared<FKidConsentAwaiterService, ESPMode::ThreadSafe>(Server->GetBaseUrl(), TEXT("benchmark"), FKidConsentAwaiterService::FSettings());
+        }
+
+        const double Now = FPlatformTime::Seconds();
+        for (int32 Index = 0; Index < NumChallenges; ++Index)
+        {
+            FChallengeRun& Run = Runs[Index];
+            Run.ResolveAt = Now + ResolveAfterSeconds + FMath::FRand();
+
+            if (Phase == EPhase::Service)
+            {
+                Run.Channel = MakeShared<FKidServiceConsentChannel, ESPMode::ThreadSafe>(Service.ToSharedRef());
+            }
+            else
+            {
+                TSharedRef<FKidConsentAwaiter, ESPMode::ThreadSafe> Awaiter =
+                            MakeShared<FKidConsentAwaiter, ESPMode::ThreadSafe>(Server->GetBaseUrl(), TEXT("benchmark"), FKidConsentAwaiter::FSettings());
+                if (Phase == EPhase::Push)
+                {
+                    Run.Channel = MakeShared<FKidPushConsentChannel, ESPMode::ThreadSafe>(Server->GetPushUrl(), TEXT("benchmark"), Awaiter);
+                }
+                else
+                {
+                    Run.Channel = Awaiter;
+                }
+            }
+
+            TWeakPtr<FKidConsentBenchmark, ESPMode::ThreadSafe> WeakThis = AsShared();
+            Run.Channel->Start(GetChallengeId(Index), FDateTime::UtcNow(), 120, [WeakThis, Index](const FKidConsentResult& Result)
+            {
+                if (TSharedPtr<FKidConsentBenchmark, ESPMode::ThreadSafe> This = WeakThis.Pin())
+                {
+                    This->Runs[Index].ReportedAt = FPlatformTime::Seconds();
+                }
+            });
+        }
+    }
+
+    bool Tick()
+    {
+        const double Now = FPlatformTime::Seconds();
+        bool bAllReported = true;
+        for (int32 Index = 0; Index < Runs.Num(); ++Index)
+        {
+            FChallengeRun& Run = Runs[Index];
+            if (Run.ResolvedAt == 0.0 && Now >= Run.ResolveAt)
+            {
+                Run.ResolvedAt = Now;
+                Server->SetChallengeStatus(GetChallengeId(Index), TEXT("PASS"));
+            }
+            bAllReported &= Run.ReportedAt > 0.0;
+        }
+
+        OpenConnectionSum += Server->GetOpenConnectionCount();
+        OpenConnectionSamples++;
+
+        if (!bAllReported)
+        {
+            return true;
+        }
+
+        Report();
+        if (Phase != EPhase::Service)
+        {
+            StartPhase(Phase == EPhase::LongPoll ? EPhase::Push : EPhase::Service);
+            return true;
+        }
+
+        Server->Stop();
+        bFinished = true;
+        return false;
+    }
+
+    void Report() const
+    {
+        TArray<double> Latencies;
+        for (const FChallengeRun& Run : Runs)
+        {
+            Latencies.Add((Run.ReportedAt - Run.ResolvedAt) * 1000.0);
+        }
+        Latencies.Sort();
+
+        double Sum = 0.0;
+        for (double Latency : Latencies)
+        {
+            Sum += Latency;
+        }
+
+        const int32 Num = Latencies.Num();
+        const int32 NumRequests = Server->GetRequestCount() - RequestsAtStart;
+        const double PhaseSeconds = FMath::Max(FPlatformTime::Seconds() - PhaseStartTime, 0.001);
+        UE_LOG(LogTemp, Display, TEXT("kID consent benchmark (%s, %d challenges, %.0f ms latency): ")
+                    TEXT("mean %.1f ms, p50 %.1f ms, p95 %.1f ms, max %.1f ms, %d requests/connections (%.1f per second), %.1f open connections on average"),
+                    GetPhaseName(), Num, LatencySeconds * 1000.0,
+                    Sum / Num, Latencies[Num / 2], Latencies[FMath::Min(Num - 1, Num * 95 / 100)], Latencies.Last(),
+                    NumRequests, NumRequests / PhaseSeconds,
+                    OpenConnectionSamples > 0 ? static_cast<double>(OpenConnectionSum) / OpenConnectionSamples : 0.0);
+    }
+
+    const TCHAR* GetPhaseName() const
+    {
+        switch (Phase)
+        {
+        case EPhase::Push:
+            return TEXT("push");
+        case EPhase::Service:
+            return TEXT("shared awaiter");
+        default:
+            return TEXT("long poll");
+        }
+    }
+
+    FString GetChallengeId(int32 Index) const
+    {
+        static const TCHAR* const Prefixes[] = { TEXT("poll"), TEXT("push"), TEXT("service") };
+        return FString::Printf(TEXT("benchmark-%s-%d"), Prefixes[static_cast<int32>(Phase)], Index);
+    }
+
+    int32 NumChallenges;
+    double LatencySeconds;
+    double ResolveAfterSeconds;
+
+    TUniquePtr<FKidMockServer> Server;
+    TSharedPtr<FKidConsentAwaiterService, ESPMode::ThreadSafe> Service;
+    TArray<FChallengeRun> Runs;
+    EPhase Phase = EPhase::LongPoll;
+    double PhaseStartTime = 0.0;
+    bool bFinished = false;
+    int32 RequestsAtStart = 0;
+    int64 OpenConnectionSum = 0;
+    int32 OpenConnectionSamples = 0;
+    FTSTicker::FDelegateHandle TickHandle;
+};
+
+static TSharedPtr<FKidConsentBenchmark, ESPMode::ThreadSafe> ActiveConsentBenchmark;
+
+static FAutoConsoleCommand KidConsentBenchmarkCommand(
+    TEXT("kid.Benchmark.Consent"),
+    TEXT("Compares consent latency of long polling, push and the shared awaiter service against a local stand-in server. ")
+    TEXT("Arguments: [Challenges=50] [LatencyMs=50] [ResolveAfterSeconds=2]"),
+    FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+    {
+        if (ActiveConsentBenchmark.IsValid() && !ActiveConsentBenchmark->IsFinished())
+        {
+            UE_LOG(LogTemp, Warning, TEXT("A kID consent benchmark is already running."));
+            return;
+        }
+
+        const int32 NumChallenges = FMath::Max(1, Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 50);
+        const double LatencySeconds = (Args.Num() > 1 ? FCString::Atod(*Args[1]) : 50.0) / 1000.0;
+        const double ResolveAfterSeconds = Args.Num() > 2 ? FCString::Atod(*Args[2]) : 2.0;
+
+        ActiveConsentBenchmark = MakeShared<FKidConsentBenchmark, ESPMode::ThreadSafe>(NumChallenges, LatencySeconds, ResolveAfterSeconds);
+        if (!ActiveConsentBenchmark->Start())
+        {
+            UE_LOG(LogTemp, Error, TEXT("Could not start the kID mock server for the consent benchmark."));
+            ActiveConsentBenchmark.Reset();
+        }
+    }));
+
+#endif
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+enum class EKidConsentStatus : uint8
+{
+    Granted,
+    Denied,
+    TimedOut,
+    Cancelled
+};
+
+struct FKidConsentResult
+{
+    EKidConsentStatus Status = EKidConsentStatus::Cancelled;
+    FString SessionId;
+    FString ApproverEmail;
+};
+
+// Delivers the outcome of a consent challenge, either by polling /challenge/await or by having
+// the server push status changes.
+class IKidConsentChannel
+{
+public:
+    virtual ~IKidConsentChannel() = default;
+
+    // OnResolved is called exactly once, including when the channel is cancelled
+    virtual void Start(const FString& ChallengeId, FDateTime StartTime, int32 TimeoutSeconds,
+                TFunction<void(const FKidConsentResult&)> OnResolved) = 0;
+    virtual void Cancel() = 0;
+    virtual bool IsActive() const = 0;
+
+    // HTTP requests or connections opened so far, for comparing channels
+    virtual int32 GetRequestCount() const = 0;
+};
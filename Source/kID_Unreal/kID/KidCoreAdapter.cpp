@@ -0,0 +1,45 @@
+#include "KidCoreAdapter.h"
+#include "Dom/JsonValue.h"
+
+std::vector<KidCore::FPermission> KidReadPermissions(const TSharedPtr<FJsonObject>& Session)
+{
+    std::vector<KidCore::FPermission> Result;
+    const TArray<TSharedPtr<FJsonValue>>* Permissions = nullptr;
+    if (!Session.IsValid() || !Session->TryGetArrayField(TEXT("permissions"), Permissions))
+    {
+        return Result;
+    }
+
+    Result.reserve(Permissions->Num());
+    for (const TSharedPtr<FJsonValue>& Permission : *Permissions)
+    {
+        const TSharedPtr<FJsonObject>* PermissionObject = nullptr;
+        FString Name;
+        if (Permission->TryGetObject(PermissionObject) && (*PermissionObject)->TryGetStringField(TEXT("name"), Name))
+        {
+            KidCore::FPermission& State = Result.emplace_back();
+            State.Name = KidToUtf8(Name);
+            (*PermissionObject)->TryGetBoolField(TEXT("enabled"), State.bEnabled);
+
+            FString ManagedBy;
+            (*PermissionObject)->TryGetStringField(TEXT("managedBy"), ManagedBy);
+            State.ManagedBy = KidToUtf8(ManagedBy);
+        }
+    }
+    return Result;
+}
+
+TArray<TSharedPtr<FJsonValue>> KidWritePermissions(const std::vector<KidCore::FPermission>& Permissions)
+{
+    TArray<TSharedPtr<FJsonValue>> Result;
+    Result.Reserve(static_cast<int32>(Permissions.size()));
+    for (const KidCore::FPermission& Permission : Permissions)
+    {
+        TSharedRef<FJsonObject> PermissionObject = MakeShared<FJsonObject>();
+        PermissionObject->SetStringField(TEXT("name"), KidFromUtf8(Permission.Name));
+        PermissionObject->SetBoolField(TEXT("enabled"), Permission.bEnabled);
+        PermissionObject->SetStringField(TEXT("managedBy"), KidFromUtf8(Permission.ManagedBy));
+        Result.Add(MakeShared<FJsonValueObject>(PermissionObject));
+    }
+    return Result;
+}
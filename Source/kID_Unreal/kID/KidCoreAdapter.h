@@ -0,0 +1,31 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Dom/JsonObject.h"
+#include "KidCoreSession.h"
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Conversions between engine strings and the UTF-8 strings of the engine-agnostic core in kIDCore
+inline std::string KidToUtf8(FStringView Text)
+{
+    FTCHARToUTF8 Converted(Text.GetData(), Text.Len());
+    return std::string(Converted.Get(), Converted.Length());
+}
+
+// converted straight into the string's own allocation, with no intermediate buffer
+inline FString KidFromUtf8(std::string_view Text)
+{
+    return FString(static_cast<int32>(Text.size()), reinterpret_cast<const UTF8CHAR*>(Text.data()));
+}
+
+// names that are already registered, e.g. every permission after the first session, allocate nothing
+inline FName KidNameFromUtf8(std::string_view Text)
+{
+    return FName(static_cast<int32>(Text.size()), reinterpret_cast<const UTF8CHAR*>(Text.data()));
+}
+
+// The "permissions" array of a session or of /age-gate/get-default-permissions, and back
+std::vector<KidCore::FPermission> KidReadPermissions(const TSharedPtr<FJsonObject>& Session);
+TArray<TSharedPtr<FJsonValue>> KidWritePermissions(const std::vector<KidCore::FPermission>& Permissions);
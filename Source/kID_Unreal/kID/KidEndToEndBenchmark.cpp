@@ -0,0 +1,571 @@
+#include "KidEndToEndBenchmark.h"
+#include "HttpRequestHelper.h"
+#include "KidMockServer.h"
+#include "KidRequestBody.h"
+#include "KidWorkflow.h"
+#include "Containers/Ticker.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "UObject/StrongObjectPtr.h"
+
+#if !UE_BUILD_SHIPPING
+
+// End-to-end latency of the kID flows a player waits on, measured on UKidWorkflow with its widgets
+// replaced by UI hooks, against the local stand-in server.  Each iteration is a new player on a
+// fresh install:
+//
+//   ColdStart               Initialize and StartKidSession until the age gate is shown
+//   AgeGateRoundTrip        a child's date of birth submitted until the consent challenge is shown
+//   ConsentToFullAccess     challenge approved through /test/set-challenge-status until access is Full
+//   SessionRestore          a new workflow on the same install until its saved session is revalidated
+//   AdultToFullAccess       that session cleared and an adult's date of birth submitted until access
+//                           is Full, which the cached policy and the prefetched defaults bring forward
+//
+// Iterations run one after the other so the results are latencies, not contention.  Every run
+// appends its results to Saved/kID/Benchmarks/EndToEnd.csv so they can be tracked over time, and
+// is compared against the thresholds in UKidBenchmarkSettings.
+//
+// The kID.EndToEnd automation test runs the scenarios and fails on any error or regression; the
+// console command and -run=KidBenchmark drive the same runner for longer runs and the history.
+//
+//   kid.Benchmark.EndToEnd [Iterations=20]
+class FKidEndToEndBenchmark : public TSharedFromThis<FKidEndToEndBenchmark>
+{
+public:
+    explicit FKidEndToEndBenchmark(int32 InNumIterations)
+        : NumIterations(InNumIterations)
+        , StorageDirectory(FPaths::ProjectSavedDir() / TEXT("kID") / TEXT("Benchmark"))
+    {
+        Scenarios.SetNum(static_cast<int32>(EScenario::Count));
+    }
+
+    ~FKidEndToEndBenchmark()
+    {
+        EndIteration();
+        if (Server.IsValid())
+        {
+            Server->Stop();
+        }
+        IFileManager::Get().DeleteDirectory(*StorageDirectory, false, true);
+    }
+
+    bool Start()
+    {
+        const UKidBenchmarkSettings* Settings = GetDefault<UKidBenchmarkSettings>();
+        Server = MakeUnique<FKidMockServer>();
+        Server->SetLatencySeconds(Settings->ServerLatencyMs / 1000.0);
+        if (!Server->Start(0))
+        {
+            return false;
+        }
+
+        IFileManager::Get().DeleteDirectory(*StorageDirectory, false, true);
+        BeginIteration();
+        return true;
+    }
+
+    bool IsFinished() const { return Iteration >= NumIterations; }
+
+    void Tick()
+    {
+        if (IsFinished())
+        {
+            return;
+        }
+
+        const double Now = FPlatformTime::Seconds();
+        if (SubmitAgeGate && Now >= SubmitAt)
+        {
+            // the scenario after the age gate is timed from when the player submits it
+            TFunction<void()> Submit = MoveTemp(SubmitAgeGate);
+            SubmitAgeGate = nullptr;
+            ScenarioStart = Now;
+            bSubmitted = true;
+            Submit();
+        }
+
+        if (!Flow.IsValid() || !Flow->IsFinished())
+        {
+            return;
+        }
+
+        // each flow is let go of once the scenario it ran is measured, so a flow that finishes
+        // earlier ended before reaching it
+        const bool bCompleted = Flow->GetState() == EKidFlowState::Completed && Workflow->GetState().GetMode() == EKidAccessMode::Full;
+        Flow.Reset();
+        if (bCompleted && Scenario == EScenario::SessionRestore && !bRestoring)
+        {
+            BeginRestore(Now);
+            return;
+        }
+        if (bCompleted && Scenario == EScenario::SessionRestore)
+        {
+            AddSample(EScenario::SessionRestore, Now - ScenarioStart);
+            BeginAdult();
+            return;
+        }
+        if (!bCompleted || Scenario != EScenario::AdultToFullAccess || !bMeasured)
+        {
+            Scenarios[static_cast<int32>(Scenario)].Errors++;
+        }
+
+        EndIteration();
+        if (++Iteration < NumIterations)
+        {
+            BeginIteration();
+        }
+    }
+
+    struct FScenarioSummary
+    {
+        const TCHAR* Name = nullptr;
+        int32 NumSamples = 0;
+        int32 Errors = 0;
+        double MeanMs = 0.0;
+        double P50Ms = 0.0;
+        double P90Ms = 0.0;
+        double MaxMs = 0.0;
+        double ThresholdP90Ms = 0.0;
+
+        // every iteration measured, none failed and the 90th percentile within the threshold
+        bool bPassed = false;
+    };
+
+    TArray<FScenarioSummary> Summarize() const
+    {
+        const UKidBenchmarkSettings* Settings = GetDefault<UKidBenchmarkSettings>();
+        const float Thresholds[] = { Settings->ColdStartMaxP90Ms, Settings->AgeGateRoundTripMaxP90Ms,
+                    Settings->ConsentToFullAccessMaxP90Ms, Settings->SessionRestoreMaxP90Ms, Settings->AdultToFullAccessMaxP90Ms };
+        static_assert(UE_ARRAY_COUNT(Thresholds) == static_cast<int32>(EScenario::Count), "A threshold is needed for every scenario");
+
+        TArray<FScenarioSummary> Summaries;
+        for (int32 Index = 0; Index < Scenarios.Num(); ++Index)
+        {
+            TArray<double> Sorted = Scenarios[Index].LatenciesMs;
+            Sorted.Sort();
+
+            double Sum = 0.0;
+            for (double Latency : Sorted)
+            {
+                Sum += Latency;
+            }
+
+            FScenarioSummary& Summary = Summaries.AddDefaulted_GetRef();
+            const int32 Num = Sorted.Num();
+            Summary.Name = GetScenarioName(static_cast<EScenario>(Index));
+            Summary.NumSamples = Num;
+            Summary.Errors = Scenarios[Index].Errors;
+            Summary.MeanMs = Num > 0 ? Sum / Num : 0.0;
+            Summary.P50Ms = Num > 0 ? Sorted[Num / 2] : 0.0;
+            Summary.P90Ms = Num > 0 ? Sorted[FMath::Min(Num - 1, Num * 90 / 100)] : 0.0;
+            Summary.MaxMs = Num > 0 ? Sorted.Last() : 0.0;
+            Summary.ThresholdP90Ms = Thresholds[Index];
+            Summary.bPassed = Num == NumIterations && Summary.Errors == 0 && Summary.P90Ms <= Summary.ThresholdP90Ms;
+        }
+        return Summaries;
+    }
+
+    // Logs the results, appends them to the history and returns false if any scenario failed or
+    // regressed.
+    bool Report() const
+    {
+        const UKidBenchmarkSettings* Settings = GetDefault<UKidBenchmarkSettings>();
+        const FString HistoryPath = FPaths::ProjectSavedDir() / TEXT("kID") / TEXT("Benchmarks") / TEXT("EndToEnd.csv");
+        FString History = IFileManager::Get().FileExists(*HistoryPath) ? FString() :
+                    TEXT("timestamp,scenario,iterations,errors,meanMs,p50Ms,p90Ms,maxMs,thresholdP90Ms,result\n");
+        const FString Timestamp = FDateTime::UtcNow().ToIso8601();
+
+        bool bPassed = true;
+        UE_LOG(LogTemp, Display, TEXT("kID end-to-end benchmark, %d iterations, %.0f ms server latency:"), NumIterations, Settings->ServerLatencyMs);
+        for (const FScenarioSummary& Summary : Summarize())
+        {
+            bPassed &= Summary.bPassed;
+
+            UE_LOG(LogTemp, Display, TEXT("    %-20s mean %7.1f ms, p50 %7.1f ms, p90 %7.1f ms (threshold %7.1f ms), max %7.1f ms, %d errors: %s"),
+                        Summary.Name, Summary.MeanMs, Summary.P50Ms, Summary.P90Ms, Summary.ThresholdP90Ms, Summary.MaxMs, Summary.Errors,
+                        Summary.bPassed ? TEXT("PASS") : TEXT("REGRESSED"));
+            if (!Summary.bPassed)
+            {
+                UE_LOG(LogTemp, Error, TEXT("kID benchmark scenario %s regressed."), Summary.Name);
+            }
+
+            History += FString::Printf(TEXT("%s,%s,%d,%d,%.2f,%.2f,%.2f,%.2f,%.2f,%s\n"), *Timestamp, Summary.Name, Summary.NumSamples, Summary.Errors,
+                        Summary.MeanMs, Summary.P50Ms, Summary.P90Ms, Summary.MaxMs, Summary.ThresholdP90Ms, Summary.bPassed ? TEXT("pass") : TEXT("regressed"));
+        }
+
+        FFileHelper::SaveStringToFile(History, *HistoryPath, FFileHelper::EEncodingOptions::AutoDetect, &IFileManager::Get(), FILEWRITE_Append);
+        return bPassed;
+    }
+
+private:
+    enum class EScenario : uint8
+    {
+        ColdStart,
+        AgeGateRoundTrip,
+        ConsentToFullAccess,
+        SessionRestore,
+        AdultToFullAccess,
+        Count
+    };
+
+    static const TCHAR* GetScenarioName(EScenario InScenario)
+    {
+        switch (InScenario)
+        {
+        case EScenario::ColdStart:           return TEXT("ColdStart");
+        case EScenario::AgeGateRoundTrip:    return TEXT("AgeGateRoundTrip");
+        case EScenario::ConsentToFullAccess: return TEXT("ConsentToFullAccess");
+        case EScenario::SessionRestore:      return TEXT("SessionRestore");
+        case EScenario::AdultToFullAccess:   return TEXT("AdultToFullAccess");
+        default:                             return TEXT("Unknown");
+        }
+    }
+
+    struct FScenarioResults
+    {
+        TArray<double> LatenciesMs;
+        int32 Errors = 0;
+    };
+
+    void BeginIteration()
+    {
+        // a new install each time, so every iteration starts without saved state or caches
+        Scenario = EScenario::ColdStart;
+        ScenarioStart = FPlatformTime::Seconds();
+        bRestoring = false;
+        StartWorkflow();
+    }
+
+    void BeginRestore(double Now)
+    {
+        // a new workflow on the same install, so nothing but what is on disk carries over
+        bRestoring = true;
+        ScenarioStart = Now;
+        Workflow->CleanUp();
+        StartWorkflow();
+    }
+
+    void BeginAdult()
+    {
+        // another player on the same device, who starts with the install's caches but no session
+        Scenario = EScenario::AdultToFullAccess;
+        bSubmitted = false;
+        bMeasured = false;
+        Workflow->ClearChallengeId();
+        Workflow->ClearSession();
+        Flow = Workflow->StartKidSession(TEXT("US-CA"));
+        if (!Flow.IsValid())
+        {
+            Flow = MakeShared<FKidFlow, ESPMode::ThreadSafe>(TEXT("Benchmark"));
+            Flow->Fail();
+        }
+    }
+
+    void StartWorkflow()
+    {
+        Workflow = TStrongObjectPtr<UKidWorkflow>(NewObject<UKidWorkflow>());
+        Workflow->SetEndpoints({ Server->GetBaseUrl() });
+        Workflow->SetApiKey(TEXT("benchmark"));
+        Workflow->SetStateDirectory(StorageDirectory / FString::Printf(TEXT("Iteration%d"), Iteration));
+        Workflow->SetUi(MakeUi());
+
+        TWeakPtr<FKidEndToEndBenchmark> WeakThis = AsShared();
+        const int32 StartedIteration = Iteration;
+        Workflow->Initialize([WeakThis, StartedIteration](bool bTokenIssued)
+        {
+            TSharedPtr<FKidEndToEndBenchmark> This = WeakThis.Pin();
+            if (!This || This->Iteration != StartedIteration)
+            {
+                return;
+            }
+
+            This->Flow = bTokenIssued ? This->Workflow->StartKidSession(TEXT("US-CA")) : nullptr;
+            if (!This->Flow.IsValid())
+            {
+                This->Flow = MakeShared<FKidFlow, ESPMode::ThreadSafe>(TEXT("Benchmark"));
+                This->Flow->Fail();
+            }
+        });
+    }
+
+    // stands in for the widgets, and moves the iteration from one scenario to the next
+    FKidWorkflowUi MakeUi()
+    {
+        TWeakPtr<FKidEndToEndBenchmark> WeakThis = AsShared();
+        FKidWorkflowUi Ui;
+        Ui.ShowAgeGate = [WeakThis](const FKidAgeGateRequirements& Requirements, TFunction<void(const FString&)> Submit)
+        {
+            TSharedPtr<FKidEndToEndBenchmark> This = WeakThis.Pin();
+            if (!This)
+            {
+                return;
+            }
+
+            FString DateOfBirth;
+            if (This->Scenario == EScenario::ColdStart)
+            {
+                This->NextScenario(EScenario::AgeGateRoundTrip);
+
+                // young enough to need consent
+                DateOfBirth = TEXT("2015-01-01");
+            }
+            else if (This->Scenario == EScenario::AdultToFullAccess)
+            {
+                DateOfBirth = TEXT("1990-01-01");
+            }
+            else
+            {
+                return;
+            }
+
+            // submitted from the next tick once the player has taken their time over it
+            This->SubmitAgeGate = [Submit = MoveTemp(Submit), DateOfBirth]() { Submit(DateOfBirth); };
+            This->SubmitAt = FPlatformTime::Seconds() + GetDefault<UKidBenchmarkSettings>()->AgeGateThinkTimeMs / 1000.0;
+        };
+        Ui.ShowAgeAssurance = [](int32 Age, TFunction<void(bool, int32, int32)> OnResponse)
+        {
+            OnResponse(true, Age, Age);
+        };
+        Ui.ShowChallenge = [WeakThis](const FKidSavedChallenge& Challenge)
+        {
+            TSharedPtr<FKidEndToEndBenchmark> This = WeakThis.Pin();
+            if (This && This->Scenario == EScenario::AgeGateRoundTrip)
+            {
+                This->NextScenario(EScenario::ConsentToFullAccess);
+                This->Approve(Challenge.ChallengeId);
+            }
+        };
+        Ui.UpdateHUD = [WeakThis](const FKidHudViewModel& ViewModel)
+        {
+            TSharedPtr<FKidEndToEndBenchmark> This = WeakThis.Pin();
+            if (!This || This->Workflow->GetState().GetMode() != EKidAccessMode::Full)
+            {
+                return;
+            }
+
+            if (This->Scenario == EScenario::ConsentToFullAccess)
+            {
+                // restored once the flow has finished saving the session
+                This->NextScenario(EScenario::SessionRestore);
+            }
+            else if (This->Scenario == EScenario::AdultToFullAccess && This->bSubmitted && !This->bMeasured)
+            {
+                This->AddSample(EScenario::AdultToFullAccess, FPlatformTime::Seconds() - This->ScenarioStart);
+                This->bMeasured = true;
+            }
+        };
+        return Ui;
+    }
+
+    void Approve(const FString& ChallengeId)
+    {
+        FKidSetChallengeStatusRequest Request;
+        Request.Status = TEXTVIEW("PASS");
+        Request.ChallengeId = ChallengeId;
+
+        HttpRequestHelper::PostRequestWithAuthAsync(Workflow->GetBaseUrl() + TEXT("/test/set-challenge-status"), KidSerializeRequest(Request),
+                    Workflow->GetAuthToken());
+    }
+
+    void NextScenario(EScenario NewScenario)
+    {
+        const double Now = FPlatformTime::Seconds();
+        AddSample(Scenario, Now - ScenarioStart);
+        Scenario = NewScenario;
+        ScenarioStart = Now;
+    }
+
+    void EndIteration()
+    {
+        if (Workflow.IsValid())
+        {
+            Workflow->CleanUp();
+            Workflow.Reset();
+        }
+        Flow.Reset();
+        SubmitAgeGate = nullptr;
+        bSubmitted = false;
+        bMeasured = false;
+    }
+
+    void AddSample(EScenario InScenario, double Seconds)
+    {
+        Scenarios[static_cast<int32>(InScenario)].LatenciesMs.Add(Seconds * 1000.0);
+    }
+
+    int32 NumIterations;
+    FString StorageDirectory;
+    TUniquePtr<FKidMockServer> Server;
+    TArray<FScenarioResults> Scenarios;
+
+    int32 Iteration = 0;
+    EScenario Scenario = EScenario::ColdStart;
+    double ScenarioStart = 0.0;
+    bool bRestoring = false;
+    TStrongObjectPtr<UKidWorkflow> Workflow;
+    FKidFlowPtr Flow;
+
+    // the age gate being shown, and whether the date of birth for the scenario has been submitted
+    // and the access it leads to measured
+    TFunction<void()> SubmitAgeGate;
+    double SubmitAt = 0.0;
+    bool bSubmitted = false;
+    bool bMeasured = false;
+};
+
+static TSharedPtr<FKidEndToEndBenchmark> ActiveEndToEndBenchmark;
+static FTSTicker::FDelegateHandle EndToEndBenchmarkTickHandle;
+
+static FAutoConsoleCommand KidEndToEndBenchmarkCommand(
+    TEXT("kid.Benchmark.EndToEnd"),
+    TEXT("Measures cold start, age gate, consent, session restore and adult access latency of the kID workflow against a local stand-in server. ")
+    TEXT("Arguments: [Iterations=20]"),
+    FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+    {
+        if (ActiveEndToEndBenchmark.IsValid())
+        {
+            UE_LOG(LogTemp, Warning, TEXT("A kID end-to-end benchmark is already running."));
+            return;
+        }
+
+        const int32 NumIterations = FMath::Max(1, Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 20);
+        ActiveEndToEndBenchmark = MakeShared<FKidEndToEndBenchmark>(NumIterations);
+        if (!ActiveEndToEndBenchmark->Start())
+        {
+            UE_LOG(LogTemp, Error, TEXT("Could not start the kID mock server for the benchmark."));
+            ActiveEndToEndBenchmark.Reset();
+            return;
+        }
+
+        EndToEndBenchmarkTickHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda([](float DeltaTime)
+        {
+            ActiveEndToEndBenchmark->Tick();
+            if (!ActiveEndToEndBenchmark->IsFinished())
+            {
+                return true;
+            }
+            ActiveEndToEndBenchmark->Report();
+            ActiveEndToEndBenchmark.Reset();
+            return false;
+        }));
+    }));
+
+#endif
+
+UKidBenchmarkCommandlet::UKidBenchmarkCommandlet()
+{
+    IsClient = false;
+    IsServer = false;
+    IsEditor = false;
+    LogToConsole = true;
+}
+
+int32 UKidBenchmarkCommandlet::Main(const FString& Params)
+{
+#if UE_BUILD_SHIPPING
+    UE_LOG(LogTemp, Error, TEXT("The kID benchmark is not available in Shipping builds."));
+    return 1;
+#else
+    int32 NumIterations = 20;
+    double TimeoutSeconds = 300.0;
+    FParse::Value(*Params, TEXT("Iterations="), NumIterations);
+    FParse::Value(*Params, TEXT("TimeoutSeconds="), TimeoutSeconds);
+
+    TSharedRef<FKidEndToEndBenchmark> Benchmark = MakeShared<FKidEndToEndBenchmark>(FMath::Max(1, NumIterations));
+    if (!Benchmark->Start())
+    {
+        UE_LOG(LogTemp, Error, TEXT("Could not start the kID mock server for the benchmark."));
+        return 1;
+    }
+
+    // as in the load generator, the core ticker and the game thread's task queue are pumped here
+    const double Deadline = FPlatformTime::Seconds() + TimeoutSeconds;
+    double LastTime = FPlatformTime::Seconds();
+    while (!Benchmark->IsFinished() && !IsEngineExitRequested())
+    {
+        const double Now = FPlatformTime::Seconds();
+        FTaskGraphInterface::Get().ProcessThreadUntilIdle(ENamedThreads::GameThread);
+        FTSTicker::GetCoreTicker().Tick(static_cast<float>(Now - LastTime));
+        Benchmark->Tick();
+        LastTime = Now;
+
+        if (Now > Deadline)
+        {
+            UE_LOG(LogTemp, Error, TEXT("kID benchmark timed out after %.0f s."), TimeoutSeconds);
+            Benchmark->Report();
+            return 1;
+        }
+        FPlatformProcess::Sleep(0.001f);
+    }
+
+    return Benchmark->Report() ? 0 : 1;
+#endif
+}
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+// Ticks the benchmark every frame until it finishes, then fails the test for every scenario that
+// had an error, missed an iteration or regressed past its threshold.
+class FKidEndToEndBenchmarkLatentCommand : public IAutomationLatentCommand
+{
+public:
+    FKidEndToEndBenchmarkLatentCommand(FAutomationTestBase* InTest, TSharedRef<FKidEndToEndBenchmark> InBenchmark, int32 InNumIterations, double TimeoutSeconds)
+        : Test(InTest)
+        , Benchmark(InBenchmark)
+        , NumIterations(InNumIterations)
+        , Deadline(FPlatformTime::Seconds() + TimeoutSeconds)
+    {
+    }
+
+    virtual bool Update() override
+    {
+        Benchmark->Tick();
+        if (!Benchmark->IsFinished())
+        {
+            if (FPlatformTime::Seconds() < Deadline)
+            {
+                return false;
+            }
+            Test->AddError(TEXT("The kID end-to-end benchmark timed out."));
+        }
+
+        for (const FKidEndToEndBenchmark::FScenarioSummary& Summary : Benchmark->Summarize())
+        {
+            Test->AddInfo(FString::Printf(TEXT("%s: p90 %.1f ms (threshold %.1f ms), %d samples, %d errors"),
+                        Summary.Name, Summary.P90Ms, Summary.ThresholdP90Ms, Summary.NumSamples, Summary.Errors));
+            Test->TestEqual(FString::Printf(TEXT("%s errors"), Summary.Name), Summary.Errors, 0);
+            Test->TestEqual(FString::Printf(TEXT("%s samples"), Summary.Name), Summary.NumSamples, NumIterations);
+            Test->TestTrue(FString::Printf(TEXT("%s p90 within its threshold"), Summary.Name), Summary.NumSamples > 0 && Summary.P90Ms <= Summary.ThresholdP90Ms);
+        }
+        return true;
+    }
+
+private:
+    FAutomationTestBase* Test;
+    TSharedRef<FKidEndToEndBenchmark> Benchmark;
+    int32 NumIterations;
+    double Deadline;
+};
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FKidEndToEndTest, "kID.EndToEnd",
+            EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::EngineFilter)
+
+bool FKidEndToEndTest::RunTest(const FString& Parameters)
+{
+    const int32 NumIterations = 10;
+    TSharedRef<FKidEndToEndBenchmark> Benchmark = MakeShared<FKidEndToEndBenchmark>(NumIterations);
+    if (!TestTrue(TEXT("The kID mock server started"), Benchmark->Start()))
+    {
+        return false;
+    }
+
+    ADD_LATENT_AUTOMATION_COMMAND(FKidEndToEndBenchmarkLatentCommand(this, Benchmark, NumIterations, 120.0));
+    return true;
+}
+
+#endif
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "KidEndToEndBenchmark.generated.h"
+
+// Regression thresholds for the end-to-end benchmark, on the 90th percentile of each scenario.
+// A run that exceeds any of them fails.
+UCLASS(Config=Game)
+class UKidBenchmarkSettings : public UObject
+{
+    GENERATED_BODY()
+
+public:
+    // round trip latency the local stand-in server adds to every response
+    UPROPERTY(Config)
+    float ServerLatencyMs = 20.0f;
+
+    // how long the player takes over the age gate, during which the default permissions are prefetched
+    UPROPERTY(Config)
+    float AgeGateThinkTimeMs = 250.0f;
+
+    // UKidWorkflow startup, until the age gate could be shown
+    UPROPERTY(Config)
+    float ColdStartMaxP90Ms = 400.0f;
+
+    // date of birth submitted until the consent challenge could be shown
+    UPROPERTY(Config)
+    float AgeGateRoundTripMaxP90Ms = 250.0f;
+
+    // challenge approved until the player's access mode is Full
+    UPROPERTY(Config)
+    float ConsentToFullAccessMaxP90Ms = 400.0f;
+
+    // saved state loaded from disk and the session revalidated
+    UPROPERTY(Config)
+    float SessionRestoreMaxP90Ms = 250.0f;
+
+    // an adult's date of birth submitted until the player's access mode is Full
+    UPROPERTY(Config)
+    float AdultToFullAccessMaxP90Ms = 250.0f;
+};
+
+// Runs the end-to-end benchmark headlessly, for build machines.  Returns non-zero if a scenario
+// failed or regressed past its threshold.
+//
+//   UnrealEditor-Cmd kID_Unreal.uproject -run=KidBenchmark [-Iterations=20]
+UCLASS()
+class UKidBenchmarkCommandlet : public UCommandlet
+{
+    GENERATED_BODY()
+
+public:
+    UKidBenchmarkCommandlet();
+
+    virtual int32 Main(const FString& Params) override;
+};
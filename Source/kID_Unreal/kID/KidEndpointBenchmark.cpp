@@ -0,0 +1,204 @@
+#include "CoreMinimal.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
+#include "KidMockServer.h"
+#include "KidEndpointSelector.h"
+#include "HttpRequestHelper.h"
+
+#if !UE_BUILD_SHIPPING
+
+// Checks regional endpoint selection against several local stand-in servers with different
+// latencies.  The selector must pick the fastest one; that server is then stopped and requests
+// are sent until the selector fails over, which must be to the next fastest.
+//
+//   kid.Benchmark.Endpoints [LatenciesMs=150,40,90] [FailuresBeforeSwitch=3]
+class FKidEndpointBenchmark : public TSharedFromThis<FKidEndpointBenchmark, ESPMode::ThreadSafe>
+{
+public:
+    FKidEndpointBenchmark(const TArray<double>& InLatenciesSeconds, int32 InFailuresBeforeSwitch)
+        : LatenciesSeconds(InLatenciesSeconds)
+        , FailuresBeforeSwitch(InFailuresBeforeSwitch)
+    {
+    }
+
+    bool Start()
+    {
+        TArray<FString> BaseUrls;
+        for (double Latency : LatenciesSeconds)
+        {
+            TUniquePtr<FKidMockServer>& Server = Servers.Add_GetRef(MakeUnique<FKidMockServer>());
+            Server->SetLatencySeconds(Latency);
+            if (!Server->Start(0))
+            {
+                return false;
+            }
+            BaseUrls.Add(Server->GetBaseUrl());
+        }
+
+        FKidEndpointSelector::FSettings Settings;
+        Settings.FailuresBeforeSwitch = FailuresBeforeSwitch;
+        Selector = MakeShared<FKidEndpointSelector, ESPMode::ThreadSafe>(BaseUrls, Settings);
+
+        TWeakPtr<FKidEndpointBenchmark, ESPMode::ThreadSafe> WeakThis = AsShared();
+        const double ProbeStart = FPlatformTime::Seconds();
+        Selector->Probe().Next([WeakThis, ProbeStart](FString SelectedBaseUrl)
+        {
+            if (TSharedPtr<FKidEndpointBenchmark, ESPMode::ThreadSafe> This = WeakThis.Pin())
+            {
+                This->OnProbed(SelectedBaseUrl, FPlatformTime::Seconds() - ProbeStart);
+            }
+        });
+        return true;
+    }
+
+    bool IsFinished() const { return bFinished; }
+
+private:
+    // indices of the servers ordered by latency
+    TArray<int32> GetServersByLatency() const
+    {
+        TArray<int32> Order;
+        for (int32 Index = 0; Index < Servers.Num(); ++Index)
+        {
+            Order.Add(Index);
+        }
+        Order.Sort([this](int32 A, int32 B) { return LatenciesSeconds[A] < LatenciesSeconds[B]; });
+        return Order;
+    }
+
+    void OnProbed(const FString& SelectedBaseUrl, double ProbeSeconds)
+    {
+        const TArray<int32> Order = GetServersByLatency();
+        const FString& Fastest = Servers[Order[0]]->GetBaseUrl();
+        UE_LOG(LogTemp, Display, TEXT("kID endpoints probed in %.0f ms, selected %s (%.0f ms latency)"), 
+                    ProbeSeconds * 1000.0, *SelectedBaseUrl, LatenciesSeconds[Order[0]] * 1000.0);
+        if (SelectedBaseUrl != Fastest)
+        {
+            Finish(FString::Printf(TEXT("expected the fastest endpoint %s"), *Fastest));
+            return;
+        }
+
+        if (Servers.Num() < 2)
+        {
+            Finish(FString());
+            return;
+        }
+
+        // take the selected region down and keep using it until the selector moves away
+        Servers[Order[0]]->Stop();
+        FailoverStart = FPlatformTime::Seconds();
+        TWeakPtr<FKidEndpointBenchmark, ESPMode::ThreadSafe> WeakThis = AsShared();
+        Selector->OnEndpointChanged().AddLambda([WeakThis](const FString& NewBaseUrl)
+        {
+            if (TSharedPtr<FKidEndpointBenchmark, ESPMode::ThreadSafe> This = WeakThis.Pin())
+            {
+                This->OnFailover(NewBaseUrl);
+            }
+        });
+        SendRequest();
+    }
+
+    void SendRequest()
+    {
+        if (bFinished)
+        {
+            return;
+        }
+
+        if (++NumRequests > FailuresBeforeSwitch * 4)
+        {
+            Finish(TEXT("the selector never failed over"));
+            return;
+        }
+
+        TWeakPtr<FKidEndpointBenchmark, ESPMode::ThreadSafe> WeakThis = AsShared();
+        HttpRequestHelper::GetRequest(Selector->GetBaseUrl() + TEXT("/age-gate/get-requirements?jurisdiction=US"), 
+                    [WeakThis](FHttpResponsePtr Response, bool bWasSuccessful)
+        {
+            if (TSharedPtr<FKidEndpointBenchmark, ESPMode::ThreadSafe> This = WeakThis.Pin())
+            {
+                This->SendRequest();
+            }
+        });
+    }
+
+    void OnFailover(const FString& NewBaseUrl)
+    {
+        if (bFinished)
+        {
+            return;
+        }
+
+        const TArray<int32> Order = GetServersByLatency();
+        const FString& NextFastest = Servers[Order[1]]->GetBaseUrl();
+        UE_LOG(LogTemp, Display, TEXT("kID endpoint failed over to %s after %d requests and %.0f ms"), 
+                    *NewBaseUrl, NumRequests, (FPlatformTime::Seconds() - FailoverStart) * 1000.0);
+        Finish(NewBaseUrl == NextFastest ? FString() : FString::Printf(TEXT("expected the next fastest endpoint %s"), *NextFastest));
+    }
+
+    void Finish(const FString& Error)
+    {
+        if (Error.IsEmpty())
+        {
+            UE_LOG(LogTemp, Display, TEXT("kID endpoint selection passed"));
+        }
+        else
+        {
+            UE_LOG(LogTemp, Error, TEXT("kID endpoint selection failed: %s"), *Error);
+        }
+
+        for (const TUniquePtr<FKidMockServer>& Server : Servers)
+        {
+            Server->Stop();
+        }
+        bFinished = true;
+    }
+
+    TArray<double> LatenciesSeconds;
+    int32 FailuresBeforeSwitch;
+
+    TArray<TUniquePtr<FKidMockServer>> Servers;
+    TSharedPtr<FKidEndpointSelector, ESPMode::ThreadSafe> Selector;
+
+    double FailoverStart = 0.0;
+    int32 NumRequests = 0;
+    bool bFinished = false;
+};
+
+static TSharedPtr<FKidEndpointBenchmark, ESPMode::ThreadSafe> ActiveEndpointBenchmark;
+
+static FAutoConsoleCommand KidEndpointBenchmarkCommand(
+    TEXT("kid.Benchmark.Endpoints"),
+    TEXT("Checks latency-based endpoint selection and failover against local stand-in servers. ")
+    TEXT("Arguments: [LatenciesMs=150,40,90] [FailuresBeforeSwitch=3]"),
+    FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+    {
+        if (ActiveEndpointBenchmark.IsValid() && !ActiveEndpointBenchmark->IsFinished())
+        {
+            UE_LOG(LogTemp, Warning, TEXT("A kID endpoint benchmark is already running."));
+            return;
+        }
+
+        TArray<FString> LatencyStrings;
+        (Args.Num() > 0 ? Args[0] : FString(TEXT("150,40,90"))).ParseIntoArray(LatencyStrings, TEXT(","));
+        TArray<double> LatenciesSeconds;
+        for (const FString& Latency : LatencyStrings)
+        {
+            LatenciesSeconds.Add(FMath::Max(0.0, FCString::Atod(*Latency)) / 1000.0);
+        }
+        if (LatenciesSeconds.IsEmpty())
+        {
+            UE_LOG(LogTemp, Error, TEXT("kid.Benchmark.Endpoints needs at least one latency."));
+            return;
+        }
+
+        const int32 FailuresBeforeSwitch = FMath::Max(1, Args.Num() > 1 ? FCString::Atoi(*Args[1]) : 3);
+        ActiveEndpointBenchmark = MakeShared<FKidEndpointBenchmark, ESPMode::ThreadSafe>(LatenciesSeconds, FailuresBeforeSwitch);
+        if (!ActiveEndpointBenchmark->Start())
+        {
+            UE_LOG(LogTemp, Error, TEXT("Could not start the kID mock servers for the endpoint benchmark."));
+            ActiveEndpointBenchmark.Reset();
+        }
+    }));
+
+#endif
@@ -0,0 +1,149 @@
+#include "KidEndpointSelector.h"
+#include "HttpModule.h"
+#include "Interfaces/IHttpRequest.h"
+#include "Interfaces/IHttpResponse.h"
+#include "HAL/PlatformTime.h"
+#include "HttpRequestHelper.h"
+
+FKidEndpointSelector::FKidEndpointSelector(const TArray<FString>& InBaseUrls, const FSettings& InSettings)
+    : Settings(InSettings)
+{
+    for (const FString& BaseUrl : InBaseUrls)
+    {
+        FKidEndpoint& Endpoint = Endpoints.AddDefaulted_GetRef();
+        Endpoint.BaseUrl = BaseUrl;
+        Endpoint.BaseUrl.RemoveFromEnd(TEXT("/"));
+        Endpoint.bHealthy = true;
+    }
+    check(Endpoints.Num() > 0);
+
+    ResponseHandle = HttpRequestHelper::OnEndpointResponse().AddRaw(this, &FKidEndpointSelector::OnResponse);
+}
+
+FKidEndpointSelector::~FKidEndpointSelector()
+{
+    HttpRequestHelper::OnEndpointResponse().Remove(ResponseHandle);
+}
+
+const FString& FKidEndpointSelector::GetBaseUrl() const
+{
+    return Endpoints[SelectedIndex].BaseUrl;
+}
+
+TFuture<FString> FKidEndpointSelector::Probe()
+{
+    if (Endpoints.Num() == 1)
+    {
+        return MakeFulfilledPromise<FString>(GetBaseUrl()).GetFuture();
+    }
+
+    TSharedRef<TKidPromise<FString>> Promise = MakeShared<TKidPromise<FString>>();
+    ProbeWaiters.Add(Promise);
+    if (PendingProbes > 0)
+    {
+        return Promise->GetFuture();
+    }
+
+    const int32 Serial = ++ProbeSerial;
+    PendingProbes = Endpoints.Num();
+    TWeakPtr<FKidEndpointSelector, ESPMode::ThreadSafe> WeakThis = AsShared();
+    for (int32 Index = 0; Index < Endpoints.Num(); ++Index)
+    {
+        TSharedRef<IHttpRequest, ESPMode::ThreadSafe> Request = FHttpModule::Get().CreateRequest();
+        Request->SetURL(Endpoints[Index].BaseUrl + Settings.ProbePath);
+        Request->SetVerb(TEXT("GET"));
+        Request->SetHeader(TEXT("accept"), TEXT("application/json"));
+        Request->SetTimeout(Settings.ProbeTimeoutSeconds);
+
+        const double StartTime = FPlatformTime::Seconds();
+        Request->OnProcessRequestComplete().BindLambda([WeakThis, Index, Serial, StartTime](FHttpRequestPtr RequestPtr, FHttpResponsePtr Response, bool bWasSuccessful)
+        {
+            if (TSharedPtr<FKidEndpointSelector, ESPMode::ThreadSafe> This = WeakThis.Pin())
+            {
+                const bool bHealthy = bWasSuccessful && Response.IsValid() && Response->GetResponseCode() < 500;
+                This->OnProbeComplete(Index, Serial, FPlatformTime::Seconds() - StartTime, bHealthy);
+            }
+        });
+        Request->ProcessRequest();
+    }
+    return Promise->GetFuture();
+}
+
+void FKidEndpointSelector::OnProbeComplete(int32 Index, int32 Serial, double Latency, bool bHealthy)
+{
+    if (Serial != ProbeSerial)
+    {
+        return;
+    }
+
+    FKidEndpoint& Endpoint = Endpoints[Index];
+    Endpoint.bHealthy = bHealthy;
+    Endpoint.LatencySeconds = Latency;
+    Endpoint.ConsecutiveFailures = 0;
+    UE_LOG(LogTemp, Log, TEXT("kID endpoint %s: %s in %.0f ms"), *Endpoint.BaseUrl, bHealthy ? TEXT("healthy") : TEXT("unhealthy"), Latency * 1000.0);
+
+    if (--PendingProbes > 0)
+    {
+        return;
+    }
+
+    Select();
+    TArray<TSharedRef<TKidPromise<FString>>> Waiters = MoveTemp(ProbeWaiters);
+    for (const TSharedRef<TKidPromise<FString>>& Waiter : Waiters)
+    {
+        Waiter->SetValue(GetBaseUrl());
+    }
+}
+
+void FKidEndpointSelector::OnResponse(const FString& Url, bool bEndpointHealthy)
+{
+    const int32 Index = Endpoints.IndexOfByPredicate([&Url](const FKidEndpoint& Endpoint) { return Url.StartsWith(Endpoint.BaseUrl); });
+    if (Index == INDEX_NONE)
+    {
+        return;
+    }
+
+    FKidEndpoint& Endpoint = Endpoints[Index];
+    if (bEndpointHealthy)
+    {
+        Endpoint.ConsecutiveFailures = 0;
+        return;
+    }
+
+    if (++Endpoint.ConsecutiveFailures < Settings.FailuresBeforeSwitch || !Endpoint.bHealthy || Endpoints.Num() == 1)
+    {
+        return;
+    }
+
+    UE_LOG(LogTemp, Warning, TEXT("kID endpoint %s failed %d times in a row"), *Endpoint.BaseUrl, Endpoint.ConsecutiveFailures);
+    Endpoint.bHealthy = false;
+    if (Index == SelectedIndex)
+    {
+        Select();
+    }
+
+    // latencies may have changed along with the failure, so the next fastest is only a stopgap
+    Probe();
+}
+
+void FKidEndpointSelector::Select()
+{
+    int32 BestIndex = INDEX_NONE;
+    for (int32 Index = 0; Index < Endpoints.Num(); ++Index)
+    {
+        if (Endpoints[Index].bHealthy && (BestIndex == INDEX_NONE || Endpoints[Index].LatencySeconds < Endpoints[BestIndex].LatencySeconds))
+        {
+            BestIndex = Index;
+        }
+    }
+
+    // with nothing healthy, stay where we are rather than hop around
+    if (BestIndex == INDEX_NONE || BestIndex == SelectedIndex)
+    {
+        return;
+    }
+
+    UE_LOG(LogTemp, Log, TEXT("kID endpoint switched from %s to %s"), *Endpoints[SelectedIndex].BaseUrl, *Endpoints[BestIndex].BaseUrl);
+    SelectedIndex = BestIndex;
+    EndpointChanged.Broadcast(GetBaseUrl());
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "KidFlow.h"
+
+struct FKidEndpoint
+{
+    FString BaseUrl;
+    bool bHealthy = false;
+    double LatencySeconds = 0.0;
+    int32 ConsecutiveFailures = 0;
+};
+
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnKidEndpointChanged, const FString& /*BaseUrl*/);
+
+// Picks the regional API endpoint to use.
+//
+// All endpoints are probed concurrently and the healthy one with the lowest round trip is
+// selected.  An endpoint is healthy while it answers, even with an error status, as long as it is
+// not a server error.  Every request the HTTP helper completes is reported here, and after a
+// number of consecutive failures against the selected endpoint the next fastest healthy one takes
+// over and all of them are probed again.
+class FKidEndpointSelector : public TSharedFromThis<FKidEndpointSelector, ESPMode::ThreadSafe>
+{
+public:
+    struct FSettings
+    {
+        // appended to each base URL to probe it
+        FString ProbePath;
+        float ProbeTimeoutSeconds = 5.0f;
+        int32 FailuresBeforeSwitch = 3;
+    };
+
+    FKidEndpointSelector(const TArray<FString>& InBaseUrls, const FSettings& InSettings);
+    ~FKidEndpointSelector();
+
+    // Probes every endpoint and resolves with the selected base URL.  Resolves straight away when
+    // only one endpoint is configured.  Probes already in flight are shared.
+    TFuture<FString> Probe();
+
+    // the selected endpoint, the first configured one until probing has finished
+    const FString& GetBaseUrl() const;
+    const TArray<FKidEndpoint>& GetEndpoints() const { return Endpoints; }
+
+    FOnKidEndpointChanged& OnEndpointChanged() { return EndpointChanged; }
+
+private:
+    void OnProbeComplete(int32 Index, int32 Serial, double Latency, bool bHealthy);
+    void OnResponse(const FString& Url, bool bEndpointHealthy);
+    void Select();
+
+    TArray<FKidEndpoint> Endpoints;
+    FSettings Settings;
+    int32 SelectedIndex = 0;
+
+    int32 ProbeSerial = 0;
+    int32 PendingProbes = 0;
+    TArray<TSharedRef<TKidPromise<FString>>> ProbeWaiters;
+
+    FDelegateHandle ResponseHandle;
+    FOnKidEndpointChanged EndpointChanged;
+};
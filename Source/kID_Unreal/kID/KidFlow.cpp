@@ -0,0 +1,146 @@
+#include "KidFlow.h"
+#include "KidTrace.h"
+#include "HAL/PlatformTime.h"
+
+const TCHAR* LexToString(EKidFlowState State)
+{
+    // the core names the states; they are widened once so logging and tracing get TCHAR pointers
+    static const TArray<FString> Names = []()
+    {
+        TArray<FString> Result;
+        for (uint8 Value = 0; Value <= static_cast<uint8>(EKidFlowState::Cancelled); ++Value)
+        {
+            Result.Add(ANSI_TO_TCHAR(KidCore::ToString(static_cast<EKidFlowState>(Value))));
+        }
+        return Result;
+    }();
+
+    const uint8 Index = static_cast<uint8>(State);
+    return Names.IsValidIndex(Index) ? *Names[Index] : TEXT("Unknown");
+}
+
+FKidFlow::FKidFlow(const FString& InName)
+    : Name(InName)
+{
+    Transitions.Add({ EKidFlowState::Idle, FPlatformTime::Seconds() });
+}
+
+bool FKidFlow::IsFinished() const
+{
+    return KidCore::IsFinalState(State);
+}
+
+void FKidFlow::TransitionTo(EKidFlowState NewState)
+{
+    if (!KidCore::CanTransition(State, NewState))
+    {
+        return;
+    }
+
+    const double Now = FPlatformTime::Seconds();
+    UE_LOG(LogTemp, Log, TEXT("kID flow %s: %s -> %s after %.3f s"), *Name, LexToString(State), LexToString(NewState),
+                Now - Transitions.Last().Timestamp);
+
+    State = NewState;
+    Transitions.Add({ NewState, Now });
+    FKidTrace::MarkFlowState(Name, LexToString(NewState));
+}
+
+void FKidFlow::Complete()
+{
+    Finish(EKidFlowState::Completed);
+}
+
+void FKidFlow::Fail()
+{
+    Finish(EKidFlowState::Failed);
+}
+
+void FKidFlow::Cancel()
+{
+    if (IsFinished())
+    {
+        return;
+    }
+    Finish(EKidFlowState::Cancelled);
+
+    // cancelling fires the request callbacks, which see a finished flow and do nothing
+    TArray<FHttpRequestPtr> PendingRequests = MoveTemp(Requests);
+    for (const FHttpRequestPtr& Request : PendingRequests)
+    {
+        if (Request.IsValid() && Request->GetStatus() == EHttpRequestStatus::Processing)
+        {
+            Request->CancelRequest();
+        }
+    }
+}
+
+void FKidFlow::Finish(EKidFlowState FinalState)
+{
+    if (IsFinished())
+    {
+        return;
+    }
+
+    const double Now = FPlatformTime::Seconds();
+    for (FKidFlowStage& Stage : Stages)
+    {
+        if (Stage.EndTime == 0.0)
+        {
+            Stage.EndTime = Now;
+        }
+    }
+
+    TransitionTo(FinalState);
+    LogTimeline();
+}
+
+void FKidFlow::BeginStage(FName Stage)
+{
+    Stages.Add({ Stage, FPlatformTime::Seconds(), 0.0 });
+}
+
+void FKidFlow::EndStage(FName Stage)
+{
+    for (int32 Index = Stages.Num() - 1; Index >= 0; --Index)
+    {
+        if (Stages[Index].Name == Stage && Stages[Index].EndTime == 0.0)
+        {
+            Stages[Index].EndTime = FPlatformTime::Seconds();
+            return;
+        }
+    }
+}
+
+bool FKidFlow::HasOpenStages() const
+{
+    return Stages.ContainsByPredicate([](const FKidFlowStage& Stage) { return Stage.EndTime == 0.0; });
+}
+
+void FKidFlow::TrackRequest(FHttpRequestPtr Request)
+{
+    Requests.RemoveAll([](const FHttpRequestPtr& Existing)
+    {
+        return !Existing.IsValid() || Existing->GetStatus() != EHttpRequestStatus::Processing;
+    });
+    Requests.Add(Request);
+}
+
+double FKidFlow::GetElapsedSeconds() const
+{
+    return Transitions.Last().Timestamp - Transitions[0].Timestamp;
+}
+
+void FKidFlow::LogTimeline() const
+{
+    UE_LOG(LogTemp, Log, TEXT("kID flow %s finished as %s in %.3f s"), *Name, LexToString(State), GetElapsedSeconds());
+    for (int32 Index = 0; Index + 1 < Transitions.Num(); ++Index)
+    {
+        UE_LOG(LogTemp, Log, TEXT("    state %-28s %8.3f s"), LexToString(Transitions[Index].State),
+                    Transitions[Index + 1].Timestamp - Transitions[Index].Timestamp);
+    }
+    for (const FKidFlowStage& Stage : Stages)
+    {
+        UE_LOG(LogTemp, Log, TEXT("    stage %-28s %8.3f s"), *Stage.Name.ToString(), Stage.EndTime - Stage.StartTime);
+    }
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Async/Async.h"
+#include "Async/Future.h"
+#include "Interfaces/IHttpRequest.h"
+#include "KidCoreFlowState.h"
+
+// The states a kID flow moves through, defined by the engine-agnostic core
+using EKidFlowState = KidCore::EFlowState;
+
+const TCHAR* LexToString(EKidFlowState State);
+
+struct FKidFlowTransition
+{
+    EKidFlowState State;
+    double Timestamp; // FPlatformTime::Seconds() when the state was entered
+};
+
+struct FKidFlowStage
+{
+    FName Name;
+    double StartTime;
+    double EndTime; // zero while the stage is still running
+};
+
+// A promise that is fulfilled with a default value if it is destroyed before being set, so a
+// request that is dropped or a step that is cancelled never leaves a broken promise behind.
+template <typename ResultType>
+class TKidPromise
+{
+public:
+    ~TKidPromise()
+    {
+        SetValue(ResultType());
+    }
+
+    TFuture<ResultType> GetFuture()
+    {
+        return Promise.GetFuture();
+    }
+
+    void SetValue(ResultType Value)
+    {
+        if (!bIsSet)
+        {
+            bIsSet = true;
+            Promise.SetValue(MoveTemp(Value));
+        }
+    }
+
+private:
+    TPromise<ResultType> Promise;
+    bool bIsSet = false;
+};
+
+// Runs Work on the thread pool and returns a future that is fulfilled back on the game thread, so
+// flow steps chained onto it always run on the game thread.
+template <typename ResultType>
+TFuture<ResultType> KidRunInBackground(TUniqueFunction<ResultType()> Work)
+{
+    TSharedRef<TKidPromise<ResultType>> Promise = MakeShared<TKidPromise<ResultType>>();
+    TFuture<ResultType> Future = Promise->GetFuture();
+
+    Async(EAsyncExecution::ThreadPool, [Promise, Work = MoveTemp(Work)]() mutable
+    {
+        ResultType Result = Work();
+        AsyncTask(ENamedThreads::GameThread, [Promise, Result = MoveTemp(Result)]() mutable
+        {
+            Promise->SetValue(MoveTemp(Result));
+        });
+    });
+    return Future;
+}
+
+// One run of a kID workflow (starting a session, upgrading a session, ...).  Every state change
+// is timestamped so individual stages can be profiled, and the whole flow, including any HTTP
+// requests still in flight, can be cancelled from the handle returned when the flow started.
+class FKidFlow : public TSharedFromThis<FKidFlow, ESPMode::ThreadSafe>
+{
+public:
+    explicit FKidFlow(const FString& InName);
+
+    const FString& GetName() const { return Name; }
+    EKidFlowState GetState() const { return State; }
+    bool IsFinished() const;
+    bool IsCancelled() const { return State == EKidFlowState::Cancelled; }
+
+    void TransitionTo(EKidFlowState NewState);
+    void Complete();
+    void Fail();
+    void Cancel();
+
+    // stages can overlap each other and the current state
+    void BeginStage(FName Stage);
+    void EndStage(FName Stage);
+    bool HasOpenStages() const;
+
+    // requests tracked here are cancelled along with the flow
+    void TrackRequest(FHttpRequestPtr Request);
+
+    const TArray<FKidFlowTransition>& GetTransitions() const { return Transitions; }
+    const TArray<FKidFlowStage>& GetStages() const { return Stages; }
+    double GetElapsedSeconds() const;
+    void LogTimeline() const;
+
+private:
+    void Finish(EKidFlowState FinalState);
+
+    FString Name;
+    EKidFlowState State = EKidFlowState::Idle;
+    TArray<FKidFlowTransition> Transitions;
+    TArray<FKidFlowStage> Stages;
+    TArray<FHttpRequestPtr> Requests;
+};
+
+typedef TSharedPtr<FKidFlow, ESPMode::ThreadSafe> FKidFlowPtr;
+typedef TSharedRef<FKidFlow, ESPMode::ThreadSafe> FKidFlowRef;
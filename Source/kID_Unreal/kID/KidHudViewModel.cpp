@@ -0,0 +1,60 @@
+#include "KidHudViewModel.h"
+
+void FKidHudViewModel::SetAuthorized(bool bInAuthorized)
+{
+    Set(bAuthorized, bInAuthorized, Authorized);
+}
+
+void FKidHudViewModel::SetSession(const TSharedPtr<FJsonObject>& InSession)
+{
+    // sessions are replaced, not edited, whenever their ID or age status changes
+    if (bSessionSet == InSession.IsValid() && (!InSession.IsValid() || Session.HasSameObject(InSession.Get())))
+    {
+        return;
+    }
+    Session = InSession;
+    bSessionSet = InSession.IsValid();
+
+    FString NewSessionId = TEXT("N/A");
+    FString NewAgeStatus = TEXT("N/A");
+    bool bNewHasSessionId = false;
+    if (InSession.IsValid())
+    {
+        bNewHasSessionId = InSession->TryGetStringField(TEXT("sessionId"), NewSessionId);
+        if (!bNewHasSessionId)
+        {
+            NewSessionId = TEXT("Default Permissions");
+        }
+        InSession->TryGetStringField(TEXT("ageStatus"), NewAgeStatus);
+    }
+
+    Set(bHasSessionId, bNewHasSessionId, SessionId);
+    Set(SessionIdText, NewSessionId, SessionId);
+    Set(AgeStatusText, NewAgeStatus, AgeStatus);
+}
+
+void FKidHudViewModel::SetChallengeId(const FString& InChallengeId)
+{
+    // compared before building the display text so an unchanged challenge costs no allocation
+    if (InChallengeId.IsEmpty() ? ChallengeIdText != TEXT("N/A") : ChallengeIdText != InChallengeId)
+    {
+        ChallengeIdText = InChallengeId.IsEmpty() ? FString(TEXT("N/A")) : InChallengeId;
+        DirtyFields |= ChallengeId;
+    }
+}
+
+void FKidHudViewModel::SetAccessMode(EKidAccessMode InMode)
+{
+    Set(Mode, InMode, AccessMode);
+}
+
+const TCHAR* FKidHudViewModel::GetAccessMode() const
+{
+    switch (Mode)
+    {
+    case EKidAccessMode::None:     return TEXT("None");
+    case EKidAccessMode::DataLite: return TEXT("Data Lite");
+    case EKidAccessMode::Full:     return TEXT("Full");
+    }
+    return TEXT("Unknown");
+}
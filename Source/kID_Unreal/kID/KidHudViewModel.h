@@ -0,0 +1,66 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Dom/JsonObject.h"
+#include "KidStateStore.h"
+
+// What the HUD and demo controls show, with a dirty flag per field.
+//
+// The workflow sets every field after each state change; a field only becomes dirty when its
+// value differs from what was last pushed, so pushing is skipped entirely when nothing changed.
+// The session is only read again when a different session object is set.
+class FKidHudViewModel
+{
+public:
+    enum EField : uint8
+    {
+        SessionId   = 1 << 0,
+        ChallengeId = 1 << 1,
+        AgeStatus   = 1 << 2,
+        AccessMode  = 1 << 3,
+        // whether there is an auth token to show any of the above with
+        Authorized  = 1 << 4,
+        All         = 0xFF
+    };
+
+    void SetAuthorized(bool bInAuthorized);
+    void SetSession(const TSharedPtr<FJsonObject>& InSession);
+    void SetChallengeId(const FString& InChallengeId);
+    void SetAccessMode(EKidAccessMode InMode);
+
+    bool IsDirty(EField Field) const { return (DirtyFields & Field) != 0; }
+    bool IsAnyDirty() const { return DirtyFields != 0; }
+    void ClearDirty() { DirtyFields = 0; }
+
+    // forces the next push to send every field, e.g. after the widgets were recreated
+    void MarkAllDirty() { DirtyFields = All; }
+
+    bool IsAuthorized() const { return bAuthorized; }
+    bool HasSessionId() const { return bHasSessionId; }
+    const FString& GetSessionId() const { return SessionIdText; }
+    const FString& GetChallengeId() const { return ChallengeIdText; }
+    const FString& GetAgeStatus() const { return AgeStatusText; }
+    const TCHAR* GetAccessMode() const;
+
+private:
+    template <typename ValueType>
+    void Set(ValueType& Value, const ValueType& NewValue, EField Field)
+    {
+        if (!(Value == NewValue))
+        {
+            Value = NewValue;
+            DirtyFields |= Field;
+        }
+    }
+
+    uint8 DirtyFields = All;
+
+    bool bAuthorized = false;
+    TWeakPtr<FJsonObject> Session;
+    bool bSessionSet = false;
+    bool bHasSessionId = false;
+    FString SessionIdText = TEXT("N/A");
+    FString ChallengeIdText = TEXT("N/A");
+    FString AgeStatusText = TEXT("N/A");
+    EKidAccessMode Mode = EKidAccessMode::DataLite;
+};
@@ -0,0 +1,168 @@
+#include "KidJsonDecoder.h"
+#include "KidCoreAdapter.h"
+#include "KidCoreSession.h"
+
+namespace
+{
+    std::string_view AsUtf8(TConstArrayView<uint8> Utf8Json)
+    {
+        return std::string_view(reinterpret_cast<const char*>(Utf8Json.GetData()), Utf8Json.Num());
+    }
+
+    template <typename ResultType>
+    bool DecodeText(FStringView Json, ResultType& OutResult)
+    {
+        FTCHARToUTF8 Converted(Json.GetData(), Json.Len());
+        return FKidJsonDecoder::Decode(TConstArrayView<uint8>(reinterpret_cast<const uint8*>(Converted.Get()), Converted.Length()), OutResult);
+    }
+}
+
+void FKidSessionSummary::GetEnabledPermissions(TSet<FName>& OutEnabled) const
+{
+    OutEnabled.Reset();
+    for (const FKidPermission& Permission : Permissions)
+    {
+        if (Permission.bEnabled)
+        {
+            OutEnabled.Add(Permission.Name);
+        }
+    }
+}
+
+bool FKidJsonDecoder::Decode(TConstArrayView<uint8> Utf8Json, FKidChallengeStatus& OutStatus)
+{
+    class FVisitor final : public KidCore::IResponseVisitor
+    {
+    public:
+        explicit FVisitor(FKidChallengeStatus& InStatus) : Status(InStatus) {}
+
+        virtual void String(KidCore::EResponseField Field, std::string_view Value) override
+        {
+            switch (Field)
+            {
+            case KidCore::EResponseField::ChallengeId:   Status.ChallengeId = KidFromUtf8(Value); break;
+            case KidCore::EResponseField::Status:        Status.Status = KidFromUtf8(Value); break;
+            case KidCore::EResponseField::SessionId:     Status.SessionId = KidFromUtf8(Value); break;
+            case KidCore::EResponseField::ApproverEmail: Status.ApproverEmail = KidFromUtf8(Value); break;
+            default: break;
+            }
+        }
+
+    private:
+        FKidChallengeStatus& Status;
+    };
+
+    FVisitor Visitor(OutStatus);
+    return KidCore::DecodeChallengeStatus(AsUtf8(Utf8Json), Visitor);
+}
+
+bool FKidJsonDecoder::Decode(TConstArrayView<uint8> Utf8Json, FKidAgeGateRequirements& OutRequirements)
+{
+    class FVisitor final : public KidCore::IResponseVisitor
+    {
+    public:
+        explicit FVisitor(FKidAgeGateRequirements& InRequirements) : Requirements(InRequirements) {}
+
+        virtual void String(KidCore::EResponseField Field, std::string_view Value) override
+        {
+            if (Field == KidCore::EResponseField::ApprovedAgeCollectionMethod)
+            {
+                Requirements.ApprovedAgeCollectionMethods.Add(KidFromUtf8(Value));
+            }
+        }
+
+        virtual void Bool(KidCore::EResponseField Field, bool bValue) override
+        {
+            switch (Field)
+            {
+            case KidCore::EResponseField::ShouldDisplay:        Requirements.bShouldDisplay = bValue; break;
+            case KidCore::EResponseField::AgeAssuranceRequired: Requirements.bAgeAssuranceRequired = bValue; break;
+            default: break;
+            }
+        }
+
+        virtual void Integer(KidCore::EResponseField Field, int32_t Value) override
+        {
+            switch (Field)
+            {
+            case KidCore::EResponseField::MinimumAge:        Requirements.MinimumAge = Value; break;
+            case KidCore::EResponseField::DigitalConsentAge: Requirements.DigitalConsentAge = Value; break;
+            case KidCore::EResponseField::CivilAge:          Requirements.CivilAge = Value; break;
+            default: break;
+            }
+        }
+
+    private:
+        FKidAgeGateRequirements& Requirements;
+    };
+
+    OutRequirements.ApprovedAgeCollectionMethods.Reset();
+    FVisitor Visitor(OutRequirements);
+    return KidCore::DecodeRequirements(AsUtf8(Utf8Json), Visitor);
+}
+
+bool FKidJsonDecoder::Decode(TConstArrayView<uint8> Utf8Json, FKidSessionSummary& OutSession)
+{
+    class FVisitor final : public KidCore::IResponseVisitor
+    {
+    public:
+        explicit FVisitor(FKidSessionSummary& InSession) : Session(InSession) {}
+
+        virtual void String(KidCore::EResponseField Field, std::string_view Value) override
+        {
+            switch (Field)
+            {
+            case KidCore::EResponseField::SessionId:           Session.SessionId = KidFromUtf8(Value); break;
+            case KidCore::EResponseField::ETag:                Session.ETag = KidFromUtf8(Value); break;
+            case KidCore::EResponseField::AgeStatus:           Session.AgeStatus = KidFromUtf8(Value); break;
+            case KidCore::EResponseField::PermissionName:      Session.Permissions.Last().Name = KidNameFromUtf8(Value); break;
+            case KidCore::EResponseField::PermissionManagedBy: Session.Permissions.Last().ManagedBy = KidFromUtf8(Value); break;
+            default: break;
+            }
+        }
+
+        virtual void Bool(KidCore::EResponseField Field, bool bValue) override
+        {
+            if (Field == KidCore::EResponseField::PermissionEnabled)
+            {
+                Session.Permissions.Last().bEnabled = bValue;
+            }
+        }
+
+        virtual void BeginPermission() override
+        {
+            Session.Permissions.AddDefaulted();
+        }
+
+        virtual void EndPermission(bool bHasName) override
+        {
+            if (!bHasName)
+            {
+                Session.Permissions.Pop(EAllowShrinking::No);
+            }
+        }
+
+    private:
+        FKidSessionSummary& Session;
+    };
+
+    // the array keeps its allocation, so a summary that is decoded into again stops allocating for it
+    OutSession.Permissions.Reset();
+    FVisitor Visitor(OutSession);
+    return KidCore::DecodeSession(AsUtf8(Utf8Json), Visitor);
+}
+
+bool FKidJsonDecoder::Decode(FStringView Json, FKidChallengeStatus& OutStatus)
+{
+    return DecodeText(Json, OutStatus);
+}
+
+bool FKidJsonDecoder::Decode(FStringView Json, FKidAgeGateRequirements& OutRequirements)
+{
+    return DecodeText(Json, OutRequirements);
+}
+
+bool FKidJsonDecoder::Decode(FStringView Json, FKidSessionSummary& OutSession)
+{
+    return DecodeText(Json, OutSession);
+}
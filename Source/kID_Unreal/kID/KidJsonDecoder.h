@@ -0,0 +1,51 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "KidRequirementsCache.h"
+
+// Status of a consent challenge, as answered by /challenge/await and pushed by /challenge/subscribe
+struct FKidChallengeStatus
+{
+    FString ChallengeId;
+    FString Status;
+    FString SessionId;
+    FString ApproverEmail;
+};
+
+struct FKidPermission
+{
+    FName Name;
+    bool bEnabled = false;
+    FString ManagedBy;
+};
+
+// The parts of a session that callers holding many sessions keep, e.g. the server-side permission cache
+struct FKidSessionSummary
+{
+    FString SessionId;
+    FString ETag;
+    FString AgeStatus;
+    TArray<FKidPermission> Permissions;
+
+    void GetEnabledPermissions(TSet<FName>& OutEnabled) const;
+};
+
+// Decodes kID responses straight into structs with the pull decoders of the engine-agnostic core
+// in kIDCore, instead of building an FJsonObject DOM and reading a handful of fields out of it.
+// Fields the structs do not have are skipped without being materialized, and the core hands over
+// the others as views into the response, so each string is converted once, into its FString or
+// FName.  Response bodies are read as the UTF-8 bytes they arrive in; text that is already an
+// engine string is converted to UTF-8 first.
+//
+// Code that keeps or forwards the whole session, e.g. the workflow's saved state, still uses the DOM.
+class FKidJsonDecoder
+{
+public:
+    static bool Decode(TConstArrayView<uint8> Utf8Json, FKidChallengeStatus& OutStatus);
+    static bool Decode(TConstArrayView<uint8> Utf8Json, FKidAgeGateRequirements& OutRequirements);
+    static bool Decode(TConstArrayView<uint8> Utf8Json, FKidSessionSummary& OutSession);
+
+    static bool Decode(FStringView Json, FKidChallengeStatus& OutStatus);
+    static bool Decode(FStringView Json, FKidAgeGateRequirements& OutRequirements);
+    static bool Decode(FStringView Json, FKidSessionSummary& OutSession);
+};
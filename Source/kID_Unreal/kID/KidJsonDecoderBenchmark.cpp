@@ -0,0 +1,199 @@
+#include "CoreMinimal.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
+#include "HAL/PlatformTLS.h"
+#include "KidJsonDecoder.h"
+#include "KidSessionApi.h"
+#include "Json.h"
+
+#if !UE_BUILD_SHIPPING
+
+// Compares decoding a session with the pull decoder against deserializing it into a DOM and
+// reading the permissions out of it, the way the permission cache used to.  Both run over the
+// same generated session, which carries a large permissions array, and must agree.  The pull
+// decoder reads the UTF-8 bytes, as it does with response content.
+//
+// Allocations are counted by putting a forwarding allocator in front of GMalloc while each side
+// runs.  Only allocations made by the game thread are counted.
+//
+//   kid.Benchmark.JsonDecode [Permissions=1000] [Iterations=200]
+namespace
+{
+    class FKidCountingMalloc final : public FMalloc
+    {
+    public:
+        explicit FKidCountingMalloc(FMalloc* InInner)
+            : Inner(InInner)
+            , OwnerThreadId(FPlatformTLS::GetCurrentThreadId())
+        {
+        }
+
+        virtual void* Malloc(SIZE_T Count, uint32 Alignment) override
+        {
+            Record(Count);
+            return Inner->Malloc(Count, Alignment);
+        }
+
+        virtual void* TryMalloc(SIZE_T Count, uint32 Alignment) override
+        {
+            Record(Count);
+            return Inner->TryMalloc(Count, Alignment);
+        }
+
+        virtual void* Realloc(void* Original, SIZE_T Count, uint32 Alignment) override
+        {
+            Record(Count);
+            return Inner->Realloc(Original, Count, Alignment);
+        }
+
+        virtual void* TryRealloc(void* Original, SIZE_T Count, uint32 Alignment) override
+        {
+            Record(Count);
+            return Inner->TryRealloc(Original, Count, Alignment);
+        }
+
+        virtual void Free(void* Original) override { Inner->Free(Original); }
+        virtual SIZE_T QuantizeSize(SIZE_T Count, uint32 Alignment) override { return Inner->QuantizeSize(Count, Alignment); }
+        virtual bool GetAllocationSize(void* Original, SIZE_T& SizeOut) override { return Inner->GetAllocationSize(Original, SizeOut); }
+        virtual void Trim(bool bTrimThreadCaches) override { Inner->Trim(bTrimThreadCaches); }
+        virtual void SetupTLSCachesOnCurrentThread() override { Inner->SetupTLSCachesOnCurrentThread(); }
+        virtual void ClearAndDisableTLSCachesOnCurrentThread() override { Inner->ClearAndDisableTLSCachesOnCurrentThread(); }
+        virtual void InitializeStatsMetadata() override { Inner->InitializeStatsMetadata(); }
+        virtual void GetAllocatorStats(FGenericMemoryStats& OutStats) override { Inner->GetAllocatorStats(OutStats); }
+        virtual void DumpAllocatorStats(FOutputDevice& Ar) override { Inner->DumpAllocatorStats(Ar); }
+        virtual bool IsInternallyThreadSafe() const override { return Inner->IsInternallyThreadSafe(); }
+        virtual bool ValidateHeap() override { return Inner->ValidateHeap(); }
+        virtual const TCHAR* GetDescriptiveName() override { return TEXT("kID counting proxy"); }
+
+        void Reset()
+        {
+            NumAllocations = 0;
+            NumBytes = 0;
+        }
+
+        int64 NumAllocations = 0;
+        int64 NumBytes = 0;
+
+    private:
+        void Record(SIZE_T Count)
+        {
+            if (FPlatformTLS::GetCurrentThreadId() == OwnerThreadId)
+            {
+                NumAllocations++;
+                NumBytes += Count;
+            }
+        }
+
+        FMalloc* Inner;
+        uint32 OwnerThreadId;
+    };
+
+    struct FDecodeRun
+    {
+        double Seconds = 0.0;
+        int64 NumAllocations = 0;
+        int64 NumBytes = 0;
+    };
+
+    // Runs Decode with the counting proxy in front of GMalloc.  The proxy forwards everything, so
+    // memory allocated before the swap can be freed through it and the other way round.
+    template <typename DecodeFunc>
+    FDecodeRun MeasureDecode(int32 NumIterations, DecodeFunc&& Decode)
+    {
+        // never destroyed, since another thread may still be inside it when GMalloc is put back
+        static FKidCountingMalloc* CountingMalloc = new FKidCountingMalloc(GMalloc);
+        check(IsInGameThread());
+
+        FDecodeRun Run;
+        FMalloc* Previous = GMalloc;
+        CountingMalloc->Reset();
+        GMalloc = CountingMalloc;
+
+        const double Start = FPlatformTime::Seconds();
+        for (int32 Iteration = 0; Iteration < NumIterations; ++Iteration)
+        {
+            Decode();
+        }
+        Run.Seconds = FPlatformTime::Seconds() - Start;
+
+        GMalloc = Previous;
+        Run.NumAllocations = CountingMalloc->NumAllocations;
+        Run.NumBytes = CountingMalloc->NumBytes;
+        return Run;
+    }
+
+    FString MakeSessionJson(int32 NumPermissions)
+    {
+        TStringBuilder<256> Json;
+        Json << TEXT("{\"sessionId\":\"6d1f9a52-4c4e-4b0c-8a43-1f0e5b3c2d71\",\"etag\":\"W/\\\"42\\\"\",")
+             << TEXT("\"status\":\"ACTIVE\",\"ageStatus\":\"LEGAL_ADULT\",\"jurisdiction\":\"US-CA\",\"dateOfBirth\":\"2012-05-17\",")
+             << TEXT("\"player\":{\"displayName\":\"Player\",\"links\":[{\"rel\":\"self\",\"href\":\"/session/get\"}]},")
+             << TEXT("\"permissions\":[");
+        for (int32 Index = 0; Index < NumPermissions; ++Index)
+        {
+            Json.Appendf(TEXT("%s{\"name\":\"feature-%d\",\"enabled\":%s,\"managedBy\":\"%s\",\"description\":\"Permission %d\"}"),
+                        Index > 0 ? TEXT(",") : TEXT(""), Index, Index % 3 != 0 ? TEXT("true") : TEXT("false"),
+                        Index % 2 == 0 ? TEXT("GUARDIAN") : TEXT("PLAYER"), Index);
+        }
+        Json << TEXT("]}");
+        return FString(Json.ToView());
+    }
+
+    void RunJsonDecodeBenchmark(int32 NumPermissions, int32 NumIterations)
+    {
+        const FString Json = MakeSessionJson(NumPermissions);
+
+        TSet<FName> DomEnabled;
+        FString DomETag;
+        const FDecodeRun DomRun = MeasureDecode(NumIterations, [&Json, &DomEnabled, &DomETag]()
+        {
+            TSharedPtr<FJsonObject> Session;
+            TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(Json);
+            if (FJsonSerializer::Deserialize(Reader, Session))
+            {
+                DomETag = FKidSessionApi::GetETag(Session);
+                FKidSessionApi::GetEnabledPermissions(Session, DomEnabled);
+            }
+        });
+
+        const FTCHARToUTF8 Utf8(*Json, Json.Len());
+        const TArray<uint8> Content(reinterpret_cast<const uint8*>(Utf8.Get()), Utf8.Length());
+
+        TSet<FName> PullEnabled;
+        FKidSessionSummary Summary;
+        bool bDecoded = true;
+        const FDecodeRun PullRun = MeasureDecode(NumIterations, [&Content, &PullEnabled, &Summary, &bDecoded]()
+        {
+            bDecoded &= FKidJsonDecoder::Decode(Content, Summary);
+            Summary.GetEnabledPermissions(PullEnabled);
+        });
+
+        UE_LOG(LogTemp, Display, TEXT("kID JSON decode, %d permissions (%d KB), %d iterations:"),
+                    NumPermissions, static_cast<int32>(Json.Len() * sizeof(TCHAR) / 1024), NumIterations);
+        UE_LOG(LogTemp, Display, TEXT("  DOM  %8.1f us per session, %7.1f allocations, %9.1f KB allocated"),
+                    DomRun.Seconds * 1e6 / NumIterations, double(DomRun.NumAllocations) / NumIterations,
+                    double(DomRun.NumBytes) / NumIterations / 1024.0);
+        UE_LOG(LogTemp, Display, TEXT("  pull %8.1f us per session, %7.1f allocations, %9.1f KB allocated (%.1fx faster)"),
+                    PullRun.Seconds * 1e6 / NumIterations, double(PullRun.NumAllocations) / NumIterations,
+                    double(PullRun.NumBytes) / NumIterations / 1024.0, DomRun.Seconds / FMath::Max(PullRun.Seconds, 1e-9));
+
+        if (!bDecoded || Summary.ETag != DomETag || PullEnabled.Num() != DomEnabled.Num() || !PullEnabled.Includes(DomEnabled))
+        {
+            UE_LOG(LogTemp, Error, TEXT("kID JSON decode disagreed with the DOM: %d enabled permissions against %d"),
+                        PullEnabled.Num(), DomEnabled.Num());
+        }
+    }
+}
+
+static FAutoConsoleCommand KidJsonDecodeBenchmarkCommand(
+    TEXT("kid.Benchmark.JsonDecode"),
+    TEXT("Compares decoding a session with the pull decoder against building a DOM, in time and allocations. ")
+    TEXT("Arguments: [Permissions=1000] [Iterations=200]"),
+    FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+    {
+        const int32 NumPermissions = FMath::Max(0, Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 1000);
+        const int32 NumIterations = FMath::Max(1, Args.Num() > 1 ? FCString::Atoi(*Args[1]) : 200);
+        RunJsonDecodeBenchmark(NumPermissions, NumIterations);
+    }));
+
+#endif
@@ -0,0 +1,681 @@
+#include "KidLoadGeneratorCommandlet.h"
+#include "HttpRequestHelper.h"
+#include "KidMockServer.h"
+#include "KidRequestBody.h"
+#include "KidWorkflow.h"
+#include "Containers/Ticker.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Json.h"
+#include "UObject/StrongObjectPtr.h"
+
+#if !UE_BUILD_SHIPPING
+
+namespace
+{
+    // name under which the time spent in a flow state is reported, or null for states that only
+    // wait on the player
+    const TCHAR* GetStepName(EKidFlowState State)
+    {
+        switch (State)
+        {
+        case EKidFlowState::RestoringChallenge:         return TEXT("challenge/get");
+        case EKidFlowState::RefreshingSession:          return TEXT("session/get");
+        case EKidFlowState::FetchingRequirements:       return TEXT("age-gate/get-requirements");
+        case EKidFlowState::CheckingAge:                return TEXT("age-gate/check");
+        case EKidFlowState::FetchingDefaultPermissions: return TEXT("age-gate/get-default-permissions");
+        case EKidFlowState::UpgradingSession:           return TEXT("session/upgrade");
+        case EKidFlowState::AwaitingConsent:            return TEXT("challenge/await");
+        default:                                        return nullptr;
+        }
+    }
+
+    double GetPercentile(const TArray<double>& Sorted, double Percentile)
+    {
+        const int32 Rank = FMath::CeilToInt(Percentile / 100.0 * Sorted.Num()) - 1;
+        return Sorted.Num() > 0 ? Sorted[FMath::Clamp(Rank, 0, Sorted.Num() - 1)] : 0.0;
+    }
+}
+
+// Drives the virtual players of one run.  Everything happens on the game thread, from the ticks
+// of the commandlet's loop and the HTTP completions it dispatches.
+class FKidLoadGenerator : public TSharedFromThis<FKidLoadGenerator>
+{
+public:
+    struct FSettings
+    {
+        // regional endpoints, probed by every player at startup
+        TArray<FString> Endpoints;
+        FString ApiKey = TEXT("loadtest");
+        int32 NumPlayers = 200;
+        int32 Concurrency = 50;
+
+        // how long a player spends on the age gate, while the default permissions are prefetched
+        double AgeGateSeconds = 0.5;
+        double ApproveAfterSeconds = 0.25;
+        FString Jurisdiction = TEXT("US-CA");
+
+        // adults pass the age gate, and the others are young enough for it to be challenged
+        int32 AdultPercent = 50;
+        FString AdultDateOfBirth = TEXT("1990-01-01");
+        FString ChildDateOfBirth = TEXT("2015-01-01");
+
+        // requested together, so they share one /session/upgrade
+        TArray<FString> UpgradeFeatures = { TEXT("voice-chat"), TEXT("text-chat-private") };
+    };
+
+    explicit FKidLoadGenerator(const FSettings& InSettings)
+        : Settings(InSettings)
+        , StorageDirectory(FPaths::ProjectSavedDir() / TEXT("kID") / TEXT("LoadGenerator"))
+    {
+    }
+
+    ~FKidLoadGenerator()
+    {
+        for (FVirtualPlayer& Player : Players)
+        {
+            if (Player.Workflow.IsValid())
+            {
+                Player.Workflow->CleanUp();
+            }
+        }
+        IFileManager::Get().DeleteDirectory(*StorageDirectory, false, true);
+    }
+
+    void Start()
+    {
+        IFileManager::Get().DeleteDirectory(*StorageDirectory, false, true);
+
+        Players.SetNum(Settings.NumPlayers);
+        for (int32 Index = 0; Index < Players.Num(); ++Index)
+        {
+            // spread evenly over the run, so adults also start on installs that children used
+            Players[Index].Index = Index;
+            Players[Index].bAdult = (Index + 1) * Settings.AdultPercent / 100 > Index * Settings.AdultPercent / 100;
+        }
+
+        for (int32 Install = Settings.Concurrency - 1; Install >= 0; --Install)
+        {
+            FreeInstalls.Add(Install);
+        }
+        StartTime = FPlatformTime::Seconds();
+    }
+
+    void Tick(double Now)
+    {
+        while (NumActive < Settings.Concurrency && NextPlayer < Players.Num())
+        {
+            StartPlayer(Players[NextPlayer++], Now);
+        }
+
+        for (FVirtualPlayer& Player : Players)
+        {
+            if (Player.Phase == EPhase::Waiting || Player.Phase == EPhase::Done)
+            {
+                continue;
+            }
+            if (Player.StartupFlow.IsValid() && Player.StartupFlow->IsFinished())
+            {
+                OnStartupFinished(Player);
+            }
+            if (Player.SubmitAt > 0.0 && Now >= Player.SubmitAt)
+            {
+                SubmitAgeGate(Player, Now);
+            }
+            if (Player.ApproveAt > 0.0 && Now >= Player.ApproveAt)
+            {
+                Approve(Player);
+            }
+            if (Player.Flow.IsValid() && Player.Flow->IsFinished())
+            {
+                OnFlowFinished(Player, Now);
+            }
+        }
+    }
+
+    bool IsFinished() const { return NumFinished == Players.Num(); }
+    int32 GetNumFailed() const { return NumFailed; }
+
+    void Report(const FString& ReportPath, int32 NumServerRequests) const
+    {
+        const double Elapsed = (EndTime > 0.0 ? EndTime : FPlatformTime::Seconds()) - StartTime;
+
+        TSharedRef<FJsonObject> JsonObject = MakeShared<FJsonObject>();
+        JsonObject->SetStringField(TEXT("endpoints"), FString::Join(Settings.Endpoints, TEXT(",")));
+        JsonObject->SetNumberField(TEXT("players"), Players.Num());
+        JsonObject->SetNumberField(TEXT("concurrency"), Settings.Concurrency);
+        JsonObject->SetNumberField(TEXT("completed"), NumFinished - NumFailed);
+        JsonObject->SetNumberField(TEXT("failed"), NumFailed);
+        JsonObject->SetNumberField(TEXT("elapsedSeconds"), Elapsed);
+        JsonObject->SetNumberField(TEXT("playersPerSecond"), Elapsed > 0.0 ? (NumFinished - NumFailed) / Elapsed : 0.0);
+        if (NumServerRequests >= 0)
+        {
+            JsonObject->SetNumberField(TEXT("serverRequests"), NumServerRequests);
+            JsonObject->SetNumberField(TEXT("serverRequestsPerSecond"), Elapsed > 0.0 ? NumServerRequests / Elapsed : 0.0);
+        }
+
+        TSharedRef<FJsonObject> PolicyObject = MakeShared<FJsonObject>();
+        PolicyObject->SetNumberField(TEXT("applied"), PolicyStats.Applied);
+        PolicyObject->SetNumberField(TEXT("confirmed"), PolicyStats.Confirmed);
+        PolicyObject->SetNumberField(TEXT("contradicted"), PolicyStats.Contradicted);
+        PolicyObject->SetNumberField(TEXT("retracted"), PolicyStats.Retracted);
+        JsonObject->SetObjectField(TEXT("policyPredictions"), PolicyObject);
+
+        TSharedRef<FJsonObject> PrefetchObject = MakeShared<FJsonObject>();
+        PrefetchObject->SetNumberField(TEXT("issued"), PrefetchStats.Issued);
+        PrefetchObject->SetNumberField(TEXT("hits"), PrefetchStats.Hits);
+        PrefetchObject->SetNumberField(TEXT("notReady"), PrefetchStats.NotReady);
+        PrefetchObject->SetNumberField(TEXT("failed"), PrefetchStats.Failed);
+        PrefetchObject->SetNumberField(TEXT("notAdult"), PrefetchStats.NotAdult);
+        PrefetchObject->SetNumberField(TEXT("retracted"), PrefetchStats.Retracted);
+        JsonObject->SetObjectField(TEXT("defaultPermissionsPrefetch"), PrefetchObject);
+
+        FString Csv = TEXT("step,count,errors,errorRate,meanMs,p50Ms,p90Ms,p99Ms,maxMs\n");
+        TArray<TSharedPtr<FJsonValue>> StepArray;
+
+        UE_LOG(LogTemp, Display, TEXT("kID load generator: %d of %d players completed in %.1f s (%.1f players/s), %d failed"),
+                    NumFinished - NumFailed, Players.Num(), Elapsed, Elapsed > 0.0 ? (NumFinished - NumFailed) / Elapsed : 0.0, NumFailed);
+        UE_LOG(LogTemp, Display, TEXT("    policy predictions: %d applied, %d confirmed, %d contradicted, %d retracted"),
+                    PolicyStats.Applied, PolicyStats.Confirmed, PolicyStats.Contradicted, PolicyStats.Retracted);
+        UE_LOG(LogTemp, Display, TEXT("    default permissions prefetch: %d issued, %d hits, %d not ready, %d failed, %d not adult, %d retracted"),
+                    PrefetchStats.Issued, PrefetchStats.Hits, PrefetchStats.NotReady, PrefetchStats.Failed, PrefetchStats.NotAdult, PrefetchStats.Retracted);
+
+        for (const TPair<FString, FStep>& Pair : Steps)
+        {
+            TArray<double> Sorted = Pair.Value.LatenciesMs;
+            Sorted.Sort();
+
+            double Sum = 0.0;
+            for (double Latency : Sorted)
+            {
+                Sum += Latency;
+            }
+
+            const int32 Count = Sorted.Num();
+            const int32 Errors = Pair.Value.Errors;
+            const double ErrorRate = Count + Errors > 0 ? static_cast<double>(Errors) / (Count + Errors) : 0.0;
+            const double Mean = Count > 0 ? Sum / Count : 0.0;
+            const double P50 = GetPercentile(Sorted, 50.0);
+            const double P90 = GetPercentile(Sorted, 90.0);
+            const double P99 = GetPercentile(Sorted, 99.0);
+            const double Max = Count > 0 ? Sorted.Last() : 0.0;
+
+            TSharedRef<FJsonObject> StepObject = MakeShared<FJsonObject>();
+            StepObject->SetStringField(TEXT("step"), Pair.Key);
+            StepObject->SetNumberField(TEXT("count"), Count);
+            StepObject->SetNumberField(TEXT("errors"), Errors);
+            StepObject->SetNumberField(TEXT("errorRate"), ErrorRate);
+            StepObject->SetNumberField(TEXT("meanMs"), Mean);
+            StepObject->SetNumberField(TEXT("p50Ms"), P50);
+            StepObject->SetNumberField(TEXT("p90Ms"), P90);
+            StepObject->SetNumberField(TEXT("p99Ms"), P99);
+            StepObject->SetNumberField(TEXT("maxMs"), Max);
+            StepArray.Add(MakeShared<FJsonValueObject>(StepObject));
+
+            Csv += FString::Printf(TEXT("%s,%d,%d,%.4f,%.2f,%.2f,%.2f,%.2f,%.2f\n"), *Pair.Key, Count, Errors, ErrorRate, Mean, P50, P90, P99, Max);
+
+            UE_LOG(LogTemp, Display, TEXT("    %-34s %6d ok %5d errors (%5.1f%%)  mean %8.1f ms  p50 %8.1f ms  p90 %8.1f ms  p99 %8.1f ms  max %8.1f ms"),
+                        *Pair.Key, Count, Errors, ErrorRate * 100.0, Mean, P50, P90, P99, Max);
+        }
+        JsonObject->SetArrayField(TEXT("steps"), StepArray);
+
+        FString Json;
+        TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&Json);
+        FJsonSerializer::Serialize(JsonObject, Writer);
+
+        if (FFileHelper::SaveStringToFile(Json, *(ReportPath + TEXT(".json"))) && FFileHelper::SaveStringToFile(Csv, *(ReportPath + TEXT(".csv"))))
+        {
+            UE_LOG(LogTemp, Display, TEXT("kID load generator report written to %s.json and .csv"), *ReportPath);
+        }
+        else
+        {
+            UE_LOG(LogTemp, Error, TEXT("Could not write the kID load generator report to %s"), *ReportPath);
+        }
+    }
+
+private:
+    enum class EPhase : uint8
+    {
+        Waiting,
+        Initializing,
+        StartingSession,
+        Upgrading,
+        Done
+    };
+
+    struct FVirtualPlayer
+    {
+        int32 Index = 0;
+        int32 Install = INDEX_NONE;
+        bool bAdult = false;
+        EPhase Phase = EPhase::Waiting;
+        double StartTime = 0.0;
+        TStrongObjectPtr<UKidWorkflow> Workflow;
+        FKidFlowPtr StartupFlow;
+        FKidFlowPtr Flow;
+
+        // the age gate being shown, submitted once the player has taken their time over it
+        TFunction<void(const FString&)> SubmitAgeGate;
+        double SubmitAt = 0.0;
+        double SubmittedAt = 0.0;
+
+        // when the challenge being shown is approved, as a parent would
+        double ApproveAt = 0.0;
+    };
+
+    struct FStep
+    {
+        TArray<double> LatenciesMs;
+        int32 Errors = 0;
+    };
+
+    void StartPlayer(FVirtualPlayer& Player, double Now)
+    {
+        NumActive++;
+        Player.Phase = EPhase::Initializing;
+        Player.StartTime = Now;
+        Player.Install = FreeInstalls.Pop(EAllowShrinking::No);
+
+        Player.Workflow = TStrongObjectPtr<UKidWorkflow>(NewObject<UKidWorkflow>());
+        Player.Workflow->SetEndpoints(Settings.Endpoints);
+        Player.Workflow->SetApiKey(Settings.ApiKey);
+        Player.Workflow->SetStateDirectory(StorageDirectory / FString::Printf(TEXT("Install%d"), Player.Install));
+        Player.Workflow->SetUi(MakeUi(Player.Index));
+
+        TWeakPtr<FKidLoadGenerator> WeakThis = AsShared();
+        const int32 Index = Player.Index;
+        Player.StartupFlow = Player.Workflow->Initialize([WeakThis, Index](bool bTokenIssued)
+        {
+            if (TSharedPtr<FKidLoadGenerator> This = WeakThis.Pin())
+            {
+                This->OnInitialized(This->Players[Index], bTokenIssued);
+            }
+        });
+    }
+
+    // stands in for the widgets a real player would answer
+    FKidWorkflowUi MakeUi(int32 Index)
+    {
+        TWeakPtr<FKidLoadGenerator> WeakThis = AsShared();
+        FKidWorkflowUi Ui;
+        Ui.ShowAgeGate = [WeakThis, Index](const FKidAgeGateRequirements& Requirements, TFunction<void(const FString&)> Submit)
+        {
+            if (TSharedPtr<FKidLoadGenerator> This = WeakThis.Pin())
+            {
+                FVirtualPlayer& Player = This->Players[Index];
+                Player.SubmitAgeGate = MoveTemp(Submit);
+                Player.SubmitAt = FPlatformTime::Seconds() + This->Settings.AgeGateSeconds;
+            }
+        };
+        Ui.ShowAgeAssurance = [](int32 Age, TFunction<void(bool, int32, int32)> OnResponse)
+        {
+            OnResponse(true, Age, Age);
+        };
+        Ui.ShowChallenge = [WeakThis, Index](const FKidSavedChallenge& Challenge)
+        {
+            if (TSharedPtr<FKidLoadGenerator> This = WeakThis.Pin())
+            {
+                This->Players[Index].ApproveAt = FPlatformTime::Seconds() + This->Settings.ApproveAfterSeconds;
+            }
+        };
+
+        // how long after the age gate the player could play, which for an adult is before
+        // /age-gate/check answers when the cached policy or the prefetched defaults are used
+        Ui.UpdateHUD = [WeakThis, Index](const FKidHudViewModel& ViewModel)
+        {
+            TSharedPtr<FKidLoadGenerator> This = WeakThis.Pin();
+            if (!This)
+            {
+                return;
+            }
+
+            FVirtualPlayer& Player = This->Players[Index];
+            if (Player.SubmittedAt > 0.0 && Player.Workflow.IsValid() && Player.Workflow->GetState().GetMode() == EKidAccessMode::Full)
+            {
+                This->AddSample(Player.bAdult ? TEXT("adult/age-gate-to-play") : TEXT("child/age-gate-to-play"), FPlatformTime::Seconds() - Player.SubmittedAt);
+                Player.SubmittedAt = 0.0;
+            }
+        };
+        return Ui;
+    }
+
+    void OnInitialized(FVirtualPlayer& Player, bool bTokenIssued)
+    {
+        if (Player.Phase != EPhase::Initializing)
+        {
+            return;
+        }
+
+        const double Now = FPlatformTime::Seconds();
+        if (!bTokenIssued)
+        {
+            AddError(TEXT("initialize"));
+            FinishPlayer(Player, false, Now);
+            return;
+        }
+        AddSample(TEXT("initialize"), Now - Player.StartTime);
+
+        Player.Flow = Player.Workflow->StartKidSession(Settings.Jurisdiction);
+        if (!Player.Flow.IsValid())
+        {
+            AddError(TEXT("start-session"));
+            FinishPlayer(Player, false, Now);
+            return;
+        }
+        Player.Phase = EPhase::StartingSession;
+    }
+
+    void OnStartupFinished(FVirtualPlayer& Player)
+    {
+        // the steps of startup overlap, so each is timed by its own stage rather than by transitions
+        if (Player.StartupFlow->GetState() == EKidFlowState::Completed)
+        {
+            for (const FKidFlowStage& Stage : Player.StartupFlow->GetStages())
+            {
+                AddSample(TEXT("startup/") + Stage.Name.ToString(), Stage.EndTime - Stage.StartTime);
+            }
+        }
+        Player.StartupFlow.Reset();
+    }
+
+    void SubmitAgeGate(FVirtualPlayer& Player, double Now)
+    {
+        TFunction<void(const FString&)> Submit = MoveTemp(Player.SubmitAgeGate);
+        Player.SubmitAgeGate = nullptr;
+        Player.SubmitAt = 0.0;
+        Player.SubmittedAt = Now;
+        Submit(Player.bAdult ? Settings.AdultDateOfBirth : Settings.ChildDateOfBirth);
+    }
+
+    void OnFlowFinished(FVirtualPlayer& Player, double Now)
+    {
+        const FKidFlow& Flow = *Player.Flow;
+        const bool bCompleted = Flow.GetState() == EKidFlowState::Completed;
+
+        // the state a failed flow ended in is the step that failed
+        const TArray<FKidFlowTransition>& Transitions = Flow.GetTransitions();
+        for (int32 Index = 0; Index + 1 < Transitions.Num(); ++Index)
+        {
+            if (const TCHAR* StepName = GetStepName(Transitions[Index].State))
+            {
+                if (!bCompleted && Index + 2 == Transitions.Num())
+                {
+                    AddError(StepName);
+                }
+                else
+                {
+                    AddSample(StepName, Transitions[Index + 1].Timestamp - Transitions[Index].Timestamp);
+                }
+            }
+        }
+
+        const TCHAR* FlowName = Player.Phase == EPhase::StartingSession ? TEXT("start-session") : TEXT("upgrade");
+        if (!bCompleted || Player.Workflow->GetState().GetMode() != EKidAccessMode::Full)
+        {
+            AddError(FlowName);
+            FinishPlayer(Player, false, Now);
+            return;
+        }
+        AddSample(FlowName, Flow.GetElapsedSeconds());
+
+        if (Player.Phase == EPhase::StartingSession)
+        {
+            // requested in the same frame, so the features join one batch and share its flow
+            Player.Flow.Reset();
+            for (const FString& Feature : Settings.UpgradeFeatures)
+            {
+                Player.Flow = Player.Workflow->UpgradeSession(Feature, []() {});
+            }
+            Player.Phase = EPhase::Upgrading;
+            if (!Player.Flow.IsValid())
+            {
+                AddError(TEXT("upgrade"));
+                FinishPlayer(Player, false, Now);
+            }
+        }
+        else
+        {
+            FinishPlayer(Player, true, Now);
+        }
+    }
+
+    void Approve(FVirtualPlayer& Player)
+    {
+        Player.ApproveAt = 0.0;
+
+        const FString ChallengeId = Player.Workflow->GetState().GetChallengeId();
+        if (ChallengeId.IsEmpty())
+        {
+            return;
+        }
+
+        FKidSetChallengeStatusRequest Request;
+        Request.Status = TEXTVIEW("PASS");
+        Request.ChallengeId = ChallengeId;
+
+        // the challenge lives on the endpoint the player's startup probe selected
+        TWeakPtr<FKidLoadGenerator> WeakThis = AsShared();
+        const double RequestTime = FPlatformTime::Seconds();
+        HttpRequestHelper::PostRequestWithAuthAsync(Player.Workflow->GetBaseUrl() + TEXT("/test/set-challenge-status"), KidSerializeRequest(Request),
+                    Player.Workflow->GetAuthToken()).Next([WeakThis, RequestTime](FKidHttpResult Result)
+        {
+            if (TSharedPtr<FKidLoadGenerator> This = WeakThis.Pin())
+            {
+                if (Result.IsOk())
+                {
+                    This->AddSample(TEXT("test/set-challenge-status"), FPlatformTime::Seconds() - RequestTime);
+                }
+                else
+                {
+                    This->AddError(TEXT("test/set-challenge-status"));
+                }
+            }
+        });
+    }
+
+    void FinishPlayer(FVirtualPlayer& Player, bool bSucceeded, double Now)
+    {
+        if (bSucceeded)
+        {
+            AddSample(TEXT("player"), Now - Player.StartTime);
+        }
+        else
+        {
+            AddError(TEXT("player"));
+            NumFailed++;
+        }
+
+        // the next player on the install starts without a session, but with its caches
+        Player.Phase = EPhase::Done;
+        if (Player.Workflow.IsValid())
+        {
+            Player.Workflow->ClearChallengeId();
+            Player.Workflow->ClearSession();
+            Player.Workflow->CleanUp();
+            AddStats(*Player.Workflow);
+            Player.Workflow.Reset();
+        }
+        Player.StartupFlow.Reset();
+        Player.Flow.Reset();
+        Player.SubmitAgeGate = nullptr;
+        Player.SubmitAt = 0.0;
+        Player.ApproveAt = 0.0;
+        FreeInstalls.Add(Player.Install);
+
+        NumActive--;
+        if (++NumFinished == Players.Num())
+        {
+            EndTime = Now;
+        }
+    }
+
+    void AddStats(const UKidWorkflow& Workflow)
+    {
+        const UKidWorkflow::FPolicyStats& Policy = Workflow.GetPolicyStats();
+        PolicyStats.Applied += Policy.Applied;
+        PolicyStats.Confirmed += Policy.Confirmed;
+        PolicyStats.Contradicted += Policy.Contradicted;
+        PolicyStats.Retracted += Policy.Retracted;
+
+        const UKidWorkflow::FPrefetchStats& Prefetch = Workflow.GetPrefetchStats();
+        PrefetchStats.Issued += Prefetch.Issued;
+        PrefetchStats.Hits += Prefetch.Hits;
+        PrefetchStats.NotReady += Prefetch.NotReady;
+        PrefetchStats.Failed += Prefetch.Failed;
+        PrefetchStats.NotAdult += Prefetch.NotAdult;
+        PrefetchStats.Retracted += Prefetch.Retracted;
+    }
+
+    FStep& FindOrAddStep(const FString& Step)
+    {
+        // steps are reported in the order they were first seen, which follows the flow
+        for (TPair<FString, FStep>& Pair : Steps)
+        {
+            if (Pair.Key == Step)
+            {
+                return Pair.Value;
+            }
+        }
+        return Steps.Emplace_GetRef(Step, FStep()).Value;
+    }
+
+    void AddSample(const FString& Step, double Seconds)
+    {
+        FindOrAddStep(Step).LatenciesMs.Add(Seconds * 1000.0);
+    }
+
+    void AddError(const FString& Step)
+    {
+        FindOrAddStep(Step).Errors++;
+    }
+
+    FSettings Settings;
+    FString StorageDirectory;
+    TArray<FVirtualPlayer> Players;
+    TArray<TPair<FString, FStep>> Steps;
+
+    // installs no player is running on
+    TArray<int32> FreeInstalls;
+
+    // of every finished player's workflow
+    UKidWorkflow::FPolicyStats PolicyStats;
+    UKidWorkflow::FPrefetchStats PrefetchStats;
+
+    int32 NextPlayer = 0;
+    int32 NumActive = 0;
+    int32 NumFinished = 0;
+    int32 NumFailed = 0;
+    double StartTime = 0.0;
+    double EndTime = 0.0;
+};
+
+#endif
+
+UKidLoadGeneratorCommandlet::UKidLoadGeneratorCommandlet()
+{
+    IsClient = false;
+    IsServer = false;
+    IsEditor = false;
+    LogToConsole = true;
+}
+
+int32 UKidLoadGeneratorCommandlet::Main(const FString& Params)
+{
+#if UE_BUILD_SHIPPING
+    UE_LOG(LogTemp, Error, TEXT("The kID load generator is not available in Shipping builds."));
+    return 1;
+#else
+    FKidLoadGenerator::FSettings Settings;
+    FString BaseUrls = LoadTestBaseUrl;
+    FParse::Value(*Params, TEXT("BaseUrl="), BaseUrls, false);
+    BaseUrls.ParseIntoArray(Settings.Endpoints, TEXT(","));
+    FParse::Value(*Params, TEXT("ApiKey="), Settings.ApiKey);
+    FParse::Value(*Params, TEXT("Players="), Settings.NumPlayers);
+    FParse::Value(*Params, TEXT("Concurrency="), Settings.Concurrency);
+    FParse::Value(*Params, TEXT("AdultPercent="), Settings.AdultPercent);
+    Settings.NumPlayers = FMath::Max(1, Settings.NumPlayers);
+    Settings.Concurrency = FMath::Max(1, Settings.Concurrency);
+    Settings.AdultPercent = FMath::Clamp(Settings.AdultPercent, 0, 100);
+
+    int32 NumRegions = 2;
+    int32 AgeGateMs = 500;
+    int32 ApproveAfterMs = 250;
+    int32 LatencyMs = 20;
+    double TimeoutSeconds = 600.0;
+    FString ReportPath = FPaths::ProjectSavedDir() / TEXT("kID") / TEXT("LoadGenerator");
+    FParse::Value(*Params, TEXT("Regions="), NumRegions);
+    FParse::Value(*Params, TEXT("AgeGateMs="), AgeGateMs);
+    FParse::Value(*Params, TEXT("ApproveAfterMs="), ApproveAfterMs);
+    FParse::Value(*Params, TEXT("LatencyMs="), LatencyMs);
+    FParse::Value(*Params, TEXT("TimeoutSeconds="), TimeoutSeconds);
+    FParse::Value(*Params, TEXT("Report="), ReportPath);
+    Settings.AgeGateSeconds = AgeGateMs / 1000.0;
+    Settings.ApproveAfterSeconds = ApproveAfterMs / 1000.0;
+
+    // each region is further away than the last, so the startup probe has a nearest one to pick
+    TArray<TUniquePtr<FKidMockServer>> Servers;
+    if (Settings.Endpoints.Num() == 0)
+    {
+        for (int32 Region = 0; Region < FMath::Max(1, NumRegions); ++Region)
+        {
+            TUniquePtr<FKidMockServer>& Server = Servers.Add_GetRef(MakeUnique<FKidMockServer>());
+            Server->SetLatencySeconds(LatencyMs * (Region + 1) / 1000.0);
+            if (!Server->Start(0))
+            {
+                UE_LOG(LogTemp, Error, TEXT("Could not start the kID mock servers for the load generator."));
+                for (TUniquePtr<FKidMockServer>& Started : Servers)
+                {
+                    Started->Stop();
+                }
+                return 1;
+            }
+            Settings.Endpoints.Add(Server->GetBaseUrl());
+        }
+    }
+
+    UE_LOG(LogTemp, Display, TEXT("kID load generator: %d players, %d at a time, against %s"), Settings.NumPlayers, Settings.Concurrency,
+                *FString::Join(Settings.Endpoints, TEXT(", ")));
+
+    TSharedRef<FKidLoadGenerator> Generator = MakeShared<FKidLoadGenerator>(Settings);
+    Generator->Start();
+
+    // there is no engine loop in a commandlet, so the core ticker (which also drives HTTP) and the
+    // game thread's task queue are pumped here
+    const double Deadline = FPlatformTime::Seconds() + TimeoutSeconds;
+    double LastTime = FPlatformTime::Seconds();
+    bool bTimedOut = false;
+    while (!Generator->IsFinished() && !IsEngineExitRequested())
+    {
+        const double Now = FPlatformTime::Seconds();
+        FTaskGraphInterface::Get().ProcessThreadUntilIdle(ENamedThreads::GameThread);
+        FTSTicker::GetCoreTicker().Tick(static_cast<float>(Now - LastTime));
+        Generator->Tick(Now);
+        LastTime = Now;
+
+        if (Now > Deadline)
+        {
+            UE_LOG(LogTemp, Error, TEXT("kID load generator timed out after %.0f s."), TimeoutSeconds);
+            bTimedOut = true;
+            break;
+        }
+        FPlatformProcess::Sleep(0.001f);
+    }
+
+    int32 NumServerRequests = Servers.Num() > 0 ? 0 : -1;
+    for (const TUniquePtr<FKidMockServer>& Server : Servers)
+    {
+        NumServerRequests += Server->GetRequestCount();
+    }
+    Generator->Report(ReportPath, NumServerRequests);
+    const bool bSucceeded = !bTimedOut && Generator->IsFinished() && Generator->GetNumFailed() == 0;
+
+    for (TUniquePtr<FKidMockServer>& Server : Servers)
+    {
+        Server->Stop();
+    }
+    return bSucceeded ? 0 : 1;
+#endif
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "KidLoadGeneratorCommandlet.generated.h"
+
+// Runs many virtual players through the whole kID flow headlessly and reports throughput, latency
+// percentiles and error rates per step, as JSON and CSV.
+//
+// Each virtual player is a UKidWorkflow with no-op UI hooks in place of the widgets, so it runs
+// the same code as the game: Initialize (endpoint probe, token, saved state, requirements and
+// policy caches), StartKidSession (age gate, with the default permissions prefetched while it is
+// up and the outcome predicted from the cached policy, then /age-gate/check, and a consent
+// challenge approved through /test/set-challenge-status for children), and then a batched
+// upgrade of several features, which needs a second approved challenge.
+//
+// Players run on as many installs as can run at once.  A player that finishes clears its session
+// and leaves the install to the next one, which starts with the install's requirements and
+// policy caches, as a new player on a shared device would.  The local stand-in servers, one per
+// region, are started unless base URLs are given.
+//
+//   UnrealEditor-Cmd kID_Unreal.uproject -run=KidLoadGenerator [-Players=200] [-Concurrency=50]
+//       [-BaseUrl=<url>[,<url>...]] [-ApiKey=] [-Regions=2] [-LatencyMs=20] [-AgeGateMs=500]
+//       [-ApproveAfterMs=250] [-AdultPercent=50] [-TimeoutSeconds=600] [-Report=Saved/kID/LoadGenerator]
+//
+// Returns non-zero if any player failed or the run timed out.
+UCLASS(Config=Game)
+class UKidLoadGeneratorCommandlet : public UCommandlet
+{
+    GENERATED_BODY()
+
+public:
+    UKidLoadGeneratorCommandlet();
+
+    virtual int32 Main(const FString& Params) override;
+
+private:
+    // Regional API endpoints the virtual players probe when -BaseUrl is not given, comma
+    // separated.  The local stand-in servers are used when empty.
+    UPROPERTY(Config)
+    FString LoadTestBaseUrl;
+};
@@ -0,0 +1,553 @@
+#include "KidMockServer.h"
+#include "Sockets.h"
+#include "SocketSubsystem.h"
+#include "IPAddress.h"
+#include "HAL/RunnableThread.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/PlatformTime.h"
+#include "GenericPlatform/GenericPlatformHttp.h"
+#include "Misc/Base64.h"
+#include "Misc/SecureHash.h"
+#include "Json.h"
+
+#if !UE_BUILD_SHIPPING
+
+namespace
+{
+    const TCHAR* const WebSocketGuid = TEXT("258EAFA5-E914-47DA-95CA-C5AB0DC85B11");
+    constexpr int32 MaxRequestSize = 64 * 1024;
+
+    const TCHAR* const SessionPermissions[] = { TEXT("text-chat-private"), TEXT("text-chat-public"), TEXT("voice-chat"),
+                TEXT("user-generated-content"), TEXT("in-game-purchases"), TEXT("multiplayer"), TEXT("leaderboards"),
+                TEXT("friend-requests") };
+}
+
+FKidMockServer::FKidMockServer()
+    : bStopping(false)
+{
+}
+
+FKidMockServer::~FKidMockServer()
+{
+    Stop();
+}
+
+bool FKidMockServer::Start(int32 InPort)
+{
+    ISocketSubsystem* SocketSubsystem = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
+    ListenerSocket = SocketSubsystem->CreateSocket(NAME_Stream, TEXT("KidMockServerListener"), false);
+    if (!ListenerSocket)
+    {
+        UE_LOG(LogTemp, Error, TEXT("kID mock server: failed to create listener socket"));
+        return false;
+    }
+
+    TSharedRef<FInternetAddr> Addr = SocketSubsystem->CreateInternetAddr();
+    bool bIsValid = false;
+    Addr->SetIp(TEXT("127.0.0.1"), bIsValid);
+    Addr->SetPort(InPort);
+
+    ListenerSocket->SetReuseAddr(true);
+    if (!ListenerSocket->Bind(*Addr) || !ListenerSocket->Listen(128))
+    {
+        UE_LOG(LogTemp, Error, TEXT("kID mock server: failed to listen on port %d"), InPort);
+        SocketSubsystem->DestroySocket(ListenerSocket);
+        ListenerSocket = nullptr;
+        return false;
+    }
+    ListenerSocket->SetNonBlocking(true);
+
+    // port 0 asks for any free port
+    TSharedRef<FInternetAddr> BoundAddr = SocketSubsystem->CreateInternetAddr();
+    ListenerSocket->GetAddress(*BoundAddr);
+    Port = BoundAddr->GetPort();
+
+    bStopping = false;
+    Thread = FRunnableThread::Create(this, TEXT("KidMockServerThread"));
+    UE_LOG(LogTemp, Log, TEXT("kID mock server listening on %s"), *GetBaseUrl());
+    return true;
+}
+
+void FKidMockServer::Stop()
+{
+    bStopping = true;
+
+    if (Thread)
+    {
+        Thread->WaitForCompletion();
+        delete Thread;
+        Thread = nullptr;
+    }
+
+    if (ListenerSocket)
+    {
+        ListenerSocket->Close();
+        ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(ListenerSocket);
+        ListenerSocket = nullptr;
+    }
+}
+
+FString FKidMockServer::GetBaseUrl() const
+{
+    return FString::Printf(TEXT("http://127.0.0.1:%d"), Port);
+}
+
+FString FKidMockServer::GetPushUrl() const
+{
+    return FString::Printf(TEXT("ws://127.0.0.1:%d/challenge/subscribe"), Port);
+}
+
+void FKidMockServer::SetChallengeStatus(const FString& ChallengeId, const FString& Status)
+{
+    FScopeLock Lock(&ChallengesLock);
+    FChallenge& Challenge = Challenges.FindOrAdd(ChallengeId);
+    Challenge.Status = Status;
+    Challenge.ResolvedAt = FPlatformTime::Seconds();
+
+    if (Status == TEXT("PASS"))
+    {
+        // an age gate challenge creates a session, an upgrade challenge changes its session
+        if (Challenge.SessionId.IsEmpty())
+        {
+            Challenge.SessionId = FGuid::NewGuid().ToString(EGuidFormats::DigitsWithHyphensLower);
+        }
+        else
+        {
+            TouchSession(Challenge.SessionId);
+        }
+    }
+}
+
+FString FKidMockServer::CreateChallenge(const FString& SessionId)
+{
+    const FString ChallengeId = FGuid::NewGuid().ToString(EGuidFormats::DigitsWithHyphensLower);
+
+    FScopeLock Lock(&ChallengesLock);
+    Challenges.Add(ChallengeId).SessionId = SessionId;
+    return ChallengeId;
+}
+
+void FKidMockServer::TouchSession(const FString& SessionId)
+{
+    FScopeLock Lock(&SessionsLock);
+    SessionVersions.FindOrAdd(SessionId)++;
+}
+
+bool FKidMockServer::GetChallenge(const FString& ChallengeId, FChallenge& OutChallenge)
+{
+    FScopeLock Lock(&ChallengesLock);
+    if (const FChallenge* Challenge = Challenges.Find(ChallengeId))
+    {
+        OutChallenge = *Challenge;
+        return true;
+    }
+    return false;
+}
+
+uint32 FKidMockServer::Run()
+{
+    while (!bStopping)
+    {
+        AcceptConnections();
+
+        const double Now = FPlatformTime::Seconds();
+        for (int32 Index = Connections.Num() - 1; Index >= 0; --Index)
+        {
+            FConnection& Connection = *Connections[Index];
+            ServiceConnection(Connection, Now);
+
+            if (Connection.State == EConnectionState::Closed)
+            {
+                Connection.Socket->Close();
+                ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(Connection.Socket);
+                Connections.RemoveAtSwap(Index);
+                OpenConnectionCount.Decrement();
+            }
+        }
+
+        FPlatformProcess::Sleep(0.001f);
+    }
+
+    for (const TUniquePtr<FConnection>& Connection : Connections)
+    {
+        Connection->Socket->Close();
+        ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(Connection->Socket);
+    }
+    Connections.Reset();
+    OpenConnectionCount.Reset();
+    return 0;
+}
+
+void FKidMockServer::AcceptConnections()
+{
+    bool bHasPendingConnection = false;
+    while (ListenerSocket->HasPendingConnection(bHasPendingConnection) && bHasPendingConnection)
+    {
+        FSocket* Socket = ListenerSocket->Accept(TEXT("KidMockServerConnection"));
+        if (!Socket)
+        {
+            return;
+        }
+        Socket->SetNonBlocking(true);
+
+        TUniquePtr<FConnection> Connection = MakeUnique<FConnection>();
+        Connection->Socket = Socket;
+        Connections.Add(MoveTemp(Connection));
+
+        const int32 Open = OpenConnectionCount.Increment();
+        if (Open > PeakOpenConnectionCount.GetValue())
+        {
+            PeakOpenConnectionCount.Set(Open);
+        }
+    }
+}
+
+void FKidMockServer::ServiceConnection(FConnection& Connection, double Now)
+{
+    const double Latency = LatencySeconds.load();
+
+    switch (Connection.State)
+    {
+    case EConnectionState::Reading:
+        ReadRequest(Connection, Now);
+        break;
+
+    case EConnectionState::Responding:
+        if (Now >= Connection.RespondAt)
+        {
+            FTCHARToUTF8 Utf8(*Connection.Response);
+            const bool bSent = SendAll(Connection.Socket, reinterpret_cast<const uint8*>(Utf8.Get()), Utf8.Length());
+            Connection.State = bSent && Connection.bUpgrade ? EConnectionState::WebSocket : EConnectionState::Closed;
+        }
+        break;
+
+    case EConnectionState::Awaiting:
+    {
+        FChallenge Challenge;
+        const bool bResolved = GetChallenge(Connection.ChallengeId, Challenge) && Challenge.ResolvedAt > 0.0;
+        if (bResolved && Now >= Challenge.ResolvedAt + Latency)
+        {
+            Respond(Connection, 200, MakeStatusJson(Connection.ChallengeId, Challenge), Now);
+        }
+        else if (Now >= Connection.AwaitDeadline)
+        {
+            Respond(Connection, 200, MakeStatusJson(Connection.ChallengeId, FChallenge()), Now);
+        }
+        break;
+    }
+
+    case EConnectionState::WebSocket:
+    {
+        // anything from the client other than a close is ignored
+        uint8 Buffer[256];
+        int32 BytesRead = 0;
+        if (!Connection.Socket->Recv(Buffer, sizeof(Buffer), BytesRead) || (BytesRead > 0 && (Buffer[0] & 0x0F) == 0x8))
+        {
+            Connection.State = EConnectionState::Closed;
+            break;
+        }
+
+        FChallenge Challenge;
+        if (!Connection.bPushed && GetChallenge(Connection.ChallengeId, Challenge) && Challenge.ResolvedAt > 0.0 &&
+            Now >= Challenge.ResolvedAt + Latency)
+        {
+            Connection.bPushed = true;
+            if (!SendWebSocketText(Connection.Socket, MakeStatusJson(Connection.ChallengeId, Challenge)))
+            {
+                Connection.State = EConnectionState::Closed;
+            }
+        }
+        break;
+    }
+
+    case EConnectionState::Closed:
+        break;
+    }
+}
+
+void FKidMockServer::ReadRequest(FConnection& Connection, double Now)
+{
+    uint8 Buffer[4096];
+    int32 BytesRead = 0;
+    if (!Connection.Socket->Recv(Buffer, sizeof(Buffer), BytesRead))
+    {
+        Connection.State = EConnectionState::Closed;
+        return;
+    }
+    if (BytesRead == 0)
+    {
+        return;
+    }
+
+    Connection.Received.Append(Buffer, BytesRead);
+    if (Connection.Received.Num() > MaxRequestSize)
+    {
+        Connection.State = EConnectionState::Closed;
+        return;
+    }
+
+    // wait for the headers, then for the body they announce
+    const TArray<uint8>& Received = Connection.Received;
+    int32 HeaderEnd = INDEX_NONE;
+    for (int32 Index = 0; Index + 3 < Received.Num(); ++Index)
+    {
+        if (Received[Index] == '\r' && Received[Index + 1] == '\n' && Received[Index + 2] == '\r' && Received[Index + 3] == '\n')
+        {
+            HeaderEnd = Index;
+            break;
+        }
+    }
+    if (HeaderEnd == INDEX_NONE)
+    {
+        return;
+    }
+
+    const FString HeaderText(HeaderEnd, reinterpret_cast<const ANSICHAR*>(Received.GetData()));
+    TArray<FString> Lines;
+    HeaderText.ParseIntoArray(Lines, TEXT("\r\n"));
+    if (Lines.Num() == 0)
+    {
+        Connection.State = EConnectionState::Closed;
+        return;
+    }
+
+    TMap<FString, FString> Headers;
+    for (int32 Index = 1; Index < Lines.Num(); ++Index)
+    {
+        FString Name, Value;
+        if (Lines[Index].Split(TEXT(":"), &Name, &Value))
+        {
+            Headers.Add(Name.TrimStartAndEnd().ToLower(), Value.TrimStartAndEnd());
+        }
+    }
+
+    const int32 BodyStart = HeaderEnd + 4;
+    const int32 ContentLength = FCString::Atoi(*Headers.FindRef(TEXT("content-length")));
+    if (Received.Num() - BodyStart < ContentLength)
+    {
+        return;
+    }
+    const FUTF8ToTCHAR BodyText(reinterpret_cast<const ANSICHAR*>(Received.GetData() + BodyStart), ContentLength);
+    const FString Body(BodyText.Length(), BodyText.Get());
+
+    TArray<FString> RequestLine;
+    Lines[0].ParseIntoArrayWS(RequestLine);
+    if (RequestLine.Num() < 2)
+    {
+        Connection.State = EConnectionState::Closed;
+        return;
+    }
+
+    FString Path = RequestLine[1];
+    FString QueryString;
+    TMap<FString, FString> Query;
+    if (RequestLine[1].Split(TEXT("?"), &Path, &QueryString))
+    {
+        TArray<FString> Pairs;
+        QueryString.ParseIntoArray(Pairs, TEXT("&"));
+        for (const FString& Pair : Pairs)
+        {
+            FString Name, Value;
+            Pair.Split(TEXT("="), &Name, &Value);
+            Query.Add(Name, FGenericPlatformHttp::UrlDecode(Value));
+        }
+    }
+
+    RequestCount.Increment();
+    HandleRequest(Connection, RequestLine[0], Path, Query, Headers, Body, Now);
+}
+
+void FKidMockServer::HandleRequest(FConnection& Connection, const FString& Method, const FString& Path,
+                const TMap<FString, FString>& Query, const TMap<FString, FString>& Headers, const FString& Body, double Now)
+{
+    const double Latency = LatencySeconds.load();
+
+    if (Path == TEXT("/challenge/subscribe") && Headers.FindRef(TEXT("upgrade")).Equals(TEXT("websocket"), ESearchCase::IgnoreCase))
+    {
+        FTCHARToUTF8 Key(*(Headers.FindRef(TEXT("sec-websocket-key")) + WebSocketGuid));
+        uint8 Hash[20];
+        FSHA1::HashBuffer(Key.Get(), Key.Length(), Hash);
+
+        Connection.ChallengeId = Query.FindRef(TEXT("challengeId"));
+        Connection.Response = FString::Printf(TEXT("HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\n")
+                    TEXT("Connection: Upgrade\r\nSec-WebSocket-Accept: %s\r\n\r\n"), *FBase64::Encode(Hash, sizeof(Hash)));
+        Connection.RespondAt = Now + Latency;
+        Connection.bUpgrade = true;
+        Connection.State = EConnectionState::Responding;
+    }
+    else if (Path == TEXT("/auth/issue-token") && Method == TEXT("POST"))
+    {
+        Respond(Connection, 200, FString::Printf(TEXT("{\"accessToken\":\"mock-%s\",\"expiresIn\":86400}"),
+                    *FGuid::NewGuid().ToString(EGuidFormats::Digits)), Now + Latency);
+    }
+    else if (Path == TEXT("/age-gate/get-requirements"))
+    {
+        Respond(Connection, 200, TEXT("{\"shouldDisplay\":true,\"ageAssuranceRequired\":false,\"digitalConsentAge\":13,")
+                    TEXT("\"civilAge\":18,\"minimumAge\":0,\"approvedAgeCollectionMethods\":[\"date-of-birth\"]}"), Now + Latency);
+    }
+    else if (Path == TEXT("/age-gate/check") && Method == TEXT("POST"))
+    {
+        TSharedPtr<FJsonObject> JsonObject;
+        if (!FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(Body), JsonObject))
+        {
+            Respond(Connection, 400, TEXT("{\"error\":\"INVALID_INPUT\"}"), Now + Latency);
+        }
+        else if (FDateTime::UtcNow().GetYear() - FCString::Atoi(*JsonObject->GetStringField(TEXT("dateOfBirth")).Left(4)) < 13)
+        {
+            Respond(Connection, 200, FString::Printf(TEXT("{\"status\":\"CHALLENGE\",\"challenge\":%s}"),
+                        *MakeChallengeJson(CreateChallenge(FGuid::NewGuid().ToString(EGuidFormats::DigitsWithHyphensLower)))), Now + Latency);
+        }
+        else
+        {
+            Respond(Connection, 200, FString::Printf(TEXT("{\"status\":\"PASS\",\"session\":%s}"),
+                        *MakeSessionJson(FGuid::NewGuid().ToString(EGuidFormats::DigitsWithHyphensLower), 0)), Now + Latency);
+        }
+    }
+    else if (Path == TEXT("/age-gate/get-default-permissions"))
+    {
+        Respond(Connection, 200, TEXT("{\"permissions\":[{\"name\":\"multiplayer\",\"enabled\":false,\"managedBy\":\"PLAYER\"}]}"), Now + Latency);
+    }
+    else if (Path == TEXT("/challenge/get"))
+    {
+        Respond(Connection, 200, MakeChallengeJson(Query.FindRef(TEXT("challengeId"))), Now + Latency);
+    }
+    else if (Path == TEXT("/session/upgrade") && Method == TEXT("POST"))
+    {
+        TSharedPtr<FJsonObject> JsonObject;
+        if (FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(Body), JsonObject))
+        {
+            Respond(Connection, 200, FString::Printf(TEXT("{\"challenge\":%s}"),
+                        *MakeChallengeJson(CreateChallenge(JsonObject->GetStringField(TEXT("sessionId"))))), Now + Latency);
+        }
+        else
+        {
+            Respond(Connection, 400, TEXT("{\"error\":\"INVALID_INPUT\"}"), Now + Latency);
+        }
+    }
+    else if (Path == TEXT("/challenge/await"))
+    {
+        Connection.ChallengeId = Query.FindRef(TEXT("challengeId"));
+        Connection.AwaitDeadline = Now + FCString::Atoi(*Query.FindRef(TEXT("timeout"))) + Latency;
+        Connection.State = EConnectionState::Awaiting;
+    }
+    else if (Path == TEXT("/test/set-challenge-status") && Method == TEXT("POST"))
+    {
+        TSharedPtr<FJsonObject> JsonObject;
+        if (FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(Body), JsonObject))
+        {
+            SetChallengeStatus(JsonObject->GetStringField(TEXT("challengeId")), JsonObject->GetStringField(TEXT("status")));
+            Respond(Connection, 200, TEXT("{}"), Now + Latency);
+        }
+        else
+        {
+            Respond(Connection, 400, TEXT("{\"error\":\"INVALID_INPUT\"}"), Now + Latency);
+        }
+    }
+    else if (Path == TEXT("/session/get"))
+    {
+        const FString SessionId = Query.FindRef(TEXT("sessionId"));
+        int32 Version = 0;
+        {
+            FScopeLock Lock(&SessionsLock);
+            Version = SessionVersions.FindRef(SessionId);
+        }
+
+        if (Query.FindRef(TEXT("etag")) == FString::FromInt(Version))
+        {
+            Respond(Connection, 304, FString(), Now + Latency);
+        }
+        else
+        {
+            Respond(Connection, 200, MakeSessionJson(SessionId, Version), Now + Latency);
+        }
+    }
+    else
+    {
+        Respond(Connection, 404, TEXT("{\"error\":\"NOT_FOUND\"}"), Now + Latency);
+    }
+}
+
+void FKidMockServer::Respond(FConnection& Connection, int32 StatusCode, const FString& Body, double RespondAt)
+{
+    const int32 BodyLength = FTCHARToUTF8(*Body).Length();
+    Connection.Response = FString::Printf(TEXT("HTTP/1.1 %d %s\r\nContent-Type: application/json\r\nContent-Length: %d\r\n")
+                TEXT("Connection: close\r\n\r\n%s"), StatusCode, StatusCode == 200 ? TEXT("OK") : (StatusCode == 304 ? TEXT("Not Modified") : TEXT("Error")), BodyLength, *Body);
+    Connection.RespondAt = RespondAt;
+    Connection.State = EConnectionState::Responding;
+}
+
+FString FKidMockServer::MakeChallengeJson(const FString& ChallengeId)
+{
+    return FString::Printf(TEXT("{\"challengeId\":\"%s\",\"oneTimePassword\":\"%06u\",\"url\":\"https://family.k-id.com/authorize?otp=%06u\"}"),
+                *ChallengeId, GetTypeHash(ChallengeId) % 1000000u, GetTypeHash(ChallengeId) % 1000000u);
+}
+
+FString FKidMockServer::MakeStatusJson(const FString& ChallengeId, const FChallenge& Challenge)
+{
+    const bool bPassed = Challenge.Status == TEXT("PASS");
+    return FString::Printf(TEXT("{\"challengeId\":\"%s\",\"status\":\"%s\",\"sessionId\":\"%s\",\"approverEmail\":\"%s\"}"),
+                *ChallengeId, *Challenge.Status, bPassed ? *Challenge.SessionId : TEXT(""),
+                bPassed ? TEXT("parent@example.com") : TEXT(""));
+}
+
+FString FKidMockServer::MakeSessionJson(const FString& SessionId, int32 Version)
+{
+    // which permissions are enabled follows from the ID and changes with every version
+    const uint32 Bits = GetTypeHash(SessionId) ^ (static_cast<uint32>(Version) * 0x9E3779B9u);
+
+    FString Permissions;
+    for (int32 Index = 0; Index < UE_ARRAY_COUNT(SessionPermissions); ++Index)
+    {
+        Permissions += FString::Printf(TEXT("%s{\"name\":\"%s\",\"enabled\":%s,\"managedBy\":\"GUARDIAN\"}"),
+                    Index > 0 ? TEXT(",") : TEXT(""), SessionPermissions[Index], (Bits >> Index) & 1 ? TEXT("true") : TEXT("false"));
+    }
+
+    return FString::Printf(TEXT("{\"sessionId\":\"%s\",\"etag\":\"%d\",\"status\":\"ACTIVE\",\"jurisdiction\":\"US-CA\",")
+                TEXT("\"dateOfBirth\":\"2015-01-01\",\"permissions\":[%s]}"), *SessionId, Version, *Permissions);
+}
+
+bool FKidMockServer::SendAll(FSocket* Socket, const uint8* Data, int32 Size)
+{
+    // responses are small, so waiting out a full send buffer here is acceptable
+    int32 Offset = 0;
+    while (Offset < Size)
+    {
+        int32 BytesSent = 0;
+        if (!Socket->Send(Data + Offset, Size - Offset, BytesSent))
+        {
+            return false;
+        }
+        if (BytesSent == 0)
+        {
+            FPlatformProcess::Sleep(0.0f);
+        }
+        Offset += BytesSent;
+    }
+    return true;
+}
+
+bool FKidMockServer::SendWebSocketText(FSocket* Socket, const FString& Text)
+{
+    FTCHARToUTF8 Utf8(*Text);
+    const int32 Length = Utf8.Length();
+
+    // a single unmasked text frame, as sent by servers
+    TArray<uint8> Frame;
+    Frame.Add(0x81);
+    if (Length < 126)
+    {
+        Frame.Add(static_cast<uint8>(Length));
+    }
+    else
+    {
+        check(Length <= 0xFFFF);
+        Frame.Add(126);
+        Frame.Add(static_cast<uint8>(Length >> 8));
+        Frame.Add(static_cast<uint8>(Length & 0xFF));
+    }
+    Frame.Append(reinterpret_cast<const uint8*>(Utf8.Get()), Length);
+
+    return SendAll(Socket, Frame.GetData(), Frame.Num());
+}
+
+#endif
@@ -0,0 +1,128 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/Runnable.h"
+#include "HAL/ThreadSafeBool.h"
+#include "HAL/ThreadSafeCounter.h"
+#include <atomic>
+
+#if !UE_BUILD_SHIPPING
+
+class FSocket;
+class FRunnableThread;
+
+// A local stand-in for the kID API, for measuring the client without depending on the network.
+//
+// Serves the endpoints the client uses on 127.0.0.1 from a single thread with non-blocking sockets:
+//   POST /auth/issue-token                         any API key is accepted
+//   GET  /age-gate/get-requirements?jurisdiction=  the same requirements for every jurisdiction
+//   POST /age-gate/check                           {"dateOfBirth", "jurisdiction"}, under 13 is challenged
+//   GET  /age-gate/get-default-permissions         default permissions without a session
+//   GET  /challenge/get?challengeId=
+//   GET  /challenge/await?challengeId=&timeout=   long poll, answered when the challenge resolves
+//   GET  /challenge/subscribe?challengeId=         WebSocket that pushes the challenge status
+//   POST /session/upgrade                          {"sessionId", "requestedPermissions"}, always challenged
+//   POST /test/set-challenge-status                {"challengeId", "status"}
+//   GET  /session/get?sessionId=&etag=             any session ID, 304 when the ETag is current
+//
+// Every response and push is delayed by the configured latency to stand in for the round trip.
+// Challenges and sessions do not need to be created up front; unknown challenges are pending and
+// unknown sessions are generated from their ID.  Passing an age gate challenge hands out a new
+// session, and passing an upgrade challenge changes the session it was created for.
+//
+// It opens a listening socket, so it is compiled out of Shipping builds along with the benchmarks
+// that use it.
+class FKidMockServer : public FRunnable
+{
+public:
+    FKidMockServer();
+    virtual ~FKidMockServer();
+
+    bool Start(int32 InPort);
+    void Stop();
+
+    int32 GetPort() const { return Port; }
+    FString GetBaseUrl() const;
+    FString GetPushUrl() const;
+
+    void SetLatencySeconds(double InLatencySeconds) { LatencySeconds = InLatencySeconds; }
+
+    // resolves a challenge as PASS or FAIL.  Safe to call from any thread.
+    void SetChallengeStatus(const FString& ChallengeId, const FString& Status);
+
+    // changes a session's permissions and ETag, as a parent would in the parent portal.  Safe to
+    // call from any thread.
+    void TouchSession(const FString& SessionId);
+
+    int32 GetRequestCount() const { return RequestCount.GetValue(); }
+    int32 GetOpenConnectionCount() const { return OpenConnectionCount.GetValue(); }
+    int32 GetPeakOpenConnectionCount() const { return PeakOpenConnectionCount.GetValue(); }
+
+    // FRunnable
+    virtual uint32 Run() override;
+
+private:
+    enum class EConnectionState : uint8
+    {
+        Reading,
+        Responding,
+        Awaiting,
+        WebSocket,
+        Closed
+    };
+
+    struct FConnection
+    {
+        FSocket* Socket = nullptr;
+        EConnectionState State = EConnectionState::Reading;
+        TArray<uint8> Received;
+        FString Response;
+        double RespondAt = 0.0;
+        bool bUpgrade = false;
+        FString ChallengeId;
+        double AwaitDeadline = 0.0;
+        bool bPushed = false;
+    };
+
+    struct FChallenge
+    {
+        FString Status = TEXT("PENDING");
+        FString SessionId;
+        double ResolvedAt = 0.0;
+    };
+
+    void AcceptConnections();
+    void ServiceConnection(FConnection& Connection, double Now);
+    void ReadRequest(FConnection& Connection, double Now);
+    void HandleRequest(FConnection& Connection, const FString& Method, const FString& Path,
+                const TMap<FString, FString>& Query, const TMap<FString, FString>& Headers, const FString& Body, double Now);
+    void Respond(FConnection& Connection, int32 StatusCode, const FString& Body, double RespondAt);
+
+    bool GetChallenge(const FString& ChallengeId, FChallenge& OutChallenge);
+    FString CreateChallenge(const FString& SessionId);
+    static FString MakeChallengeJson(const FString& ChallengeId);
+    static FString MakeStatusJson(const FString& ChallengeId, const FChallenge& Challenge);
+    static FString MakeSessionJson(const FString& SessionId, int32 Version);
+    static bool SendAll(FSocket* Socket, const uint8* Data, int32 Size);
+    static bool SendWebSocketText(FSocket* Socket, const FString& Text);
+
+    int32 Port = 0;
+    FSocket* ListenerSocket = nullptr;
+    FRunnableThread* Thread = nullptr;
+    FThreadSafeBool bStopping;
+    std::atomic<double> LatencySeconds{ 0.05 };
+
+    TArray<TUniquePtr<FConnection>> Connections;
+
+    FCriticalSection ChallengesLock;
+    TMap<FString, FChallenge> Challenges;
+
+    FCriticalSection SessionsLock;
+    TMap<FString, int32> SessionVersions;
+
+    FThreadSafeCounter RequestCount;
+    FThreadSafeCounter OpenConnectionCount;
+    FThreadSafeCounter PeakOpenConnectionCount;
+};
+
+#endif
@@ -0,0 +1,157 @@
+#include "KidPermissionCache.h"
+#include "HAL/PlatformTime.h"
+
+FKidPermissionCache::FKidPermissionCache(const FString& InBaseUrl, const FString& InAuthToken, const FSettings& InSettings)
+    : BaseUrl(InBaseUrl)
+    , AuthToken(InAuthToken)
+    , Settings(InSettings)
+{
+}
+
+FKidPermissionCache::~FKidPermissionCache()
+{
+    if (TickHandle.IsValid())
+    {
+        FTSTicker::GetCoreTicker().RemoveTicker(TickHandle);
+    }
+}
+
+void FKidPermissionCache::AddPlayer(const FString& PlayerId, const FString& SessionId)
+{
+    RemovePlayer(PlayerId);
+
+    FEntryRef* Found = Sessions.Find(SessionId);
+    FEntryRef Entry = Found ? *Found : MakeShared<FSessionEntry, ESPMode::ThreadSafe>();
+    if (!Found)
+    {
+        Entry->SessionId = SessionId;
+        Sessions.Add(SessionId, Entry);
+        Stats.NumSessions = Sessions.Num();
+        Schedule(Entry, 0.0);
+    }
+
+    Entry->NumPlayers++;
+    PlayerSessions.Add(PlayerId, Entry);
+
+    if (!TickHandle.IsValid())
+    {
+        TWeakPtr<FKidPermissionCache, ESPMode::ThreadSafe> WeakThis = AsShared();
+        TickHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda([WeakThis](float DeltaTime)
+        {
+            TSharedPtr<FKidPermissionCache, ESPMode::ThreadSafe> This = WeakThis.Pin();
+            return This && This->Tick(DeltaTime);
+        }));
+    }
+}
+
+void FKidPermissionCache::RemovePlayer(const FString& PlayerId)
+{
+    const FEntryRef* Found = PlayerSessions.Find(PlayerId);
+    if (!Found)
+    {
+        return;
+    }
+    FEntryRef Entry = *Found;
+    PlayerSessions.Remove(PlayerId);
+
+    if (--Entry->NumPlayers == 0)
+    {
+        // left in the fetch queue and skipped when it comes due
+        Entry->bRemoved = true;
+        if (Entry->bVerified)
+        {
+            Stats.NumVerified--;
+        }
+        Sessions.Remove(Entry->SessionId);
+        Stats.NumSessions = Sessions.Num();
+    }
+}
+
+bool FKidPermissionCache::IsPlayerVerified(const FString& PlayerId) const
+{
+    const FEntryRef* Entry = PlayerSessions.Find(PlayerId);
+    return Entry && (*Entry)->bVerified;
+}
+
+bool FKidPermissionCache::IsFeatureAllowed(const FString& PlayerId, FName Feature) const
+{
+    const FEntryRef* Entry = PlayerSessions.Find(PlayerId);
+    return Entry && (*Entry)->Enabled.Contains(Feature);
+}
+
+void FKidPermissionCache::Schedule(const FEntryRef& Entry, double Delay)
+{
+    Entry->NextRevalidateTime = FPlatformTime::Seconds() + Delay;
+    FetchQueue.HeapPush({ Entry->NextRevalidateTime, Entry });
+}
+
+bool FKidPermissionCache::Tick(float DeltaTime)
+{
+    const double Now = FPlatformTime::Seconds();
+    while (FetchQueue.Num() > 0 && Stats.InFlight < Settings.MaxConcurrentRequests && FetchQueue.HeapTop().DueTime <= Now)
+    {
+        FScheduledFetch Due = FetchQueue.HeapTop();
+        FetchQueue.HeapPopDiscard(false);
+
+        // entries rescheduled since this one was queued, removed or already fetching are skipped
+        if (!Due.Entry->bRemoved && !Due.Entry->bFetching && Due.Entry->NextRevalidateTime == Due.DueTime)
+        {
+            Fetch(Due.Entry);
+        }
+    }
+    return true;
+}
+
+void FKidPermissionCache::Fetch(const FEntryRef& Entry)
+{
+    Entry->bFetching = true;
+    Stats.InFlight++;
+    Stats.Requests++;
+
+    TWeakPtr<FKidPermissionCache, ESPMode::ThreadSafe> WeakThis = AsShared();
+    FKidSessionApi::GetSessionSummary(BaseUrl, AuthToken, Entry->SessionId, Entry->ETag).Next([WeakThis, Entry](FKidSessionSummaryResult Result)
+    {
+        if (TSharedPtr<FKidPermissionCache, ESPMode::ThreadSafe> This = WeakThis.Pin())
+        {
+            This->OnFetched(Entry, Result);
+        }
+    });
+}
+
+void FKidPermissionCache::OnFetched(const FEntryRef& Entry, const FKidSessionSummaryResult& Result)
+{
+    Entry->bFetching = false;
+    Stats.InFlight--;
+
+    if (Entry->bRemoved)
+    {
+        return;
+    }
+
+    if (!Result.bSuccess)
+    {
+        Stats.Failures++;
+        Schedule(Entry, Settings.RetryIntervalSeconds * FMath::FRandRange(0.5, 1.0));
+        return;
+    }
+
+    if (Result.bNotModified)
+    {
+        Stats.NotModified++;
+    }
+    else
+    {
+        Stats.Updated++;
+        Entry->ETag = Result.Summary.ETag;
+        Result.Summary.GetEnabledPermissions(Entry->Enabled);
+    }
+
+    if (!Entry->bVerified)
+    {
+        Entry->bVerified = true;
+        Stats.NumVerified++;
+    }
+
+    // spread the next revalidations so sessions that joined together do not stay in step
+    Schedule(Entry, Settings.RevalidateIntervalSeconds * FMath::FRandRange(0.8, 1.2));
+}
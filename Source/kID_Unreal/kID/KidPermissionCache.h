@@ -0,0 +1,88 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+#include "KidSessionApi.h"
+
+// Server-side cache of the kID permissions of connected players, for dedicated servers that
+// need to verify what each player is allowed to do.
+//
+// Sessions are keyed by sessionId and fetched with the same request code the client uses, then
+// decoded straight into the permissions without building a DOM.  Each session is revalidated with
+// its ETag on a schedule, so an unchanged session costs a 304 and no parsing.  Fetches are spread
+// over time with jitter and capped at a number in flight, so thousands of players joining at once
+// do not become thousands of simultaneous requests.
+// IsFeatureAllowed() is two hash lookups and never waits on the network.
+//
+// A session that has never been fetched successfully allows nothing.  A session that fails to
+// revalidate keeps its last known permissions and is retried sooner.
+class FKidPermissionCache : public TSharedFromThis<FKidPermissionCache, ESPMode::ThreadSafe>
+{
+public:
+    struct FSettings
+    {
+        double RevalidateIntervalSeconds = 300.0;
+        double RetryIntervalSeconds = 30.0;
+        int32 MaxConcurrentRequests = 64;
+    };
+
+    struct FStats
+    {
+        int32 NumSessions = 0;
+        int32 NumVerified = 0;
+        int32 InFlight = 0;
+        int64 Requests = 0;
+        int64 NotModified = 0;
+        int64 Updated = 0;
+        int64 Failures = 0;
+    };
+
+    FKidPermissionCache(const FString& InBaseUrl, const FString& InAuthToken, const FSettings& InSettings);
+    ~FKidPermissionCache();
+
+    void AddPlayer(const FString& PlayerId, const FString& SessionId);
+    void RemovePlayer(const FString& PlayerId);
+
+    bool IsPlayerVerified(const FString& PlayerId) const;
+    bool IsFeatureAllowed(const FString& PlayerId, FName Feature) const;
+
+    const FStats& GetStats() const { return Stats; }
+
+private:
+    struct FSessionEntry
+    {
+        FString SessionId;
+        FString ETag;
+        TSet<FName> Enabled;
+        int32 NumPlayers = 0;
+        double NextRevalidateTime = 0.0;
+        bool bVerified = false;
+        bool bFetching = false;
+        bool bRemoved = false;
+    };
+    using FEntryRef = TSharedRef<FSessionEntry, ESPMode::ThreadSafe>;
+
+    struct FScheduledFetch
+    {
+        double DueTime;
+        FEntryRef Entry;
+
+        bool operator<(const FScheduledFetch& Other) const { return DueTime < Other.DueTime; }
+    };
+
+    void Schedule(const FEntryRef& Entry, double Delay);
+    void Fetch(const FEntryRef& Entry);
+    void OnFetched(const FEntryRef& Entry, const FKidSessionSummaryResult& Result);
+    bool Tick(float DeltaTime);
+
+    FString BaseUrl;
+    FString AuthToken;
+    FSettings Settings;
+
+    TMap<FString, FEntryRef> Sessions;
+    TMap<FString, FEntryRef> PlayerSessions;
+    TArray<FScheduledFetch> FetchQueue;
+
+    FStats Stats;
+    FTSTicker::FDelegateHandle TickHandle;
+};
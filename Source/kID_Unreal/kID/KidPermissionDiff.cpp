@@ -0,0 +1,21 @@
+#include "KidPermissionDiff.h"
+#include "KidCoreAdapter.h"
+#include "KidCoreSession.h"
+
+TArray<FKidPermissionChange> FKidPermissionDiff::Diff(const TSharedPtr<FJsonObject>& OldSession, const TSharedPtr<FJsonObject>& NewSession)
+{
+    const std::vector<KidCore::FPermissionChange> CoreChanges = KidCore::DiffPermissions(KidReadPermissions(OldSession), KidReadPermissions(NewSession));
+
+    TArray<FKidPermissionChange> Changes;
+    Changes.Reserve(static_cast<int32>(CoreChanges.size()));
+    for (const KidCore::FPermissionChange& CoreChange : CoreChanges)
+    {
+        FKidPermissionChange& Change = Changes.AddDefaulted_GetRef();
+        Change.Name = KidFromUtf8(CoreChange.Name);
+        Change.bWasEnabled = CoreChange.bWasEnabled;
+        Change.bEnabled = CoreChange.bEnabled;
+        Change.PreviousManagedBy = KidFromUtf8(CoreChange.PreviousManagedBy);
+        Change.ManagedBy = KidFromUtf8(CoreChange.ManagedBy);
+    }
+    return Changes;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Dom/JsonObject.h"
+
+// One permission whose state differs between two sessions.  A permission missing from a
+// session counts as disabled and not managed by anyone.
+struct FKidPermissionChange
+{
+    FString Name;
+    bool bWasEnabled = false;
+    bool bEnabled = false;
+    FString PreviousManagedBy;
+    FString ManagedBy;
+
+    bool IsEnabledChanged() const { return bWasEnabled != bEnabled; }
+};
+
+// Broadcast once per session replacement with every permission that changed, and not at all
+// when nothing did.
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnKidPermissionsChanged, const TArray<FKidPermissionChange>& /*Changes*/);
+
+class FKidPermissionDiff
+{
+public:
+    // Compares the permissions of two sessions, either of which may be null, and returns the
+    // changes in the order the new session lists its permissions, then any that were removed.
+    static TArray<FKidPermissionChange> Diff(const TSharedPtr<FJsonObject>& OldSession, const TSharedPtr<FJsonObject>& NewSession);
+};
@@ -0,0 +1,169 @@
+#include "CoreMinimal.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
+#include "Containers/Ticker.h"
+#include "KidMockServer.h"
+#include "KidPermissionCache.h"
+
+#if !UE_BUILD_SHIPPING
+
+// Load test of the server-side permission cache against the local stand-in server.  Adds the
+// given number of simulated players at once, changes a few of their sessions every second as
+// parents would, and measures fetch traffic and the cost of IsFeatureAllowed() while the cache
+// keeps up.
+//
+//   kid.Server.LoadTest [Sessions=10000] [Seconds=60] [ChangesPerSecond=20] [RevalidateSeconds=20]
+class FKidPermissionLoadTest : public TSharedFromThis<FKidPermissionLoadTest, ESPMode::ThreadSafe>
+{
+public:
+    FKidPermissionLoadTest(int32 InNumSessions, double InDurationSeconds, int32 InChangesPerSecond, double InRevalidateSeconds)
+        : NumSessions(InNumSessions)
+        , DurationSeconds(InDurationSeconds)
+        , ChangesPerSecond(InChangesPerSecond)
+        , RevalidateSeconds(InRevalidateSeconds)
+    {
+    }
+
+    ~FKidPermissionLoadTest()
+    {
+        FTSTicker::GetCoreTicker().RemoveTicker(TickHandle);
+    }
+
+    bool Start()
+    {
+        Server = MakeUnique<FKidMockServer>();
+        Server->SetLatencySeconds(0.02);
+        if (!Server->Start(0))
+        {
+            return false;
+        }
+
+        FKidPermissionCache::FSettings Settings;
+        Settings.RevalidateIntervalSeconds = RevalidateSeconds;
+        Cache = MakeShared<FKidPermissionCache, ESPMode::ThreadSafe>(Server->GetBaseUrl(), TEXT("loadtest"), Settings);
+
+        PlayerIds.Reserve(NumSessions);
+        for (int32 Index = 0; Index < NumSessions; ++Index)
+        {
+            PlayerIds.Add(FString::Printf(TEXT("player-%d"), Index));
+            Cache->AddPlayer(PlayerIds.Last(), FString::Printf(TEXT("session-%d"), Index));
+        }
+
+        StartTime = FPlatformTime::Seconds();
+        LastReportTime = StartTime;
+
+        TWeakPtr<FKidPermissionLoadTest, ESPMode::ThreadSafe> WeakThis = AsShared();
+        TickHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda([WeakThis](float DeltaTime)
+        {
+            TSharedPtr<FKidPermissionLoadTest, ESPMode::ThreadSafe> This = WeakThis.Pin();
+            return This && This->Tick(DeltaTime);
+        }));
+        return true;
+    }
+
+    bool IsFinished() const { return bFinished; }
+
+private:
+    bool Tick(float DeltaTime)
+    {
+        const double Now = FPlatformTime::Seconds();
+
+        // parents changing permissions
+        ChangeBudget += ChangesPerSecond * DeltaTime;
+        for (; ChangeBudget >= 1.0; ChangeBudget -= 1.0)
+        {
+            Server->TouchSession(FString::Printf(TEXT("session-%d"), FMath::RandRange(0, NumSessions - 1)));
+        }
+
+        // gameplay checks, a batch per frame
+        static const FName Features[] = { TEXT("text-chat-private"), TEXT("voice-chat"), TEXT("multiplayer"), TEXT("in-game-purchases") };
+        const int32 NumLookups = 10000;
+        int32 NumAllowed = 0;
+        const double LookupStart = FPlatformTime::Seconds();
+        for (int32 Index = 0; Index < NumLookups; ++Index)
+        {
+            NumAllowed += Cache->IsFeatureAllowed(PlayerIds[(LookupCursor + Index) % NumSessions], Features[Index & 3]) ? 1 : 0;
+        }
+        LookupSeconds += FPlatformTime::Seconds() - LookupStart;
+        LookupCursor = (LookupCursor + NumLookups) % NumSessions;
+        TotalLookups += NumLookups;
+        TotalAllowed += NumAllowed;
+
+        if (Now - LastReportTime >= 5.0 || Now - StartTime >= DurationSeconds)
+        {
+            LastReportTime = Now;
+            Report(Now);
+        }
+
+        if (Now - StartTime < DurationSeconds)
+        {
+            return true;
+        }
+
+        Cache.Reset();
+        Server->Stop();
+        bFinished = true;
+        return false;
+    }
+
+    void Report(double Now) const
+    {
+        const FKidPermissionCache::FStats& Stats = Cache->GetStats();
+        const double Elapsed = Now - StartTime;
+        UE_LOG(LogTemp, Display, TEXT("kID permission cache after %.0f s: %d/%d sessions verified, %d in flight, ")
+                    TEXT("%lld requests (%.1f/s, %lld not modified, %lld updated, %lld failed), ")
+                    TEXT("IsFeatureAllowed %.0f ns per call over %lld calls (%.1f%% allowed)"),
+                    Elapsed, Stats.NumVerified, Stats.NumSessions, Stats.InFlight,
+                    Stats.Requests, Stats.Requests / FMath::Max(Elapsed, 1.0), Stats.NotModified, Stats.Updated, Stats.Failures,
+                    TotalLookups > 0 ? LookupSeconds * 1e9 / TotalLookups : 0.0, TotalLookups,
+                    TotalLookups > 0 ? 100.0 * TotalAllowed / TotalLookups : 0.0);
+    }
+
+    int32 NumSessions;
+    double DurationSeconds;
+    int32 ChangesPerSecond;
+    double RevalidateSeconds;
+
+    TUniquePtr<FKidMockServer> Server;
+    TSharedPtr<FKidPermissionCache, ESPMode::ThreadSafe> Cache;
+    TArray<FString> PlayerIds;
+
+    double StartTime = 0.0;
+    double LastReportTime = 0.0;
+    double ChangeBudget = 0.0;
+    double LookupSeconds = 0.0;
+    int32 LookupCursor = 0;
+    int64 TotalLookups = 0;
+    int64 TotalAllowed = 0;
+    bool bFinished = false;
+    FTSTicker::FDelegateHandle TickHandle;
+};
+
+static TSharedPtr<FKidPermissionLoadTest, ESPMode::ThreadSafe> ActivePermissionLoadTest;
+
+static FAutoConsoleCommand KidPermissionLoadTestCommand(
+    TEXT("kid.Server.LoadTest"),
+    TEXT("Load tests the server-side permission cache against a local stand-in server. ")
+    TEXT("Arguments: [Sessions=10000] [Seconds=60] [ChangesPerSecond=20] [RevalidateSeconds=20]"),
+    FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+    {
+        if (ActivePermissionLoadTest.IsValid() && !ActivePermissionLoadTest->IsFinished())
+        {
+            UE_LOG(LogTemp, Warning, TEXT("A kID permission cache load test is already running."));
+            return;
+        }
+
+        const int32 NumSessions = FMath::Max(1, Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 10000);
+        const double DurationSeconds = Args.Num() > 1 ? FCString::Atod(*Args[1]) : 60.0;
+        const int32 ChangesPerSecond = Args.Num() > 2 ? FCString::Atoi(*Args[2]) : 20;
+        const double RevalidateSeconds = Args.Num() > 3 ? FCString::Atod(*Args[3]) : 20.0;
+
+        ActivePermissionLoadTest = MakeShared<FKidPermissionLoadTest, ESPMode::ThreadSafe>(NumSessions, DurationSeconds, ChangesPerSecond, RevalidateSeconds);
+        if (!ActivePermissionLoadTest->Start())
+        {
+            UE_LOG(LogTemp, Error, TEXT("Could not start the kID mock server for the load test."));
+            ActivePermissionLoadTest.Reset();
+        }
+    }));
+
+#endif
@@ -0,0 +1,174 @@
+#include "KidPolicyCache.h"
+#include "KidCoreAdapter.h"
+#include "Misc/FileHelper.h"
+
+namespace
+{
+    TSharedPtr<FJsonObject> MakeDefaultSession(const KidCore::FBandDefaults& Defaults)
+    {
+        TSharedPtr<FJsonObject> Session = MakeShared<FJsonObject>();
+        if (!Defaults.AgeStatus.empty())
+        {
+            Session->SetStringField(TEXT("ageStatus"), KidFromUtf8(Defaults.AgeStatus));
+        }
+        Session->SetArrayField(TEXT("permissions"), KidWritePermissions(Defaults.Permissions));
+        return Session;
+    }
+}
+
+TFuture<int32> FKidPolicyCache::Load(const FString& InStoragePath)
+{
+    StoragePath = InStoragePath;
+
+    TFuture<KidCore::FPolicyBundle> Loaded = KidRunInBackground<KidCore::FPolicyBundle>([InStoragePath]()
+    {
+        KidCore::FPolicyBundle LoadedBundle;
+        TArray<uint8> Blob;
+        if (FFileHelper::LoadFileToArray(Blob, *InStoragePath, FILEREAD_Silent) && !LoadedBundle.Decode(Blob.GetData(), Blob.Num()))
+        {
+            UE_LOG(LogTemp, Warning, TEXT("Ignoring the cached kID policy bundle in %s, it is damaged or of another version."), *InStoragePath);
+        }
+        return LoadedBundle;
+    });
+
+    TWeakPtr<FKidPolicyCache, ESPMode::ThreadSafe> WeakThis = AsShared();
+    return MoveTemp(Loaded).Next([WeakThis](KidCore::FPolicyBundle LoadedBundle)
+    {
+        TSharedPtr<FKidPolicyCache, ESPMode::ThreadSafe> This = WeakThis.Pin();
+        if (!This)
+        {
+            return 0;
+        }
+
+        // anything recorded while the file was being read is newer than what is on disk
+        This->Bundle.MergeMissing(LoadedBundle);
+
+        const int32 NumJurisdictions = static_cast<int32>(This->Bundle.Num());
+        UE_LOG(LogTemp, Log, TEXT("Loaded the cached kID policy bundle, revision %u, with %d jurisdictions; the cache now holds %d"),
+                    LoadedBundle.GetRevision(), static_cast<int32>(LoadedBundle.Num()), NumJurisdictions);
+        return NumJurisdictions;
+    });
+}
+
+std::string FKidPolicyCache::MakeKey(const FString& Jurisdiction)
+{
+    return KidToUtf8(Jurisdiction.TrimStartAndEnd().ToUpper());
+}
+
+void FKidPolicyCache::RecordRequirements(const FString& Jurisdiction, const FKidAgeGateRequirements& Requirements)
+{
+    const std::string Key = MakeKey(Jurisdiction);
+    if (!Key.empty() && Bundle.SetRequirements(Key, Requirements.bShouldDisplay, Requirements.bAgeAssuranceRequired,
+                KidCore::FAgeThresholds{ Requirements.MinimumAge, Requirements.DigitalConsentAge, Requirements.CivilAge }))
+    {
+        Save();
+    }
+}
+
+void FKidPolicyCache::RecordDefaults(const FString& Jurisdiction, EKidAgeBand Band, const TSharedPtr<FJsonObject>& Session)
+{
+    if (!Session.IsValid())
+    {
+        return;
+    }
+
+    const std::string Key = MakeKey(Jurisdiction);
+    const KidCore::FJurisdictionPolicy* Policy = Bundle.Find(Key);
+    if (!Policy || Band == EKidAgeBand::Invalid)
+    {
+        return;
+    }
+
+    // /age-gate/get-default-permissions has no age status, so it keeps the one already learned
+    FString AgeStatus;
+    const std::string AgeStatusUtf8 = Session->TryGetStringField(TEXT("ageStatus"), AgeStatus) ? KidToUtf8(AgeStatus) : Policy->GetDefaults(Band).AgeStatus;
+    if (Bundle.SetDefaults(Key, Band, AgeStatusUtf8, KidReadPermissions(Session)))
+    {
+        UE_LOG(LogTemp, Log, TEXT("kID policy for %s learned the %s defaults, revision %u."), *Jurisdiction, LexToString(Band), Bundle.GetRevision());
+        Save();
+    }
+}
+
+void FKidPolicyCache::Invalidate(const FString& Jurisdiction)
+{
+    if (Bundle.Remove(MakeKey(Jurisdiction)))
+    {
+        Save();
+    }
+}
+
+FKidPolicyPrediction FKidPolicyCache::Predict(const FString& Jurisdiction, int32 Age) const
+{
+    FKidPolicyPrediction Prediction;
+    const KidCore::FJurisdictionPolicy* Policy = Bundle.Find(MakeKey(Jurisdiction));
+    if (!Policy)
+    {
+        return Prediction;
+    }
+
+    const KidCore::FPolicyPrediction CorePrediction = KidCore::PredictCheck(*Policy, Age);
+    Prediction.Status = CorePrediction.Status;
+    Prediction.Band = CorePrediction.Band;
+    if (CorePrediction.Defaults)
+    {
+        Prediction.Session = MakeDefaultSession(*CorePrediction.Defaults);
+    }
+    return Prediction;
+}
+
+TSharedPtr<FJsonObject> FKidPolicyCache::GetDefaultSession(const FString& Jurisdiction) const
+{
+    const KidCore::FJurisdictionPolicy* Policy = Bundle.Find(MakeKey(Jurisdiction));
+    if (!Policy || Policy->bShouldDisplay || !Policy->GetDefaults(EKidAgeBand::Adult).bKnown)
+    {
+        return nullptr;
+    }
+    return MakeDefaultSession(Policy->GetDefaults(EKidAgeBand::Adult));
+}
+
+bool FKidPolicyCache::HasDefaults(const FString& Jurisdiction, EKidAgeBand Band) const
+{
+    const KidCore::FJurisdictionPolicy* Policy = Bundle.Find(MakeKey(Jurisdiction));
+    return Policy && Band != EKidAgeBand::Invalid && Policy->GetDefaults(Band).bKnown;
+}
+
+void FKidPolicyCache::Save()
+{
+    if (StoragePath.IsEmpty())
+    {
+        return;
+    }
+
+    if (bSaveInFlight)
+    {
+        bSaveAgain = true;
+        return;
+    }
+
+    std::vector<uint8_t> Encoded;
+    Bundle.Encode(Encoded);
+    TArray<uint8> Blob(Encoded.data(), static_cast<int32>(Encoded.size()));
+
+    // Written off the game thread, one write at a time so an older revision can never land after a
+    // newer one.  Every save carries the whole bundle, so the single save that follows a write
+    // covers every change made during it.
+    bSaveInFlight = true;
+    TWeakPtr<FKidPolicyCache, ESPMode::ThreadSafe> WeakThis = AsShared();
+    Async(EAsyncExecution::ThreadPool, [WeakThis, Path = StoragePath, Blob = MoveTemp(Blob)]()
+    {
+        FFileHelper::SaveArrayToFile(Blob, *Path);
+
+        AsyncTask(ENamedThreads::GameThread, [WeakThis]()
+        {
+            if (TSharedPtr<FKidPolicyCache, ESPMode::ThreadSafe> This = WeakThis.Pin())
+            {
+                This->bSaveInFlight = false;
+                if (This->bSaveAgain)
+                {
+                    This->bSaveAgain = false;
+                    This->Save();
+                }
+            }
+        });
+    });
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Dom/JsonObject.h"
+#include "KidFlow.h"
+#include "KidAgeClassifier.h"
+#include "KidRequirementsCache.h"
+#include "KidCorePolicyBundle.h"
+
+// What the cached policy says /age-gate/check will answer
+struct FKidPolicyPrediction
+{
+    // Unknown when there is no policy for the jurisdiction or only the server can tell
+    KidCore::ECheckStatus Status = KidCore::ECheckStatus::Unknown;
+    EKidAgeBand Band = EKidAgeBand::Invalid;
+
+    // the defaults to play with until the server answers, set for a pass whose defaults are known
+    TSharedPtr<FJsonObject> Session;
+};
+
+// The age gate policy of every jurisdiction seen so far, persisted to disk as the core's compact
+// binary bundle, so the outcome of the age gate and the default permissions are known without
+// waiting on the network.
+//
+// Requirements and defaults are recorded as the server returns them, so each jurisdiction is only
+// fetched once.  The server still answers every flow; those answers confirm the predictions, and
+// a jurisdiction whose prediction the server contradicts is dropped and learned again.
+class FKidPolicyCache : public TSharedFromThis<FKidPolicyCache, ESPMode::ThreadSafe>
+{
+public:
+    // Reads the persisted bundle on the thread pool and merges it under what was recorded meanwhile.
+    // Resolves with the number of jurisdictions in the cache after the merge.  A bundle that is
+    // damaged or of another format version is ignored.
+    TFuture<int32> Load(const FString& InStoragePath);
+
+    void RecordRequirements(const FString& Jurisdiction, const FKidAgeGateRequirements& Requirements);
+
+    // Records the permissions and age status of a session as the defaults of an age band.  Only
+    // sessions fresh from /age-gate/check or /age-gate/get-default-permissions hold defaults.
+    void RecordDefaults(const FString& Jurisdiction, EKidAgeBand Band, const TSharedPtr<FJsonObject>& Session);
+
+    void Invalidate(const FString& Jurisdiction);
+
+    FKidPolicyPrediction Predict(const FString& Jurisdiction, int32 Age) const;
+
+    // the defaults of a jurisdiction that shows no age gate, which are those of an adult
+    TSharedPtr<FJsonObject> GetDefaultSession(const FString& Jurisdiction) const;
+
+    bool HasDefaults(const FString& Jurisdiction, EKidAgeBand Band) const;
+    uint32 GetRevision() const { return Bundle.GetRevision(); }
+
+private:
+    static std::string MakeKey(const FString& Jurisdiction);
+    void Save();
+
+    FString StoragePath;
+    KidCore::FPolicyBundle Bundle;
+
+    // only one write to StoragePath is in flight at a time, and changes made while it runs are
+    // written once it finishes
+    bool bSaveInFlight = false;
+    bool bSaveAgain = false;
+};
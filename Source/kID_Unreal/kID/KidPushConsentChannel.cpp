@@ -0,0 +1,186 @@
+#include "KidPushConsentChannel.h"
+#include "KidJsonDecoder.h"
+#include "WebSocketsModule.h"
+#include "IWebSocket.h"
+
+FKidPushConsentChannel::FKidPushConsentChannel(const FString& InPushUrl, const FString& InAuthToken,
+                const TSharedRef<FKidConsentAwaiter, ESPMode::ThreadSafe>& InFallback)
+    : PushUrl(InPushUrl)
+    , AuthToken(InAuthToken)
+    , Fallback(InFallback)
+{
+}
+
+FKidPushConsentChannel::~FKidPushConsentChannel()
+{
+    CloseSocket();
+    Fallback->Cancel();
+}
+
+void FKidPushConsentChannel::Start(const FString& InChallengeId, FDateTime InStartTime, int32 InTimeoutSeconds,
+                TFunction<void(const FKidConsentResult&)> InOnResolved)
+{
+    Cancel();
+
+    ChallengeId = InChallengeId;
+    StartTime = InStartTime;
+    TimeoutSeconds = InTimeoutSeconds;
+    OnResolved = MoveTemp(InOnResolved);
+    bActive = true;
+    bUsingFallback = false;
+
+    TWeakPtr<FKidPushConsentChannel, ESPMode::ThreadSafe> WeakThis = AsShared();
+
+    // the push only saves latency, so the deadline itself is enforced by a final poll
+    const double RemainingSeconds = (StartTime + FTimespan::FromSeconds(TimeoutSeconds) - FDateTime::UtcNow()).GetTotalSeconds();
+    DeadlineHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda([WeakThis](float DeltaTime)
+    {
+        if (TSharedPtr<FKidPushConsentChannel, ESPMode::ThreadSafe> This = WeakThis.Pin())
+        {
+            This->DeadlineHandle.Reset();
+            This->FallBackToPolling(TEXT("the deadline passed"));
+        }
+        return false;
+    }), FMath::Max(0.0, RemainingSeconds));
+
+    TMap<FString, FString> Headers;
+    Headers.Add(TEXT("Authorization"), TEXT("Bearer ") + AuthToken);
+
+    FModuleManager::LoadModuleChecked<FWebSocketsModule>(TEXT("WebSockets"));
+    Socket = FWebSocketsModule::Get().CreateWebSocket(PushUrl + TEXT("?challengeId=") + ChallengeId, TEXT(""), Headers);
+    ConnectionCount++;
+
+    Socket->OnConnectionError().AddLambda([WeakThis](const FString& Error)
+    {
+        if (TSharedPtr<FKidPushConsentChannel, ESPMode::ThreadSafe> This = WeakThis.Pin())
+        {
+            UE_LOG(LogTemp, Warning, TEXT("Consent push connection failed: %s"), *Error);
+            This->FallBackToPolling(TEXT("the connection failed"));
+        }
+    });
+    Socket->OnClosed().AddLambda([WeakThis](int32 StatusCode, const FString& Reason, bool bWasClean)
+    {
+        if (TSharedPtr<FKidPushConsentChannel, ESPMode::ThreadSafe> This = WeakThis.Pin())
+        {
+            This->FallBackToPolling(TEXT("the connection closed"));
+        }
+    });
+    Socket->OnMessage().AddLambda([WeakThis](const FString& Message)
+    {
+        if (TSharedPtr<FKidPushConsentChannel, ESPMode::ThreadSafe> This = WeakThis.Pin())
+        {
+            This->OnMessage(Message);
+        }
+    });
+
+    Socket->Connect();
+}
+
+void FKidPushConsentChannel::Cancel()
+{
+    if (!bActive)
+    {
+        return;
+    }
+
+    if (bUsingFallback)
+    {
+        // resolves through the fallback's callback
+        Fallback->Cancel();
+    }
+    else
+    {
+        FKidConsentResult Result;
+        Result.Status = EKidConsentStatus::Cancelled;
+        Resolve(Result);
+    }
+}
+
+void FKidPushConsentChannel::OnMessage(const FString& Message)
+{
+    if (!bActive || bUsingFallback)
+    {
+        return;
+    }
+
+    FKidChallengeStatus ChallengeStatus;
+    if (!FKidJsonDecoder::Decode(Message, ChallengeStatus) || ChallengeStatus.ChallengeId != ChallengeId)
+    {
+        return;
+    }
+
+    FKidConsentResult Result;
+    if (ChallengeStatus.Status == TEXT("PASS"))
+    {
+        Result.Status = EKidConsentStatus::Granted;
+        Result.SessionId = MoveTemp(ChallengeStatus.SessionId);
+        Result.ApproverEmail = MoveTemp(ChallengeStatus.ApproverEmail);
+        Resolve(Result);
+    }
+    else if (ChallengeStatus.Status == TEXT("FAIL"))
+    {
+        Result.Status = EKidConsentStatus::Denied;
+        Resolve(Result);
+    }
+}
+
+void FKidPushConsentChannel::FallBackToPolling(const TCHAR* Reason)
+{
+    if (!bActive || bUsingFallback)
+    {
+        return;
+    }
+
+    UE_LOG(LogTemp, Log, TEXT("Falling back to polling for consent because %s."), Reason);
+    bUsingFallback = true;
+    CloseSocket();
+
+    TWeakPtr<FKidPushConsentChannel, ESPMode::ThreadSafe> WeakThis = AsShared();
+    Fallback->Start(ChallengeId, StartTime, TimeoutSeconds, [WeakThis](const FKidConsentResult& Result)
+    {
+        if (TSharedPtr<FKidPushConsentChannel, ESPMode::ThreadSafe> This = WeakThis.Pin())
+        {
+            This->Resolve(Result);
+        }
+    });
+}
+
+void FKidPushConsentChannel::Resolve(const FKidConsentResult& Result)
+{
+    if (!bActive)
+    {
+        return;
+    }
+    bActive = false;
+    CloseSocket();
+
+    TFunction<void(const FKidConsentResult&)> Callback = MoveTemp(OnResolved);
+    OnResolved = nullptr;
+    if (Callback)
+    {
+        Callback(Result);
+    }
+}
+
+void FKidPushConsentChannel::CloseSocket()
+{
+    if (DeadlineHandle.IsValid())
+    {
+        FTSTicker::GetCoreTicker().RemoveTicker(DeadlineHandle);
+        DeadlineHandle.Reset();
+    }
+
+    if (Socket.IsValid())
+    {
+        // unbind first so closing does not report back into this channel
+        TSharedPtr<IWebSocket> ClosingSocket = MoveTemp(Socket);
+        Socket.Reset();
+        ClosingSocket->OnConnectionError().Clear();
+        ClosingSocket->OnClosed().Clear();
+        ClosingSocket->OnMessage().Clear();
+        if (ClosingSocket->IsConnected())
+        {
+            ClosingSocket->Close();
+        }
+    }
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+#include "KidConsentChannel.h"
+#include "KidConsentAwaiter.h"
+
+class IWebSocket;
+
+// Receives challenge status changes pushed by the server over a WebSocket.
+//
+// The server is expected to send the current status as soon as the subscription is open and
+// again whenever it changes, as JSON of the form {"challengeId", "status", "sessionId", "approverEmail"}.
+// If the connection cannot be opened, drops before the challenge is resolved, or the deadline
+// passes, the channel falls back to long polling for whatever time remains, so a missed push
+// costs latency rather than the result.
+class FKidPushConsentChannel : public IKidConsentChannel, public TSharedFromThis<FKidPushConsentChannel, ESPMode::ThreadSafe>
+{
+public:
+    FKidPushConsentChannel(const FString& InPushUrl, const FString& InAuthToken,
+                const TSharedRef<FKidConsentAwaiter, ESPMode::ThreadSafe>& InFallback);
+    virtual ~FKidPushConsentChannel();
+
+    // IKidConsentChannel
+    virtual void Start(const FString& InChallengeId, FDateTime InStartTime, int32 InTimeoutSeconds,
+                TFunction<void(const FKidConsentResult&)> InOnResolved) override;
+    virtual void Cancel() override;
+    virtual bool IsActive() const override { return bActive; }
+    virtual int32 GetRequestCount() const override { return ConnectionCount + Fallback->GetRequestCount(); }
+
+    bool IsUsingFallback() const { return bUsingFallback; }
+
+private:
+    void OnMessage(const FString& Message);
+    void FallBackToPolling(const TCHAR* Reason);
+    void Resolve(const FKidConsentResult& Result);
+    void CloseSocket();
+
+    FString PushUrl;
+    FString AuthToken;
+    TSharedRef<FKidConsentAwaiter, ESPMode::ThreadSafe> Fallback;
+
+    FString ChallengeId;
+    FDateTime StartTime;
+    int32 TimeoutSeconds = 0;
+    TFunction<void(const FKidConsentResult&)> OnResolved;
+
+    bool bActive = false;
+    bool bUsingFallback = false;
+    int32 ConnectionCount = 0;
+
+    TSharedPtr<IWebSocket> Socket;
+    FTSTicker::FDelegateHandle DeadlineHandle;
+};
@@ -0,0 +1,57 @@
+#include "KidRefreshSchedule.h"
+
+void FKidRefreshSchedule::Start(const FKidRefreshSettings& Settings, double Now)
+{
+    StartTime = Now;
+    IntervalSeconds = Settings.BaseIntervalSeconds;
+    PendingChangeUntil = 0.0;
+    NumRefreshes = 0;
+
+    if (Settings.MaxRefreshesPerHour > 0.0f && 3600.0 / Settings.MaxRefreshesPerHour > Settings.PendingChangeIntervalSeconds)
+    {
+        UE_LOG(LogTemp, Warning, TEXT("kID session refreshes are capped at %.0f an hour, so a pending change is refreshed every %.0f s instead of every %.0f s."),
+                    Settings.MaxRefreshesPerHour, 3600.0 / Settings.MaxRefreshesPerHour, Settings.PendingChangeIntervalSeconds);
+    }
+}
+
+double FKidRefreshSchedule::GetNextDelay(const FKidRefreshSettings& Settings, double Now) const
+{
+    double Interval = Now < PendingChangeUntil ? FMath::Min<double>(IntervalSeconds, Settings.PendingChangeIntervalSeconds) : IntervalSeconds;
+
+    if (Settings.MaxRefreshesPerHour > 0.0f)
+    {
+        Interval = FMath::Max(Interval, 3600.0 / Settings.MaxRefreshesPerHour);
+    }
+
+    const double Jitter = FMath::Clamp<double>(Settings.JitterFraction, 0.0, 1.0);
+    return Interval * FMath::FRandRange(1.0 - Jitter, 1.0 + Jitter);
+}
+
+void FKidRefreshSchedule::OnRefreshed(const FKidRefreshSettings& Settings, EKidRefreshOutcome Outcome)
+{
+    NumRefreshes++;
+
+    switch (Outcome)
+    {
+    case EKidRefreshOutcome::Changed:
+        IntervalSeconds = Settings.BaseIntervalSeconds;
+        PendingChangeUntil = 0.0;
+        break;
+
+    case EKidRefreshOutcome::Unchanged:
+    case EKidRefreshOutcome::Failed:
+        IntervalSeconds = FMath::Min<double>(IntervalSeconds * Settings.BackoffFactor, Settings.MaxIntervalSeconds);
+        break;
+    }
+}
+
+void FKidRefreshSchedule::ExpectChange(const FKidRefreshSettings& Settings, double Now)
+{
+    PendingChangeUntil = Now + Settings.PendingChangeWindowSeconds;
+}
+
+double FKidRefreshSchedule::GetRefreshesPerHour(double Now) const
+{
+    const double Hours = (Now - StartTime) / 3600.0;
+    return Hours > 0.0 ? NumRefreshes / Hours : 0.0;
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "KidRefreshSchedule.generated.h"
+
+// How often a session is re-fetched in the background.  Set from config, e.g.
+// SessionRefresh=(BaseIntervalSeconds=120,MaxRefreshesPerHour=240)
+USTRUCT()
+struct FKidRefreshSettings
+{
+    GENERATED_BODY()
+
+    // interval after a session has changed, and the starting interval
+    UPROPERTY()
+    float BaseIntervalSeconds = 120.0f;
+
+    // interval while a change is expected, e.g. after an upgrade challenge was created
+    UPROPERTY()
+    float PendingChangeIntervalSeconds = 15.0f;
+
+    // how long a change is expected for
+    UPROPERTY()
+    float PendingChangeWindowSeconds = 600.0f;
+
+    // each refresh that finds the session unchanged multiplies the interval by this, up to the maximum
+    UPROPERTY()
+    float BackoffFactor = 1.5f;
+
+    UPROPERTY()
+    float MaxIntervalSeconds = 1800.0f;
+
+    // every interval is scaled by a random factor in [1 - JitterFraction, 1 + JitterFraction]
+    UPROPERTY()
+    float JitterFraction = 0.2f;
+
+    // Hard cap on the request rate per active player, whatever the other settings say.  It also
+    // floors PendingChangeIntervalSeconds, so it has to be at least 3600 / that interval (240 for
+    // 15 seconds) for the interval to be used.
+    UPROPERTY()
+    float MaxRefreshesPerHour = 240.0f;
+};
+
+enum class EKidRefreshOutcome : uint8
+{
+    Changed,
+    Unchanged,
+    Failed
+};
+
+// When one session should next be refreshed.  Stable sessions are refreshed less and less often,
+// a change resets the interval, and a change that is known to be pending (such as an upgrade
+// waiting on a parent) shortens it for a while.  Every delay is jittered so that sessions that
+// started together drift apart instead of refreshing in bursts.
+class FKidRefreshSchedule
+{
+public:
+    void Start(const FKidRefreshSettings& Settings, double Now);
+    bool IsStarted() const { return StartTime > 0.0; }
+
+    // Seconds from now until the next refresh
+    double GetNextDelay(const FKidRefreshSettings& Settings, double Now) const;
+
+    void OnRefreshed(const FKidRefreshSettings& Settings, EKidRefreshOutcome Outcome);
+    void ExpectChange(const FKidRefreshSettings& Settings, double Now);
+
+    // measured request rate since Start()
+    int32 GetNumRefreshes() const { return NumRefreshes; }
+    double GetRefreshesPerHour(double Now) const;
+
+private:
+    double StartTime = 0.0;
+    double IntervalSeconds = 0.0;
+    double PendingChangeUntil = 0.0;
+    int32 NumRefreshes = 0;
+};
@@ -0,0 +1,52 @@
+#include "KidRefreshSchedule.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/ConfigCacheIni.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+// A pending change is refreshed at PendingChangeIntervalSeconds under the default settings and
+// under the ones shipped in DefaultGame.ini, rather than at the floor MaxRefreshesPerHour sets.
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FKidRefreshSchedulePendingIntervalTest, "kID.RefreshSchedule.PendingInterval",
+            EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::EngineFilter)
+
+bool FKidRefreshSchedulePendingIntervalTest::RunTest(const FString& Parameters)
+{
+    TArray<TPair<FString, FKidRefreshSettings>> Configurations;
+    Configurations.Emplace(TEXT("defaults"), FKidRefreshSettings());
+
+    // every local player runs a UKidWorkflow, so its schedule is the only one shipped
+    for (const TCHAR* Section : { TEXT("/Script/kID_Unreal.KidWorkflow") })
+    {
+        FString Value;
+        if (!TestTrue(FString::Printf(TEXT("%s has SessionRefresh"), Section), GConfig->GetString(Section, TEXT("SessionRefresh"), Value, GGameIni)))
+        {
+            continue;
+        }
+
+        FKidRefreshSettings Shipped;
+        TestNotNull(FString::Printf(TEXT("%s SessionRefresh parses"), Section),
+                    FKidRefreshSettings::StaticStruct()->ImportText(*Value, &Shipped, nullptr, PPF_None, GLog, TEXT("SessionRefresh")));
+        Configurations.Emplace(Section, Shipped);
+    }
+
+    for (TPair<FString, FKidRefreshSettings>& Configuration : Configurations)
+    {
+        FKidRefreshSettings& Settings = Configuration.Value;
+        Settings.JitterFraction = 0.0f;
+
+        FKidRefreshSchedule Schedule;
+        const double Now = 1000.0;
+        Schedule.Start(Settings, Now);
+        TestEqual(FString::Printf(TEXT("%s: interval with nothing pending"), *Configuration.Key),
+                    Schedule.GetNextDelay(Settings, Now), FMath::Max<double>(Settings.BaseIntervalSeconds, 3600.0 / Settings.MaxRefreshesPerHour));
+
+        Schedule.ExpectChange(Settings, Now);
+        TestEqual(FString::Printf(TEXT("%s: interval while a change is pending"), *Configuration.Key),
+                    Schedule.GetNextDelay(Settings, Now), static_cast<double>(Settings.PendingChangeIntervalSeconds));
+        TestEqual(FString::Printf(TEXT("%s: interval once the pending window is over"), *Configuration.Key),
+                    Schedule.GetNextDelay(Settings, Now + Settings.PendingChangeWindowSeconds), FMath::Max<double>(Settings.BaseIntervalSeconds, 3600.0 / Settings.MaxRefreshesPerHour));
+    }
+    return true;
+}
+
+#endif
@@ -0,0 +1,13 @@
+#include "KidRequestBody.h"
+
+void FKidRequestWriter::WriteString(FStringView Value)
+{
+    Writer.String(Value.GetData(), static_cast<size_t>(Value.Len()));
+}
+
+std::string& KidGetRequestBuffer()
+{
+    static thread_local std::string Buffer;
+    Buffer.clear();
+    return Buffer;
+}
@@ -0,0 +1,193 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "KidCoreJson.h"
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+// Typed bodies of the kID POST requests.  Each request lists its JSON fields once in VisitFields,
+// and FKidRequestWriter expands that list at compile time into calls on the core's JSON writer,
+// which writes the fields in order straight into a UTF-8 buffer.  String fields are views, so
+// filling in a request copies nothing, and an unset TOptional field is left out of the body.
+//
+// The serialized body is a view into a buffer owned by the calling thread, which the next
+// KidSerializeRequest on that thread overwrites.  Pass it straight to HttpRequestHelper, which
+// copies it into the request, and never keep it.
+//
+//   FKidCheckAgeRequest Request{ DOB, Location };
+//   HttpRequestHelper::PostRequestWithAuthAsync(Url, KidSerializeRequest(Request), AuthToken, Flow);
+
+// /auth/issue-token
+struct FKidIssueTokenRequest
+{
+    FStringView ClientId;
+
+    template <typename VisitorType>
+    static void VisitFields(VisitorType&& Visit)
+    {
+        Visit("clientId", &FKidIssueTokenRequest::ClientId);
+    }
+};
+
+// /age-gate/check
+struct FKidCheckAgeRequest
+{
+    FStringView DateOfBirth;
+    FStringView Jurisdiction;
+
+    template <typename VisitorType>
+    static void VisitFields(VisitorType&& Visit)
+    {
+        Visit("dateOfBirth", &FKidCheckAgeRequest::DateOfBirth);
+        Visit("jurisdiction", &FKidCheckAgeRequest::Jurisdiction);
+    }
+};
+
+// /challenge/send-email
+struct FKidSendEmailRequest
+{
+    FStringView Email;
+    FStringView ChallengeId;
+
+    template <typename VisitorType>
+    static void VisitFields(VisitorType&& Visit)
+    {
+        Visit("email", &FKidSendEmailRequest::Email);
+        Visit("challengeId", &FKidSendEmailRequest::ChallengeId);
+    }
+};
+
+struct FKidRequestedPermission
+{
+    FStringView Name;
+
+    template <typename VisitorType>
+    static void VisitFields(VisitorType&& Visit)
+    {
+        Visit("name", &FKidRequestedPermission::Name);
+    }
+};
+
+// /session/upgrade
+struct FKidUpgradeSessionRequest
+{
+    FStringView SessionId;
+    TConstArrayView<FKidRequestedPermission> RequestedPermissions;
+
+    template <typename VisitorType>
+    static void VisitFields(VisitorType&& Visit)
+    {
+        Visit("sessionId", &FKidUpgradeSessionRequest::SessionId);
+        Visit("requestedPermissions", &FKidUpgradeSessionRequest::RequestedPermissions);
+    }
+};
+
+// /test/set-challenge-status
+struct FKidSetChallengeStatusRequest
+{
+    FStringView Status;
+    FStringView ChallengeId;
+    TOptional<FStringView> Jurisdiction;
+    TOptional<int32> Age;
+
+    template <typename VisitorType>
+    static void VisitFields(VisitorType&& Visit)
+    {
+        Visit("status", &FKidSetChallengeStatusRequest::Status);
+        Visit("challengeId", &FKidSetChallengeStatusRequest::ChallengeId);
+        Visit("jurisdiction", &FKidSetChallengeStatusRequest::Jurisdiction);
+        Visit("age", &FKidSetChallengeStatusRequest::Age);
+    }
+};
+
+template <typename T> struct TKidIsOptional { static constexpr bool Value = false; };
+template <typename T> struct TKidIsOptional<TOptional<T>> { static constexpr bool Value = true; };
+
+// Expands the request's field list into calls on the core's JSON writer, which appends compact
+// JSON to a caller-owned string.  The string is never shrunk, so a buffer that is reused stops
+// allocating once it has grown to fit the largest body.
+class FKidRequestWriter
+{
+public:
+    explicit FKidRequestWriter(std::string& InBuffer)
+        : Writer(InBuffer)
+    {
+    }
+
+    template <typename RequestType>
+    void WriteObject(const RequestType& Request)
+    {
+        Writer.BeginObject();
+        RequestType::VisitFields([this, &Request](const auto& Name, auto Member)
+        {
+            // field names are ASCII literals and need no escaping
+            const std::string_view Key(Name, sizeof(Name) - 1);
+            const auto& Value = Request.*Member;
+            if constexpr (TKidIsOptional<std::decay_t<decltype(Value)>>::Value)
+            {
+                if (Value.IsSet())
+                {
+                    Writer.Key(Key);
+                    WriteValue(Value.GetValue());
+                }
+            }
+            else
+            {
+                Writer.Key(Key);
+                WriteValue(Value);
+            }
+        });
+        Writer.EndObject();
+    }
+
+    template <typename ValueType>
+    void WriteValue(const ValueType& Value)
+    {
+        if constexpr (std::is_same_v<ValueType, bool>)
+        {
+            Writer.Bool(Value);
+        }
+        else if constexpr (std::is_integral_v<ValueType>)
+        {
+            Writer.Integer(static_cast<int64_t>(Value));
+        }
+        else if constexpr (std::is_same_v<ValueType, FStringView> || std::is_same_v<ValueType, FString>)
+        {
+            WriteString(Value);
+        }
+        else if constexpr (TIsContiguousContainer<ValueType>::Value)
+        {
+            Writer.BeginArray();
+            for (const auto& Element : Value)
+            {
+                WriteValue(Element);
+            }
+            Writer.EndArray();
+        }
+        else
+        {
+            WriteObject(Value);
+        }
+    }
+
+    // Encodes the string as UTF-8 straight into the buffer, quoted and escaped
+    void WriteString(FStringView Value);
+
+private:
+    KidCore::FJsonWriter Writer;
+};
+
+// The calling thread's request buffer, emptied with its allocation kept
+std::string& KidGetRequestBuffer();
+
+// Serializes the request into the calling thread's reusable buffer.  The view is valid until the
+// next call on the same thread, which is enough to hand it to HttpRequestHelper.
+template <typename RequestType>
+TConstArrayView<uint8> KidSerializeRequest(const RequestType& Request)
+{
+    std::string& Buffer = KidGetRequestBuffer();
+    FKidRequestWriter Writer(Buffer);
+    Writer.WriteObject(Request);
+    return TConstArrayView<uint8>(reinterpret_cast<const uint8*>(Buffer.data()), static_cast<int32>(Buffer.size()));
+}
@@ -0,0 +1,294 @@
+#include "KidRequirementsCache.h"
+#include "HttpRequestHelper.h"
+#include "KidJsonDecoder.h"
+#include "Json.h"
+#include "Misc/FileHelper.h"
+
+bool FKidAgeGateRequirements::FromJson(const TSharedPtr<FJsonObject>& JsonObject)
+{
+    if (!JsonObject.IsValid())
+    {
+        return false;
+    }
+
+    bShouldDisplay = JsonObject->GetBoolField(TEXT("shouldDisplay"));
+    bAgeAssuranceRequired = JsonObject->GetBoolField(TEXT("ageAssuranceRequired"));
+    DigitalConsentAge = JsonObject->GetIntegerField(TEXT("digitalConsentAge"));
+    CivilAge = JsonObject->GetIntegerField(TEXT("civilAge"));
+    MinimumAge = JsonObject->GetIntegerField(TEXT("minimumAge"));
+
+    ApprovedAgeCollectionMethods.Reset();
+    const TArray<TSharedPtr<FJsonValue>>* Methods = nullptr;
+    if (JsonObject->TryGetArrayField(TEXT("approvedAgeCollectionMethods"), Methods))
+    {
+        for (const TSharedPtr<FJsonValue>& Value : *Methods)
+        {
+            ApprovedAgeCollectionMethods.Add(Value->AsString());
+        }
+    }
+    return true;
+}
+
+TSharedRef<FJsonObject> FKidAgeGateRequirements::ToJson() const
+{
+    TSharedRef<FJsonObject> JsonObject = MakeShared<FJsonObject>();
+    JsonObject->SetBoolField(TEXT("shouldDisplay"), bShouldDisplay);
+    JsonObject->SetBoolField(TEXT("ageAssuranceRequired"), bAgeAssuranceRequired);
+    JsonObject->SetNumberField(TEXT("digitalConsentAge"), DigitalConsentAge);
+    JsonObject->SetNumberField(TEXT("civilAge"), CivilAge);
+    JsonObject->SetNumberField(TEXT("minimumAge"), MinimumAge);
+
+    TArray<TSharedPtr<FJsonValue>> Methods;
+    for (const FString& Method : ApprovedAgeCollectionMethods)
+    {
+        Methods.Add(MakeShared<FJsonValueString>(Method));
+    }
+    JsonObject->SetArrayField(TEXT("approvedAgeCollectionMethods"), Methods);
+    return JsonObject;
+}
+
+void FKidRequirementsCache::SetEndpoint(const FString& InBaseUrl, const FString& InAuthToken)
+{
+    BaseUrl = InBaseUrl;
+    AuthToken = InAuthToken;
+}
+
+void FKidRequirementsCache::SetTimeToLive(double InTimeToLiveSeconds, double InMaxStaleSeconds)
+{
+    TimeToLiveSeconds = InTimeToLiveSeconds;
+    MaxStaleSeconds = FMath::Max(InTimeToLiveSeconds, InMaxStaleSeconds);
+}
+
+TFuture<int32> FKidRequirementsCache::Load(const FString& InStoragePath)
+{
+    StoragePath = InStoragePath;
+
+    TFuture<TMap<FString, FKidCachedRequirements>> Loaded = KidRunInBackground<TMap<FString, FKidCachedRequirements>>([InStoragePath]()
+    {
+        TMap<FString, FKidCachedRequirements> Requirements;
+
+        FString JsonString;
+        TSharedPtr<FJsonObject> JsonObject;
+        if (!FFileHelper::LoadFileToString(JsonString, *InStoragePath) ||
+            !FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(JsonString), JsonObject))
+        {
+            return Requirements;
+        }
+
+        const TSharedPtr<FJsonObject>* Jurisdictions = nullptr;
+        if (JsonObject->TryGetObjectField(TEXT("jurisdictions"), Jurisdictions))
+        {
+            for (const TPair<FString, TSharedPtr<FJsonValue>>& Pair : (*Jurisdictions)->Values)
+            {
+                const TSharedPtr<FJsonObject> EntryObject = Pair.Value->AsObject();
+                FKidCachedRequirements Cached;
+                if (EntryObject.IsValid() && Cached.Requirements.FromJson(EntryObject->GetObjectField(TEXT("requirements"))))
+                {
+                    Cached.FetchedAt = FDateTime::FromUnixTimestamp(static_cast<int64>(EntryObject->GetNumberField(TEXT("fetchedAt"))));
+                    Requirements.Add(Pair.Key, Cached);
+                }
+            }
+        }
+        return Requirements;
+    });
+
+    TWeakPtr<FKidRequirementsCache, ESPMode::ThreadSafe> WeakThis = AsShared();
+    return MoveTemp(Loaded).Next([WeakThis](TMap<FString, FKidCachedRequirements> Requirements)
+    {
+        TSharedPtr<FKidRequirementsCache, ESPMode::ThreadSafe> This = WeakThis.Pin();
+        if (!This)
+        {
+            return 0;
+        }
+
+        // anything fetched while the file was being read is newer than what is on disk
+        for (TPair<FString, FKidCachedRequirements>& Pair : Requirements)
+        {
+            FEntry& Entry = This->Entries.FindOrAdd(Pair.Key);
+            if (!Entry.bHasValue)
+            {
+                Entry.bHasValue = true;
+                Entry.Cached = MoveTemp(Pair.Value);
+            }
+        }
+
+        UE_LOG(LogTemp, Log, TEXT("Loaded cached age gate requirements for %d jurisdictions"), Requirements.Num());
+        return Requirements.Num();
+    });
+}
+
+FString FKidRequirementsCache::MakeKey(const FString& Jurisdiction)
+{
+    return Jurisdiction.TrimStartAndEnd().ToUpper();
+}
+
+double FKidRequirementsCache::GetAgeSeconds(const FEntry& Entry) const
+{
+    return (FDateTime::UtcNow() - Entry.Cached.FetchedAt).GetTotalSeconds();
+}
+
+bool FKidRequirementsCache::Contains(const FString& Jurisdiction) const
+{
+    const FEntry* Entry = Entries.Find(MakeKey(Jurisdiction));
+    return Entry && Entry->bHasValue;
+}
+
+void FKidRequirementsCache::ForEachCached(TFunctionRef<void(const FString&, const FKidAgeGateRequirements&)> Visitor) const
+{
+    for (const TPair<FString, FEntry>& Pair : Entries)
+    {
+        if (Pair.Value.bHasValue)
+        {
+            Visitor(Pair.Key, Pair.Value.Cached.Requirements);
+        }
+    }
+}
+
+TFuture<FKidRequirementsResult> FKidRequirementsCache::Get(const FString& Jurisdiction)
+{
+    const FString Key = MakeKey(Jurisdiction);
+    FEntry& Entry = Entries.FindOrAdd(Key);
+
+    if (Entry.bHasValue)
+    {
+        const double AgeSeconds = GetAgeSeconds(Entry);
+        if (AgeSeconds < MaxStaleSeconds)
+        {
+            FKidRequirementsResult Result{ true, Entry.Cached.Requirements };
+            if (AgeSeconds >= TimeToLiveSeconds && !Entry.bFetching)
+            {
+                UE_LOG(LogTemp, Log, TEXT("Revalidating age gate requirements for %s in the background"), *Key);
+                Fetch(Key);
+            }
+            return MakeFulfilledPromise<FKidRequirementsResult>(MoveTemp(Result)).GetFuture();
+        }
+    }
+
+    TSharedRef<TKidPromise<FKidRequirementsResult>> Waiter = MakeShared<TKidPromise<FKidRequirementsResult>>();
+    TFuture<FKidRequirementsResult> Future = Waiter->GetFuture();
+    Entries.FindChecked(Key).Waiters.Add(Waiter);
+
+    if (!Entries.FindChecked(Key).bFetching)
+    {
+        Fetch(Key);
+    }
+    return Future;
+}
+
+void FKidRequirementsCache::Prefetch(const FString& Jurisdiction)
+{
+    const FString Key = MakeKey(Jurisdiction);
+    if (Key.IsEmpty())
+    {
+        return;
+    }
+
+    FEntry& Entry = Entries.FindOrAdd(Key);
+    if (!Entry.bFetching && (!Entry.bHasValue || GetAgeSeconds(Entry) >= TimeToLiveSeconds))
+    {
+        UE_LOG(LogTemp, Log, TEXT("Prefetching age gate requirements for %s"), *Key);
+        Fetch(Key);
+    }
+}
+
+void FKidRequirementsCache::Fetch(const FString& Key)
+{
+    Entries.FindChecked(Key).bFetching = true;
+
+    TWeakPtr<FKidRequirementsCache, ESPMode::ThreadSafe> WeakThis = AsShared();
+    HttpRequestHelper::GetRequestWithAuth(BaseUrl + TEXT("/age-gate/get-requirements?jurisdiction=") + Key, AuthToken,
+                [WeakThis, Key](FHttpResponsePtr Response, bool bWasSuccessful)
+    {
+        if (TSharedPtr<FKidRequirementsCache, ESPMode::ThreadSafe> This = WeakThis.Pin())
+        {
+            This->OnFetched(Key, Response, bWasSuccessful);
+        }
+    });
+}
+
+void FKidRequirementsCache::OnFetched(const FString& Key, FHttpResponsePtr Response, bool bWasSuccessful)
+{
+    FEntry& Entry = Entries.FindOrAdd(Key);
+    Entry.bFetching = false;
+
+    FKidRequirementsResult Result;
+    if (bWasSuccessful && Response.IsValid())
+    {
+        if (FKidJsonDecoder::Decode(Response->GetContent(), Result.Requirements))
+        {
+            Result.bSuccess = true;
+            Entry.bHasValue = true;
+            Entry.Cached.Requirements = Result.Requirements;
+            Entry.Cached.FetchedAt = FDateTime::UtcNow();
+        }
+    }
+
+    // a failed revalidation keeps serving the stale copy, and waiters are only left
+    // when there was nothing usable in the cache
+    TArray<TSharedRef<TKidPromise<FKidRequirementsResult>>> Waiters = MoveTemp(Entry.Waiters);
+    for (const TSharedRef<TKidPromise<FKidRequirementsResult>>& Waiter : Waiters)
+    {
+        Waiter->SetValue(Result);
+    }
+
+    if (Result.bSuccess)
+    {
+        Save();
+    }
+}
+
+void FKidRequirementsCache::Save()
+{
+    if (StoragePath.IsEmpty())
+    {
+        return;
+    }
+
+    if (bSaveInFlight)
+    {
+        bSaveAgain = true;
+        return;
+    }
+
+    TSharedRef<FJsonObject> Jurisdictions = MakeShared<FJsonObject>();
+    for (const TPair<FString, FEntry>& Pair : Entries)
+    {
+        if (Pair.Value.bHasValue)
+        {
+            TSharedRef<FJsonObject> EntryObject = MakeShared<FJsonObject>();
+            EntryObject->SetNumberField(TEXT("fetchedAt"), static_cast<double>(Pair.Value.Cached.FetchedAt.ToUnixTimestamp()));
+            EntryObject->SetObjectField(TEXT("requirements"), Pair.Value.Cached.Requirements.ToJson());
+            Jurisdictions->SetObjectField(Pair.Key, EntryObject);
+        }
+    }
+
+    TSharedRef<FJsonObject> JsonObject = MakeShared<FJsonObject>();
+    JsonObject->SetObjectField(TEXT("jurisdictions"), Jurisdictions);
+
+    FString JsonString;
+    TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&JsonString);
+    FJsonSerializer::Serialize(JsonObject, Writer);
+
+    // Written off the game thread, one write at a time so two writes never interleave in the file.
+    // Every save carries the whole cache, so the changes that arrive during a write are all covered
+    // by the single save that follows it.
+    bSaveInFlight = true;
+    TWeakPtr<FKidRequirementsCache, ESPMode::ThreadSafe> WeakThis = AsShared();
+    Async(EAsyncExecution::ThreadPool, [WeakThis, Path = StoragePath, JsonString = MoveTemp(JsonString)]()
+    {
+        FFileHelper::SaveStringToFile(JsonString, *Path);
+
+        AsyncTask(ENamedThreads::GameThread, [WeakThis]()
+        {
+            if (TSharedPtr<FKidRequirementsCache, ESPMode::ThreadSafe> This = WeakThis.Pin())
+            {
+                This->bSaveInFlight = false;
+                if (This->bSaveAgain)
+                {
+                    This->bSaveAgain = false;
+                    This->Save();
+                }
+            }
+        });
+    });
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Dom/JsonObject.h"
+#include "KidFlow.h"
+
+// Age gate requirements for one jurisdiction, as returned by /age-gate/get-requirements
+struct FKidAgeGateRequirements
+{
+    bool bShouldDisplay = false;
+    bool bAgeAssuranceRequired = false;
+
+    // Extra information about the jurisdiction.  Can be used to further customize the age gate.
+    int32 DigitalConsentAge = 0;
+    int32 CivilAge = 0;
+    int32 MinimumAge = 0;
+
+    TSet<FString> ApprovedAgeCollectionMethods;
+
+    bool FromJson(const TSharedPtr<FJsonObject>& JsonObject);
+    TSharedRef<FJsonObject> ToJson() const;
+};
+
+struct FKidCachedRequirements
+{
+    FKidAgeGateRequirements Requirements;
+    FDateTime FetchedAt;
+};
+
+struct FKidRequirementsResult
+{
+    bool bSuccess = false;
+    FKidAgeGateRequirements Requirements;
+};
+
+// Age gate requirements by jurisdiction, persisted to disk so the age gate can usually be shown
+// without waiting on the network.
+//
+// Requirements younger than the time to live are served as they are.  Older requirements are
+// still served straight away but are revalidated in the background, unless they are older than
+// the maximum staleness, in which case they are fetched again before being used.  Callers asking
+// for a jurisdiction that is already being fetched share the request that is in flight.
+class FKidRequirementsCache : public TSharedFromThis<FKidRequirementsCache, ESPMode::ThreadSafe>
+{
+public:
+    void SetEndpoint(const FString& InBaseUrl, const FString& InAuthToken);
+    void SetTimeToLive(double InTimeToLiveSeconds, double InMaxStaleSeconds);
+
+    // Reads the persisted requirements on the thread pool.  Resolves with the number of
+    // jurisdictions loaded.
+    TFuture<int32> Load(const FString& InStoragePath);
+
+    TFuture<FKidRequirementsResult> Get(const FString& Jurisdiction);
+
+    // fetches the jurisdiction if it is missing or due for revalidation
+    void Prefetch(const FString& Jurisdiction);
+    bool Contains(const FString& Jurisdiction) const;
+
+    // visits the requirements of every jurisdiction that has been fetched or loaded
+    void ForEachCached(TFunctionRef<void(const FString& Jurisdiction, const FKidAgeGateRequirements& Requirements)> Visitor) const;
+
+private:
+    struct FEntry
+    {
+        bool bHasValue = false;
+        bool bFetching = false;
+        FKidCachedRequirements Cached;
+        TArray<TSharedRef<TKidPromise<FKidRequirementsResult>>> Waiters;
+    };
+
+    static FString MakeKey(const FString& Jurisdiction);
+    double GetAgeSeconds(const FEntry& Entry) const;
+    void Fetch(const FString& Key);
+    void OnFetched(const FString& Key, FHttpResponsePtr Response, bool bWasSuccessful);
+    void Save();
+
+    FString BaseUrl;
+    FString AuthToken;
+    FString StoragePath;
+    double TimeToLiveSeconds = 24.0 * 60.0 * 60.0;
+    double MaxStaleSeconds = 30.0 * 24.0 * 60.0 * 60.0;
+    TMap<FString, FEntry> Entries;
+
+    // only one write to StoragePath is in flight at a time, and changes made while it runs are
+    // written once it finishes
+    bool bSaveInFlight = false;
+    bool bSaveAgain = false;
+};
@@ -0,0 +1,93 @@
+#include "KidSessionApi.h"
+#include "HttpRequestHelper.h"
+#include "Json.h"
+
+namespace
+{
+    TFuture<FKidHttpResult> RequestSession(const FString& BaseUrl, const FString& AuthToken, const FString& SessionId,
+                const FString& ETag, const FKidFlowPtr& Flow)
+    {
+        FString Url = FString::Printf(TEXT("%s/session/get?sessionId=%s&etag=%s"), *BaseUrl, *SessionId, *ETag);
+        return HttpRequestHelper::GetRequestWithAuthAsync(Url, AuthToken, Flow);
+    }
+}
+
+TFuture<FKidSessionResult> FKidSessionApi::GetSession(const FString& BaseUrl, const FString& AuthToken, const FString& SessionId,
+                const FString& ETag, const FKidFlowPtr& Flow)
+{
+    return RequestSession(BaseUrl, AuthToken, SessionId, ETag, Flow).Next([](FKidHttpResult Result)
+    {
+        FKidSessionResult SessionResult;
+        if (!Result.IsOk())
+        {
+            return SessionResult;
+        }
+
+        if (Result.Response->GetResponseCode() == 304)
+        {
+            SessionResult.bSuccess = true;
+            SessionResult.bNotModified = true;
+            return SessionResult;
+        }
+
+        TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(Result.Response->GetContentAsString());
+        SessionResult.bSuccess = FJsonSerializer::Deserialize(Reader, SessionResult.Session) && SessionResult.Session.IsValid();
+        return SessionResult;
+    });
+}
+
+TFuture<FKidSessionSummaryResult> FKidSessionApi::GetSessionSummary(const FString& BaseUrl, const FString& AuthToken, const FString& SessionId,
+                const FString& ETag, const FKidFlowPtr& Flow)
+{
+    return RequestSession(BaseUrl, AuthToken, SessionId, ETag, Flow).Next([](FKidHttpResult Result)
+    {
+        FKidSessionSummaryResult SummaryResult;
+        if (!Result.IsOk())
+        {
+            return SummaryResult;
+        }
+
+        if (Result.Response->GetResponseCode() == 304)
+        {
+            SummaryResult.bSuccess = true;
+            SummaryResult.bNotModified = true;
+            return SummaryResult;
+        }
+
+        SummaryResult.bSuccess = FKidJsonDecoder::Decode(Result.Response->GetContent(), SummaryResult.Summary);
+        return SummaryResult;
+    });
+}
+
+FString FKidSessionApi::GetETag(const TSharedPtr<FJsonObject>& Session)
+{
+    FString ETag;
+    if (Session.IsValid())
+    {
+        Session->TryGetStringField(TEXT("etag"), ETag);
+    }
+    return ETag;
+}
+
+void FKidSessionApi::GetEnabledPermissions(const TSharedPtr<FJsonObject>& Session, TSet<FName>& OutEnabled)
+{
+    OutEnabled.Reset();
+
+    const TArray<TSharedPtr<FJsonValue>>* Permissions = nullptr;
+    if (!Session.IsValid() || !Session->TryGetArrayField(TEXT("permissions"), Permissions))
+    {
+        return;
+    }
+
+    for (const TSharedPtr<FJsonValue>& Permission : *Permissions)
+    {
+        const TSharedPtr<FJsonObject>* PermissionObject = nullptr;
+        bool bEnabled = false;
+        FString Name;
+        if (Permission->TryGetObject(PermissionObject) && (*PermissionObject)->TryGetBoolField(TEXT("enabled"), bEnabled) &&
+            bEnabled && (*PermissionObject)->TryGetStringField(TEXT("name"), Name))
+        {
+            OutEnabled.Add(FName(*Name));
+        }
+    }
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Dom/JsonObject.h"
+#include "KidFlow.h"
+#include "KidJsonDecoder.h"
+
+struct FKidSessionResult
+{
+    bool bSuccess = false;
+
+    // the session has not changed since the ETag that was sent, and Session is null
+    bool bNotModified = false;
+
+    TSharedPtr<FJsonObject> Session;
+};
+
+struct FKidSessionSummaryResult
+{
+    bool bSuccess = false;
+
+    // the session has not changed since the ETag that was sent, and Summary is empty
+    bool bNotModified = false;
+
+    FKidSessionSummary Summary;
+};
+
+// Request and parsing code for kID sessions, shared by the client workflow, the multi-player
+// session manager and the server-side permission cache.
+class FKidSessionApi
+{
+public:
+    // Fetches a session with /session/get.  Passing the ETag of the copy already held lets the
+    // server answer 304 Not Modified.
+    static TFuture<FKidSessionResult> GetSession(const FString& BaseUrl, const FString& AuthToken, const FString& SessionId,
+                const FString& ETag, const FKidFlowPtr& Flow = nullptr);
+
+    // Same request as GetSession, decoded straight into a summary without building a DOM.  For
+    // callers that only need the permissions and hold many sessions at once.
+    static TFuture<FKidSessionSummaryResult> GetSessionSummary(const FString& BaseUrl, const FString& AuthToken, const FString& SessionId,
+                const FString& ETag, const FKidFlowPtr& Flow = nullptr);
+
+    static FString GetETag(const TSharedPtr<FJsonObject>& Session);
+
+    // Names of the permissions the session has enabled
+    static void GetEnabledPermissions(const TSharedPtr<FJsonObject>& Session, TSet<FName>& OutEnabled);
+};
@@ -0,0 +1,258 @@
+#include "KidSessionManager.h"
+#include "KidWorkflow.h"
+#include "Json.h"
+#include "Misc/Paths.h"
+#include "HAL/PlatformTime.h"
+
+void UKidSessionManager::Initialize(UKidWorkflow* InPrimary)
+{
+    Primary = InPrimary;
+    if (ConsentAwaiter.IsValid() && Primary)
+    {
+        ConsentAwaiter->SetEndpoint(Primary->GetBaseUrl(), Primary->GetAuthToken());
+    }
+
+    if (!TickHandle.IsValid())
+    {
+        TWeakObjectPtr<UKidSessionManager> WeakThis(this);
+        TickHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda([WeakThis](float DeltaTime)
+        {
+            UKidSessionManager* This = WeakThis.Get();
+            return This && This->Tick(DeltaTime);
+        }), 1.0f);
+    }
+}
+
+void UKidSessionManager::CleanUp()
+{
+    if (TickHandle.IsValid())
+    {
+        FTSTicker::GetCoreTicker().RemoveTicker(TickHandle);
+        TickHandle.Reset();
+    }
+
+    TArray<int32> PlayerIndices;
+    Players.GetKeys(PlayerIndices);
+    for (int32 PlayerIndex : PlayerIndices)
+    {
+        RemovePlayer(PlayerIndex);
+    }
+    RefreshQueue.Reset();
+
+    if (ConsentAwaiter.IsValid())
+    {
+        UE_LOG(LogTemp, Log, TEXT("kID consent awaits of all players: %d requests, %d errors."),
+                    ConsentAwaiter->GetRequestCount(), ConsentAwaiter->GetErrorCount());
+        ConsentAwaiter->UnwatchAll();
+    }
+}
+
+TSharedRef<FKidConsentAwaiterService, ESPMode::ThreadSafe> UKidSessionManager::GetConsentAwaiter()
+{
+    if (!ConsentAwaiter.IsValid())
+    {
+        FKidConsentAwaiterService::FSettings Settings;
+        Settings.MaxConcurrentRequests = MaxConcurrentConsentAwaits;
+        Settings.MaxRequestsPerSecond = MaxConsentAwaitsPerSecond;
+        ConsentAwaiter = MakeShared<FKidConsentAwaiterService, ESPMode::ThreadSafe>(Primary->GetBaseUrl(), Primary->GetAuthToken(), Settings);
+    }
+    return ConsentAwaiter.ToSharedRef();
+}
+
+TFuture<bool> UKidSessionManager::AddPlayer(int32 PlayerIndex)
+{
+    if (Players.Contains(PlayerIndex) || !Primary)
+    {
+        return MakeFulfilledPromise<bool>(false).GetFuture();
+    }
+
+    UKidWorkflow* Workflow = NewObject<UKidWorkflow>(this);
+    const FString& Root = StorageDirectory.IsEmpty() ? FPaths::ProjectSavedDir() / TEXT("kID") : StorageDirectory;
+    Workflow->SetStateDirectory(Root / FString::Printf(TEXT("Player%d"), PlayerIndex));
+    Workflow->SetUi(MakeWorkflowUi(PlayerIndex));
+    Workflow->SetConsentAwaiter(GetConsentAwaiter());
+
+    TWeakObjectPtr<UKidSessionManager> WeakThis(this);
+    Workflow->SetRefreshScheduler([WeakThis, PlayerIndex](double DelaySeconds)
+    {
+        if (UKidSessionManager* This = WeakThis.Get())
+        {
+            This->ScheduleRefresh(PlayerIndex, DelaySeconds);
+        }
+    });
+    Workflow->OnPermissionsChanged().AddWeakLambda(this, [this, PlayerIndex](const TArray<FKidPermissionChange>& Changes)
+    {
+        if (Ui.OnPermissionsChanged)
+        {
+            Ui.OnPermissionsChanged(PlayerIndex, Changes);
+        }
+    });
+    Players.Add(PlayerIndex, Workflow);
+
+    // a player removed while loading drops the callback, which keeps the promise with false
+    TSharedRef<TKidPromise<bool>, ESPMode::ThreadSafe> Promise = MakeShared<TKidPromise<bool>, ESPMode::ThreadSafe>();
+    TFuture<bool> Future = Promise->GetFuture();
+    Workflow->InitializeFrom(*Primary, [Promise](bool bTokenIssued)
+    {
+        Promise->SetValue(true);
+    });
+    return Future;
+}
+
+void UKidSessionManager::RemovePlayer(int32 PlayerIndex)
+{
+    UKidWorkflow* Workflow = nullptr;
+    if (Players.RemoveAndCopyValue(PlayerIndex, Workflow))
+    {
+        Workflow->OnPermissionsChanged().RemoveAll(this);
+        Workflow->CleanUp();
+        NextRefreshTimes.Remove(PlayerIndex);
+    }
+}
+
+UKidWorkflow* UKidSessionManager::GetPlayerWorkflow(int32 PlayerIndex) const
+{
+    UKidWorkflow* const* Found = Players.Find(PlayerIndex);
+    return Found ? *Found : nullptr;
+}
+
+FKidWorkflowUi UKidSessionManager::MakeWorkflowUi(int32 PlayerIndex) const
+{
+    // hooks the game has not set are left unset, so the workflow handles them as it does for the
+    // single player
+    FKidWorkflowUi WorkflowUi;
+    if (Ui.ShowAgeGate)
+    {
+        WorkflowUi.ShowAgeGate = [ShowAgeGate = Ui.ShowAgeGate, PlayerIndex](const FKidAgeGateRequirements& Requirements, TFunction<void(const FString&)> Submit)
+        {
+            ShowAgeGate(PlayerIndex, Requirements, MoveTemp(Submit));
+        };
+    }
+    if (Ui.ShowAgeAssurance)
+    {
+        WorkflowUi.ShowAgeAssurance = [ShowAgeAssurance = Ui.ShowAgeAssurance, PlayerIndex](int32 Age, TFunction<void(bool, int32, int32)> OnResponse)
+        {
+            ShowAgeAssurance(PlayerIndex, Age, MoveTemp(OnResponse));
+        };
+    }
+    if (Ui.ShowChallenge)
+    {
+        WorkflowUi.ShowChallenge = [ShowChallenge = Ui.ShowChallenge, PlayerIndex](const FKidSavedChallenge& Challenge)
+        {
+            ShowChallenge(PlayerIndex, Challenge.OneTimePassword, Challenge.Url);
+        };
+    }
+    if (Ui.DismissChallenge)
+    {
+        WorkflowUi.DismissChallenge = [DismissChallenge = Ui.DismissChallenge, PlayerIndex]()
+        {
+            DismissChallenge(PlayerIndex);
+        };
+    }
+    if (Ui.OnSessionChanged)
+    {
+        WorkflowUi.UpdateHUD = [OnSessionChanged = Ui.OnSessionChanged, PlayerIndex](const FKidHudViewModel& ViewModel)
+        {
+            if (ViewModel.IsDirty(FKidHudViewModel::SessionId) || ViewModel.IsDirty(FKidHudViewModel::AgeStatus) ||
+                ViewModel.IsDirty(FKidHudViewModel::AccessMode))
+            {
+                OnSessionChanged(PlayerIndex);
+            }
+        };
+    }
+    return WorkflowUi;
+}
+
+FKidFlowPtr UKidSessionManager::StartSession(int32 PlayerIndex, const FString& Location)
+{
+    UKidWorkflow* Workflow = GetPlayerWorkflow(PlayerIndex);
+    if (!Workflow || !Workflow->GetState().IsLoaded())
+    {
+        UE_LOG(LogTemp, Error, TEXT("Player %d has not been added or is still loading."), PlayerIndex);
+        return nullptr;
+    }
+    return Workflow->StartKidSession(Location);
+}
+
+FKidFlowPtr UKidSessionManager::UpgradeSession(int32 PlayerIndex, const TArray<FString>& FeatureNames)
+{
+    TSharedPtr<FJsonObject> Session = GetSession(PlayerIndex);
+    if (!Session.IsValid() || !Session->HasField(TEXT("sessionId")) || FeatureNames.Num() == 0)
+    {
+        UE_LOG(LogTemp, Error, TEXT("Player %d has no session to upgrade."), PlayerIndex);
+        return nullptr;
+    }
+
+    // requested together, so they are sent in one batch and share its flow
+    UKidWorkflow* Workflow = GetPlayerWorkflow(PlayerIndex);
+    FKidFlowPtr Flow;
+    for (const FString& FeatureName : FeatureNames)
+    {
+        Flow = Workflow->UpgradeSession(FeatureName, []() {});
+    }
+    return Flow;
+}
+
+void UKidSessionManager::ClearSession(int32 PlayerIndex)
+{
+    if (UKidWorkflow* Workflow = GetPlayerWorkflow(PlayerIndex))
+    {
+        Workflow->ClearChallengeId();
+        Workflow->ClearSession();
+        NextRefreshTimes.Remove(PlayerIndex);
+    }
+}
+
+FString UKidSessionManager::GetChallengeId(int32 PlayerIndex) const
+{
+    UKidWorkflow* Workflow = GetPlayerWorkflow(PlayerIndex);
+    return Workflow && Workflow->GetState().HasChallengeId() ? Workflow->GetState().GetChallengeId() : FString();
+}
+
+EKidAccessMode UKidSessionManager::GetMode(int32 PlayerIndex) const
+{
+    UKidWorkflow* Workflow = GetPlayerWorkflow(PlayerIndex);
+    return Workflow ? Workflow->GetState().GetMode() : EKidAccessMode::None;
+}
+
+TSharedPtr<FJsonObject> UKidSessionManager::GetSession(int32 PlayerIndex) const
+{
+    UKidWorkflow* Workflow = GetPlayerWorkflow(PlayerIndex);
+    return Workflow ? Workflow->GetState().GetSession() : nullptr;
+}
+
+TSharedPtr<FJsonObject> UKidSessionManager::FindPermission(int32 PlayerIndex, const FString& PermissionName) const
+{
+    UKidWorkflow* Workflow = GetPlayerWorkflow(PlayerIndex);
+    return Workflow ? Workflow->FindPermission(PermissionName) : nullptr;
+}
+
+void UKidSessionManager::ScheduleRefresh(int32 PlayerIndex, double DelaySeconds)
+{
+    // an earlier entry for the player is left in the queue and skipped when it comes due
+    const double DueTime = FPlatformTime::Seconds() + DelaySeconds;
+    NextRefreshTimes.Add(PlayerIndex, DueTime);
+    RefreshQueue.HeapPush({ DueTime, PlayerIndex });
+}
+
+bool UKidSessionManager::Tick(float DeltaTime)
+{
+    const double Now = FPlatformTime::Seconds();
+    while (RefreshQueue.Num() > 0 && RefreshQueue.HeapTop().DueTime <= Now)
+    {
+        FScheduledRefresh Due;
+        RefreshQueue.HeapPop(Due, EAllowShrinking::No);
+
+        const double* NextRefreshTime = NextRefreshTimes.Find(Due.PlayerIndex);
+        UKidWorkflow* Workflow = GetPlayerWorkflow(Due.PlayerIndex);
+        if (!Workflow || !NextRefreshTime || *NextRefreshTime != Due.DueTime)
+        {
+            continue;
+        }
+
+        // the workflow schedules the next refresh once this one has finished
+        NextRefreshTimes.Remove(Due.PlayerIndex);
+        Workflow->RefreshSessionInBackground();
+    }
+    return true;
+}
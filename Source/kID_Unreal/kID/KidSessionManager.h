@@ -0,0 +1,130 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/NoExportTypes.h"
+#include "Containers/Ticker.h"
+#include "KidStateStore.h"
+#include "KidFlow.h"
+#include "KidRequirementsCache.h"
+#include "KidConsentAwaiterService.h"
+#include "KidPermissionDiff.h"
+#include "KidSessionManager.generated.h"
+
+class UKidWorkflow;
+struct FKidWorkflowUi;
+
+// Hooks from the session manager into the game's UI for one player, e.g. that player's
+// split-screen viewport.  Every callback is given the index of the player it is for.
+struct FKidPlayerUi
+{
+    // The age gate has to be shown.  Call Submit with the date of birth the player entered.
+    TFunction<void(int32 PlayerIndex, const FKidAgeGateRequirements& Requirements, TFunction<void(const FString& DOB)> Submit)> ShowAgeGate;
+
+    // The player's age has to be assured.  Call OnResponse as the age assurance widget does.  A
+    // jurisdiction that requires age assurance fails the flow when this is not set.
+    TFunction<void(int32 PlayerIndex, int32 Age, TFunction<void(bool bSuccessful, int32 MinAge, int32 MaxAge)> OnResponse)> ShowAgeAssurance;
+
+    // A consent challenge has to be shown to the player's parent or guardian, or can be dismissed.
+    TFunction<void(int32 PlayerIndex, const FString& OTP, const FString& QRCodeUrl)> ShowChallenge;
+    TFunction<void(int32 PlayerIndex)> DismissChallenge;
+
+    // The player's session or access mode has changed.
+    TFunction<void(int32 PlayerIndex)> OnSessionChanged;
+
+    // Only the permissions that changed with the player's session, never empty.
+    TFunction<void(int32 PlayerIndex, const TArray<FKidPermissionChange>& Changes)> OnPermissionsChanged;
+};
+
+// Runs independent kID sessions for any number of local players, e.g. split-screen.
+//
+// Each player is a UKidWorkflow of its own, started from the game's primary workflow, so every
+// player runs the same flow steps as the single player does.  Players share the primary's
+// endpoint, auth token, age gate requirements and policy caches and the engine's HTTP connection
+// pool, and each has its own storage slot under Saved/kID/Player<Index>.  Nothing runs per player
+// on a timer: the consent challenges of all players are awaited by a single service under one
+// request budget, and the background session refresh of every player is driven from a single
+// ticker owned by the manager.
+UCLASS(Config=Game)
+class UKidSessionManager : public UObject
+{
+    GENERATED_BODY()
+
+public:
+    // Shares the endpoint, token and caches of a workflow that has been initialized.
+    void Initialize(UKidWorkflow* InPrimary);
+
+    // Set before adding players.
+    void SetPlayerUi(const FKidPlayerUi& InUi) { Ui = InUi; }
+
+    // Root of the per-player storage slots, Saved/kID by default.  Set before adding players.
+    void SetStorageDirectory(const FString& InStorageDirectory) { StorageDirectory = InStorageDirectory; }
+    void CleanUp();
+
+    // Adds a player and loads its saved state on the thread pool.  Resolves with false if the
+    // player already exists, there is no primary workflow, or the player is removed before
+    // loading finishes.
+    TFuture<bool> AddPlayer(int32 PlayerIndex);
+    void RemovePlayer(int32 PlayerIndex);
+    int32 GetNumPlayers() const { return Players.Num(); }
+
+    // Starts the kID flow for one player with UKidWorkflow::StartKidSession.  Returns null if the
+    // player is not loaded or there is no token.
+    FKidFlowPtr StartSession(int32 PlayerIndex, const FString& Location);
+
+    // Asks for the given features to be enabled in the player's session with one /session/upgrade,
+    // through the batching of UKidWorkflow::UpgradeSession, and returns the flow they share.  A
+    // consent challenge, if the upgrade needs one, is shown and awaited like the age gate's.
+    FKidFlowPtr UpgradeSession(int32 PlayerIndex, const TArray<FString>& FeatureNames);
+
+    // Forgets the player's session and any pending challenge.
+    void ClearSession(int32 PlayerIndex);
+
+    // The challenge the player is waiting on, if any
+    FString GetChallengeId(int32 PlayerIndex) const;
+
+    EKidAccessMode GetMode(int32 PlayerIndex) const;
+    TSharedPtr<FJsonObject> GetSession(int32 PlayerIndex) const;
+    TSharedPtr<FJsonObject> FindPermission(int32 PlayerIndex, const FString& PermissionName) const;
+
+    // The workflow running the player's session, or null
+    UKidWorkflow* GetPlayerWorkflow(int32 PlayerIndex) const;
+
+private:
+    // the player's hooks, bound to its index
+    FKidWorkflowUi MakeWorkflowUi(int32 PlayerIndex) const;
+
+    void ScheduleRefresh(int32 PlayerIndex, double DelaySeconds);
+    bool Tick(float DeltaTime);
+
+    // budget of /challenge/await calls shared by the challenges of all players
+    UPROPERTY(Config)
+    int32 MaxConcurrentConsentAwaits = 8;
+
+    UPROPERTY(Config)
+    float MaxConsentAwaitsPerSecond = 4.0f;
+
+    TSharedRef<FKidConsentAwaiterService, ESPMode::ThreadSafe> GetConsentAwaiter();
+
+    UPROPERTY()
+    UKidWorkflow* Primary;
+
+    FString StorageDirectory;
+    TSharedPtr<FKidConsentAwaiterService, ESPMode::ThreadSafe> ConsentAwaiter;
+    FKidPlayerUi Ui;
+
+    UPROPERTY()
+    TMap<int32, UKidWorkflow*> Players;
+
+    // when each player's session is next refreshed, and the same as a min-heap on the time
+    TMap<int32, double> NextRefreshTimes;
+
+    struct FScheduledRefresh
+    {
+        double DueTime;
+        int32 PlayerIndex;
+
+        bool operator<(const FScheduledRefresh& Other) const { return DueTime < Other.DueTime; }
+    };
+    TArray<FScheduledRefresh> RefreshQueue;
+    FTSTicker::FDelegateHandle TickHandle;
+};
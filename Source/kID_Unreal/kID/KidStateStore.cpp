@@ -0,0 +1,217 @@
+#include "KidStateStore.h"
+#include "Json.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "HAL/FileManager.h"
+
+FKidStateStore::FKidStateStore()
+    : Directory(FPaths::ProjectSavedDir())
+{
+}
+
+void FKidStateStore::SetDirectory(const FString& InDirectory)
+{
+    if (Directory != InDirectory)
+    {
+        Directory = InDirectory;
+        bLoaded = false;
+    }
+}
+
+void FKidStateStore::Load()
+{
+    if (bLoaded)
+    {
+        return;
+    }
+    bLoaded = true;
+
+    Challenge = FKidSavedChallenge();
+    FileReadCount++;
+    if (!FFileHelper::LoadFileToString(Challenge.ChallengeId, *GetChallengeIdPath()))
+    {
+        Challenge.ChallengeId.Reset();
+    }
+
+    // the details are only used if they belong to the saved ID, since older versions only wrote the ID
+    FString ChallengeString;
+    if (!Challenge.ChallengeId.IsEmpty())
+    {
+        FileReadCount++;
+        FFileHelper::LoadFileToString(ChallengeString, *GetChallengePath());
+    }
+
+    TSharedPtr<FJsonObject> SavedChallenge;
+    if (!ChallengeString.IsEmpty() && FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(ChallengeString), SavedChallenge) &&
+        SavedChallenge->GetStringField(TEXT("challengeId")) == Challenge.ChallengeId)
+    {
+        SavedChallenge->TryGetStringField(TEXT("oneTimePassword"), Challenge.OneTimePassword);
+        SavedChallenge->TryGetStringField(TEXT("url"), Challenge.Url);
+        SavedChallenge->TryGetNumberField(TEXT("timeoutSeconds"), Challenge.TimeoutSeconds);
+        FDateTime::ParseIso8601(*SavedChallenge->GetStringField(TEXT("startTime")), Challenge.StartTime);
+    }
+
+    Session.Reset();
+    Mode = EKidAccessMode::DataLite;
+    bSessionSpeculative = false;
+    SavedSession.Reset();
+
+    FString SessionInfoString;
+    FileReadCount++;
+    if (FFileHelper::LoadFileToString(SessionInfoString, *GetSessionPath()))
+    {
+        TSharedPtr<FJsonObject> LoadedSession;
+        TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(SessionInfoString);
+        if (FJsonSerializer::Deserialize(Reader, LoadedSession) && LoadedSession.IsValid())
+        {
+            UE_LOG(LogTemp, Log, TEXT("Found saved session."));
+            Session = LoadedSession;
+            Mode = EKidAccessMode::Full;
+        }
+        else
+        {
+            UE_LOG(LogTemp, Error, TEXT("Failed to deserialize saved session."));
+        }
+    }
+    else
+    {
+        UE_LOG(LogTemp, Log, TEXT("No saved session found."));
+    }
+
+    LastJurisdiction.Reset();
+    FileReadCount++;
+    if (!FFileHelper::LoadFileToString(LastJurisdiction, *GetLastJurisdictionPath()))
+    {
+        LastJurisdiction.Reset();
+    }
+}
+
+void FKidStateStore::SetChallengeId(const FString& InChallengeId)
+{
+    FKidSavedChallenge IdOnly;
+    IdOnly.ChallengeId = InChallengeId;
+    SetChallenge(IdOnly);
+}
+
+void FKidStateStore::SetChallenge(const FKidSavedChallenge& InChallenge)
+{
+    Challenge = InChallenge;
+    FileWriteCount++;
+    FFileHelper::SaveStringToFile(Challenge.ChallengeId, *GetChallengeIdPath());
+
+    if (!Challenge.HasDetails())
+    {
+        IFileManager::Get().Delete(*GetChallengePath());
+        return;
+    }
+
+    TSharedRef<FJsonObject> JsonObject = MakeShared<FJsonObject>();
+    JsonObject->SetStringField(TEXT("challengeId"), Challenge.ChallengeId);
+    JsonObject->SetStringField(TEXT("oneTimePassword"), Challenge.OneTimePassword);
+    JsonObject->SetStringField(TEXT("url"), Challenge.Url);
+    JsonObject->SetNumberField(TEXT("timeoutSeconds"), Challenge.TimeoutSeconds);
+    JsonObject->SetStringField(TEXT("startTime"), Challenge.StartTime.ToIso8601());
+
+    FString ChallengeString;
+    TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&ChallengeString);
+    FJsonSerializer::Serialize(JsonObject, Writer);
+    FileWriteCount++;
+    FFileHelper::SaveStringToFile(ChallengeString, *GetChallengePath());
+}
+
+void FKidStateStore::ClearChallengeId()
+{
+    Challenge = FKidSavedChallenge();
+    FileWriteCount++;
+    IFileManager::Get().Delete(*GetChallengeIdPath());
+    IFileManager::Get().Delete(*GetChallengePath());
+}
+
+void FKidStateStore::SetSession(TSharedPtr<FJsonObject> InSession)
+{
+    if (!InSession.IsValid())
+    {
+        ClearSession();
+        return;
+    }
+
+    Session = InSession;
+    bSessionSpeculative = false;
+    SavedSession.Reset();
+
+    FString SessionString;
+    TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&SessionString);
+    FJsonSerializer::Serialize(Session.ToSharedRef(), Writer);
+    FileWriteCount++;
+    FFileHelper::SaveStringToFile(SessionString, *GetSessionPath());
+}
+
+void FKidStateStore::ClearSession()
+{
+    Session.Reset();
+    bSessionSpeculative = false;
+    SavedSession.Reset();
+    FileWriteCount++;
+    if (IFileManager::Get().Delete(*GetSessionPath()))
+    {
+        UE_LOG(LogTemp, Log, TEXT("Session file deleted successfully."));
+    }
+}
+
+void FKidStateStore::SetSpeculativeSession(TSharedPtr<FJsonObject> InSession, EKidAccessMode InMode)
+{
+    // a second speculation replaces the first, in front of the same saved session
+    if (!bSessionSpeculative)
+    {
+        SavedSession = Session;
+        SavedMode = Mode;
+        bSessionSpeculative = true;
+    }
+
+    Session = InSession;
+    Mode = InMode;
+}
+
+void FKidStateStore::ClearSpeculativeSession()
+{
+    if (!bSessionSpeculative)
+    {
+        return;
+    }
+
+    Session = MoveTemp(SavedSession);
+    Mode = SavedMode;
+    bSessionSpeculative = false;
+}
+
+void FKidStateStore::SetLastJurisdiction(const FString& InJurisdiction)
+{
+    if (LastJurisdiction == InJurisdiction)
+    {
+        return;
+    }
+
+    LastJurisdiction = InJurisdiction;
+    FileWriteCount++;
+    FFileHelper::SaveStringToFile(LastJurisdiction, *GetLastJurisdictionPath());
+}
+
+FString FKidStateStore::GetChallengeIdPath() const
+{
+    return Directory + TEXT("/ChallengeId.txt");
+}
+
+FString FKidStateStore::GetChallengePath() const
+{
+    return Directory + TEXT("/Challenge.json");
+}
+
+FString FKidStateStore::GetSessionPath() const
+{
+    return Directory + TEXT("/SessionInfo.json");
+}
+
+FString FKidStateStore::GetLastJurisdictionPath() const
+{
+    return Directory + TEXT("/LastJurisdiction.txt");
+}
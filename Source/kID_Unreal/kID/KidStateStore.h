@@ -0,0 +1,102 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Dom/JsonObject.h"
+
+enum class EKidAccessMode {
+    None, // player has no access (under the minimum age)
+    DataLite, // player has access to data-lite features
+    Full // full access to all features
+};
+
+// A consent challenge waiting on a parent, with what is needed to show it again without asking
+// the server first
+struct FKidSavedChallenge
+{
+    FString ChallengeId;
+    FString OneTimePassword;
+    FString Url;
+    int32 TimeoutSeconds = 0;
+    FDateTime StartTime;
+
+    // false when only the ID was saved, e.g. by an older version of the sample
+    bool HasDetails() const { return !OneTimePassword.IsEmpty() && !Url.IsEmpty() && TimeoutSeconds > 0; }
+    FDateTime GetDeadline() const { return StartTime + FTimespan::FromSeconds(TimeoutSeconds); }
+};
+
+// In-memory copy of the kID state the sample keeps in the Saved directory (challenge ID, session
+// and access mode).  The files are read once by Load() and every change is written through to
+// disk immediately, so the HUD, settings and workflow only ever read from memory.  The one
+// exception is a speculative session, which only reaches the disk once the server confirms it.
+//
+// Load() can run on a worker thread as long as nothing else touches the store until it returns.
+class FKidStateStore
+{
+public:
+    FKidStateStore();
+
+    // Directory holding ChallengeId.txt, Challenge.json and SessionInfo.json.  Changing it forces a reload.
+    void SetDirectory(const FString& InDirectory);
+    const FString& GetDirectory() const { return Directory; }
+
+    // Reads the saved files.  Only touches the disk the first time it is called.
+    void Load();
+    bool IsLoaded() const { return bLoaded; }
+
+    // challenge ID
+    bool HasChallengeId() const { return !Challenge.ChallengeId.IsEmpty(); }
+    const FString& GetChallengeId() const { return Challenge.ChallengeId; }
+    void SetChallengeId(const FString& InChallengeId);
+    void ClearChallengeId();
+
+    // the challenge with its one-time password, URL and timeout, when they were saved with it
+    const FKidSavedChallenge& GetChallenge() const { return Challenge; }
+    void SetChallenge(const FKidSavedChallenge& InChallenge);
+
+    // session
+    bool HasSession() const { return Session.IsValid(); }
+    TSharedPtr<FJsonObject> GetSession() const { return Session; }
+    void SetSession(TSharedPtr<FJsonObject> InSession);
+    void ClearSession();
+
+    // A session applied ahead of the server's answer, such as predicted default permissions.  It is
+    // kept in memory only: SetSession() replaces it with the server's session and writes that
+    // through, ClearSpeculativeSession() goes back to the saved session and its access mode.
+    void SetSpeculativeSession(TSharedPtr<FJsonObject> InSession, EKidAccessMode InMode);
+    void ClearSpeculativeSession();
+    bool IsSessionSpeculative() const { return bSessionSpeculative; }
+
+    // the jurisdiction the last session was started in, used to prefetch its requirements at startup
+    const FString& GetLastJurisdiction() const { return LastJurisdiction; }
+    void SetLastJurisdiction(const FString& InJurisdiction);
+
+    // access mode is derived from the session and is not persisted
+    EKidAccessMode GetMode() const { return Mode; }
+    void SetMode(EKidAccessMode InMode) { Mode = InMode; }
+
+    // file I/O counters, used to confirm that reads of the state never hit the disk
+    int32 GetFileReadCount() const { return FileReadCount; }
+    int32 GetFileWriteCount() const { return FileWriteCount; }
+
+private:
+    FString GetChallengeIdPath() const;
+    FString GetChallengePath() const;
+    FString GetSessionPath() const;
+    FString GetLastJurisdictionPath() const;
+
+    FString Directory;
+    bool bLoaded = false;
+
+    FKidSavedChallenge Challenge;
+    TSharedPtr<FJsonObject> Session;
+    FString LastJurisdiction;
+    EKidAccessMode Mode = EKidAccessMode::DataLite;
+
+    // the session and mode a speculative session stands in front of
+    bool bSessionSpeculative = false;
+    TSharedPtr<FJsonObject> SavedSession;
+    EKidAccessMode SavedMode = EKidAccessMode::DataLite;
+
+    int32 FileReadCount = 0;
+    int32 FileWriteCount = 0;
+};
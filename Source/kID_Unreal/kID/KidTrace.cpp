@@ -0,0 +1,76 @@
+#include "KidTrace.h"
+#include "ProfilingDebugging/MiscTrace.h"
+#include "GenericPlatform/GenericPlatformHttp.h"
+#include <atomic>
+
+UE_TRACE_CHANNEL_DEFINE(KidChannel)
+
+namespace
+{
+    std::atomic<uint32> NextSpanId{ 1 };
+}
+
+bool FKidTrace::IsEnabled()
+{
+    return UE_TRACE_CHANNELEXPR_IS_ENABLED(KidChannel);
+}
+
+FString FKidTrace::BeginSpan(const FString& Name)
+{
+    if (!IsEnabled())
+    {
+        return FString();
+    }
+
+    // the HTTP server and flows may begin spans off the game thread
+    FString SpanName = FString::Printf(TEXT("kID %s #%u"), *Name, NextSpanId.fetch_add(1, std::memory_order_relaxed));
+    TRACE_BEGIN_REGION(*SpanName);
+    return SpanName;
+}
+
+void FKidTrace::EndSpan(const FString& SpanName)
+{
+    // a span begun while the channel was disabled has no name; one begun before it was disabled still ends
+    if (!SpanName.IsEmpty())
+    {
+        TRACE_END_REGION(*SpanName);
+    }
+}
+
+FString FKidTrace::BeginRequest(const FString& Verb, const FString& Url)
+{
+    if (!IsEnabled())
+    {
+        return FString();
+    }
+
+    // the path alone keeps the region names short and free of tokens passed in the query
+    FString Path = FGenericPlatformHttp::GetUrlPath(Url);
+    if (Path.IsEmpty())
+    {
+        Path = Url;
+    }
+    return BeginSpan(Verb + TEXT(" ") + Path);
+}
+
+void FKidTrace::EndRequest(const FString& SpanName, int32 ResponseCode)
+{
+    if (SpanName.IsEmpty())
+    {
+        return;
+    }
+
+    if (ResponseCode != 200 && ResponseCode != 304)
+    {
+        TRACE_BOOKMARK(TEXT("%s failed (%d)"), *SpanName, ResponseCode);
+    }
+    EndSpan(SpanName);
+}
+
+void FKidTrace::MarkFlowState(const FString& FlowName, const TCHAR* State)
+{
+    if (IsEnabled())
+    {
+        TRACE_BOOKMARK(TEXT("kID %s: %s"), *FlowName, State);
+    }
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Trace/Trace.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+
+// Trace channel for the kID subsystem, so it can be profiled in Unreal Insights without the noise
+// of the rest of the game.  Enable it with -trace=default,kid,region,bookmark or at runtime with
+// "Trace.Enable kid".  It records CPU scopes, one timing region per HTTP request from issue to
+// callback and a bookmark for every flow state change.
+UE_TRACE_CHANNEL_EXTERN(KidChannel)
+
+// CPU scope recorded only while the kid channel is enabled
+#define KID_TRACE_SCOPE(Name) TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(Name, KidChannel)
+
+class FKidTrace
+{
+public:
+    static bool IsEnabled();
+
+    // Begins a timing region and returns its unique name, to pass to EndSpan.  Overlapping spans
+    // of the same kind are numbered.  Returns an empty name, and records nothing, while the
+    // channel is disabled.
+    static FString BeginSpan(const FString& Name);
+    static void EndSpan(const FString& SpanName);
+
+    // Span for an HTTP request, named after its verb and path
+    static FString BeginRequest(const FString& Verb, const FString& Url);
+    static void EndRequest(const FString& SpanName, int32 ResponseCode);
+
+    static void MarkFlowState(const FString& FlowName, const TCHAR* State);
+};
@@ -0,0 +1,78 @@
+#include "KidWidgetPool.h"
+
+UUserWidget* UKidWidgetPool::Acquire(UWorld* World, UClass* WidgetClass, bool& bOutReused)
+{
+    // instances from a world that has gone away, e.g. an earlier PIE session, cannot be shown again
+    Widgets.RemoveAll([World](const TObjectPtr<UUserWidget>& Widget) { return !IsValid(Widget) || Widget->GetWorld() != World; });
+
+    for (UUserWidget* Widget : Widgets)
+    {
+        if (Widget->GetClass() == WidgetClass && !Widget->IsInViewport() && !Widget->GetParent())
+        {
+            bOutReused = true;
+            return Widget;
+        }
+    }
+
+    bOutReused = false;
+    UUserWidget* Widget = CreateWidget<UUserWidget>(World, WidgetClass);
+    if (Widget)
+    {
+        Widgets.Add(Widget);
+    }
+    return Widget;
+}
+
+void UKidWidgetPool::Release(UUserWidget* Widget)
+{
+    if (Widget)
+    {
+        Widget->RemoveFromParent();
+    }
+}
+
+void UKidWidgetPool::RecordShow(UClass* WidgetClass, bool bReused, double Seconds)
+{
+    FShowStats& ClassStats = Stats.FindOrAdd(WidgetClass->GetFName());
+    if (bReused)
+    {
+        ++ClassStats.NumReused;
+        ClassStats.ReusedSeconds += Seconds;
+        ClassStats.MaxReusedSeconds = FMath::Max(ClassStats.MaxReusedSeconds, Seconds);
+    }
+    else
+    {
+        ++ClassStats.NumCreated;
+        ClassStats.CreatedSeconds += Seconds;
+        ClassStats.MaxCreatedSeconds = FMath::Max(ClassStats.MaxCreatedSeconds, Seconds);
+    }
+
+    UE_LOG(LogTemp, Log, TEXT("kID widget %s shown in %.2f ms (%s)"), *WidgetClass->GetName(), Seconds * 1000.0, 
+                bReused ? TEXT("reused") : TEXT("created"));
+}
+
+void UKidWidgetPool::LogStats() const
+{
+    for (const TPair<FName, FShowStats>& Pair : Stats)
+    {
+        const FShowStats& ClassStats = Pair.Value;
+        UE_LOG(LogTemp, Log, TEXT("kID widget %s: created %d times, avg %.2f ms, max %.2f ms; reused %d times, avg %.2f ms, max %.2f ms"),
+                    *Pair.Key.ToString(),
+                    ClassStats.NumCreated, ClassStats.NumCreated > 0 ? ClassStats.CreatedSeconds * 1000.0 / ClassStats.NumCreated : 0.0, 
+                    ClassStats.MaxCreatedSeconds * 1000.0,
+                    ClassStats.NumReused, ClassStats.NumReused > 0 ? ClassStats.ReusedSeconds * 1000.0 / ClassStats.NumReused : 0.0, 
+                    ClassStats.MaxReusedSeconds * 1000.0);
+    }
+}
+
+void UKidWidgetPool::Empty()
+{
+    for (UUserWidget* Widget : Widgets)
+    {
+        if (IsValid(Widget))
+        {
+            Widget->RemoveFromParent();
+        }
+    }
+    Widgets.Reset();
+}
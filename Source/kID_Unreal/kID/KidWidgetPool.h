@@ -0,0 +1,47 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Object.h"
+#include "Blueprint/UserWidget.h"
+#include "KidWidgetPool.generated.h"
+
+// Instances of the kID widgets, kept after they are dismissed and handed out again the next time
+// the same widget is shown.  Each widget resets itself in its InitializeWidget.
+//
+// A pooled widget is free whenever it is off screen, so widgets that remove themselves, e.g. from
+// their cancel button, go back to the pool without telling it.  The time taken to show each
+// widget is recorded separately for created and reused instances, and logged by LogStats.
+UCLASS()
+class UKidWidgetPool : public UObject
+{
+    GENERATED_BODY()
+
+public:
+    // Returns an off screen instance of the class, creating one only if every instance is in use.
+    UUserWidget* Acquire(UWorld* World, UClass* WidgetClass, bool& bOutReused);
+
+    // takes the widget off screen so it can be handed out again
+    void Release(UUserWidget* Widget);
+
+    // Records how long showing a widget took, from acquiring it until it was added to the viewport.
+    void RecordShow(UClass* WidgetClass, bool bReused, double Seconds);
+    void LogStats() const;
+
+    void Empty();
+
+private:
+    struct FShowStats
+    {
+        int32 NumCreated = 0;
+        double CreatedSeconds = 0.0;
+        double MaxCreatedSeconds = 0.0;
+        int32 NumReused = 0;
+        double ReusedSeconds = 0.0;
+        double MaxReusedSeconds = 0.0;
+    };
+
+    UPROPERTY()
+    TArray<TObjectPtr<UUserWidget>> Widgets;
+
+    TMap<FName, FShowStats> Stats;
+};
@@ -1,10 +1,17 @@
 #include "KidWorkflow.h"
 #include "HttpRequestHelper.h"
+#include "KidSessionApi.h"
+#include "KidTrace.h"
+#include "KidAgeClassifier.h"
+#include "KidCoreAdapter.h"
+#include "KidCorePolicy.h"
+#include "KidRequestBody.h"
 #include "Json.h"
 #include "JsonUtilities.h"
 #include "Misc/FileHelper.h"
 #include "Misc/Paths.h"
 #include "Misc/DefaultValueHelper.h"
+#include "HAL/PlatformTime.h"
 #include "Widgets/SWeakWidget.h"
 #include "Widgets/Images/SImage.h"
 #include "Widgets/Layout/SBox.h"
@@ -20,74 +27,391 @@
 #include "Widgets/TestSetChallengeWidget.h"
 #include "Widgets/SliderAgeGateWidget.h"
 #include "Widgets/AgeGateWidget.h"
+#include "Engine/AssetManager.h"
+#include "Engine/StreamableManager.h"
 
 // Constants
-const FString BaseUrl = TEXT("https://game-api.k-id.com/api/v1"); 
+const FString DefaultBaseUrl = TEXT("https://game-api.k-id.com/api/v1"); // used when no endpoints are configured
 
 const int32 ConsentTimeoutSeconds = 300; // maximum time to wait for consent in seconds
-const int32 ConsentPollingInterval = 1; // time to wait between polling for consent in seconds
 const FString ClientId = TEXT("12345678-1234-1234-1234-123456789012"); // client ID for the demo
 
-// Unreal PIE aid to prevent long poll from causing issues after quitting the game
-bool UKidWorkflow::bShutdown = false;
+// kID widget blueprints.  All of them are streamed in during startup.
+namespace KidWidgets
+{
+    const TCHAR* const AgeGate = TEXT("/Game/kID/Blueprints/BP_AgeGateWidget.BP_AgeGateWidget_C");
+    const TCHAR* const SliderAgeGate = TEXT("/Game/kID/Blueprints/BP_SliderAgeGateWidget.BP_SliderAgeGateWidget_C");
+    const TCHAR* const TestSetChallenge = TEXT("/Game/kID/Blueprints/BP_TestSetChallengeWidget.BP_TestSetChallengeWidget_C");
+    const TCHAR* const DemoControls = TEXT("/Game/kID/Blueprints/BP_DemoControlsWidget.BP_DemoControlsWidget_C");
+    const TCHAR* const PlayerHUD = TEXT("/Game/kID/Blueprints/BP_PlayerHUDWidget.BP_PlayerHUDWidget_C");
+    const TCHAR* const FloatingChallenge = TEXT("/Game/kID/Blueprints/BP_FloatingChallengeWidget.BP_FloatingChallengeWidget_C");
+    const TCHAR* const AgeAssurance = TEXT("/Game/kID/Blueprints/BP_AgeAssuranceWidget.BP_AgeAssuranceWidget_C");
+    const TCHAR* const Settings = TEXT("/Game/kID/Blueprints/BP_SettingsWidget.BP_SettingsWidget_C");
+    const TCHAR* const Unavailable = TEXT("/Game/kID/Blueprints/BP_UnavailableWidget.BP_UnavailableWidget_C");
+
+    const TCHAR* const All[] = { AgeGate, SliderAgeGate, TestSetChallenge, DemoControls, PlayerHUD, 
+                                 FloatingChallenge, AgeAssurance, Settings, Unavailable };
+}
+
+namespace
+{
+    FKidSavedChallenge MakeSavedChallenge(const TSharedPtr<FJsonObject>& Challenge, int32 TimeoutSeconds)
+    {
+        FKidSavedChallenge Saved;
+        Saved.ChallengeId = Challenge->GetStringField(TEXT("challengeId"));
+        Saved.OneTimePassword = Challenge->GetStringField(TEXT("oneTimePassword"));
+        Saved.Url = Challenge->GetStringField(TEXT("url"));
+        Saved.TimeoutSeconds = TimeoutSeconds;
+        Saved.StartTime = FDateTime::UtcNow();
+        return Saved;
+    }
+}
 
-void UKidWorkflow::Initialize(TFunction<void(bool)> Callback)
+FKidFlowPtr UKidWorkflow::Initialize(TFunction<void(bool)> Callback)
 { 
+    KID_TRACE_SCOPE(KidWorkflow_Initialize);
     bShutdown = false;
 
+    PermissionsChanged.RemoveAll(this);
+    PermissionsChanged.AddUObject(this, &UKidWorkflow::HandlePermissionsChanged);
+
+    if (!WidgetPool)
+    {
+        WidgetPool = NewObject<UKidWidgetPool>(this);
+    }
+
+    if (!EndpointSelector.IsValid())
+    {
+        FKidEndpointSelector::FSettings EndpointSettings;
+        EndpointSettings.ProbePath = EndpointProbePath;
+        EndpointSettings.ProbeTimeoutSeconds = EndpointProbeTimeoutSeconds;
+        EndpointSettings.FailuresBeforeSwitch = EndpointFailuresBeforeSwitch;
+        EndpointSelector = MakeShared<FKidEndpointSelector, ESPMode::ThreadSafe>(
+                    Endpoints.Num() > 0 ? Endpoints : TArray<FString>{ DefaultBaseUrl }, EndpointSettings);
+
+        // requests that are already in flight finish against the old endpoint, everything after uses the new one
+        TWeakObjectPtr<UKidWorkflow> WeakThis(this);
+        EndpointSelector->OnEndpointChanged().AddLambda([WeakThis](const FString& NewBaseUrl)
+        {
+            if (WeakThis.IsValid() && !WeakThis->AuthToken.IsEmpty())
+            {
+                WeakThis->RequirementsCache->SetEndpoint(NewBaseUrl, WeakThis->AuthToken);
+            }
+        });
+    }
+
+    // The startup phases overlap instead of running one after the other: the widget classes stream 
+    // in, the API key and the saved state are read on the thread pool, the auth token is requested 
+    // as soon as the key is available, and the requirements for the last known jurisdiction are 
+    // prefetched once both the token and the saved state are in.  Each phase is a stage of the 
+    // startup flow, so its duration is logged when the flow completes.  Cached requirements are 
+    // read from disk alongside the saved state, so the age gate usually needs no network wait.
+    FKidFlowRef Flow = BeginFlow(TEXT("Startup"));
+    Flow->BeginStage(TEXT("TimeToInteractive"));
+
+    TFunction<void(FName)> EndStage = [Flow](FName Stage)
+    {
+        Flow->EndStage(Stage);
+        if (!Flow->HasOpenStages())
+        {
+            Flow->Complete();
+        }
+    };
+
+    Flow->BeginStage(TEXT("PreloadWidgets"));
+    PreloadWidgetClasses([EndStage]()
+    {
+        EndStage(TEXT("PreloadWidgets"));
+    });
+
+    // the workflow is usable once the saved state, cached requirements and cached policy are 
+    // loaded and the token request has finished
+    struct FStartupJoin
+    {
+        int32 Pending = 4;
+        bool bTokenIssued = false;
+    };
+    TSharedRef<FStartupJoin> Join = MakeShared<FStartupJoin>();
+
+    TFunction<void()> OnPhaseReady = [this, Flow, Join, Callback, EndStage]()
+    {
+        if (--Join->Pending > 0)
+        {
+            return;
+        }
+
+        if (Join->bTokenIssued)
+        {
+            const FString LastJurisdiction = State.GetLastJurisdiction();
+            if (!LastJurisdiction.IsEmpty())
+            {
+                Flow->BeginStage(TEXT("PrefetchRequirements"));
+                ContinueFlow(RequirementsCache->Get(LastJurisdiction), Flow, [EndStage](FKidRequirementsResult Result)
+                {
+                    EndStage(TEXT("PrefetchRequirements"));
+                });
+            }
+
+            for (const FString& Jurisdiction : PrefetchJurisdictions)
+            {
+                RequirementsCache->Prefetch(Jurisdiction);
+            }
+
+            ScheduleSessionRefresh();
+        }
+
+        // everything the saved session allows is a change from the game's defaults
+        BroadcastPermissionChanges(nullptr, State.GetSession());
+
+        Callback(Join->bTokenIssued);
+        EndStage(TEXT("TimeToInteractive"));
+    };
+
     // this demo is not a typical deployment of k-ID which will generally be behind your game backend.  Therefore 
     // the use of the api key in a file below is for demo purposes only.  In a standard deployment, the api key should be stored securely
     // in your server backend and not in a file the client.
-    FString ApiKey;
-    if (!FFileHelper::LoadFileToString(ApiKey, *(FPaths::ProjectDir() + TEXT("/apikey.txt"))))
+    Flow->BeginStage(TEXT("LoadApiKey"));
+    TFuture<FString> ApiKeyFuture = !ApiKey.IsEmpty() ? MakeFulfilledPromise<FString>(ApiKey).GetFuture() : KidRunInBackground<FString>([]()
     {
-        UE_LOG(LogTemp, Error, TEXT("Failed to load API key from apikey.txt.  Create a file with your API key in the project root directory."));
-        Callback(false);
-        return;
+        FString FileApiKey;
+        if (FFileHelper::LoadFileToString(FileApiKey, *(FPaths::ProjectDir() + TEXT("/apikey.txt"))))
+        {
+            FileApiKey.TrimEndInline();
+        }
+        return FileApiKey;
+    });
+    ContinueFlow(MoveTemp(ApiKeyFuture), Flow, [this, Flow, Join, OnPhaseReady, EndStage](FString LoadedApiKey)
+    {
+        EndStage(TEXT("LoadApiKey"));
+
+        if (LoadedApiKey.IsEmpty())
+        {
+            UE_LOG(LogTemp, Error, TEXT("Failed to load API key from apikey.txt.  Create a file with your API key in the project root directory."));
+            OnPhaseReady();
+            return;
+        }
+
+        // the token is issued by the region that will serve the session, so pick it first
+        Flow->BeginStage(TEXT("ProbeEndpoints"));
+        ContinueFlow(EndpointSelector->Probe(), Flow, [this, Flow, Join, OnPhaseReady, EndStage, LoadedApiKey](FString SelectedBaseUrl)
+        {
+            EndStage(TEXT("ProbeEndpoints"));
+
+            FKidIssueTokenRequest Request{ ClientId };
+
+            Flow->BeginStage(TEXT("IssueToken"));
+            ContinueFlow(HttpRequestHelper::PostRequestWithAuthAsync(GetBaseUrl() + TEXT("/auth/issue-token"), KidSerializeRequest(Request), LoadedApiKey, Flow), 
+                        Flow, [this, Join, OnPhaseReady, EndStage](FKidHttpResult Result)
+            {
+                if (Result.IsOk())
+                {
+                    TSharedPtr<FJsonObject> JsonResponse;
+                    TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(Result.Response->GetContentAsString());
+                    if (FJsonSerializer::Deserialize(Reader, JsonResponse))
+                    {
+                        AuthToken = JsonResponse->GetStringField(TEXT("accessToken"));
+                        UE_LOG(LogTemp, Log, TEXT("AuthToken generated: %s"), *AuthToken);
+                        RequirementsCache->SetEndpoint(GetBaseUrl(), AuthToken);
+                    }
+                }
+                Join->bTokenIssued = Result.bWasSuccessful;
+
+                EndStage(TEXT("IssueToken"));
+                OnPhaseReady();
+            });
+        });
+    });
+
+    Flow->BeginStage(TEXT("LoadRequirementsCache"));
+    RequirementsCache->SetTimeToLive(RequirementsTimeToLiveSeconds, RequirementsMaxStaleSeconds);
+    ContinueFlow(RequirementsCache->Load(State.GetDirectory() + TEXT("/AgeGateRequirements.json")), Flow, 
+                [OnPhaseReady, EndStage](int32 NumJurisdictions)
+    {
+        EndStage(TEXT("LoadRequirementsCache"));
+        OnPhaseReady();
+    });
+
+    Flow->BeginStage(TEXT("LoadPolicyBundle"));
+    ContinueFlow(PolicyCache->Load(State.GetDirectory() + TEXT("/PolicyBundle.bin")), Flow, 
+                [OnPhaseReady, EndStage](int32 NumJurisdictions)
+    {
+        EndStage(TEXT("LoadPolicyBundle"));
+        OnPhaseReady();
+    });
+
+    // do this up front so that the HUD shows the session before interacting with the kID demo controls.
+    // This is the only place the saved state is read from disk.
+    Flow->BeginStage(TEXT("LoadSavedState"));
+    const FString StateDirectory = State.GetDirectory();
+    ContinueFlow(KidRunInBackground<FKidStateStore>([StateDirectory]()
+    {
+        FKidStateStore LoadedState;
+        LoadedState.SetDirectory(StateDirectory);
+        LoadedState.Load();
+        return LoadedState;
+    }), Flow, [this, OnPhaseReady, EndStage](FKidStateStore LoadedState)
+    {
+        State = MoveTemp(LoadedState);
+        GetSavedSessionInfo();
+
+        EndStage(TEXT("LoadSavedState"));
+        OnPhaseReady();
+    });
+    return Flow;
+}
+
+FKidFlowPtr UKidWorkflow::InitializeFrom(const UKidWorkflow& Primary, TFunction<void(bool)> Callback)
+{
+    KID_TRACE_SCOPE(KidWorkflow_InitializeFrom);
+    bShutdown = false;
+
+    PermissionsChanged.RemoveAll(this);
+    PermissionsChanged.AddUObject(this, &UKidWorkflow::HandlePermissionsChanged);
+
+    if (!WidgetPool)
+    {
+        WidgetPool = NewObject<UKidWidgetPool>(this);
     }
-    ApiKey.TrimEndInline();
 
-    // do this up front so that the HUD shows the session before interacting with the kID demo controls
-    GetSavedSessionInfo();
+    // the primary has already picked the endpoint and been issued the token, and players in the
+    // same jurisdiction share its cached requirements and policy, or the request in flight
+    EndpointSelector = Primary.EndpointSelector;
+    AuthToken = Primary.AuthToken;
+    RequirementsCache = Primary.RequirementsCache;
+    PolicyCache = Primary.PolicyCache;
+
+    FKidFlowRef Flow = BeginFlow(TEXT("Startup"));
+    Flow->BeginStage(TEXT("LoadSavedState"));
+    const FString StateDirectory = State.GetDirectory();
+    ContinueFlow(KidRunInBackground<FKidStateStore>([StateDirectory]()
+    {
+        FKidStateStore LoadedState;
+        LoadedState.SetDirectory(StateDirectory);
+        LoadedState.Load();
+        return LoadedState;
+    }), Flow, [this, Flow, Callback](FKidStateStore LoadedState)
+    {
+        State = MoveTemp(LoadedState);
+        GetSavedSessionInfo();
+        Flow->EndStage(TEXT("LoadSavedState"));
+
+        if (!AuthToken.IsEmpty())
+        {
+            ScheduleSessionRefresh();
+        }
+        BroadcastPermissionChanges(nullptr, State.GetSession());
+
+        Callback(!AuthToken.IsEmpty());
+        Flow->Complete();
+    });
+    return Flow;
+}
 
-    FString payload = TEXT("{ \"clientId\": \"") + ClientId + TEXT("\"}");
+void UKidWorkflow::SetUi(const FKidWorkflowUi& InUi)
+{
+    Ui = InUi;
+    bUseUiHooks = true;
+}
 
-    HttpRequestHelper::PostRequestWithAuth(BaseUrl + TEXT("/auth/issue-token"), payload, ApiKey, 
-                    [this, Callback](FHttpResponsePtr Response, bool bWasSuccessful)
+template <typename ResultType, typename StepType>
+void UKidWorkflow::ContinueFlow(TFuture<ResultType>&& Future, const FKidFlowRef& Flow, StepType&& Step)
+{
+    TWeakObjectPtr<UKidWorkflow> WeakThis(this);
+    MoveTemp(Future).Next([WeakThis, Flow, Step = Forward<StepType>(Step)](ResultType Result) mutable
     {
-        if (bWasSuccessful && Response.IsValid())
+        if (!WeakThis.IsValid() || WeakThis->bShutdown)
+        {
+            return;
+        }
+
+        if (Flow->IsFinished())
         {
-            TSharedPtr<FJsonObject> JsonResponse;
-            TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(Response->GetContentAsString());
-            if (FJsonSerializer::Deserialize(Reader, JsonResponse))
+            // a cancelled flow takes the session it applied ahead of the server's answer with it
+            if (Flow->IsCancelled() && WeakThis->SpeculativeFlow.Pin() == Flow)
             {
-                AuthToken = JsonResponse->GetStringField(TEXT("accessToken"));
-                UE_LOG(LogTemp, Log, TEXT("AuthToken generated: %s"), *AuthToken);
+                WeakThis->RetractSpeculativeSession();
             }
+            return;
         }
-        Callback(bWasSuccessful);
+        KID_TRACE_SCOPE(KidWorkflow_FlowStep);
+        Step(MoveTemp(Result));
     });
+}
+
+FKidFlowRef UKidWorkflow::BeginFlow(const FString& Name)
+{
+    ActiveFlows.RemoveAll([](const FKidFlowRef& Flow) { return Flow->IsFinished(); });
 
+    FKidFlowRef Flow = MakeShared<FKidFlow, ESPMode::ThreadSafe>(Name);
+    ActiveFlows.Add(Flow);
+    return Flow;
 }
 
+void UKidWorkflow::CancelFlows()
+{
+    TArray<FKidFlowRef> Flows = MoveTemp(ActiveFlows);
+    for (const FKidFlowRef& Flow : Flows)
+    {
+        Flow->Cancel();
+    }
+
+    if (ConsentChannel.IsValid())
+    {
+        ConsentChannel->Cancel();
+    }
+
+    FTSTicker::GetCoreTicker().RemoveTicker(UpgradeBatchHandle);
+    UpgradeBatchHandle.Reset();
+    PendingUpgrades.Reset();
+    PendingUpgradeFlow.Reset();
+    ApprovedUpgrades.Reset();
+
+    // the answer that would have confirmed a speculative session is not coming any more
+    RetractSpeculativeSession();
+}
+
+FString UKidWorkflow::GetBaseUrl() const
+{
+    return EndpointSelector.IsValid() ? EndpointSelector->GetBaseUrl() : DefaultBaseUrl;
+}
 
 // This function is called to start a full kID workflow.  For the demo, this function doesn't
 // get invoked until the player presses the "Start Session" button in the demo controls.  In a real game 
 // this would happen on startup based on acquiring the location/jurisdistion from the player's IP address
 // or other means.
-void UKidWorkflow::StartKidSession(const FString& Location)
+FKidFlowPtr UKidWorkflow::StartKidSession(const FString& Location)
 {
+    KID_TRACE_SCOPE(KidWorkflow_StartKidSession);
     if (AuthToken.IsEmpty())
     {
         UE_LOG(LogTemp, Error, TEXT("AuthToken is not assigned. Please call InitializeAuthToken first."));
-        return;
+        return nullptr;
+    }
+
+    FKidFlowRef Flow = BeginFlow(TEXT("StartKidSession"));
+    TSharedPtr<FJsonObject> SessionInfo = State.GetSession();
+
+    if (!Location.IsEmpty())
+    {
+        State.SetLastJurisdiction(Location);
     }
 
-    FString LoadedChallengeId;
-    if (LoadChallengeId(LoadedChallengeId))
+    if (State.HasChallengeId())
     {
-        HandleExistingChallenge(LoadedChallengeId);
-        return;
+        // a session that is waiting on a challenge (e.g. an upgrade) can be refreshed 
+        // while the challenge is restored
+        if (SessionInfo.IsValid() && SessionInfo->HasField(TEXT("sessionId")))
+        {
+            Flow->BeginStage(TEXT("RefreshSession"));
+            ContinueFlow(GetSessionPermissions(SessionInfo->GetStringField(TEXT("sessionId")), 
+                        SessionInfo->GetStringField(TEXT("etag")), Flow), Flow, [Flow](bool bUpdated)
+            {
+                Flow->EndStage(TEXT("RefreshSession"));
+            });
+        }
+
+        HandleExistingChallenge(Flow, State.GetChallenge());
+        return Flow;
     }
 
     if (GetSavedSessionInfo())
@@ -98,91 +422,108 @@ void UKidWorkflow::StartKidSession(const FString& Location)
             FString SessionId = SessionInfo->GetStringField(TEXT("sessionId"));
             UE_LOG(LogTemp, Log, TEXT("Refreshing session."));
             FString ETag = SessionInfo->GetStringField(TEXT("etag"));
-            GetSessionPermissions(SessionId, ETag);
+            RefreshSession(Flow, SessionId, ETag);
         }
         else
         {
             UE_LOG(LogTemp, Log, TEXT("No age gate was necessary for this location."));
+            Flow->Complete();
         }
     }
     else
     {
-        GetUserAge(Location, [this, Location](bool ageGateShown, bool bAgeAssuranceRequired, const FString& DOB)
+        GetUserAge(Flow, Location);
+    }
+    return Flow;
+}
+
+// A challenge saved with its details is shown again straight away and its timeout carries on from
+// when it was first shown, while /challenge/get confirms it in the background.  One saved with only
+// its ID, or whose timeout ran out while the game was closed, waits on /challenge/get and gets a
+// fresh timeout.
+void UKidWorkflow::HandleExistingChallenge(const FKidFlowRef& Flow, const FKidSavedChallenge& Challenge)
+{
+    if (Challenge.HasDetails() && FDateTime::UtcNow() < Challenge.GetDeadline())
+    {
+        ShowConsentChallenge(Flow, Challenge, [this, Flow](bool bConsentGranted, const FString &SessionId)
         {
-            if (ageGateShown) {
-                if (bAgeAssuranceRequired)
-                {
-                    int32 Age = CalculateAgeFromDOB(DOB);
-                    ValidateAge(Age, [this, Location, DOB, Age](bool successful, int minAge, int maxAge)
-                    {
-                        if (successful) {
-                            DismissAgeAssuranceWidget();
-                            if (Age <= maxAge)
-                            {
-                                UE_LOG(LogTemp, Log, TEXT("Age successfully validated!"));
-                                StartKidSessionWithDOB(Location, DOB);
-                            }
-                            else
-                            {
-                                // using the minimum age as the default DOB as a year
-                                int32 DOBYear = FDateTime::Now().GetYear() - minAge;
-                                UE_LOG(LogTemp, Warning, TEXT("%s%s"),
-                                    TEXT("Player's age appears to be less than what was given. "), 
-                                    TEXT("Using %d as the birth year."), DOBYear);
-                                StartKidSessionWithDOB(Location, FString::FromInt(DOBYear));
-                            }
-                        }
-                        else
-                        {
-                            UE_LOG(LogTemp, Warning, TEXT("Age validation failed."));
-                            HandleProhibitedStatus();
-                        }
-                    });
-                }
-                else
-                {
-                    UE_LOG(LogTemp, Log, TEXT("Location is %s"), *Location);
-                    StartKidSessionWithDOB(Location, DOB);
-                }      
-            } 
-            else
-            {
-                UE_LOG(LogTemp, Log, TEXT("No age gate needed for location %s"), *Location);
-                GetDefaultPermissions(Location);
-            }
+            OnConsentResult(Flow, bConsentGranted, SessionId);
         });
+        RevalidateChallenge(Flow, Challenge);
+        return;
     }
+
+    Flow->TransitionTo(EKidFlowState::RestoringChallenge);
+
+    const FString ChallengeId = Challenge.ChallengeId;
+    ContinueFlow(HttpRequestHelper::GetRequestWithAuthAsync(GetBaseUrl() + TEXT("/challenge/get?challengeId=") + ChallengeId, AuthToken, Flow), 
+                Flow, [this, Flow, ChallengeId](FKidHttpResult Result)
+    {
+        if (!Result.IsOk())
+        {
+            Flow->Fail();
+            return;
+        }
+
+        UE_LOG(LogTemp, Log, TEXT("Call to /challenge/get succeeded: %s"), *Result.Response->GetContentAsString());
+
+        TSharedPtr<FJsonObject> JsonResponse;
+        TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(Result.Response->GetContentAsString());
+        if (!FJsonSerializer::Deserialize(Reader, JsonResponse))
+        {
+            Flow->Fail();
+            return;
+        }
+
+        FKidSavedChallenge Restored = MakeSavedChallenge(JsonResponse, ConsentTimeoutSeconds);
+        Restored.ChallengeId = ChallengeId;
+        SaveChallenge(Restored);
+
+        ShowConsentChallenge(Flow, Restored, [this, Flow](bool bConsentGranted, const FString &SessionId)
+        {
+            OnConsentResult(Flow, bConsentGranted, SessionId);
+        });
+    });
 }
 
-void UKidWorkflow::HandleExistingChallenge(const FString& ChallengeId)
+void UKidWorkflow::RevalidateChallenge(const FKidFlowRef& Flow, const FKidSavedChallenge& Challenge)
 {
-    HttpRequestHelper::GetRequestWithAuth(BaseUrl + TEXT("/challenge/get?challengeId=") + ChallengeId, AuthToken, [this, ChallengeId](FHttpResponsePtr Response, bool bWasSuccessful)
+    Flow->BeginStage(TEXT("RevalidateChallenge"));
+
+    ContinueFlow(HttpRequestHelper::GetRequestWithAuthAsync(GetBaseUrl() + TEXT("/challenge/get?challengeId=") + Challenge.ChallengeId, AuthToken, Flow), 
+                Flow, [this, Flow, Challenge](FKidHttpResult Result)
     {
-        if (bWasSuccessful && Response.IsValid())
+        Flow->EndStage(TEXT("RevalidateChallenge"));
+
+        if (State.GetChallengeId() != Challenge.ChallengeId)
         {
-            UE_LOG(LogTemp, Log, TEXT("Call to /challenge/get succeeded: %s"), *Response->GetContentAsString());
+            return;
+        }
 
-            TSharedPtr<FJsonObject> JsonResponse;
-            TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(Response->GetContentAsString());
-            if (FJsonSerializer::Deserialize(Reader, JsonResponse))
-            {
-                FString OneTimePassword = JsonResponse->GetStringField(TEXT("oneTimePassword"));
-                FString QRCodeUrl = JsonResponse->GetStringField(TEXT("url"));
+        // a 404 is not OK, so it is told apart from other failures first
+        if (Result.Response.IsValid() && Result.Response->GetResponseCode() == 404)
+        {
+            UE_LOG(LogTemp, Warning, TEXT("Saved challenge %s no longer exists."), *Challenge.ChallengeId);
+            ClearChallengeId();
+            return;
+        }
 
-                ShowConsentChallenge(ChallengeId, ConsentTimeoutSeconds, OneTimePassword, QRCodeUrl, [this](bool bConsentGranted, 
-                        const FString &SessionId)
-                {
-                    if (bConsentGranted)
-                    {
-                        GetSessionPermissions(SessionId, TEXT(""));
-                        ClearChallengeId();
-                    }
-                    else
-                    {
-                        HandleNoConsent();
-                    }
-                });
-            }
+        // the cached copy stays up if the server could not be reached or answered with another error
+        TSharedPtr<FJsonObject> JsonResponse;
+        if (!Result.IsOk() || !FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(Result.Response->GetContentAsString()), JsonResponse))
+        {
+            return;
+        }
+
+        FKidSavedChallenge Revalidated = Challenge;
+        Revalidated.OneTimePassword = JsonResponse->GetStringField(TEXT("oneTimePassword"));
+        Revalidated.Url = JsonResponse->GetStringField(TEXT("url"));
+        if (Revalidated.OneTimePassword != Challenge.OneTimePassword || Revalidated.Url != Challenge.Url)
+        {
+            UE_LOG(LogTemp, Log, TEXT("Saved challenge %s changed on the server, showing the new one."), *Challenge.ChallengeId);
+            SaveChallenge(Revalidated);
+            DismissFloatingChallengeWidget();
+            ShowFloatingChallengeWidget(Revalidated);
         }
     });
 }
@@ -190,288 +531,546 @@ void UKidWorkflow::HandleExistingChallenge(const FString& ChallengeId)
 // This function is called when a player has passed the age gate and assurance if necessary
 // and is ready to start a session or the age was already known because the game has stored 
 // the kID session information previously and associated it with an identity.
-void UKidWorkflow::StartKidSessionWithDOB(const FString& Location, const FString& DOB)
+void UKidWorkflow::StartKidSessionWithDOB(const FKidFlowRef& Flow, const FString& Location, const FString& DOB)
 {
+    KID_TRACE_SCOPE(KidWorkflow_StartKidSessionWithDOB);
     if (AuthToken.IsEmpty())
     {
         UE_LOG(LogTemp, Error, TEXT("AuthToken is not assigned. Please call InitializeAuthToken first."));
+        Flow->Fail();
         return;
     }
 
-    TSharedPtr<FJsonObject> JsonObject = MakeShareable(new FJsonObject());
-    JsonObject->SetStringField(TEXT("dateOfBirth"), DOB);
-    JsonObject->SetStringField(TEXT("jurisdiction"), Location);
+    Flow->TransitionTo(EKidFlowState::CheckingAge);
 
-    FString ContentJsonString;
-    TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&ContentJsonString);
-    FJsonSerializer::Serialize(JsonObject.ToSharedRef(), Writer);
+    FKidCheckAgeRequest Request{ DOB, Location };
 
-    HttpRequestHelper::PostRequestWithAuth(BaseUrl + TEXT("/age-gate/check"), ContentJsonString, AuthToken, [this](FHttpResponsePtr Response, bool bWasSuccessful)
+    ContinueFlow(HttpRequestHelper::PostRequestWithAuthAsync(GetBaseUrl() + TEXT("/age-gate/check"), KidSerializeRequest(Request), AuthToken, Flow), 
+                Flow, [this, Flow, Location, DOB](FKidHttpResult Result)
     {
-        if (bWasSuccessful)
+        TSharedPtr<FJsonObject> JsonResponse;
+        if (!Result.IsOk() || !FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(Result.Response->GetContentAsString()), JsonResponse))
         {
-            TSharedPtr<FJsonObject> JsonResponse;
-            TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(Response->GetContentAsString());
-            if (FJsonSerializer::Deserialize(Reader, JsonResponse))
+            RetractSpeculativeSession();
+            Flow->Fail();
+            return;
+        }
+
+        const KidCore::ECheckStatus Status = KidCore::ParseCheckStatus(KidToUtf8(JsonResponse->GetStringField(TEXT("status"))));
+        ConfirmPredictedCheck(Location, DOB, Status, Status == KidCore::ECheckStatus::Pass ? JsonResponse->GetObjectField(TEXT("session")) : nullptr);
+        if (Status != KidCore::ECheckStatus::Pass)
+        {
+            RetractSpeculativeSession();
+        }
+
+        if (Status == KidCore::ECheckStatus::Challenge)
+        {
+            FKidSavedChallenge Challenge = MakeSavedChallenge(JsonResponse->GetObjectField(TEXT("challenge")), ConsentTimeoutSeconds);
+            SaveChallenge(Challenge);
+
+            ShowConsentChallenge(Flow, Challenge, [this, Flow](bool bConsentGranted,
+                    const FString &SessionId)
             {
-                FString Status = JsonResponse->GetStringField(TEXT("status"));
-                if (Status == TEXT("CHALLENGE"))
-                {
-                    TSharedPtr<FJsonObject> Challenge = JsonResponse->GetObjectField(TEXT("challenge"));
-                    FString ChallengeId = Challenge->GetStringField(TEXT("challengeId"));
-                    FString OneTimePassword = Challenge->GetStringField(TEXT("oneTimePassword"));
-                    FString QRCodeUrl = Challenge->GetStringField(TEXT("url"));
-                    SaveChallengeId(ChallengeId);
-
-                    ShowConsentChallenge(ChallengeId, ConsentTimeoutSeconds, OneTimePassword, QRCodeUrl, [this](bool bConsentGranted,
-                            const FString &SessionId)
-                    {
-                        if (bConsentGranted)
-                        {
-                            GetSessionPermissions(SessionId, TEXT(""));
-                            ClearChallengeId();
-                        }
-                        else
-                        {
-                            HandleNoConsent();
-                        }
-                    });
-                }
-                else if (Status == TEXT("PASS"))
-                {
-                    Mode = AccessMode::Full;
-                    SessionInfo = JsonResponse->GetObjectField(TEXT("session"));
-                    SaveSessionInfo();
-                }
-                else if (Status == TEXT("PROHIBITED"))
-                {
-                    HandleProhibitedStatus();
-                }
-            }
+                OnConsentResult(Flow, bConsentGranted, SessionId);
+            });
+        }
+        else if (Status == KidCore::ECheckStatus::Pass)
+        {
+            State.SetMode(AccessMode::Full);
+            SaveSessionInfo(JsonResponse->GetObjectField(TEXT("session")));
+            Flow->Complete();
+        }
+        else if (Status == KidCore::ECheckStatus::Prohibited)
+        {
+            HandleProhibitedStatus();
+            Flow->Complete();
+        }
+        else
+        {
+            Flow->Fail();
         }
     });
 }
 
-void UKidWorkflow::GetUserAge(const FString& Location, TFunction<void(bool, bool, const FString&)> Callback)
+void UKidWorkflow::GetUserAge(const FKidFlowRef& Flow, const FString& Location)
 {
-    FString Url = BaseUrl + TEXT("/age-gate/get-requirements?jurisdiction=") + Location;
+    Flow->TransitionTo(EKidFlowState::FetchingRequirements);
 
-    HttpRequestHelper::GetRequestWithAuth(Url, AuthToken, [this, Location, Callback](FHttpResponsePtr Response, bool bWasSuccessful)
+    // usually already fetched, or in flight, from the startup prefetch
+    ContinueFlow(RequirementsCache->Get(Location), Flow, [this, Flow, Location](FKidRequirementsResult Result)
     {
-        if (bWasSuccessful && Response.IsValid())
+        if (!Result.bSuccess)
         {
-            TSharedPtr<FJsonObject> JsonResponse;
-            TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(Response->GetContentAsString());
-            if (FJsonSerializer::Deserialize(Reader, JsonResponse))
-            {
-                bool bShouldDisplay = JsonResponse->GetBoolField(TEXT("shouldDisplay"));
-                bool bAgeAssuranceRequired = JsonResponse->GetBoolField(TEXT("ageAssuranceRequired"));
+            Flow->Fail();
+            return;
+        }
 
-                // Extracting extra information about the jurisdiction.  
-                // Can be used to further customize the age gate.
-                int32 DigitalConsentAge = JsonResponse->GetIntegerField(TEXT("digitalConsentAge"));
-                int32 CivilAge = JsonResponse->GetIntegerField(TEXT("civilAge"));
-                int32 MinimumAge = JsonResponse->GetIntegerField(TEXT("minimumAge"));
+        const FKidAgeGateRequirements& Requirements = Result.Requirements;
+        PolicyCache->RecordRequirements(Location, Requirements);
+        if (Requirements.bShouldDisplay)
+        {
+            const KidCore::FAgeThresholds Thresholds = KidCore::FAgeThresholds{ Requirements.MinimumAge,
+                        Requirements.DigitalConsentAge, Requirements.CivilAge }.Normalized();
+            const bool bAgeAssuranceRequired = Requirements.bAgeAssuranceRequired;
 
-                // Extracting methods array
-                const TArray<TSharedPtr<FJsonValue>>& ApprovedAgeCollectionMethods = JsonResponse->GetArrayField(TEXT("approvedAgeCollectionMethods"));
+            if (bUseUiHooks && !Ui.ShowAgeGate)
+            {
+                UE_LOG(LogTemp, Error, TEXT("No age gate UI has been set for the workflow."));
+                Flow->Fail();
+                return;
+            }
 
-                TSet<FString> Methods;
-                for (const TSharedPtr<FJsonValue>& Value : ApprovedAgeCollectionMethods)
+            Flow->TransitionTo(EKidFlowState::AwaitingAgeGate);
+            PrefetchDefaultPermissions(Flow, Location);
+            ShowAgeGate(Requirements, [this, Flow, Location, Thresholds, bAgeAssuranceRequired](const FString& DOB)
+            {
+                // Only verify ages higher than the digital consent age
+                int32 Age = CalculateAgeFromDOB(DOB);
+                const bool bVerifyAge = KidCore::NeedsAgeAssurance(bAgeAssuranceRequired, Age, Thresholds);
+
+                // The cached policy knows the defaults of every band that passes without a challenge.
+                // The prefetched defaults are those of an adult, so they only stand in for adults
+                // who go straight to /age-gate/check.
+                if (!ApplyPredictedSession(Flow, Location, DOB))
                 {
-                    Methods.Add(Value->AsString());
+                    OnAgeGateSubmittedForPrefetch(Flow, Location, KidCore::IsUnverifiedAdult(bAgeAssuranceRequired, Age, Thresholds));
                 }
+                OnAgeGateSubmitted(Flow, Location, DOB, bVerifyAge);
+            });
+        } 
+        else 
+        {    
+            UE_LOG(LogTemp, Log, TEXT("No age gate needed for location %s"), *Location);
+            GetDefaultPermissions(Flow, Location);
+        }
+    });
+}
 
-                if (bShouldDisplay)
-                {
-                    ShowAgeGate(Methods, [this, DigitalConsentAge, Callback, bAgeAssuranceRequired](const FString& DOB)
-                    {
-                        // Only verify ages higher than the digital consent age
-                        int32 Age = CalculateAgeFromDOB(DOB);
-                        Callback(true, bAgeAssuranceRequired && Age >= DigitalConsentAge, DOB);
-                    });
-                } 
-                else 
-                {    
-                    Callback(false /* ageGateShown */, false /* ageAssuranceRequired */, TEXT(""));
-                }
+void UKidWorkflow::OnAgeGateSubmitted(const FKidFlowRef& Flow, const FString& Location, const FString& DOB, bool bAgeAssuranceRequired)
+{
+    if (Flow->IsFinished())
+    {
+        return;
+    }
+
+    if (!bAgeAssuranceRequired)
+    {
+        UE_LOG(LogTemp, Log, TEXT("Location is %s"), *Location);
+        StartKidSessionWithDOB(Flow, Location, DOB);
+        return;
+    }
+
+    if (bUseUiHooks && !Ui.ShowAgeAssurance)
+    {
+        UE_LOG(LogTemp, Error, TEXT("No age assurance UI has been set for the workflow."));
+        Flow->Fail();
+        return;
+    }
+
+    Flow->TransitionTo(EKidFlowState::AwaitingAgeAssurance);
+
+    int32 Age = CalculateAgeFromDOB(DOB);
+    ValidateAge(Age, [this, Flow, Location, DOB, Age](bool successful, int minAge, int maxAge)
+    {
+        if (Flow->IsFinished())
+        {
+            return;
+        }
+
+        if (successful) {
+            DismissAgeAssuranceWidget();
+            if (Age <= maxAge)
+            {
+                UE_LOG(LogTemp, Log, TEXT("Age successfully validated!"));
+                StartKidSessionWithDOB(Flow, Location, DOB);
             }
+            else
+            {
+                // using the minimum age as the default DOB as a year
+                int32 DOBYear = FDateTime::Now().GetYear() - minAge;
+                UE_LOG(LogTemp, Warning, TEXT("%s%s"),
+                    TEXT("Player's age appears to be less than what was given. "), 
+                    TEXT("Using %d as the birth year."), DOBYear);
+                StartKidSessionWithDOB(Flow, Location, FString::FromInt(DOBYear));
+            }
+        }
+        else
+        {
+            UE_LOG(LogTemp, Warning, TEXT("Age validation failed."));
+            HandleProhibitedStatus();
+            Flow->Complete();
         }
     });
 }
 
 void UKidWorkflow::ValidateAge(int32 Age, TFunction<void(bool, int32 minAge, int32 maxAge)> Callback)
 {
+    KID_TRACE_SCOPE(KidWorkflow_ValidateAge);
     UE_LOG(LogTemp, Log, TEXT("Validating age..."));
     ShowAgeAssuranceWidget(Age, Callback);
 }
 
-void UKidWorkflow::GetDefaultPermissions(const FString& Location)
+void UKidWorkflow::GetDefaultPermissions(const FKidFlowRef& Flow, const FString& Location)
 {
-    // use a default date of birth for age gate that would be considered a legal adult
-    FString dob = TEXT("1970");
+    Flow->TransitionTo(EKidFlowState::FetchingDefaultPermissions);
+
+    // the cached defaults let the player in straight away, and are only saved once the server
+    // confirms them
+    TSharedPtr<FJsonObject> PredictedSession = bPredictFromCachedPolicy ? PolicyCache->GetDefaultSession(Location) : nullptr;
+    if (PredictedSession.IsValid())
+    {
+        UE_LOG(LogTemp, Log, TEXT("Applying the default permissions of the cached policy for %s until the server answers."), *Location);
+        PolicyStats.Applied++;
+        ApplySpeculativeSession(Flow, PredictedSession, ESpeculativeSource::Policy);
+    }
 
-    FString Url = FString::Printf(TEXT("%s/age-gate/get-default-permissions?jurisdiction=%s&dateOfBirth=%s"), *BaseUrl, *Location, *dob);
-    HttpRequestHelper::GetRequestWithAuth(Url, AuthToken, [this](FHttpResponsePtr Response, bool bWasSuccessful)
+    ContinueFlow(FetchDefaultPermissions(Location, Flow), Flow, [this, Flow, Location, PredictedSession](TSharedPtr<FJsonObject> DefaultSession)
     {
-        if (bWasSuccessful && Response.IsValid())
+        if (!DefaultSession.IsValid())
         {
-            TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(Response->GetContentAsString());
-            if (FJsonSerializer::Deserialize(Reader, SessionInfo))
+            UE_LOG(LogTemp, Log, TEXT("Call to GetDefaultPermissions failed"));
+            RetractSpeculativeSession();
+            Flow->Fail();
+            return;
+        }
+
+        PolicyCache->RecordDefaults(Location, EKidAgeBand::Adult, DefaultSession);
+        if (PredictedSession.IsValid())
+        {
+            if (FKidPermissionDiff::Diff(PredictedSession, DefaultSession).Num() == 0)
+            {
+                PolicyStats.Confirmed++;
+            }
+            else
             {
-                Mode = AccessMode::Full;
-                SaveSessionInfo();
+                PolicyStats.Contradicted++;
+                UE_LOG(LogTemp, Log, TEXT("The default permissions for %s changed on the server, applying the new ones."), *Location);
             }
         }
-        else
+
+        State.SetMode(AccessMode::Full);
+        SaveSessionInfo(DefaultSession);
+        Flow->Complete();
+    });
+}
+
+TFuture<TSharedPtr<FJsonObject>> UKidWorkflow::FetchDefaultPermissions(const FString& Location, const FKidFlowPtr& Flow)
+{
+    // use a default date of birth for age gate that would be considered a legal adult
+    FString dob = TEXT("1970");
+
+    FString Url = FString::Printf(TEXT("%s/age-gate/get-default-permissions?jurisdiction=%s&dateOfBirth=%s"), *GetBaseUrl(), *Location, *dob);
+    return HttpRequestHelper::GetRequestWithAuthAsync(Url, AuthToken, Flow).Next([](FKidHttpResult Result)
+    {
+        TSharedPtr<FJsonObject> DefaultSession;
+        if (!Result.IsOk() || !EHttpResponseCodes::IsOk(Result.Response->GetResponseCode()) ||
+            !FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(Result.Response->GetContentAsString()), DefaultSession))
         {
-            UE_LOG(LogTemp, Log, TEXT("Call to GetDefaultPermissions failed"));
+            DefaultSession.Reset();
         }
+        return DefaultSession;
     });
 }
 
-void UKidWorkflow::ShowConsentChallenge(const FString& ChallengeId, int32 Timeout, const FString& OTP, 
-                const FString& QRCodeUrl, TFunction<void(bool, const FString&)> OnConsentGranted)
+void UKidWorkflow::PrefetchDefaultPermissions(const FKidFlowRef& Flow, const FString& Location)
 {
-    FDateTime StartTime = FDateTime::UtcNow();
+    if (!bPrefetchDefaultPermissions || Location.IsEmpty())
+    {
+        return;
+    }
 
-    ShowFloatingChallengeWidget(OTP, QRCodeUrl, [this, ChallengeId](const FString& Email, TFunction<void(bool)> OnOperationComplete)
+    // a copy for this jurisdiction from an earlier age gate is still good
+    if (DefaultPermissionsPrefetch.Jurisdiction == Location && (DefaultPermissionsPrefetch.bInFlight || DefaultPermissionsPrefetch.Session.IsValid()))
     {
-        TSharedPtr<FJsonObject> JsonObject = MakeShareable(new FJsonObject());
-        JsonObject->SetStringField(TEXT("email"), Email);
-        JsonObject->SetStringField(TEXT("challengeId"), ChallengeId);
+        return;
+    }
+
+    // so are the adult defaults of the cached policy, which /age-gate/check keeps confirming
+    if (bPredictFromCachedPolicy && PolicyCache->HasDefaults(Location, EKidAgeBand::Adult))
+    {
+        return;
+    }
 
-        FString ContentJsonString;
-        TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&ContentJsonString);
-        FJsonSerializer::Serialize(JsonObject.ToSharedRef(), Writer);
+    DefaultPermissionsPrefetch = FDefaultPermissionsPrefetch();
+    DefaultPermissionsPrefetch.Jurisdiction = Location;
+    DefaultPermissionsPrefetch.bInFlight = true;
+    PrefetchStats.Issued++;
 
-        HttpRequestHelper::PostRequestWithAuth(BaseUrl + TEXT("/challenge/send-email"), ContentJsonString, AuthToken, [OnOperationComplete](FHttpResponsePtr Response, bool bWasSuccessful)
+    // tracked by the flow so leaving the age gate cancels it
+    Flow->BeginStage(TEXT("PrefetchDefaultPermissions"));
+    TWeakObjectPtr<UKidWorkflow> WeakThis(this);
+    FetchDefaultPermissions(Location, Flow).Next([WeakThis, Flow, Location](TSharedPtr<FJsonObject> DefaultSession)
+    {
+        Flow->EndStage(TEXT("PrefetchDefaultPermissions"));
+
+        UKidWorkflow* This = WeakThis.Get();
+        if (!This || This->bShutdown || This->DefaultPermissionsPrefetch.Jurisdiction != Location)
         {
-            OnOperationComplete(bWasSuccessful && Response.IsValid());
-        });
+            return;
+        }
+
+        This->DefaultPermissionsPrefetch.bInFlight = false;
+        This->DefaultPermissionsPrefetch.Session = DefaultSession;
+        if (!DefaultSession.IsValid())
+        {
+            This->PrefetchStats.Failed++;
+        }
+        else
+        {
+            This->PolicyCache->RecordDefaults(Location, EKidAgeBand::Adult, DefaultSession);
+        }
     });
+}
+
+void UKidWorkflow::OnAgeGateSubmittedForPrefetch(const FKidFlowRef& Flow, const FString& Location, bool bAdult)
+{
+    FDefaultPermissionsPrefetch& Prefetch = DefaultPermissionsPrefetch;
+    if (Prefetch.Jurisdiction != Location || (!Prefetch.bInFlight && !Prefetch.Session.IsValid()))
+    {
+        return;
+    }
+
+    if (!bAdult)
+    {
+        PrefetchStats.NotAdult++;
+        return;
+    }
+
+    if (!Prefetch.Session.IsValid())
+    {
+        PrefetchStats.NotReady++;
+        UE_LOG(LogTemp, Log, TEXT("Default permissions for %s were not ready when the age gate was submitted."), *Location);
+        return;
+    }
+
+    PrefetchStats.Hits++;
+    UE_LOG(LogTemp, Log, TEXT("Applying prefetched default permissions for %s until /age-gate/check answers."), *Location);
+
+    // /age-gate/check replaces this with the player's own session, which is the one saved.  The
+    // prefetched copy is used up.
+    ApplySpeculativeSession(Flow, MoveTemp(Prefetch.Session), ESpeculativeSource::Prefetch);
+}
+
+void UKidWorkflow::RetractSpeculativeSession()
+{
+    if (!State.IsSessionSpeculative())
+    {
+        return;
+    }
+
+    SpeculativeFlow.Reset();
+    if (SpeculativeSource == ESpeculativeSource::Policy)
+    {
+        PolicyStats.Retracted++;
+    }
+    else
+    {
+        PrefetchStats.Retracted++;
+    }
+    UE_LOG(LogTemp, Warning, TEXT("Withdrawing the default permissions applied ahead of the server's answer."));
+
+    // nothing was written, so the saved session and mode are what the player goes back to
+    TSharedPtr<FJsonObject> OldSession = State.GetSession();
+    State.ClearSpeculativeSession();
+    UpdateHUD();
+    BroadcastPermissionChanges(OldSession, State.GetSession());
+}
+
+bool UKidWorkflow::ApplyPredictedSession(const FKidFlowRef& Flow, const FString& Location, const FString& DOB)
+{
+    FKidDate Date;
+    if (!bPredictFromCachedPolicy || !FKidAgeClassifier::ParseDate(DOB, Date))
+    {
+        return false;
+    }
+
+    FKidPolicyPrediction Prediction = PolicyCache->Predict(Location, FKidAgeClassifier::CalculateAge(Date, FKidDate::Today()));
+    if (Prediction.Status != KidCore::ECheckStatus::Pass || !Prediction.Session.IsValid())
+    {
+        return false;
+    }
+
+    PolicyStats.Applied++;
+    UE_LOG(LogTemp, Log, TEXT("Applying the %s defaults of the cached policy for %s until /age-gate/check answers."), 
+                LexToString(Prediction.Band), *Location);
+
+    // withdrawn just like prefetched defaults if /age-gate/check does not pass
+    ApplySpeculativeSession(Flow, Prediction.Session, ESpeculativeSource::Policy);
+    return true;
+}
+
+void UKidWorkflow::ConfirmPredictedCheck(const FString& Location, const FString& DOB, KidCore::ECheckStatus Status, const TSharedPtr<FJsonObject>& Session)
+{
+    FKidDate Date;
+    if (Status == KidCore::ECheckStatus::Unknown || !FKidAgeClassifier::ParseDate(DOB, Date))
+    {
+        return;
+    }
+
+    const FKidPolicyPrediction Prediction = PolicyCache->Predict(Location, FKidAgeClassifier::CalculateAge(Date, FKidDate::Today()));
+    if (Prediction.Status == KidCore::ECheckStatus::Unknown)
+    {
+        return;
+    }
+
+    if (Prediction.Status != Status)
+    {
+        PolicyStats.Contradicted++;
+        UE_LOG(LogTemp, Warning, TEXT("/age-gate/check answered %s where the cached policy for %s predicted %s, dropping the policy."),
+                    ANSI_TO_TCHAR(KidCore::ToString(Status)), *Location, ANSI_TO_TCHAR(KidCore::ToString(Prediction.Status)));
+        PolicyCache->Invalidate(Location);
+        return;
+    }
+
+    // a session fresh from /age-gate/check starts with the defaults of the player's band
+    PolicyStats.Confirmed++;
+    if (Status == KidCore::ECheckStatus::Pass)
+    {
+        PolicyCache->RecordDefaults(Location, Prediction.Band, Session);
+    }
+}
 
-    CheckForConsent(ChallengeId, StartTime, Timeout, OnConsentGranted);
+void UKidWorkflow::ShowConsentChallenge(const FKidFlowRef& Flow, const FKidSavedChallenge& Challenge, 
+                TFunction<void(bool, const FString&)> OnConsentGranted)
+{
+    Flow->TransitionTo(EKidFlowState::AwaitingConsent);
+
+    ShowFloatingChallengeWidget(Challenge);
+
+    // a restored challenge waits out what is left of its original timeout
+    CheckForConsent(Flow, Challenge.ChallengeId, Challenge.StartTime, Challenge.TimeoutSeconds, OnConsentGranted);
+}
+
+void UKidWorkflow::OnConsentResult(const FKidFlowRef& Flow, bool bConsentGranted, const FString& SessionId)
+{
+    if (bConsentGranted)
+    {
+        ClearChallengeId();
+        RefreshSession(Flow, SessionId, TEXT(""));
+    }
+    else
+    {
+        HandleNoConsent();
+        Flow->Fail();
+    }
 }
 
-void UKidWorkflow::CheckForConsent(const FString& ChallengeId, FDateTime StartTime, int32 Timeout, 
+void UKidWorkflow::CheckForConsent(const FKidFlowRef& Flow, const FString& ChallengeId, FDateTime StartTime, int32 Timeout, 
                         TFunction<void(bool, const FString &)> OnConsentGranted)
 {
     // *kID challenge/await timeout parameter*
-    // This value could be assigned the value of Timeout if you want to simply wait 
-    // for the long poll to return and reduce the number of retries.  
-    // It is set to 1 second for demo purposes as entering Play In Editor mode in 
-    // Unreal will leave the long poll hanging after quitting the game.
-    const int challengeAwaitTimeout = 1;
+    // The awaiter, used directly or as the fallback for push, holds each /challenge/await open for as long as the deadline allows, up to 
+    // MaxChallengeAwaitSeconds, and re-issues it as soon as it returns without a result.  The 
+    // request in flight is cancelled on CleanUp, so quitting Play In Editor no longer leaves a 
+    // long poll hanging.
+    FKidConsentAwaiter::FSettings Settings;
+    Settings.MaxAwaitSeconds = MaxChallengeAwaitSeconds;
+    Settings.InitialBackoffSeconds = ConsentRetryInitialBackoffSeconds;
+    Settings.MaxBackoffSeconds = ConsentRetryMaxBackoffSeconds;
+
+    if (ConsentChannel.IsValid())
+    {
+        ConsentChannel->Cancel();
+    }
 
-    FString Url = FString::Printf(TEXT("%s/challenge/await?challengeId=%s&timeout=%d"), 
-                *BaseUrl, *ChallengeId, challengeAwaitTimeout);
+    // status changes are pushed when a push endpoint is configured, with long polling as the fallback
+    if (SharedConsentAwaiter.IsValid())
+    {
+        SharedConsentAwaiter->SetEndpoint(GetBaseUrl(), AuthToken);
+        ConsentChannel = MakeShared<FKidServiceConsentChannel, ESPMode::ThreadSafe>(SharedConsentAwaiter.ToSharedRef());
+    }
+    else if (ConsentPushUrl.IsEmpty())
+    {
+        ConsentChannel = MakeShared<FKidConsentAwaiter, ESPMode::ThreadSafe>(GetBaseUrl(), AuthToken, Settings);
+    }
+    else
+    {
+        ConsentChannel = MakeShared<FKidPushConsentChannel, ESPMode::ThreadSafe>(ConsentPushUrl, AuthToken, 
+                    MakeShared<FKidConsentAwaiter, ESPMode::ThreadSafe>(GetBaseUrl(), AuthToken, Settings));
+    }
 
-    HttpRequestHelper::GetRequestWithAuth(Url, AuthToken, 
-            [this, ChallengeId, StartTime, Timeout, OnConsentGranted]
-            (FHttpResponsePtr Response, bool bWasSuccessful)
+    TWeakObjectPtr<UKidWorkflow> WeakThis(this);
+    ConsentChannel->Start(ChallengeId, StartTime, Timeout, [WeakThis, Flow, OnConsentGranted](const FKidConsentResult& Result)
     {
-        if (bShutdown)
+        if (!WeakThis.IsValid() || WeakThis->bShutdown || Flow->IsFinished())
         {
-            FString LogMessage = TEXT("CheckForConsent was called after the game instance has been shut down.");
-            UE_LOG(LogTemp, Warning, TEXT("%s"), *LogMessage);
             return;
         }
 
-        if (!HasChallengeId())
+        switch (Result.Status)
         {
-            FString LogMessage = TEXT("Challenge ID was cleared while waiting for consent.");
-            UE_LOG(LogTemp, Warning, TEXT("%s"), *LogMessage);
-            return;
+        case EKidConsentStatus::Granted:
+            // At this point, the player has been granted consent and 
+            // the email of the parent or guardian who granted consent is available
+            // in Result.ApproverEmail. This can be used for customer service 
+            // requests later.
+            //
+            // StoreEmailForLaterUse(Result.SessionId, Result.ApproverEmail);
+            OnConsentGranted(true, Result.SessionId);
+            break;
+
+        case EKidConsentStatus::Denied:
+        case EKidConsentStatus::TimedOut:
+            OnConsentGranted(false, TEXT(""));
+            break;
+
+        case EKidConsentStatus::Cancelled:
+            UE_LOG(LogTemp, Warning, TEXT("Challenge ID was cleared while waiting for consent."));
+            Flow->Cancel();
+            break;
         }
+    });
+}
 
-        bool bConsentGranted = false;
+void UKidWorkflow::RefreshSession(const FKidFlowRef& Flow, const FString& SessionId, const FString& ETag)
+{
+    Flow->TransitionTo(EKidFlowState::RefreshingSession);
 
-        if (bWasSuccessful && Response.IsValid())
+    ContinueFlow(GetSessionPermissions(SessionId, ETag, Flow), Flow, [Flow](bool bUpdated)
+    {
+        if (bUpdated)
         {
-            TSharedPtr<FJsonObject> JsonResponse;
-            TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(Response->GetContentAsString());
-            if (FJsonSerializer::Deserialize(Reader, JsonResponse))
-            {
-                FString Status = JsonResponse->GetStringField(TEXT("status"));
-
-                if (Status == TEXT("PASS"))
-                {
-                    FString SessionId = JsonResponse->GetStringField(TEXT("sessionId"));
-
-                    FString ApproverEmail = JsonResponse->GetStringField(TEXT("approverEmail"));
-
-                    // At this point, the player has been granted consent and 
-                    // the email of the parent or guardian who granted consent is available
-                    // in the approverEmail field. This can be used for customer service 
-                    // requests later.
-                    //
-                    // StoreEmailForLaterUse(SessionId, ApproverEmail);
-
-                    OnConsentGranted(true, SessionId);
-                    return;
-                }
-                else if (Status == TEXT("FAIL"))
-                {
-                    OnConsentGranted(false, TEXT(""));
-                    return;
-                }
-            }
-
-            FDateTime CurrentTime = FDateTime::UtcNow();
-            FTimespan ElapsedTime = CurrentTime - StartTime;
-
-            // Retry if the elapsed time is less than the overall timeout
-            if (ElapsedTime.GetTotalSeconds() < Timeout)
-            {
-                GetWorld()->GetTimerManager().SetTimer(ConsentPollingTimerHandle, [this, ChallengeId, StartTime, Timeout, OnConsentGranted]()
-                {
-                    CheckForConsent(ChallengeId, StartTime, Timeout, OnConsentGranted);
-                }, ConsentPollingInterval, false);
-            }
-            else
-            {
-                OnConsentGranted(false, TEXT(""));
-            }
+            Flow->Complete();
         }
         else
         {
-            OnConsentGranted(false, TEXT(""));
+            Flow->Fail();
         }
-
     });
 }
 
-void UKidWorkflow::GetSessionPermissions(const FString& SessionId, const FString& ETag)
+TFuture<bool> UKidWorkflow::GetSessionPermissions(const FString& SessionId, const FString& ETag, const FKidFlowPtr& Flow)
 {
-    FString Url = FString::Printf(TEXT("%s/session/get?sessionId=%s&etag=%s"), *BaseUrl, *SessionId, *ETag);
-
-    HttpRequestHelper::GetRequestWithAuth(Url, AuthToken, [this](FHttpResponsePtr Response, bool bWasSuccessful)
+    TWeakObjectPtr<UKidWorkflow> WeakThis(this);
+    return FKidSessionApi::GetSession(GetBaseUrl(), AuthToken, SessionId, ETag, Flow).Next([WeakThis](FKidSessionResult Result)
     {
-        if (bWasSuccessful && Response.IsValid())
+        UKidWorkflow* This = WeakThis.Get();
+        if (!This || This->bShutdown || !Result.bSuccess)
         {
-            Mode = AccessMode::Full;
-            if (Response->GetResponseCode() == 304)
-            {
-                UE_LOG(LogTemp, Log, TEXT("Session information is up-to-date."));
-                return;
-            }
+            return false;
+        }
 
-            TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(Response->GetContentAsString());
-            if (FJsonSerializer::Deserialize(Reader, SessionInfo))
-            {
-                FString dateOfBirth = SessionInfo->GetStringField(TEXT("dateOfBirth"));
+        This->State.SetMode(AccessMode::Full);
+        if (Result.bNotModified)
+        {
+            UE_LOG(LogTemp, Log, TEXT("Session information is up-to-date."));
+            This->UpdateHUD();
+            This->ResolveApprovedUpgrades();
+            return true;
+        }
 
-                // If the parent modifies the date of birth for their
-                // child in the parent portal, the dateOfBirth field in the session will now
-                // contain the modified value, not the value that the player gave.
-                //
-                // StoreDateOfBirthForLaterUse(dateOfBirth);
+        FString dateOfBirth = Result.Session->GetStringField(TEXT("dateOfBirth"));
 
-                 UE_LOG(LogTemp, Log, TEXT("Updated session."));
-                SaveSessionInfo();
-            }
-        }   
+        // If the parent modifies the date of birth for their
+        // child in the parent portal, the dateOfBirth field in the session will now
+        // contain the modified value, not the value that the player gave.
+        //
+        // StoreDateOfBirthForLaterUse(dateOfBirth);
+
+        UE_LOG(LogTemp, Log, TEXT("Updated session."));
+        This->SaveSessionInfo(Result.Session);
+        This->ResolveApprovedUpgrades();
+        return true;
     });
 }
 
@@ -486,23 +1085,23 @@ void UKidWorkflow::AttemptTurnOnRestrictedFeature(const FString& FeatureName, TF
     TSharedPtr<FJsonObject> PermissionObject = FindPermission(FeatureName);
     if (PermissionObject)
     {
-        bool bEnabled = PermissionObject->GetBoolField(TEXT("enabled"));
-
-        if (bEnabled)
+        switch (KidCore::DecidePermissionAction(PermissionObject->GetBoolField(TEXT("enabled")),
+                    KidToUtf8(PermissionObject->GetStringField(TEXT("managedBy")))))
         {
+        case KidCore::EPermissionAction::AlreadyEnabled:
             UE_LOG(LogTemp, Log, TEXT("Feature %s is already enabled."), *FeatureName);
-            return;
-        }
-
-        FString ManagedBy = PermissionObject->GetStringField(TEXT("managedBy"));
+            break;
 
-        if (ManagedBy == TEXT("PLAYER") || ManagedBy == TEXT("GUARDIAN"))
-        {
+        case KidCore::EPermissionAction::Upgrade:
             UpgradeSession(FeatureName, EnableFeature);
-        }
-        else if (ManagedBy == TEXT("PROHIBITED"))
-        {
+            break;
+
+        case KidCore::EPermissionAction::Prohibited:
             UE_LOG(LogTemp, Warning, TEXT("Feature %s is prohibited for this player."), *FeatureName);
+            break;
+
+        case KidCore::EPermissionAction::Unknown:
+            break;
         }
     }
     else
@@ -512,90 +1111,171 @@ void UKidWorkflow::AttemptTurnOnRestrictedFeature(const FString& FeatureName, TF
 }
 
 
-void UKidWorkflow::UpgradeSession(const FString &FeatureName, TFunction<void()> EnableFeature)
+FKidFlowPtr UKidWorkflow::UpgradeSession(const FString &FeatureName, TFunction<void()> EnableFeature)
+{
+    if (PendingUpgradeFlow.IsValid() && !PendingUpgradeFlow->IsFinished())
+    {
+        PendingUpgrades.Add({ FeatureName, MoveTemp(EnableFeature) });
+        return PendingUpgradeFlow;
+    }
+
+    FKidFlowRef Flow = BeginFlow(TEXT("UpgradeSession"));
+    Flow->TransitionTo(EKidFlowState::BatchingUpgrades);
+    PendingUpgradeFlow = Flow;
+    PendingUpgrades.Add({ FeatureName, MoveTemp(EnableFeature) });
+
+    TWeakObjectPtr<UKidWorkflow> WeakThis(this);
+    UpgradeBatchHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda([WeakThis](float DeltaTime)
+    {
+        if (UKidWorkflow* This = WeakThis.Get())
+        {
+            This->UpgradeBatchHandle.Reset();
+            This->SendUpgradeBatch();
+        }
+        return false;
+    }), UpgradeBatchWindowSeconds);
+    return Flow;
+}
+
+void UKidWorkflow::SendUpgradeBatch()
 {
-    TSharedPtr<FJsonObject> JsonObject = MakeShareable(new FJsonObject());
-    JsonObject->SetStringField(TEXT("sessionId"), SessionInfo->GetStringField(TEXT("sessionId")));
+    KID_TRACE_SCOPE(KidWorkflow_SendUpgradeBatch);
+    TArray<FUpgradeRequest> Upgrades = MoveTemp(PendingUpgrades);
+    FKidFlowPtr BatchFlow = MoveTemp(PendingUpgradeFlow);
+    PendingUpgrades.Reset();
+    PendingUpgradeFlow.Reset();
+    if (bShutdown || !BatchFlow.IsValid() || BatchFlow->IsFinished())
+    {
+        return;
+    }
 
-    TSharedPtr<FJsonObject> PermJsonObject = MakeShareable(new FJsonObject());
-    PermJsonObject->SetStringField(TEXT("name"), FeatureName);
+    FKidFlowRef Flow = BatchFlow.ToSharedRef();
+    Flow->TransitionTo(EKidFlowState::UpgradingSession);
 
-    TArray<TSharedPtr<FJsonValue>> JsonArray;
-    JsonArray.Add(MakeShareable(new FJsonValueObject(PermJsonObject)));
+    TArray<FString> FeatureNames;
+    TArray<FKidRequestedPermission, TInlineAllocator<16>> RequestedPermissions;
+    for (const FUpgradeRequest& Upgrade : Upgrades)
+    {
+        if (!FeatureNames.Contains(Upgrade.FeatureName))
+        {
+            FeatureNames.Add(Upgrade.FeatureName);
+            RequestedPermissions.Add(FKidRequestedPermission{ Upgrade.FeatureName });
+        }
+    }
 
-    JsonObject->SetArrayField(TEXT("requestedPermissions"), JsonArray);
+    const FString SessionId = State.GetSession()->GetStringField(TEXT("sessionId"));
+    FKidUpgradeSessionRequest Request{ SessionId, RequestedPermissions };
 
-    FString ContentJsonString;
-    TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&ContentJsonString);
-    FJsonSerializer::Serialize(JsonObject.ToSharedRef(), Writer);
+    UE_LOG(LogTemp, Log, TEXT("Upgrading session for %s."), *FString::Join(FeatureNames, TEXT(", ")));
 
-    HttpRequestHelper::PostRequestWithAuth(BaseUrl + TEXT("/session/upgrade"), ContentJsonString, AuthToken, 
-                [this, EnableFeature, FeatureName](FHttpResponsePtr Response, bool bWasSuccessful)
+    ContinueFlow(HttpRequestHelper::PostRequestWithAuthAsync(GetBaseUrl() + TEXT("/session/upgrade"), KidSerializeRequest(Request), AuthToken, Flow), 
+                Flow, [this, Flow, Upgrades, FeatureNames](FKidHttpResult Result)
     {
-        if (bWasSuccessful)
+        TSharedPtr<FJsonObject> JsonResponse;
+        if (!Result.IsOk() || !FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(Result.Response->GetContentAsString()), JsonResponse))
         {
-            TSharedPtr<FJsonObject> JsonResponse;
-            TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(Response->GetContentAsString());
-            if (FJsonSerializer::Deserialize(Reader, JsonResponse))
-            {
-                if (JsonResponse->HasField(TEXT("challenge")))
-                {
-                    TSharedPtr<FJsonObject> Challenge = JsonResponse->GetObjectField(TEXT("challenge"));
-                    FString ChallengeId = Challenge->GetStringField(TEXT("challengeId"));
-                    FString OneTimePassword = Challenge->GetStringField(TEXT("oneTimePassword"));
-                    FString QRCodeUrl = Challenge->GetStringField(TEXT("url"));
+            Flow->Fail();
+            return;
+        }
 
-                    SaveChallengeId(ChallengeId);
+        if (JsonResponse->HasField(TEXT("challenge")))
+        {
+            FKidSavedChallenge Challenge = MakeSavedChallenge(JsonResponse->GetObjectField(TEXT("challenge")), ConsentTimeoutSeconds);
+            SaveChallenge(Challenge);
+
+            // the parent may approve after this flow has given up, so look for the upgraded session
+            // more often for a while
+            RefreshSchedule.ExpectChange(SessionRefresh, FPlatformTime::Seconds());
+            ScheduleSessionRefresh();
 
-                    ShowConsentChallenge(ChallengeId, ConsentTimeoutSeconds, OneTimePassword, QRCodeUrl, 
-                            [this, EnableFeature, FeatureName](bool bConsentGranted, const FString &SessionId)
+            ShowConsentChallenge(Flow, Challenge, 
+                    [this, Flow, Upgrades, FeatureNames](bool bConsentGranted, const FString &SessionId)
+            {
+                // TODO: store challenge type and feature name if applicable
+                ClearChallengeId();
+                if (bConsentGranted)
+                {
+                    // enable the features once the upgraded session has arrived
+                    Flow->TransitionTo(EKidFlowState::RefreshingSession);
+                    ContinueFlow(GetSessionPermissions(SessionId, TEXT(""), Flow), Flow, [this, Flow, Upgrades](bool bUpdated)
                     {
-                        // TODO: store challenge type and feature name if applicable
-                        ClearChallengeId();
-                        if (bConsentGranted)
-                        {
-                            GetSessionPermissions(SessionId, TEXT(""));
-                            EnableFeature();
-                        }
-                        else
+                        if (!bUpdated)
                         {
-                            // request to turn on feature was denied, don't do anything
-                            UE_LOG(LogTemp, Warning, TEXT("Feature request denied for feature %s."), *FeatureName);
+                            // the stale session would deny every feature, so leave them to the next
+                            // refresh, which the pending change brings forward
+                            UE_LOG(LogTemp, Warning, TEXT("Could not fetch the upgraded session, the features will be enabled on the next refresh."));
+                            ApprovedUpgrades.Append(Upgrades);
+                            Flow->Fail();
+                            return;
                         }
+                        ResolveUpgrades(Upgrades);
+                        Flow->Complete();
                     });
                 }
-                else if (JsonResponse->HasField(TEXT("session")))
+                else
                 {
-                    SessionInfo = JsonResponse->GetObjectField(TEXT("session"));
-                    SaveSessionInfo();
-                    EnableFeature();
+                    // request to turn on features was denied, don't do anything
+                    UE_LOG(LogTemp, Warning, TEXT("Feature request denied for %s."), *FString::Join(FeatureNames, TEXT(", ")));
+                    Flow->Fail();
                 }
-            }
+            });
+        }
+        else if (JsonResponse->HasField(TEXT("session")))
+        {
+            SaveSessionInfo(JsonResponse->GetObjectField(TEXT("session")));
+            ResolveUpgrades(Upgrades);
+            Flow->Complete();
+        }
+        else
+        {
+            Flow->Fail();
         }
     });
 }
 
+void UKidWorkflow::ResolveUpgrades(const TArray<FUpgradeRequest>& Upgrades)
+{
+    KID_TRACE_SCOPE(KidWorkflow_ResolveUpgrades);
+    // a parent can approve some of the features of a batch and not others
+    for (const FUpgradeRequest& Upgrade : Upgrades)
+    {
+        TSharedPtr<FJsonObject> PermissionObject = FindPermission(Upgrade.FeatureName);
+        if (PermissionObject.IsValid() && PermissionObject->GetBoolField(TEXT("enabled")))
+        {
+            Upgrade.EnableFeature();
+        }
+        else
+        {
+            UE_LOG(LogTemp, Warning, TEXT("Feature %s was not enabled by the session upgrade."), *Upgrade.FeatureName);
+        }
+    }
+}
+
+void UKidWorkflow::ResolveApprovedUpgrades()
+{
+    if (ApprovedUpgrades.Num() > 0)
+    {
+        // moved out first, as enabling a feature may request another upgrade
+        const TArray<FUpgradeRequest> Upgrades = MoveTemp(ApprovedUpgrades);
+        ApprovedUpgrades.Reset();
+        ResolveUpgrades(Upgrades);
+    }
+}
+
 void UKidWorkflow::SetChallengeStatus(const FString& Location)
 {
     ShowTestSetChallengeWidget([this, Location](const FString& Status, const FString& AgeString)
     {
         FString ChallengeId;
         if (LoadChallengeId(ChallengeId)) {
-            TSharedPtr<FJsonObject> JsonObject = MakeShareable(new FJsonObject());
-            JsonObject->SetStringField(TEXT("status"), Status);
-            JsonObject->SetStringField(TEXT("challengeId"), ChallengeId);
-            JsonObject->SetStringField(TEXT("jurisdiction"), Location);
+            FKidSetChallengeStatusRequest Request{ Status, ChallengeId, FStringView(Location) };
             int32 age = 0;
             if (FDefaultValueHelper::ParseInt(AgeString, age))
             {
-                JsonObject->SetNumberField(TEXT("age"), age);
+                Request.Age = age;
             }
 
-            FString ContentJsonString;
-            TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&ContentJsonString);
-            FJsonSerializer::Serialize(JsonObject.ToSharedRef(), Writer);
-
-            HttpRequestHelper::PostRequestWithAuth(BaseUrl + TEXT("/test/set-challenge-status"), ContentJsonString, AuthToken, 
+            HttpRequestHelper::PostRequestWithAuth(GetBaseUrl() + TEXT("/test/set-challenge-status"), KidSerializeRequest(Request), AuthToken, 
                             [](FHttpResponsePtr Response, bool bWasSuccessful)
             {
                 if (bWasSuccessful && Response.IsValid())
@@ -609,36 +1289,12 @@ void UKidWorkflow::SetChallengeStatus(const FString& Location)
 
 int32 UKidWorkflow::CalculateAgeFromDOB(const FString& DateOfBirth)
 {
-    FDateTime DOB;
-    if (FDateTime::Parse(DateOfBirth, DOB))
-    {
-        FDateTime Now = FDateTime::UtcNow();
-        int32 Age = Now.GetYear() - DOB.GetYear();
-        if (Now.GetMonth() < DOB.GetMonth() || (Now.GetMonth() == DOB.GetMonth() && Now.GetDay() < DOB.GetDay()))
-        {
-            Age--;
-        }
-        return Age;
-    }
-    else if (FDateTime::ParseIso8601(*DateOfBirth, DOB)) // Handles YYYY-MM-DD format
-    {
-        FDateTime Now = FDateTime::UtcNow();
-        int32 Age = Now.GetYear() - DOB.GetYear();
-        if (Now.GetMonth() < DOB.GetMonth() || (Now.GetMonth() == DOB.GetMonth() && Now.GetDay() < DOB.GetDay()))
-        {
-            Age--;
-        }
-        return Age;
-    }
-    else
+    KID_TRACE_SCOPE(KidWorkflow_CalculateAgeFromDOB);
+    // handles YYYY-MM-DD, YYYY.MM.DD-HH.MM.SS and a bare YYYY in one pass
+    FKidDate DOB;
+    if (FKidAgeClassifier::ParseDate(DateOfBirth, DOB))
     {
-        // Handle the case where only the year is provided (YYYY)
-        int32 Year;
-        if (LexTryParseString(Year, *DateOfBirth))
-        {
-            FDateTime Now = FDateTime::UtcNow();
-            return Now.GetYear() - Year;
-        }
+        return FKidAgeClassifier::CalculateAge(DOB, FKidDate::Today());
     }
     return 0; // Invalid date format
 }
@@ -648,7 +1304,8 @@ void UKidWorkflow::HandleProhibitedStatus()
     UE_LOG(LogTemp, Warning, TEXT("Player does not meet the minimum age requirement. Play is disabled."));
     DismissFloatingChallengeWidget();
     ShowUnavailableWidget();
-    Mode = AccessMode::None;
+    State.SetMode(AccessMode::None);
+    UpdateHUD();
 }
 
 void UKidWorkflow::HandleNoConsent()
@@ -659,9 +1316,18 @@ void UKidWorkflow::HandleNoConsent()
 
 void UKidWorkflow::DismissFloatingChallengeWidget()
 {
+    if (bUseUiHooks)
+    {
+        if (Ui.DismissChallenge)
+        {
+            Ui.DismissChallenge();
+        }
+        return;
+    }
+
     if (FloatingChallengeWidget && FloatingChallengeWidget->IsInViewport())
     {
-        FloatingChallengeWidget->RemoveFromParent();
+        WidgetPool->Release(FloatingChallengeWidget);
         FloatingChallengeWidget = nullptr;
         DemoControlsWidget->SetTestSetChallengeButtonVisibility(false);
     }
@@ -672,214 +1338,372 @@ void UKidWorkflow::DismissAgeAssuranceWidget()
     if (AgeAssuranceWidget && AgeAssuranceWidget->IsInViewport())
     {
         AgeAssuranceWidget->StopHttpServer();
-        AgeAssuranceWidget->RemoveFromParent();
+        WidgetPool->Release(AgeAssuranceWidget);
         AgeAssuranceWidget = nullptr;
     }
 }
 
-void UKidWorkflow::SaveChallengeId(const FString& InChallengeId)
+void UKidWorkflow::SaveChallenge(const FKidSavedChallenge& InChallenge)
 {
-    FFileHelper::SaveStringToFile(InChallengeId, *(FPaths::ProjectSavedDir() + TEXT("/ChallengeId.txt")));
+    State.SetChallenge(InChallenge);
     UpdateHUD();
 }
 
 void UKidWorkflow::ClearChallengeId()
 {
-    IFileManager::Get().Delete(*(FPaths::ProjectSavedDir() + TEXT("/ChallengeId.txt")));
+    State.ClearChallengeId();
+
+    // a flow still waiting on the cleared challenge is cancelled
+    if (ConsentChannel.IsValid())
+    {
+        ConsentChannel->Cancel();
+    }
+
     DismissFloatingChallengeWidget();
     UpdateHUD();
 }
 
 bool UKidWorkflow::LoadChallengeId(FString& OutChallengeId)
 {
-    return FFileHelper::LoadFileToString(OutChallengeId, *(FPaths::ProjectSavedDir() + TEXT("/ChallengeId.txt")));
+    if (!State.HasChallengeId())
+    {
+        return false;
+    }
+    OutChallengeId = State.GetChallengeId();
+    return true;
 }
 
 bool UKidWorkflow::HasChallengeId()
 {
-    return IFileManager::Get().FileExists(*(FPaths::ProjectSavedDir() + TEXT("/ChallengeId.txt")));
+    return State.HasChallengeId();
 }
 
 void UKidWorkflow::ClearSession()
 {
-    Mode = AccessMode::DataLite;
+    // anything still in flight would otherwise write the old state back
+    CancelFlows();
+
+    State.SetMode(AccessMode::DataLite);
     if (AgeGateWidget && AgeGateWidget->IsInViewport())
     {
         AgeGateWidget->RemoveFromParent();
         AgeGateWidget = nullptr;
     }
 
-    if (FloatingChallengeWidget && FloatingChallengeWidget->IsInViewport())
-    {
-        FloatingChallengeWidget->RemoveFromParent();
-        FloatingChallengeWidget = nullptr;
-    }
+    DismissFloatingChallengeWidget();
 
     if (SettingsWidget && SettingsWidget->IsInViewport())
     {
-        SettingsWidget->RemoveFromParent();
+        WidgetPool->Release(SettingsWidget);
         SettingsWidget = nullptr;
     }
 
-    SessionInfo.Reset();
-    FString SessionFilePath = FPaths::ProjectSavedDir() + TEXT("/SessionInfo.json");
-    if (IFileManager::Get().Delete(*SessionFilePath))
-    {
-        UE_LOG(LogTemp, Log, TEXT("Session file deleted successfully."));
-    }
+    FTSTicker::GetCoreTicker().RemoveTicker(RefreshTickerHandle);
+    RefreshTickerHandle.Reset();
+    RefreshSchedule = FKidRefreshSchedule();
+
+    TSharedPtr<FJsonObject> OldSession = State.GetSession();
+    State.ClearSession();
     UpdateHUD();
+    BroadcastPermissionChanges(OldSession, nullptr);
 }
 
-void UKidWorkflow::SaveSessionInfo()
+void UKidWorkflow::SaveSessionInfo(TSharedPtr<FJsonObject> InSessionInfo)
 {
-    FString SessionString;
-    TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&SessionString);
-    FJsonSerializer::Serialize(SessionInfo.ToSharedRef(), Writer);
-    FFileHelper::SaveStringToFile(SessionString, *(FPaths::ProjectSavedDir() + TEXT("/SessionInfo.json")));
+    KID_TRACE_SCOPE(KidWorkflow_SaveSessionInfo);
+    TSharedPtr<FJsonObject> OldSession = State.GetSession();
+    State.SetSession(InSessionInfo);
     UpdateHUD();
+    BroadcastPermissionChanges(OldSession, InSessionInfo);
+    ScheduleSessionRefresh();
 }
 
-bool UKidWorkflow::GetSavedSessionInfo()
+void UKidWorkflow::ApplySpeculativeSession(const FKidFlowRef& Flow, TSharedPtr<FJsonObject> InSessionInfo, ESpeculativeSource Source)
+{
+    // played with but not saved or refreshed, the server's answer is
+    SpeculativeFlow = Flow;
+    SpeculativeSource = Source;
+    TSharedPtr<FJsonObject> OldSession = State.GetSession();
+    State.SetSpeculativeSession(InSessionInfo, AccessMode::Full);
+    UpdateHUD();
+    BroadcastPermissionChanges(OldSession, InSessionInfo);
+}
+
+void UKidWorkflow::BroadcastPermissionChanges(const TSharedPtr<FJsonObject>& OldSession, const TSharedPtr<FJsonObject>& NewSession)
 {
-    FString SessionInfoString;
-    if (FFileHelper::LoadFileToString(SessionInfoString, *(FPaths::ProjectSavedDir() + TEXT("/SessionInfo.json"))))
+    KID_TRACE_SCOPE(KidWorkflow_BroadcastPermissionChanges);
+    TArray<FKidPermissionChange> Changes = FKidPermissionDiff::Diff(OldSession, NewSession);
+    if (Changes.Num() > 0)
     {
-        TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(SessionInfoString);
-        if (FJsonSerializer::Deserialize(Reader, SessionInfo))
-        {
-            UE_LOG(LogTemp, Log, TEXT("Found saved session."));
-            Mode = AccessMode::Full;
-            UpdateHUD();
-            return true;
-        }
-        else
+        PermissionsChanged.Broadcast(Changes);
+    }
+}
+
+void UKidWorkflow::HandlePermissionsChanged(const TArray<FKidPermissionChange>& Changes)
+{
+    KID_TRACE_SCOPE(KidWorkflow_HandlePermissionsChanged);
+    for (const FKidPermissionChange& Change : Changes)
+    {
+        if (Change.IsEnabledChanged())
         {
-            UE_LOG(LogTemp, Error, TEXT("Failed to deserialize saved session."));     
+            EnableInGame(Change.Name, Change.bEnabled);
         }
     }
-    else
+
+    if (SettingsWidget && SettingsWidget->IsInViewport())
     {
-        UE_LOG(LogTemp, Log, TEXT("No saved session found."));
+        SettingsWidget->ApplyPermissionChanges(Changes);
     }
-    return false;
 }
 
-void UKidWorkflow::UpdateHUD()
+void UKidWorkflow::ScheduleSessionRefresh()
 {
-    if (PlayerHUDWidget)
+    FTSTicker::GetCoreTicker().RemoveTicker(RefreshTickerHandle);
+    RefreshTickerHandle.Reset();
+
+    TSharedPtr<FJsonObject> SessionInfo = State.GetSession();
+    if (bShutdown || !SessionInfo.IsValid() || !SessionInfo->HasField(TEXT("sessionId")))
     {
-        if (!AuthToken.IsEmpty())
-        {
-            FString AgeStatus = SessionInfo.IsValid() ? SessionInfo->GetStringField(TEXT("ageStatus")) : TEXT("N/A");
-            FString SessionId = SessionInfo.IsValid() ? 
-                        SessionInfo->HasField(TEXT("sessionId")) ? SessionInfo->GetStringField(TEXT("sessionId")) : TEXT("Default Permissions")  : TEXT("N/A");
-            FString ChallengeId;
-            FString HUDText = FString::Printf(
-                        TEXT("Session: %s\nChallenge: %s\nAge Status: %s\nAccess Mode: %s"), 
-                        *SessionId, 
-                        LoadChallengeId(ChallengeId) ? *ChallengeId : TEXT("N/A"), 
-                        *AgeStatus,
-                        (Mode == AccessMode::None) ? TEXT("None") : 
-                            (Mode == AccessMode::DataLite) ? TEXT("Data Lite") : TEXT("Full"));
-            PlayerHUDWidget->SetText(HUDText);
-            DemoControlsWidget->SetSettingsButtonVisibility(SessionInfo.IsValid() && SessionInfo->HasField(TEXT("sessionId")));
-        } 
-        else    
+        return;
+    }
+
+    const double Now = FPlatformTime::Seconds();
+    if (!RefreshSchedule.IsStarted())
+    {
+        RefreshSchedule.Start(SessionRefresh, Now);
+    }
+
+    const double Delay = RefreshSchedule.GetNextDelay(SessionRefresh, Now);
+    if (RefreshScheduler)
+    {
+        RefreshScheduler(Delay);
+        return;
+    }
+
+    TWeakObjectPtr<UKidWorkflow> WeakThis(this);
+    RefreshTickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda([WeakThis](float DeltaTime)
+    {
+        if (UKidWorkflow* This = WeakThis.Get())
         {
-            PlayerHUDWidget->SetText(TEXT("AuthToken not initialized. Check log for details."));
+            This->RefreshTickerHandle.Reset();
+            This->RefreshSessionInBackground();
         }
-    }
+        return false;
+    }), Delay);
 }
 
-void UKidWorkflow::ShowAgeGate(TSet<FString> AllowedAgeGateMethods, TFunction<void(const FString&)> Callback)
+void UKidWorkflow::RefreshSessionInBackground()
 {
-    if (GEngine && GEngine->GameViewport)
+    KID_TRACE_SCOPE(KidWorkflow_RefreshSessionInBackground);
+    TSharedPtr<FJsonObject> SessionInfo = State.GetSession();
+    if (bShutdown || !SessionInfo.IsValid() || !SessionInfo->HasField(TEXT("sessionId")))
+    {
+        return;
+    }
+
+    // a flow so that ClearSession() and CleanUp() cancel the request
+    FKidFlowRef Flow = BeginFlow(TEXT("BackgroundRefresh"));
+    Flow->TransitionTo(EKidFlowState::RefreshingSession);
+
+    const FString ETag = SessionInfo->GetStringField(TEXT("etag"));
+    TWeakObjectPtr<UKidWorkflow> WeakThis(this);
+    GetSessionPermissions(SessionInfo->GetStringField(TEXT("sessionId")), ETag, Flow).Next([WeakThis, Flow, ETag](bool bUpdated)
     {
-        if (AllowedAgeGateMethods.Contains(TEXT("age-slider")))
+        UKidWorkflow* This = WeakThis.Get();
+        if (!This || This->bShutdown)
+        {
+            return;
+        }
+
+        if (!Flow->IsFinished())
         {
-            UClass* AgeGateWidgetClass = LoadClass<UUserWidget>(nullptr, TEXT("/Game/kID/Blueprints/BP_SliderAgeGateWidget.BP_SliderAgeGateWidget_C"));  
-            if (AgeGateWidgetClass)
+            TSharedPtr<FJsonObject> Refreshed = This->State.GetSession();
+            const bool bChanged = Refreshed.IsValid() && Refreshed->GetStringField(TEXT("etag")) != ETag;
+            This->RefreshSchedule.OnRefreshed(This->SessionRefresh, 
+                        !bUpdated ? EKidRefreshOutcome::Failed : bChanged ? EKidRefreshOutcome::Changed : EKidRefreshOutcome::Unchanged);
+
+            if (bUpdated)
             {
-                USliderAgeGateWidget* Widget = CreateWidget<USliderAgeGateWidget>(GEngine->GameViewport->GetWorld(), AgeGateWidgetClass);
-                AgeGateWidget = Widget;
-                if (AgeGateWidget)
-                {
-                    Widget->InitializeWidget(Callback);
-                    Widget->AddToViewport();
-                }
+                Flow->Complete();
             }
-        } 
-        else
-        {
-            UClass* AgeGateWidgetClass = LoadClass<UUserWidget>(nullptr, TEXT("/Game/kID/Blueprints/BP_AgeGateWidget.BP_AgeGateWidget_C"));
-            if (AgeGateWidgetClass)
+            else
             {
-                UAgeGateWidget* Widget = CreateWidget<UAgeGateWidget>(GEngine->GameViewport->GetWorld(), AgeGateWidgetClass);
-                AgeGateWidget = Widget;
-                if (AgeGateWidget)
-                {
-                    Widget->InitializeWidget(Callback);
-                    Widget->AddToViewport();
-                }
+                Flow->Fail();
             }
-         }
+        }
+
+        // does nothing once the session has been cleared
+        This->ScheduleSessionRefresh();
+    });
+}
+
+bool UKidWorkflow::GetSavedSessionInfo()
+{
+    if (State.HasSession())
+    {
+        UpdateHUD();
+        return true;
     }
+    return false;
 }
 
-void UKidWorkflow::ShowTestSetChallengeWidget(TFunction<void(const FString&, const FString&)> Callback)
+void UKidWorkflow::UpdateHUD()
 {
-    if (GEngine && GEngine->GameViewport)
+    KID_TRACE_SCOPE(KidWorkflow_UpdateHUD);
+    if (!PlayerHUDWidget && !Ui.UpdateHUD)
+    {
+        return;
+    }
+
+    // the HUD is refreshed after every state change, so it must only read the in-memory state
+    const int32 FileReadsBefore = State.GetFileReadCount();
+
+    HudViewModel.SetAuthorized(!AuthToken.IsEmpty());
+    HudViewModel.SetSession(State.GetSession());
+    HudViewModel.SetChallengeId(State.GetChallengeId());
+    HudViewModel.SetAccessMode(State.GetMode());
+
+    ensureMsgf(State.GetFileReadCount() == FileReadsBefore, TEXT("UpdateHUD read kID state from disk."));
+
+    if (!HudViewModel.IsAnyDirty())
+    {
+        return;
+    }
+
+    if (PlayerHUDWidget)
     {
-        UClass* TestSetChallengeWidgetClass = LoadClass<UUserWidget>(nullptr, TEXT("/Game/kID/Blueprints/BP_TestSetChallengeWidget.BP_TestSetChallengeWidget_C"));
-        if (TestSetChallengeWidgetClass)
+        PlayerHUDWidget->ApplyViewModel(HudViewModel);
+        if (DemoControlsWidget && HudViewModel.IsDirty(FKidHudViewModel::SessionId))
         {
-            UTestSetChallengeWidget* TestSetChallengeWidget = CreateWidget<UTestSetChallengeWidget>(GEngine->GameViewport->GetWorld(), TestSetChallengeWidgetClass);
-            if (TestSetChallengeWidget)
-            {
-                TestSetChallengeWidget->InitializeWidget(Callback);
-                TestSetChallengeWidget->AddToViewport();
-            }
+            DemoControlsWidget->SetSettingsButtonVisibility(HudViewModel.HasSessionId());
         }
     }
+    else
+    {
+        Ui.UpdateHUD(HudViewModel);
+    }
+    HudViewModel.ClearDirty();
 }
 
-void UKidWorkflow::ShowDemoControls()
+void UKidWorkflow::PreloadWidgetClasses(TFunction<void()> OnLoaded)
+{
+    if (bUseUiHooks)
+    {
+        OnLoaded();
+        return;
+    }
+
+    TArray<FSoftObjectPath> WidgetClassPaths;
+    for (const TCHAR* Path : KidWidgets::All)
+    {
+        WidgetClassPaths.Add(FSoftObjectPath(Path));
+    }
+
+    // the handle keeps the classes loaded for the lifetime of the workflow
+    WidgetClassesHandle = UAssetManager::GetStreamableManager().RequestAsyncLoad(WidgetClassPaths, 
+                FStreamableDelegate::CreateLambda([OnLoaded]()
+    {
+        OnLoaded();
+    }));
+
+    if (!WidgetClassesHandle.IsValid())
+    {
+        OnLoaded();
+    }
+}
+
+UClass* UKidWorkflow::LoadWidgetClass(const TCHAR* ClassPath)
+{
+    // resolving only finds the class if it is already in memory, so this only blocks on disk if 
+    // the widget is needed before the startup preload has finished
+    FSoftClassPath SoftClassPath(ClassPath);
+    if (UClass* WidgetClass = SoftClassPath.ResolveClass())
+    {
+        return WidgetClass;
+    }
+    return LoadClass<UUserWidget>(nullptr, ClassPath);
+}
+
+template <typename WidgetType>
+WidgetType* UKidWorkflow::ShowPooledWidget(const TCHAR* ClassPath, TFunctionRef<void(WidgetType*)> InitializeWidget)
+{
+    if (bUseUiHooks || !GEngine || !GEngine->GameViewport)
+    {
+        return nullptr;
+    }
+
+    UClass* WidgetClass = LoadWidgetClass(ClassPath);
+    if (!WidgetClass)
+    {
+        return nullptr;
+    }
+
+    const double StartTime = FPlatformTime::Seconds();
+    bool bReused = false;
+    WidgetType* Widget = Cast<WidgetType>(WidgetPool->Acquire(GEngine->GameViewport->GetWorld(), WidgetClass, bReused));
+    if (Widget)
+    {
+        InitializeWidget(Widget);
+        Widget->AddToViewport();
+        WidgetPool->RecordShow(WidgetClass, bReused, FPlatformTime::Seconds() - StartTime);
+    }
+    return Widget;
+}
+
+void UKidWorkflow::ShowAgeGate(const FKidAgeGateRequirements& Requirements, TFunction<void(const FString&)> Callback)
 {
-    if (GEngine && GEngine->GameViewport)
+    KID_TRACE_SCOPE(KidWorkflow_ShowAgeGate);
+    if (bUseUiHooks)
     {
-        UClass* DemoControlsClass = LoadClass<UUserWidget>(nullptr, TEXT("/Game/kID/Blueprints/BP_DemoControlsWidget.BP_DemoControlsWidget_C"));
-        if (DemoControlsClass)
+        if (Ui.ShowAgeGate)
         {
-            DemoControlsWidget = CreateWidget<UDemoControlsWidget>(GEngine->GameViewport->GetWorld(), DemoControlsClass);
-            if (DemoControlsWidget)
-            {
-                DemoControlsWidget->SetKidWorkflow(this);
-                DemoControlsWidget->SetTestSetChallengeButtonVisibility(false);
-                DemoControlsWidget->AddToViewport();
-            }
+            Ui.ShowAgeGate(Requirements, MoveTemp(Callback));
         }
     }
+    else if (Requirements.ApprovedAgeCollectionMethods.Contains(TEXT("age-slider")))
+    {
+        AgeGateWidget = ShowPooledWidget<USliderAgeGateWidget>(KidWidgets::SliderAgeGate, [&Callback](USliderAgeGateWidget* Widget)
+        {
+            Widget->InitializeWidget(Callback);
+        });
+    } 
+    else
+    {
+        AgeGateWidget = ShowPooledWidget<UAgeGateWidget>(KidWidgets::AgeGate, [&Callback](UAgeGateWidget* Widget)
+        {
+            Widget->InitializeWidget(Callback);
+        });
+    }
+}
+
+void UKidWorkflow::ShowTestSetChallengeWidget(TFunction<void(const FString&, const FString&)> Callback)
+{
+    ShowPooledWidget<UTestSetChallengeWidget>(KidWidgets::TestSetChallenge, [&Callback](UTestSetChallengeWidget* Widget)
+    {
+        Widget->InitializeWidget(Callback);
+    });
+}
+
+void UKidWorkflow::ShowDemoControls()
+{
+    DemoControlsWidget = ShowPooledWidget<UDemoControlsWidget>(KidWidgets::DemoControls, [this](UDemoControlsWidget* Widget)
+    {
+        Widget->SetKidWorkflow(this);
+        Widget->SetTestSetChallengeButtonVisibility(false);
+    });
 }
 
 void UKidWorkflow::ShowPlayerHUD()
 {
-    if (GEngine && GEngine->GameViewport)
+    if (!PlayerHUDWidget)
     {
-        if (!PlayerHUDWidget)
+        // normally already streamed in during startup
+        PlayerHUDWidget = ShowPooledWidget<UPlayerHUDWidget>(KidWidgets::PlayerHUD, [](UPlayerHUDWidget* Widget) {});
+        if (PlayerHUDWidget)
         {
-            // Load the widget blueprint dynamically
-            UClass* HUDWidgetClass = LoadClass<UUserWidget>(nullptr, TEXT("/Game/kID/Blueprints/BP_PlayerHUDWidget.BP_PlayerHUDWidget_C"));
-            if (HUDWidgetClass)
-            {
-                PlayerHUDWidget = Cast<UPlayerHUDWidget>(CreateWidget<UUserWidget>(GEngine->GameViewport->GetWorld(), HUDWidgetClass));
-                if (PlayerHUDWidget)
-                {
-                    // Add the widget to the viewport
-                    PlayerHUDWidget->AddToViewport();
-
-                    UpdateHUD();
-                }
-            }
+            // a new widget shows nothing yet
+            HudViewModel.MarkAllDirty();
+            UpdateHUD();
         }
     }
 }
@@ -887,77 +1711,91 @@ void UKidWorkflow::ShowPlayerHUD()
 void UKidWorkflow::ShowFloatingChallengeWidget(const FString& OTP, const FString& QRCodeUrl, 
                                             TFunction<void(const FString&, TFunction<void(bool)>)> OnEmailSubmitted)
 {
-    if (GEngine && GEngine->GameViewport)
+    KID_TRACE_SCOPE(KidWorkflow_ShowFloatingChallengeWidget);
+    FloatingChallengeWidget = ShowPooledWidget<UFloatingChallengeWidget>(KidWidgets::FloatingChallenge, 
+                [this, &OTP, &QRCodeUrl, &OnEmailSubmitted](UFloatingChallengeWidget* Widget)
+    {
+        Widget->InitializeWidget(this, OTP, QRCodeUrl, OnEmailSubmitted);
+    });
+
+    if (FloatingChallengeWidget && DemoControlsWidget)
+    {
+        DemoControlsWidget->SetTestSetChallengeButtonVisibility(true);
+    }
+}
+
+void UKidWorkflow::ShowFloatingChallengeWidget(const FKidSavedChallenge& Challenge)
+{
+    if (bUseUiHooks)
     {
-        UClass* FloatingChallengeWidgetClass = LoadClass<UUserWidget>(nullptr, TEXT("/Game/kID/Blueprints/BP_FloatingChallengeWidget.BP_FloatingChallengeWidget_C"));
-        if (FloatingChallengeWidgetClass)
+        if (Ui.ShowChallenge)
         {
-            FloatingChallengeWidget = CreateWidget<UFloatingChallengeWidget>(GEngine->GameViewport->GetWorld(), FloatingChallengeWidgetClass);
-            if (FloatingChallengeWidget)
-            {
-                FloatingChallengeWidget->InitializeWidget(this, OTP, QRCodeUrl, OnEmailSubmitted);
-                FloatingChallengeWidget->AddToViewport();
-                DemoControlsWidget->SetTestSetChallengeButtonVisibility(true);
-            }
+            Ui.ShowChallenge(Challenge);
         }
+        return;
     }
+
+    const FString ChallengeId = Challenge.ChallengeId;
+    ShowFloatingChallengeWidget(Challenge.OneTimePassword, Challenge.Url, [this, ChallengeId](const FString& Email, TFunction<void(bool)> OnOperationComplete)
+    {
+        FKidSendEmailRequest Request{ Email, ChallengeId };
+
+        HttpRequestHelper::PostRequestWithAuth(GetBaseUrl() + TEXT("/challenge/send-email"), KidSerializeRequest(Request), AuthToken, [OnOperationComplete](FHttpResponsePtr Response, bool bWasSuccessful)
+        {
+            OnOperationComplete(bWasSuccessful && Response.IsValid());
+        });
+    });
 }
 
 void UKidWorkflow::ShowAgeAssuranceWidget(int32 Age, TFunction<void(bool, int32, int32)> OnAssuranceResponse)
 {
-    if (GEngine && GEngine->GameViewport)
+    if (bUseUiHooks)
     {
-        UClass* AgeAssuranceWidgetClass = LoadClass<UUserWidget>(nullptr, TEXT("/Game/kID/Blueprints/BP_AgeAssuranceWidget.BP_AgeAssuranceWidget_C"));
-        if (AgeAssuranceWidgetClass)
+        if (Ui.ShowAgeAssurance)
         {
-            AgeAssuranceWidget = CreateWidget<UAgeAssuranceWidget>(GEngine->GameViewport->GetWorld(), AgeAssuranceWidgetClass);
-            if (AgeAssuranceWidget)
-            {
-                AgeAssuranceWidget->InitializeWidget(Age, OnAssuranceResponse);
-                AgeAssuranceWidget->AddToViewport();
-            }
+            Ui.ShowAgeAssurance(Age, MoveTemp(OnAssuranceResponse));
         }
+        return;
     }
+
+    AgeAssuranceWidget = ShowPooledWidget<UAgeAssuranceWidget>(KidWidgets::AgeAssurance, [Age, &OnAssuranceResponse](UAgeAssuranceWidget* Widget)
+    {
+        Widget->InitializeWidget(Age, OnAssuranceResponse);
+    });
 }
 
 void UKidWorkflow::ShowSettingsWidget()
 {
-    if (GEngine && GEngine->GameViewport)
+    KID_TRACE_SCOPE(KidWorkflow_ShowSettingsWidget);
+    SettingsWidget = ShowPooledWidget<USettingsWidget>(KidWidgets::Settings, [this](USettingsWidget* Widget)
     {
-        UClass* SettingsWidgetClass = LoadClass<UUserWidget>(nullptr, TEXT("/Game/kID/Blueprints/BP_SettingsWidget.BP_SettingsWidget_C"));
-        if (SettingsWidgetClass)
+        Widget->InitializeWidget(State.GetSession(), [this](const FString& FeatureName, bool bEnabled)
         {
-            SettingsWidget = CreateWidget<USettingsWidget>(GEngine->GameViewport->GetWorld(), SettingsWidgetClass);
-            if (SettingsWidget)
+            TSharedPtr<FJsonObject> SessionInfo = State.GetSession();
+            if (SessionInfo.IsValid() && SessionInfo->HasField(TEXT("sessionId")) )
             {
-                SettingsWidget->InitializeWidget(SessionInfo, [this](const FString& FeatureName, bool bEnabled)
+                if (bEnabled)
                 {
-                    if (SessionInfo.IsValid() && SessionInfo->HasField(TEXT("sessionId")) )
-                    {
-                        if (bEnabled)
-                        {
-                            // turn the checkbox back off until the feature is actually enabled
-                            SettingsWidget->SyncCheckboxes(SessionInfo);
-                            AttemptTurnOnRestrictedFeature(FeatureName, [this, FeatureName]()
-                            {
-                                // use the new session to sync the the checkbox state which will now
-                                // have the feature turned on
-                                SettingsWidget->SyncCheckboxes(SessionInfo);
-                                EnableInGame(FeatureName, true);
-                            });
-                        }
-                        else
-                        {
-                            // make a local change only for this current game play session
-                            FindPermission(FeatureName)->SetBoolField(TEXT("enabled"), false);
-                            EnableInGame(FeatureName, false);
-                        }
-                    }
-                });
-                SettingsWidget->AddToViewport();
+                    // turn the checkbox back off until the feature is actually enabled
+                    SettingsWidget->SyncCheckboxes(SessionInfo);
+                    // the upgraded session turns the checkbox on and enables the feature 
+                    // through the permissions changed event
+                    AttemptTurnOnRestrictedFeature(FeatureName, []() {});
+                }
+                else if (TSharedPtr<FJsonObject> PermissionObject = FindPermission(FeatureName))
+                {
+                    // make a local change only for this current game play session
+                    PermissionObject->SetBoolField(TEXT("enabled"), false);
+
+                    FKidPermissionChange Change;
+                    Change.Name = FeatureName;
+                    Change.bWasEnabled = true;
+                    Change.PreviousManagedBy = Change.ManagedBy = PermissionObject->GetStringField(TEXT("managedBy"));
+                    PermissionsChanged.Broadcast({ Change });
+                }
             }
-        }
-    }
+        });
+    });
 }
 
 void UKidWorkflow::EnableInGame(const FString &FeatureName, bool bEnabled)
@@ -993,29 +1831,31 @@ void UKidWorkflow::EnableInGame(const FString &FeatureName, bool bEnabled)
 
 void UKidWorkflow::ShowUnavailableWidget()
 {
-    if (GEngine && GEngine->GameViewport)
+    if (bUseUiHooks)
     {
-        UClass* UnavailableWidgetClass = LoadClass<UUserWidget>(nullptr, TEXT("/Game/kID/Blueprints/BP_UnavailableWidget.BP_UnavailableWidget_C"));
-        if (UnavailableWidgetClass)
+        if (Ui.ShowUnavailable)
         {
-            UUnavailableWidget* UnavailableWidget = CreateWidget<UUnavailableWidget>(GEngine->GameViewport->GetWorld(), UnavailableWidgetClass);
-            if (UnavailableWidget)
-            {
-                UnavailableWidget->AddToViewport();
-            }
+            Ui.ShowUnavailable();
         }
+        return;
     }
+
+    ShowPooledWidget<UUnavailableWidget>(KidWidgets::Unavailable, [](UUnavailableWidget* Widget) {});
 }
 
-TSharedPtr<FJsonObject> UKidWorkflow::FindPermission(const FString& FeatureName)
+TSharedPtr<FJsonObject> UKidWorkflow::FindPermission(const FString& FeatureName) const
 {
-    TArray<TSharedPtr<FJsonValue>> Permissions = SessionInfo->GetArrayField(TEXT("permissions"));
-    for (auto& Permission : Permissions)
+    TSharedPtr<FJsonObject> SessionInfo = State.GetSession();
+    const TArray<TSharedPtr<FJsonValue>>* Permissions = nullptr;
+    if (SessionInfo.IsValid() && SessionInfo->TryGetArrayField(TEXT("permissions"), Permissions))
     {
-        TSharedPtr<FJsonObject> PermissionObject = Permission->AsObject();
-        if (PermissionObject->GetStringField(TEXT("name")) == FeatureName)
+        for (const TSharedPtr<FJsonValue>& Permission : *Permissions)
         {
-            return PermissionObject;
+            TSharedPtr<FJsonObject> PermissionObject = Permission->AsObject();
+            if (PermissionObject.IsValid() && PermissionObject->GetStringField(TEXT("name")) == FeatureName)
+            {
+                return PermissionObject;
+            }
         }
     }
     return nullptr;
@@ -1027,8 +1867,34 @@ void UKidWorkflow::CleanUp()
 
     DismissAgeAssuranceWidget();
     bShutdown = true;
-    if (ConsentPollingTimerHandle.IsValid())
+    CancelFlows();
+
+    FTSTicker::GetCoreTicker().RemoveTicker(RefreshTickerHandle);
+    RefreshTickerHandle.Reset();
+    if (RefreshSchedule.IsStarted())
+    {
+        UE_LOG(LogTemp, Log, TEXT("kID background session refreshes: %d, %.1f per hour."), 
+                    RefreshSchedule.GetNumRefreshes(), RefreshSchedule.GetRefreshesPerHour(FPlatformTime::Seconds()));
+    }
+
+    if (WidgetPool)
+    {
+        WidgetPool->LogStats();
+        WidgetPool->Empty();
+    }
+
+    if (PolicyStats.Applied + PolicyStats.Confirmed + PolicyStats.Contradicted > 0)
+    {
+        UE_LOG(LogTemp, Log, TEXT("kID cached policy, revision %u: %d predictions applied, %d confirmed, %d contradicted, %d retracted."),
+                    PolicyCache->GetRevision(), PolicyStats.Applied, PolicyStats.Confirmed, PolicyStats.Contradicted, PolicyStats.Retracted);
+    }
+
+    if (PrefetchStats.Issued > 0)
     {
-        GetWorld()->GetTimerManager().ClearTimer(ConsentPollingTimerHandle);
+        const int32 AdultSubmissions = PrefetchStats.Hits + PrefetchStats.NotReady;
+        UE_LOG(LogTemp, Log, TEXT("kID default permissions prefetch: %d issued, %d hits (%.0f%% of adult submissions), %d not ready, ")
+                    TEXT("%d failed, %d not adult, %d retracted."), PrefetchStats.Issued, PrefetchStats.Hits, 
+                    AdultSubmissions > 0 ? 100.0 * PrefetchStats.Hits / AdultSubmissions : 0.0, PrefetchStats.NotReady, 
+                    PrefetchStats.Failed, PrefetchStats.NotAdult, PrefetchStats.Retracted);
     }
 }
\ No newline at end of file
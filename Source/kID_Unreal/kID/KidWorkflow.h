@@ -2,6 +2,19 @@
 
 #include "CoreMinimal.h"
 #include "UObject/NoExportTypes.h"
+#include "Containers/Ticker.h"
+#include "KidStateStore.h"
+#include "KidFlow.h"
+#include "KidRequirementsCache.h"
+#include "KidPolicyCache.h"
+#include "KidConsentAwaiter.h"
+#include "KidConsentAwaiterService.h"
+#include "KidPushConsentChannel.h"
+#include "KidRefreshSchedule.h"
+#include "KidPermissionDiff.h"
+#include "KidEndpointSelector.h"
+#include "KidWidgetPool.h"
+#include "KidHudViewModel.h"
 #include "Widgets/PlayerHUDWidget.h"
 #include "Widgets/FloatingChallengeWidget.h"
 #include "Widgets/UnavailableWidget.h"
@@ -10,32 +23,98 @@
 #include "Widgets/SettingsWidget.h"
 #include "KidWorkflow.generated.h"
 
-UCLASS()
+struct FStreamableHandle;
+
+// Hooks that stand in for the kID widgets, e.g. to run the workflow headless in the load
+// generator and benchmarks.  A hook that is left unset does nothing, except that a flow that
+// needs the age gate or age assurance without a hook for it fails.
+struct FKidWorkflowUi
+{
+    // The age gate has to be shown.  Call Submit with the date of birth the player entered.
+    TFunction<void(const FKidAgeGateRequirements& Requirements, TFunction<void(const FString& DOB)> Submit)> ShowAgeGate;
+
+    // The player's age has to be assured.  Call OnResponse as the age assurance widget does.
+    TFunction<void(int32 Age, TFunction<void(bool bSuccessful, int32 MinAge, int32 MaxAge)> OnResponse)> ShowAgeAssurance;
+
+    // A consent challenge has to be shown to the player's parent or guardian, or can be dismissed.
+    TFunction<void(const FKidSavedChallenge& Challenge)> ShowChallenge;
+    TFunction<void()> DismissChallenge;
+
+    // The player does not meet the minimum age.
+    TFunction<void()> ShowUnavailable;
+
+    // Given the HUD view model whenever any of its fields changed.
+    TFunction<void(const FKidHudViewModel& ViewModel)> UpdateHUD;
+};
+
+UCLASS(Config=Game)
 class UKidWorkflow : public UObject
 {
     GENERATED_BODY()
 
 public:
-    enum class AccessMode {
-        None, // player has no access (under the minimum age)
-        DataLite, // player has access to data-lite features
-        Full // full access to all features
-    };
+    using AccessMode = EKidAccessMode;
 
-    void Initialize(TFunction<void(bool)> Callback);
+    // Returns the startup flow, whose stages time each phase of startup.
+    FKidFlowPtr Initialize(TFunction<void(bool)> Callback);
     void CleanUp();
 
-    // workflows
-    void StartKidSession(const FString& Location);
-    void HandleExistingChallenge(const FString& ChallengeId);
-    void StartKidSessionWithDOB(const FString& Location, const FString& DOB);
-    void GetUserAge(const FString& Location, TFunction<void(bool, bool, const FString&)> Callback);
+    // Starts the workflow of a further local player, e.g. split-screen, on the endpoint, token and
+    // caches of a primary workflow that has been initialized, so only this player's saved state is
+    // loaded.  Set the state directory first.  Returns the startup flow.
+    FKidFlowPtr InitializeFrom(const UKidWorkflow& Primary, TFunction<void(bool)> Callback);
+
+    // Awaits consent through a service shared with other workflows, under its request budget,
+    // instead of a channel of its own.
+    void SetConsentAwaiter(const TSharedPtr<FKidConsentAwaiterService, ESPMode::ThreadSafe>& InConsentAwaiter) { SharedConsentAwaiter = InConsentAwaiter; }
+
+    // Hands the delay until each background session refresh to the caller, which then calls
+    // RefreshSessionInBackground, instead of adding a ticker per workflow.
+    void SetRefreshScheduler(TFunction<void(double DelaySeconds)> InRefreshScheduler) { RefreshScheduler = MoveTemp(InRefreshScheduler); }
+
+    // Replaces the widgets with hooks.  No widget class is loaded or shown once they are set.
+    // Set before Initialize.
+    void SetUi(const FKidWorkflowUi& InUi);
+
+    // Overrides for running outside the demo, set before Initialize: the regional endpoints to
+    // probe instead of the configured ones, the API key instead of apikey.txt, and the directory
+    // the state and caches are saved in instead of Saved.
+    void SetEndpoints(const TArray<FString>& InEndpoints) { Endpoints = InEndpoints; }
+    void SetApiKey(const FString& InApiKey) { ApiKey = InApiKey; }
+    void SetStateDirectory(const FString& InDirectory) { State.SetDirectory(InDirectory); }
+
+    const FKidStateStore& GetState() const { return State; }
+
+    // workflows.  Each one runs as an FKidFlow state machine and returns the flow as a handle 
+    // that can be used to cancel it.
+    FKidFlowPtr StartKidSession(const FString& Location);
+    void CancelFlows();
+
+    // shared with the workflows of further local players
+    FString GetBaseUrl() const;
+    const FString& GetAuthToken() const { return AuthToken; }
+    TSharedRef<FKidRequirementsCache, ESPMode::ThreadSafe> GetRequirementsCache() const { return RequirementsCache; }
+
+    // flow steps
+    void HandleExistingChallenge(const FKidFlowRef& Flow, const FKidSavedChallenge& Challenge);
+    void RevalidateChallenge(const FKidFlowRef& Flow, const FKidSavedChallenge& Challenge);
+    void StartKidSessionWithDOB(const FKidFlowRef& Flow, const FString& Location, const FString& DOB);
+    void GetUserAge(const FKidFlowRef& Flow, const FString& Location);
+    void OnAgeGateSubmitted(const FKidFlowRef& Flow, const FString& Location, const FString& DOB, bool bAgeAssuranceRequired);
     void ValidateAge(int32 Age, TFunction<void(bool, int32, int32)> Callback);
-    void GetDefaultPermissions(const FString& Location);
-    void ShowConsentChallenge(const FString& ChallengeId, int32 Timeout, const FString& OTP, const FString& QRCodeUrl, 
+    void GetDefaultPermissions(const FKidFlowRef& Flow, const FString& Location);
+    TFuture<TSharedPtr<FJsonObject>> FetchDefaultPermissions(const FString& Location, const FKidFlowPtr& Flow);
+    void PrefetchDefaultPermissions(const FKidFlowRef& Flow, const FString& Location);
+    void OnAgeGateSubmittedForPrefetch(const FKidFlowRef& Flow, const FString& Location, bool bAdult);
+    void RetractSpeculativeSession();
+    bool ApplyPredictedSession(const FKidFlowRef& Flow, const FString& Location, const FString& DOB);
+    void ConfirmPredictedCheck(const FString& Location, const FString& DOB, KidCore::ECheckStatus Status, const TSharedPtr<FJsonObject>& Session);
+    void ShowConsentChallenge(const FKidFlowRef& Flow, const FKidSavedChallenge& Challenge, 
                             TFunction<void(bool, const FString&)> OnConsentGranted);
-    void GetSessionPermissions(const FString& SessionId, const FString& ETag);
-    void CheckForConsent(const FString& ChallengeId, FDateTime StartTime, int32 Timeout, 
+    void OnConsentResult(const FKidFlowRef& Flow, bool bConsentGranted, const FString& SessionId);
+    void RefreshSession(const FKidFlowRef& Flow, const FString& SessionId, const FString& ETag);
+    TFuture<bool> GetSessionPermissions(const FString& SessionId, const FString& ETag, const FKidFlowPtr& Flow = nullptr);
+    void CheckForConsent(const FKidFlowRef& Flow, const FString& ChallengeId, FDateTime StartTime, int32 Timeout, 
                             TFunction<void(bool, const FString&)> OnConsentGranted);
                             
     void HandleProhibitedStatus();
@@ -48,23 +127,43 @@ public:
 
     // feature management - roadmap
     void AttemptTurnOnRestrictedFeature(const FString& FeatureName, TFunction<void()> EnableFeature);
-    void UpgradeSession(const FString &FeatureName, TFunction<void()> EnableFeature);
+
+    // Upgrades requested within UpgradeBatchWindowSeconds of the first are sent as one 
+    // /session/upgrade, so they share one consent challenge and one flow, which is returned.
+    FKidFlowPtr UpgradeSession(const FString &FeatureName, TFunction<void()> EnableFeature);
 
     // managing sessions in local storage
-    void SaveSessionInfo();
+    void SaveSessionInfo(TSharedPtr<FJsonObject> InSessionInfo);
     bool GetSavedSessionInfo();
+
+    enum class ESpeculativeSource : uint8
+    {
+        Prefetch,   // the prefetched adult defaults
+        Policy,     // predicted from the cached policy bundle
+    };
+
+    // Plays with a session the server has yet to confirm, in memory only, until SaveSessionInfo
+    // saves the server's answer or RetractSpeculativeSession drops it.  Cancelling the flow that
+    // is waiting on the answer drops it too.
+    void ApplySpeculativeSession(const FKidFlowRef& Flow, TSharedPtr<FJsonObject> InSessionInfo, ESpeculativeSource Source);
     void ClearSession();
-    TSharedPtr<FJsonObject> FindPermission(const FString& FeatureName);
+    TSharedPtr<FJsonObject> FindPermission(const FString& FeatureName) const;
+
+    // Refreshes the saved session in the background, with its ETag, on the FKidRefreshSchedule.
+    void ScheduleSessionRefresh();
+    void RefreshSessionInBackground();
 
     // managing saved challenge id in local storage
     bool HasChallengeId();
-    void SaveChallengeId(const FString& InChallengeId);
+    void SaveChallenge(const FKidSavedChallenge& InChallenge);
     void ClearChallengeId();
     bool LoadChallengeId(FString& OutChallengeId);
 
      // UI Elements
+    void PreloadWidgetClasses(TFunction<void()> OnLoaded);
+    UClass* LoadWidgetClass(const TCHAR* ClassPath);
     void ShowUnavailableWidget();
-    void ShowAgeGate(TSet<FString> allowedAgeGateMethods, TFunction<void(const FString&)> Callback);
+    void ShowAgeGate(const FKidAgeGateRequirements& Requirements, TFunction<void(const FString&)> Callback);
     void ShowTestSetChallengeWidget(TFunction<void(const FString&, const FString&)> Callback);
     void ShowSettingsWidget();
 
@@ -72,6 +171,7 @@ public:
     void DismissAgeAssuranceWidget();
 
     void ShowFloatingChallengeWidget(const FString& OTP, const FString& QRCodeUrl, TFunction<void(const FString&, TFunction<void(bool)>)> OnEmailSubmitted);
+    void ShowFloatingChallengeWidget(const FKidSavedChallenge& Challenge);
     void DismissFloatingChallengeWidget();
 
     void ShowDemoControls();
@@ -80,20 +180,190 @@ public:
 
     // Connection to enablement of features in the rest of the game.
     void EnableInGame(const FString &FeatureName, bool bEnabled);
+
+    // Broadcast with the permissions that actually changed whenever the session is replaced,
+    // cleared or loaded at startup.  Gameplay code subscribes here instead of re-reading the session.
+    FOnKidPermissionsChanged& OnPermissionsChanged() { return PermissionsChanged; }
+
+    // what became of each prefetch, logged on CleanUp
+    struct FPrefetchStats
+    {
+        int32 Issued = 0;
+        int32 Hits = 0;
+        int32 NotReady = 0;     // an adult submitted before the defaults arrived
+        int32 Failed = 0;
+        int32 NotAdult = 0;     // the player needed a challenge or age assurance, so the defaults could not be used
+        int32 Retracted = 0;    // applied, but withdrawn because the server did not confirm them
+    };
+
+    // how the cached policy's predictions fared, logged on CleanUp
+    struct FPolicyStats
+    {
+        int32 Applied = 0;      // played with predicted defaults before the server answered
+        int32 Confirmed = 0;
+        int32 Contradicted = 0; // the server answered differently
+        int32 Retracted = 0;    // applied, but withdrawn because the server did not confirm them
+    };
+
+    const FPrefetchStats& GetPrefetchStats() const { return PrefetchStats; }
+    const FPolicyStats& GetPolicyStats() const { return PolicyStats; }
      
 private:
-    static bool bShutdown;
+    // set by CleanUp so that nothing still in flight, such as a long poll after quitting Play In
+    // Editor, carries on
+    bool bShutdown = false;
+
+    FKidWorkflowUi Ui;
+    bool bUseUiHooks = false;
+    FString ApiKey;
+
+    void BroadcastPermissionChanges(const TSharedPtr<FJsonObject>& OldSession, const TSharedPtr<FJsonObject>& NewSession);
+    void HandlePermissionsChanged(const TArray<FKidPermissionChange>& Changes);
+
+    FOnKidPermissionsChanged PermissionsChanged;
+
+    // Runs Step once Future is ready, unless the flow has finished or been cancelled in the
+    // meantime or this workflow has been destroyed.
+    template <typename ResultType, typename StepType>
+    void ContinueFlow(TFuture<ResultType>&& Future, const FKidFlowRef& Flow, StepType&& Step);
+
+    FKidFlowRef BeginFlow(const FString& Name);
+
+    // flows that have been started and not yet finished
+    TArray<FKidFlowRef> ActiveFlows;
 
-    FTimerHandle ConsentPollingTimerHandle;
-    TSharedPtr<FJsonObject> SessionInfo;
+    // Jurisdictions whose age gate requirements are prefetched at startup, typically the 
+    // game's top markets.  The last jurisdiction a session was started in is always prefetched.
+    UPROPERTY(Config)
+    TArray<FString> PrefetchJurisdictions;
+
+    // cached age gate requirements are revalidated in the background once older than this...
+    UPROPERTY(Config)
+    float RequirementsTimeToLiveSeconds = 24.0f * 60.0f * 60.0f;
+
+    // ...and fetched again before being used once older than this
+    UPROPERTY(Config)
+    float RequirementsMaxStaleSeconds = 30.0f * 24.0f * 60.0f * 60.0f;
+
+    // longest time the server is asked to hold a /challenge/await open
+    UPROPERTY(Config)
+    int32 MaxChallengeAwaitSeconds = 30;
+
+    // waiting for consent backs off exponentially between these bounds after errors
+    UPROPERTY(Config)
+    float ConsentRetryInitialBackoffSeconds = 1.0f;
+
+    UPROPERTY(Config)
+    float ConsentRetryMaxBackoffSeconds = 30.0f;
+
+    // WebSocket endpoint that pushes challenge status changes.  Consent is long polled when empty.
+    UPROPERTY(Config)
+    FString ConsentPushUrl;
+
+    // how often the session is refreshed in the background
+    UPROPERTY(Config)
+    FKidRefreshSettings SessionRefresh;
+
+    FKidRefreshSchedule RefreshSchedule;
+    FTSTicker::FDelegateHandle RefreshTickerHandle;
+    TFunction<void(double)> RefreshScheduler;
+
+    // Shows an instance of the widget class from the pool, after InitializeWidget has reset it.
+    template <typename WidgetType>
+    WidgetType* ShowPooledWidget(const TCHAR* ClassPath, TFunctionRef<void(WidgetType*)> InitializeWidget);
+
+    // seconds that session upgrades are collected for before being sent together
+    UPROPERTY(Config)
+    float UpgradeBatchWindowSeconds = 0.5f;
+
+    // regional API base URLs.  They are probed concurrently at startup, the fastest healthy one is
+    // used, and the next fastest takes over after repeated failures.
+    UPROPERTY(Config)
+    TArray<FString> Endpoints;
+
+    // appended to each endpoint to probe it
+    UPROPERTY(Config)
+    FString EndpointProbePath;
+
+    UPROPERTY(Config)
+    float EndpointProbeTimeoutSeconds = 5.0f;
+
+    UPROPERTY(Config)
+    int32 EndpointFailuresBeforeSwitch = 3;
+
+    TSharedPtr<FKidEndpointSelector, ESPMode::ThreadSafe> EndpointSelector;
+
+    // Fetch /age-gate/get-default-permissions while the age gate is up, which also warms the
+    // connection for /age-gate/check.  When an adult submits, the defaults are applied straight
+    // away, in memory only, and replaced by the session /age-gate/check returns, which is saved.
+    UPROPERTY(Config)
+    bool bPrefetchDefaultPermissions = true;
+
+    struct FDefaultPermissionsPrefetch
+    {
+        FString Jurisdiction;
+        TSharedPtr<FJsonObject> Session;
+        bool bInFlight = false;
+    };
+    FDefaultPermissionsPrefetch DefaultPermissionsPrefetch;
+
+    // the flow waiting on the answer that confirms the speculative session in the state store
+    TWeakPtr<FKidFlow, ESPMode::ThreadSafe> SpeculativeFlow;
+    ESpeculativeSource SpeculativeSource = ESpeculativeSource::Prefetch;
+
+    FPrefetchStats PrefetchStats;
+
+    // Predict the outcome of the age gate from the cached policy of the jurisdiction.  Players who
+    // pass play with their band's defaults straight away, as do players in jurisdictions without an
+    // age gate.  The defaults stay in memory, and the server's answer replaces them and is saved
+    // when it arrives.
+    UPROPERTY(Config)
+    bool bPredictFromCachedPolicy = true;
+
+    FPolicyStats PolicyStats;
+
+    struct FUpgradeRequest
+    {
+        FString FeatureName;
+        TFunction<void()> EnableFeature;
+    };
+
+    void SendUpgradeBatch();
+    void ResolveUpgrades(const TArray<FUpgradeRequest>& Upgrades);
+    void ResolveApprovedUpgrades();
+
+    // upgrades waiting for the batch window to close, and the flow they will be sent in
+    TArray<FUpgradeRequest> PendingUpgrades;
+    FKidFlowPtr PendingUpgradeFlow;
+    FTSTicker::FDelegateHandle UpgradeBatchHandle;
+
+    // upgrades a parent approved whose upgraded session could not be fetched, resolved by the
+    // next session fetch that succeeds
+    TArray<FUpgradeRequest> ApprovedUpgrades;
+
+    TSharedRef<FKidRequirementsCache, ESPMode::ThreadSafe> RequirementsCache = MakeShared<FKidRequirementsCache, ESPMode::ThreadSafe>();
+    TSharedRef<FKidPolicyCache, ESPMode::ThreadSafe> PolicyCache = MakeShared<FKidPolicyCache, ESPMode::ThreadSafe>();
+    TSharedPtr<FStreamableHandle> WidgetClassesHandle;
+
+    TSharedPtr<IKidConsentChannel> ConsentChannel;
+    TSharedPtr<FKidConsentAwaiterService, ESPMode::ThreadSafe> SharedConsentAwaiter;
     FString AuthToken;
 
-    // Mode declares what access the player has in the game based on age and consent. 
+    // Holds the challenge ID, session and access mode in memory, loaded once from the Saved
+    // directory and written through on every change.
+    //
+    // The mode declares what access the player has in the game based on age and consent. 
     // For None status, the player should be disallowed. 
     // For DataLite status, the player should be allowed to use "data-lite features" only.
     // For Full status, the player should be allowed to use all features that don't require 
     // further permission based on their age and jurisdiction.
-    AccessMode Mode = AccessMode::DataLite;
+    FKidStateStore State;
+
+    // what the HUD last showed, so UpdateHUD only pushes what changed
+    FKidHudViewModel HudViewModel;
+
+    UPROPERTY()
+    UKidWidgetPool* WidgetPool;
 
     UPROPERTY()
     UAgeAssuranceWidget* AgeAssuranceWidget;
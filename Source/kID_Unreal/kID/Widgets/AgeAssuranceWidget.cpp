@@ -11,15 +11,18 @@ void UAgeAssuranceWidget::InitializeWidget(int32 InAge, TFunction<void(bool, int
     Age = InAge;
     if (VerificationText)
     {
-        FText VerificationTextContent = VerificationText->GetText();
-        FString VerificationString = VerificationTextContent.ToString();
+        if (VerificationTemplate.IsEmpty())
+        {
+            VerificationTemplate = VerificationText->GetText();
+        }
+        FString VerificationString = VerificationTemplate.ToString();
         VerificationString = VerificationString.Replace(TEXT("X"), *FString::FromInt(Age));
         VerificationText->SetText(FText::FromString(VerificationString));
     }
 
-    YesButton->OnClicked.AddDynamic(this, &UAgeAssuranceWidget::OnYesClicked);   
-    NoButton->OnClicked.AddDynamic(this, &UAgeAssuranceWidget::OnNoClicked);
-    CancelButton->OnClicked.AddDynamic(this, &UAgeAssuranceWidget::OnNoClicked);
+    YesButton->OnClicked.AddUniqueDynamic(this, &UAgeAssuranceWidget::OnYesClicked);   
+    NoButton->OnClicked.AddUniqueDynamic(this, &UAgeAssuranceWidget::OnNoClicked);
+    CancelButton->OnClicked.AddUniqueDynamic(this, &UAgeAssuranceWidget::OnNoClicked);
 
     Callback = InCallback;
 
@@ -37,6 +37,9 @@ private:
     TFunction<void(bool, int32, int32)> Callback;
     int32 Age;
 
+    // the blueprint's text, with X standing for the age.  Kept so a pooled widget can fill it in again.
+    FText VerificationTemplate;
+
     UPROPERTY()
     class UFPrivatelyHttpServer* HttpServer;
     void StartHttpServer();
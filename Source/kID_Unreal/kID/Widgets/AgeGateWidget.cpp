@@ -6,13 +6,16 @@ void UAgeGateWidget::NativeConstruct()
 {
     Super::NativeConstruct();
 
-    SubmitButton->OnClicked.AddDynamic(this, &UAgeGateWidget::OnSubmitClicked);
-    CancelButton->OnClicked.AddDynamic(this, &UAgeGateWidget::RemoveFromParent);
+    SubmitButton->OnClicked.AddUniqueDynamic(this, &UAgeGateWidget::OnSubmitClicked);
+    CancelButton->OnClicked.AddUniqueDynamic(this, &UAgeGateWidget::RemoveFromParent);
 }
 
 void UAgeGateWidget::InitializeWidget(TFunction<void(const FString&)> InCallback)
 {
     Callback = InCallback;
+
+    // the widget is pooled, so clear what the previous player entered
+    DOBTextBox->SetText(FText::GetEmpty());
 }
 
 void UAgeGateWidget::OnSubmitClicked()
@@ -7,10 +7,10 @@ void UDemoControlsWidget::NativeConstruct()
 {
     Super::NativeConstruct();
 
-    SubmitButton->OnClicked.AddDynamic(this, &UDemoControlsWidget::OnSubmitClicked);
-    ClearSessionButton->OnClicked.AddDynamic(this, &UDemoControlsWidget::OnClearSessionClicked);
-    TestSetChallengeButton->OnClicked.AddDynamic(this, &UDemoControlsWidget::OnTestSetChallengeClicked);
-    SettingsButton->OnClicked.AddDynamic(this, &UDemoControlsWidget::OnSettingsClicked);
+    SubmitButton->OnClicked.AddUniqueDynamic(this, &UDemoControlsWidget::OnSubmitClicked);
+    ClearSessionButton->OnClicked.AddUniqueDynamic(this, &UDemoControlsWidget::OnClearSessionClicked);
+    TestSetChallengeButton->OnClicked.AddUniqueDynamic(this, &UDemoControlsWidget::OnTestSetChallengeClicked);
+    SettingsButton->OnClicked.AddUniqueDynamic(this, &UDemoControlsWidget::OnSettingsClicked);
 }
 
 void UDemoControlsWidget::OnSubmitClicked()
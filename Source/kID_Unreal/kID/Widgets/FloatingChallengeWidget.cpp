@@ -15,7 +15,13 @@ void UFloatingChallengeWidget::InitializeWidget(UKidWorkflow* InMyKidWorkflow,
 
     KidWorkflow = InMyKidWorkflow;
 
+    // the widget is pooled, so clear what was shown for the previous challenge
     EmailSent->SetVisibility(ESlateVisibility::Hidden);
+    EmailTextBox->SetText(FText::GetEmpty());
+    if (UWorld* World = GetWorld())
+    {
+        World->GetTimerManager().ClearTimer(TimerHandle);
+    }
 
     // Set the OTP text
     OTPTextBlock->SetText(FText::FromString(OTP));
@@ -28,8 +34,8 @@ void UFloatingChallengeWidget::InitializeWidget(UKidWorkflow* InMyKidWorkflow,
         QRCodeImage->SetBrushFromTexture(QRCodeTexture);
     }
 
-    SubmitButton->OnClicked.AddDynamic(this, &UFloatingChallengeWidget::HandleEmailSubmitted);
-    CancelButton->OnClicked.AddDynamic(this, &UFloatingChallengeWidget::OnCancelClicked);
+    SubmitButton->OnClicked.AddUniqueDynamic(this, &UFloatingChallengeWidget::HandleEmailSubmitted);
+    CancelButton->OnClicked.AddUniqueDynamic(this, &UFloatingChallengeWidget::OnCancelClicked);
 
 }
 
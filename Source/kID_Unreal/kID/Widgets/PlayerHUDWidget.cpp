@@ -16,4 +16,43 @@ void UPlayerHUDWidget::SetText(const FString& text)
     } else {
         UE_LOG(LogTemp, Warning, TEXT("textblock not set."));
     }
-}
\ No newline at end of file
+}
+
+void UPlayerHUDWidget::ApplyViewModel(const FKidHudViewModel& ViewModel)
+{
+    if (!ViewModel.IsAuthorized())
+    {
+        if (ViewModel.IsDirty(FKidHudViewModel::Authorized))
+        {
+            SetText(TEXT("AuthToken not initialized. Check log for details."));
+        }
+        return;
+    }
+
+    // coming back from the error text every line has to be shown again
+    const bool bAll = ViewModel.IsDirty(FKidHudViewModel::Authorized);
+    if (bAll || ViewModel.IsDirty(FKidHudViewModel::SessionId))
+    {
+        SessionLine = TEXT("Session: ") + ViewModel.GetSessionId();
+    }
+    if (bAll || ViewModel.IsDirty(FKidHudViewModel::ChallengeId))
+    {
+        ChallengeLine = TEXT("Challenge: ") + ViewModel.GetChallengeId();
+    }
+    if (bAll || ViewModel.IsDirty(FKidHudViewModel::AgeStatus))
+    {
+        AgeStatusLine = TEXT("Age Status: ") + ViewModel.GetAgeStatus();
+    }
+    if (bAll || ViewModel.IsDirty(FKidHudViewModel::AccessMode))
+    {
+        AccessModeLine = FString(TEXT("Access Mode: ")) + ViewModel.GetAccessMode();
+    }
+
+    FString Text;
+    Text.Reserve(SessionLine.Len() + ChallengeLine.Len() + AgeStatusLine.Len() + AccessModeLine.Len() + 3);
+    Text.Append(SessionLine).AppendChar(TEXT('\n'))
+        .Append(ChallengeLine).AppendChar(TEXT('\n'))
+        .Append(AgeStatusLine).AppendChar(TEXT('\n'))
+        .Append(AccessModeLine);
+    SetText(Text);
+}
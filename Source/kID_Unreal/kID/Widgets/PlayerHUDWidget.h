@@ -2,6 +2,7 @@
 
 #include "CoreMinimal.h"
 #include "Blueprint/UserWidget.h"
+#include "../KidHudViewModel.h"
 #include "PlayerHUDWidget.generated.h"
 
 UCLASS()
@@ -12,9 +13,18 @@ class UPlayerHUDWidget: public UUserWidget
 public:
     void SetText(const FString& text);
 
+    // Updates the lines whose fields are dirty in the view model and sets the text once.
+    void ApplyViewModel(const FKidHudViewModel& ViewModel);
+
 protected:
     virtual void NativeConstruct() override;
 
     UPROPERTY(meta = (BindWidget))
     class UTextBlock* TextBlock;
+
+private:
+    FString SessionLine;
+    FString ChallengeLine;
+    FString AgeStatusLine;
+    FString AccessModeLine;
 };
\ No newline at end of file
@@ -13,6 +13,8 @@
 #include "Editor/UnrealEd/Public/Editor.h"
 #include "PlatformUtil.h"
 #include "GenericPlatform/GenericPlatformHttp.h"
+#include "Misc/ScopeExit.h"
+#include "../../KidTrace.h"
 
 // useful for httpserver debugging in the editor
 static bool LogToFile = false;
@@ -146,6 +148,11 @@ void UFPrivatelyHttpServer::StopServer()
 
 void UFPrivatelyHttpServer::HandleClient()
 {
+    KID_TRACE_SCOPE(PrivatelyHttpServer_HandleClient);
+    // one span per browser connection, from accept until the socket is closed
+    const FString SpanName = FKidTrace::BeginSpan(TEXT("Privately connection"));
+    ON_SCOPE_EXIT { FKidTrace::EndSpan(SpanName); };
+
     // Set the socket to non-blocking mode
     ClientSocket->SetNonBlocking(true);
 
@@ -210,6 +217,7 @@ void UFPrivatelyHttpServer::HandleClient()
 
 void UFPrivatelyHttpServer::SendResponse(const FString& Response)
 {
+    KID_TRACE_SCOPE(PrivatelyHttpServer_SendResponse);
     int32 BytesSent = 0;
     TArray<uint8> ResponseData;
     ResponseData.Append(reinterpret_cast<const uint8*>(TCHAR_TO_UTF8(*Response)), Response.Len());
@@ -219,6 +227,7 @@ void UFPrivatelyHttpServer::SendResponse(const FString& Response)
 
 void UFPrivatelyHttpServer::ProcessHttpRequest(const FString& Request)
 {
+    KID_TRACE_SCOPE(PrivatelyHttpServer_ProcessHttpRequest);
     // Basic parsing of the HTTP request
     if (Request.StartsWith(TEXT("GET ")))
     {
@@ -400,6 +409,7 @@ void UFPrivatelyHttpServer::ProcessHttpRequest(const FString& Request)
 
 FString UFPrivatelyHttpServer::ReadHtmlFile()
 {
+    KID_TRACE_SCOPE(PrivatelyHttpServer_ReadHtmlFile);
     FString FilePath = FPaths::Combine(FPaths::ProjectDir(), TEXT("privately.html"));
     FString FileContent;
     FFileHelper::LoadFileToString(FileContent, *FilePath);
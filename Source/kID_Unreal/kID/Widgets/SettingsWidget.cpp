@@ -13,25 +13,51 @@ void USettingsWidget::InitializeWidget(TSharedPtr<FJsonObject> SessionInfo, TFun
     CreatePermissionWidgets(SessionInfo);
     SyncCheckboxes(SessionInfo);
     Callback = InCallback;
-    CancelButton->OnClicked.AddDynamic(this, &USettingsWidget::RemoveFromParent);
+    CancelButton->OnClicked.AddUniqueDynamic(this, &USettingsWidget::RemoveFromParent);
 }
 
 void USettingsWidget::CreatePermissionWidgets(TSharedPtr<FJsonObject> SessionInfo)
 {
     TArray<TSharedPtr<FJsonValue>> Permissions = SessionInfo->GetArrayField(TEXT("permissions"));
+
+    // The widget is pooled, so rows from the last time it was shown are kept for permissions the
+    // session still has and removed for the others.
+    TSet<FString> PermissionNames;
+    for (auto& Permission : Permissions)
+    {
+        PermissionNames.Add(Permission->AsObject()->GetStringField(TEXT("name")));
+    }
+    for (auto It = CheckBoxMap.CreateIterator(); It; ++It)
+    {
+        if (!PermissionNames.Contains(It.Key()))
+        {
+            It.Value()->GetParent()->RemoveFromParent();
+            TextBlockMap.Remove(It.Key());
+            CheckBoxStates.Remove(It.Key());
+            It.RemoveCurrent();
+        }
+    }
+
     for (auto& Permission : Permissions)
     {
         TSharedPtr<FJsonObject> PermissionObject = Permission->AsObject();
         FString PermissionName = PermissionObject->GetStringField(TEXT("name"));
+        if (CheckBoxMap.Contains(PermissionName))
+        {
+            continue;
+        }
+
         FString DisplayName = FeatureMappings.Contains(PermissionName) ? FeatureMappings[PermissionName] : PermissionName;
 
         // Create CheckBox
-        UCheckBox* CheckBox = WidgetTree->ConstructWidget<UCheckBox>(UCheckBox::StaticClass(), FName(*(PermissionName + TEXT("CheckBox"))));
+        UCheckBox* CheckBox = WidgetTree->ConstructWidget<UCheckBox>(UCheckBox::StaticClass(), 
+                    MakeUniqueObjectName(WidgetTree, UCheckBox::StaticClass(), FName(*(PermissionName + TEXT("CheckBox")))));
         CheckBox->OnCheckStateChanged.AddDynamic(this, &USettingsWidget::OnAnyCheckBoxChanged);
         CheckBoxMap.Add(PermissionName, CheckBox);
 
         // Create TextBlock
-        UTextBlock* TextBlock = WidgetTree->ConstructWidget<UTextBlock>(UTextBlock::StaticClass(), FName(*(PermissionName + TEXT("TextBlock"))));
+        UTextBlock* TextBlock = WidgetTree->ConstructWidget<UTextBlock>(UTextBlock::StaticClass(), 
+                    MakeUniqueObjectName(WidgetTree, UTextBlock::StaticClass(), FName(*(PermissionName + TEXT("TextBlock")))));
         TextBlock->SetText(FText::FromString(DisplayName));
         TextBlock->SetColorAndOpacity(FSlateColor(FLinearColor::Green));
         TextBlockMap.Add(PermissionName, TextBlock);
@@ -71,18 +97,30 @@ void USettingsWidget::SyncCheckboxes(TSharedPtr<FJsonObject> SessionInfo)
         {
             UCheckBox* CheckBox = *CheckBoxMap.Find(PermissionName);
             UTextBlock* TextBlock = *TextBlockMap.Find(PermissionName);
-            SetUpFeature(PermissionName, PermissionObject, CheckBox, TextBlock);
+            SetUpFeature(PermissionName, PermissionObject->GetBoolField(TEXT("enabled")), PermissionObject->GetStringField(TEXT("managedBy")), CheckBox, TextBlock);
+        }
+    }
+}
+
+void USettingsWidget::ApplyPermissionChanges(const TArray<FKidPermissionChange>& Changes)
+{
+    for (const FKidPermissionChange& Change : Changes)
+    {
+        UCheckBox** CheckBox = CheckBoxMap.Find(Change.Name);
+        UTextBlock** TextBlock = TextBlockMap.Find(Change.Name);
+        if (CheckBox && TextBlock)
+        {
+            SetUpFeature(Change.Name, Change.bEnabled, Change.ManagedBy, *CheckBox, *TextBlock);
         }
     }
 }
 
-void USettingsWidget::SetUpFeature(const FString &PermissionName, TSharedPtr<FJsonObject> PermissionObject, UCheckBox* Checkbox, UTextBlock* Text)
+void USettingsWidget::SetUpFeature(const FString &PermissionName, bool bEnabled, const FString& ManagedBy, UCheckBox* Checkbox, UTextBlock* Text)
 {
     Text->SetColorAndOpacity(FSlateColor(FLinearColor::Green));
     UE_LOG(LogTemp, Log, TEXT("Setting up feature: %s"), *PermissionName);
-    bool bProhibited = PermissionObject->GetStringField(TEXT("managedBy")) == TEXT("PROHIBITED");
-    bool bManagedByGuardian = PermissionObject->GetStringField(TEXT("managedBy")) == TEXT("GUARDIAN");
-    bool bEnabled = PermissionObject->GetBoolField(TEXT("enabled"));
+    bool bProhibited = ManagedBy == TEXT("PROHIBITED");
+    bool bManagedByGuardian = ManagedBy == TEXT("GUARDIAN");
     Checkbox->SetIsChecked(bEnabled);
     Checkbox->SetIsEnabled(!bProhibited);
     Text->SetColorAndOpacity(!bProhibited ? (bManagedByGuardian ? FSlateColor(FLinearColor::Blue) : FSlateColor(FLinearColor::Black)) : FSlateColor(FLinearColor::Gray));
@@ -6,6 +6,7 @@
 #include "Components/TextBlock.h"
 #include "Components/VerticalBox.h"
 #include "Components/Button.h"
+#include "../KidPermissionDiff.h"
 #include "SettingsWidget.generated.h"
 
 UCLASS()
@@ -17,9 +18,12 @@ public:
     void InitializeWidget(TSharedPtr<FJsonObject> SessionInfo, TFunction<void(const FString&, bool)> InCallback);
     void SyncCheckboxes(TSharedPtr<FJsonObject> SessionInfo);
 
+    // Updates only the checkboxes of permissions that changed.
+    void ApplyPermissionChanges(const TArray<FKidPermissionChange>& Changes);
+
 private:
     void CreatePermissionWidgets(TSharedPtr<FJsonObject> SessionInfo);
-    void SetUpFeature(const FString& PermissionName, TSharedPtr<FJsonObject> PermissionObject, UCheckBox* Checkbox, UTextBlock* Text);
+    void SetUpFeature(const FString& PermissionName, bool bEnabled, const FString& ManagedBy, UCheckBox* Checkbox, UTextBlock* Text);
 
     UFUNCTION()
     void OnAnyCheckBoxChanged(bool bIsChecked);
@@ -14,6 +14,7 @@ public:
     void InitializeWidget(TFunction<void(const FString&)> InCallback);
 
 protected:
+    virtual void NativeOnInitialized() override;
     virtual void NativeConstruct() override;
 
 private:
@@ -28,6 +29,9 @@ private:
 
     TFunction<void(const FString&)> Callback;
 
+    // the slider position set in the blueprint, restored each time the widget is shown
+    float InitialAge = 0.0f;
+
     UFUNCTION()
     void OnSubmitClicked();
 };
\ No newline at end of file
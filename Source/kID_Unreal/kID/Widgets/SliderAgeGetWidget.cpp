@@ -2,17 +2,27 @@
 #include "Components/EditableTextBox.h"
 #include "Components/Button.h"
 
+void USliderAgeGateWidget::NativeOnInitialized()
+{
+    Super::NativeOnInitialized();
+
+    InitialAge = AgeSlider->GetValue();
+}
+
 void USliderAgeGateWidget::NativeConstruct()
 {
     Super::NativeConstruct();
 
-    SubmitButton->OnClicked.AddDynamic(this, &USliderAgeGateWidget::OnSubmitClicked);
-    CancelButton->OnClicked.AddDynamic(this, &USliderAgeGateWidget::RemoveFromParent);
+    SubmitButton->OnClicked.AddUniqueDynamic(this, &USliderAgeGateWidget::OnSubmitClicked);
+    CancelButton->OnClicked.AddUniqueDynamic(this, &USliderAgeGateWidget::RemoveFromParent);
 }
 
 void USliderAgeGateWidget::InitializeWidget(TFunction<void(const FString&)> InCallback)
 {
     Callback = InCallback;
+
+    // the widget is pooled, so undo what the previous player chose
+    AgeSlider->SetValue(InitialAge);
 }
 
 void USliderAgeGateWidget::OnSubmitClicked()
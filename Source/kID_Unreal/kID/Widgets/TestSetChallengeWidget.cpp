@@ -7,8 +7,8 @@ void UTestSetChallengeWidget::NativeConstruct()
 {
     Super::NativeConstruct();
 
-    CancelButton->OnClicked.AddDynamic(this, &UTestSetChallengeWidget::OnCancelButtonClicked);
-    SubmitButton->OnClicked.AddDynamic(this, &UTestSetChallengeWidget::OnSubmitButtonClicked);
+    CancelButton->OnClicked.AddUniqueDynamic(this, &UTestSetChallengeWidget::OnCancelButtonClicked);
+    SubmitButton->OnClicked.AddUniqueDynamic(this, &UTestSetChallengeWidget::OnSubmitButtonClicked);
 }
 
 void UTestSetChallengeWidget::InitializeWidget(TFunction<void(const FString&, const FString&)> InOnSubmitCallback)
@@ -5,7 +5,7 @@ void UUnavailableWidget::NativeConstruct()
 {
     Super::NativeConstruct();
 
-    Quit->OnClicked.AddDynamic(this, &UUnavailableWidget::OnQuitClicked);
+    Quit->OnClicked.AddUniqueDynamic(this, &UUnavailableWidget::OnQuitClicked);
 }
 
 void UUnavailableWidget::OnQuitClicked()
@@ -0,0 +1,36 @@
+#include "KidCoreFlowState.h"
+
+namespace KidCore
+{
+    const char* ToString(EFlowState State)
+    {
+        switch (State)
+        {
+        case EFlowState::Idle:                       return "Idle";
+        case EFlowState::RestoringChallenge:         return "RestoringChallenge";
+        case EFlowState::RefreshingSession:          return "RefreshingSession";
+        case EFlowState::FetchingRequirements:       return "FetchingRequirements";
+        case EFlowState::AwaitingAgeGate:            return "AwaitingAgeGate";
+        case EFlowState::AwaitingAgeAssurance:       return "AwaitingAgeAssurance";
+        case EFlowState::CheckingAge:                return "CheckingAge";
+        case EFlowState::FetchingDefaultPermissions: return "FetchingDefaultPermissions";
+        case EFlowState::BatchingUpgrades:           return "BatchingUpgrades";
+        case EFlowState::UpgradingSession:           return "UpgradingSession";
+        case EFlowState::AwaitingConsent:            return "AwaitingConsent";
+        case EFlowState::Completed:                  return "Completed";
+        case EFlowState::Failed:                     return "Failed";
+        case EFlowState::Cancelled:                  return "Cancelled";
+        }
+        return "Unknown";
+    }
+
+    bool IsFinalState(EFlowState State)
+    {
+        return State == EFlowState::Completed || State == EFlowState::Failed || State == EFlowState::Cancelled;
+    }
+
+    bool CanTransition(EFlowState From, EFlowState To)
+    {
+        return !IsFinalState(From) && From != To;
+    }
+}
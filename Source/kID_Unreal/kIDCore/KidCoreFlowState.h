@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+
+namespace KidCore
+{
+    // The states a kID flow moves through.  A flow only ever sits in one state at a time; steps that
+    // run alongside the current state (e.g. refreshing a session while a challenge is restored) are
+    // recorded as stages instead.
+    enum class EFlowState : uint8_t
+    {
+        Idle,
+        RestoringChallenge,         // /challenge/get for a saved challenge
+        RefreshingSession,          // /session/get for a known session
+        FetchingRequirements,       // /age-gate/get-requirements
+        AwaitingAgeGate,            // the player is entering a date of birth
+        AwaitingAgeAssurance,       // the player is going through age assurance
+        CheckingAge,                // /age-gate/check
+        FetchingDefaultPermissions, // /age-gate/get-default-permissions
+        BatchingUpgrades,           // collecting the features of one /session/upgrade
+        UpgradingSession,           // /session/upgrade
+        AwaitingConsent,            // challenge shown, waiting on /challenge/await
+        Completed,
+        Failed,
+        Cancelled
+    };
+
+    const char* ToString(EFlowState State);
+
+    bool IsFinalState(EFlowState State);
+
+    // A finished flow stays finished, and moving to the current state is not a transition.
+    bool CanTransition(EFlowState From, EFlowState To);
+}
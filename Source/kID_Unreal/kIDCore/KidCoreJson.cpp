@@ -0,0 +1,568 @@
+#include "KidCoreJson.h"
+
+namespace KidCore
+{
+    namespace
+    {
+        // nesting deeper than any kID response, so hostile input cannot grow the stack unbounded
+        constexpr size_t MaxJsonDepth = 64;
+
+        int32_t HexDigitValue(char Char)
+        {
+            if (Char >= '0' && Char <= '9')
+            {
+                return Char - '0';
+            }
+            if (Char >= 'a' && Char <= 'f')
+            {
+                return Char - 'a' + 10;
+            }
+            if (Char >= 'A' && Char <= 'F')
+            {
+                return Char - 'A' + 10;
+            }
+            return -1;
+        }
+
+        void AppendUtf8(std::string& Out, uint32_t CodePoint)
+        {
+            if (CodePoint < 0x80)
+            {
+                Out.push_back(static_cast<char>(CodePoint));
+            }
+            else if (CodePoint < 0x800)
+            {
+                Out.push_back(static_cast<char>(0xC0 | (CodePoint >> 6)));
+                Out.push_back(static_cast<char>(0x80 | (CodePoint & 0x3F)));
+            }
+            else if (CodePoint < 0x10000)
+            {
+                Out.push_back(static_cast<char>(0xE0 | (CodePoint >> 12)));
+                Out.push_back(static_cast<char>(0x80 | ((CodePoint >> 6) & 0x3F)));
+                Out.push_back(static_cast<char>(0x80 | (CodePoint & 0x3F)));
+            }
+            else
+            {
+                Out.push_back(static_cast<char>(0xF0 | (CodePoint >> 18)));
+                Out.push_back(static_cast<char>(0x80 | ((CodePoint >> 12) & 0x3F)));
+                Out.push_back(static_cast<char>(0x80 | ((CodePoint >> 6) & 0x3F)));
+                Out.push_back(static_cast<char>(0x80 | (CodePoint & 0x3F)));
+            }
+        }
+
+        const char HexDigits[] = "0123456789abcdef";
+
+        void AppendEscaped(std::string& Out, unsigned char Char)
+        {
+            switch (Char)
+            {
+            case '"':  Out.append("\\\""); break;
+            case '\\': Out.append("\\\\"); break;
+            case '\n': Out.append("\\n"); break;
+            case '\r': Out.append("\\r"); break;
+            case '\t': Out.append("\\t"); break;
+            default:
+                Out.append("\\u00");
+                Out.push_back(HexDigits[Char >> 4]);
+                Out.push_back(HexDigits[Char & 0xF]);
+                break;
+            }
+        }
+    }
+
+    FJsonReader::FJsonReader(std::string_view InText)
+        : Text(InText)
+    {
+    }
+
+    EJsonToken FJsonReader::Fail()
+    {
+        bError = true;
+        Key = std::string_view();
+        Value = std::string_view();
+        return EJsonToken::Error;
+    }
+
+    void FJsonReader::SkipWhitespace()
+    {
+        while (Position < Text.size())
+        {
+            const char Char = Text[Position];
+            if (Char != ' ' && Char != '\t' && Char != '\r' && Char != '\n')
+            {
+                break;
+            }
+            ++Position;
+        }
+    }
+
+    EJsonToken FJsonReader::Next()
+    {
+        if (bError)
+        {
+            return EJsonToken::Error;
+        }
+
+        Key = std::string_view();
+        Value = std::string_view();
+        SkipWhitespace();
+
+        if (bDone)
+        {
+            return Position == Text.size() ? EJsonToken::None : Fail();
+        }
+        if (Position == Text.size())
+        {
+            return Fail();
+        }
+
+        if (!Containers.empty())
+        {
+            const char Char = Text[Position];
+            if (Char == '}' || Char == ']')
+            {
+                if ((Char == '}') != (Containers.back() == '{'))
+                {
+                    return Fail();
+                }
+                ++Position;
+                Containers.pop_back();
+                bNeedComma = true;
+                bDone = Containers.empty();
+                return Char == '}' ? EJsonToken::EndObject : EJsonToken::EndArray;
+            }
+
+            if (bNeedComma)
+            {
+                if (Char != ',')
+                {
+                    return Fail();
+                }
+                ++Position;
+                SkipWhitespace();
+            }
+
+            if (Containers.back() == '{')
+            {
+                if (!ReadString(Key, KeyScratch))
+                {
+                    return Fail();
+                }
+                SkipWhitespace();
+                if (Position == Text.size() || Text[Position] != ':')
+                {
+                    return Fail();
+                }
+                ++Position;
+                SkipWhitespace();
+            }
+        }
+
+        if (Position == Text.size())
+        {
+            return Fail();
+        }
+
+        EJsonToken Token = EJsonToken::Error;
+        const char Char = Text[Position];
+        if (Char == '{' || Char == '[')
+        {
+            if (Containers.size() >= MaxJsonDepth)
+            {
+                return Fail();
+            }
+            ++Position;
+            Containers.push_back(Char);
+            bNeedComma = false;
+            return Char == '{' ? EJsonToken::BeginObject : EJsonToken::BeginArray;
+        }
+        else if (Char == '"')
+        {
+            if (!ReadString(Value, ValueScratch))
+            {
+                return Fail();
+            }
+            Token = EJsonToken::String;
+        }
+        else if (Char == 't')
+        {
+            Token = ReadLiteral("true") ? EJsonToken::True : EJsonToken::Error;
+        }
+        else if (Char == 'f')
+        {
+            Token = ReadLiteral("false") ? EJsonToken::False : EJsonToken::Error;
+        }
+        else if (Char == 'n')
+        {
+            Token = ReadLiteral("null") ? EJsonToken::Null : EJsonToken::Error;
+        }
+        else if (Char == '-' || (Char >= '0' && Char <= '9'))
+        {
+            Token = ReadNumber() ? EJsonToken::Number : EJsonToken::Error;
+        }
+
+        if (Token == EJsonToken::Error)
+        {
+            return Fail();
+        }
+        bNeedComma = true;
+        bDone = Containers.empty();
+        return Token;
+    }
+
+    bool FJsonReader::SkipValue(EJsonToken Token)
+    {
+        if (Token != EJsonToken::BeginObject && Token != EJsonToken::BeginArray)
+        {
+            return Token != EJsonToken::Error;
+        }
+
+        const size_t Depth = Containers.size();
+        while (Containers.size() >= Depth)
+        {
+            const EJsonToken Skipped = Next();
+            if (Skipped == EJsonToken::Error || Skipped == EJsonToken::None)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool FJsonReader::ReadString(std::string_view& Out, std::string& Scratch)
+    {
+        if (Position == Text.size() || Text[Position] != '"')
+        {
+            return false;
+        }
+        const size_t Start = ++Position;
+
+        // the common case has no escapes and is returned in place
+        while (Position < Text.size() && Text[Position] != '"' && Text[Position] != '\\')
+        {
+            if (static_cast<unsigned char>(Text[Position]) < 0x20)
+            {
+                return false;
+            }
+            ++Position;
+        }
+        if (Position == Text.size())
+        {
+            return false;
+        }
+        if (Text[Position] == '"')
+        {
+            Out = Text.substr(Start, Position - Start);
+            ++Position;
+            return true;
+        }
+
+        Scratch.assign(Text.data() + Start, Position - Start);
+        while (Position < Text.size())
+        {
+            const char Char = Text[Position++];
+            if (Char == '"')
+            {
+                Out = Scratch;
+                return true;
+            }
+            if (static_cast<unsigned char>(Char) < 0x20)
+            {
+                return false;
+            }
+            if (Char != '\\')
+            {
+                Scratch.push_back(Char);
+                continue;
+            }
+            if (Position == Text.size())
+            {
+                return false;
+            }
+
+            const char Escape = Text[Position++];
+            switch (Escape)
+            {
+            case '"':  Scratch.push_back('"'); break;
+            case '\\': Scratch.push_back('\\'); break;
+            case '/':  Scratch.push_back('/'); break;
+            case 'b':  Scratch.push_back('\b'); break;
+            case 'f':  Scratch.push_back('\f'); break;
+            case 'n':  Scratch.push_back('\n'); break;
+            case 'r':  Scratch.push_back('\r'); break;
+            case 't':  Scratch.push_back('\t'); break;
+            case 'u':
+            {
+                auto ReadHex = [this](uint32_t& OutUnit)
+                {
+                    if (Text.size() - Position < 4)
+                    {
+                        return false;
+                    }
+                    OutUnit = 0;
+                    for (int32_t Digit = 0; Digit < 4; ++Digit)
+                    {
+                        const int32_t DigitValue = HexDigitValue(Text[Position++]);
+                        if (DigitValue < 0)
+                        {
+                            return false;
+                        }
+                        OutUnit = OutUnit * 16 + static_cast<uint32_t>(DigitValue);
+                    }
+                    return true;
+                };
+
+                uint32_t CodePoint = 0;
+                if (!ReadHex(CodePoint))
+                {
+                    return false;
+                }
+
+                // a high surrogate is combined with the low one escaped after it, and an unpaired
+                // surrogate becomes U+FFFD
+                if (CodePoint >= 0xD800 && CodePoint <= 0xDBFF)
+                {
+                    uint32_t Low = 0;
+                    const size_t Rewind = Position;
+                    if (Text.size() - Position >= 2 && Text[Position] == '\\' && Text[Position + 1] == 'u')
+                    {
+                        Position += 2;
+                        if (!ReadHex(Low))
+                        {
+                            return false;
+                        }
+                    }
+                    if (Low >= 0xDC00 && Low <= 0xDFFF)
+                    {
+                        CodePoint = 0x10000 + ((CodePoint - 0xD800) << 10) + (Low - 0xDC00);
+                    }
+                    else
+                    {
+                        Position = Rewind;
+                        CodePoint = 0xFFFD;
+                    }
+                }
+                else if (CodePoint >= 0xDC00 && CodePoint <= 0xDFFF)
+                {
+                    CodePoint = 0xFFFD;
+                }
+                AppendUtf8(Scratch, CodePoint);
+                break;
+            }
+            default:
+                return false;
+            }
+        }
+        return false;
+    }
+
+    bool FJsonReader::ReadLiteral(std::string_view Literal)
+    {
+        if (Text.substr(Position, Literal.size()) != Literal)
+        {
+            return false;
+        }
+        Position += Literal.size();
+        return true;
+    }
+
+    bool FJsonReader::ReadNumber()
+    {
+        // integers, which is all kID sends, are exact up to 2^53
+        const size_t Start = Position;
+        const bool bNegative = Text[Position] == '-';
+        if (bNegative)
+        {
+            ++Position;
+        }
+
+        auto IsDigit = [this]() { return Position < Text.size() && Text[Position] >= '0' && Text[Position] <= '9'; };
+        if (!IsDigit())
+        {
+            return false;
+        }
+
+        double Mantissa = 0.0;
+        if (Text[Position] == '0')
+        {
+            ++Position;
+        }
+        else
+        {
+            while (IsDigit())
+            {
+                Mantissa = Mantissa * 10.0 + (Text[Position++] - '0');
+            }
+        }
+
+        int32_t Exponent = 0;
+        if (Position < Text.size() && Text[Position] == '.')
+        {
+            ++Position;
+            if (!IsDigit())
+            {
+                return false;
+            }
+            while (IsDigit())
+            {
+                Mantissa = Mantissa * 10.0 + (Text[Position++] - '0');
+                --Exponent;
+            }
+        }
+
+        if (Position < Text.size() && (Text[Position] == 'e' || Text[Position] == 'E'))
+        {
+            ++Position;
+            bool bNegativeExponent = false;
+            if (Position < Text.size() && (Text[Position] == '+' || Text[Position] == '-'))
+            {
+                bNegativeExponent = Text[Position++] == '-';
+            }
+            if (!IsDigit())
+            {
+                return false;
+            }
+            int32_t ExplicitExponent = 0;
+            while (IsDigit())
+            {
+                ExplicitExponent = ExplicitExponent < 10000 ? ExplicitExponent * 10 + (Text[Position] - '0') : ExplicitExponent;
+                ++Position;
+            }
+            Exponent += bNegativeExponent ? -ExplicitExponent : ExplicitExponent;
+        }
+
+        double Scale = 1.0;
+        for (int32_t Step = 0; Step < (Exponent < 0 ? -Exponent : Exponent) && Scale < 1e308; ++Step)
+        {
+            Scale *= 10.0;
+        }
+        Number = Exponent < 0 ? Mantissa / Scale : Mantissa * Scale;
+        if (bNegative)
+        {
+            Number = -Number;
+        }
+        Value = Text.substr(Start, Position - Start);
+        return true;
+    }
+
+    void FJsonWriter::BeginValue()
+    {
+        if (bAfterKey)
+        {
+            bAfterKey = false;
+        }
+        else if (bNeedComma)
+        {
+            Out.push_back(',');
+        }
+    }
+
+    void FJsonWriter::BeginObject()
+    {
+        BeginValue();
+        Out.push_back('{');
+        bNeedComma = false;
+    }
+
+    void FJsonWriter::EndObject()
+    {
+        Out.push_back('}');
+        bNeedComma = true;
+    }
+
+    void FJsonWriter::BeginArray()
+    {
+        BeginValue();
+        Out.push_back('[');
+        bNeedComma = false;
+    }
+
+    void FJsonWriter::EndArray()
+    {
+        Out.push_back(']');
+        bNeedComma = true;
+    }
+
+    void FJsonWriter::Key(std::string_view Name)
+    {
+        if (bNeedComma)
+        {
+            Out.push_back(',');
+        }
+        Out.push_back('"');
+        Out.append(Name.data(), Name.size());
+        Out.append("\":");
+        bAfterKey = true;
+    }
+
+    void FJsonWriter::String(std::string_view Text)
+    {
+        BeginValue();
+        AppendJsonString(Out, Text);
+        bNeedComma = true;
+    }
+
+    void FJsonWriter::Integer(int64_t Number)
+    {
+        BeginValue();
+
+        // written backwards into a local buffer, which also covers the most negative value
+        char Digits[24];
+        size_t Length = 0;
+        uint64_t Magnitude = Number < 0 ? 0 - static_cast<uint64_t>(Number) : static_cast<uint64_t>(Number);
+        do
+        {
+            Digits[Length++] = static_cast<char>('0' + Magnitude % 10);
+            Magnitude /= 10;
+        }
+        while (Magnitude > 0);
+        if (Number < 0)
+        {
+            Out.push_back('-');
+        }
+        while (Length > 0)
+        {
+            Out.push_back(Digits[--Length]);
+        }
+        bNeedComma = true;
+    }
+
+    void FJsonWriter::Bool(bool bValue)
+    {
+        BeginValue();
+        Out.append(bValue ? "true" : "false");
+        bNeedComma = true;
+    }
+
+    void AppendJsonString(std::string& Out, std::string_view Text)
+    {
+        Out.push_back('"');
+        size_t RunStart = 0;
+        for (size_t Index = 0; Index < Text.size(); ++Index)
+        {
+            const unsigned char Char = static_cast<unsigned char>(Text[Index]);
+            if (Char >= 0x20 && Char != '"' && Char != '\\')
+            {
+                continue;
+            }
+
+            Out.append(Text.data() + RunStart, Index - RunStart);
+            RunStart = Index + 1;
+            AppendEscaped(Out, Char);
+        }
+        Out.append(Text.data() + RunStart, Text.size() - RunStart);
+        Out.push_back('"');
+    }
+
+    void AppendJsonCodePoint(std::string& Out, uint32_t CodePoint)
+    {
+        if (CodePoint < 0x20 || CodePoint == '"' || CodePoint == '\\')
+        {
+            AppendEscaped(Out, static_cast<unsigned char>(CodePoint));
+        }
+        else
+        {
+            AppendUtf8(Out, CodePoint);
+        }
+    }
+}
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Minimal UTF-8 JSON reading and writing for the core, which cannot use the engine's Json module.
+namespace KidCore
+{
+    enum class EJsonToken : uint8_t
+    {
+        // the end of the document
+        None,
+        BeginObject,
+        EndObject,
+        BeginArray,
+        EndArray,
+        String,
+        Number,
+        True,
+        False,
+        Null,
+        Error,
+    };
+
+    // Pull reader over a document that is not copied, so it must outlive the reader.  Strings
+    // without escapes are returned as views into the document, and the others are unescaped into a
+    // buffer that is reused, so a view is only valid until the next call to Next().
+    //
+    //   FJsonReader Reader(Json);
+    //   for (EJsonToken Token = Reader.Next(); ...; Token = Reader.Next())
+    //   {
+    //       if (Reader.GetKey() == "sessionId" && Token == EJsonToken::String) ...
+    //   }
+    class FJsonReader
+    {
+    public:
+        explicit FJsonReader(std::string_view InText);
+
+        // Any malformed input, including trailing content, ends in Error, after which Next()
+        // keeps returning Error.
+        EJsonToken Next();
+
+        // Skips the rest of the value the last token began, if it began an object or array.
+        bool SkipValue(EJsonToken Token);
+
+        // the member name of the last token, empty inside arrays and at the root
+        std::string_view GetKey() const { return Key; }
+        std::string_view GetString() const { return Value; }
+        double GetNumber() const { return Number; }
+
+        // how many objects and arrays the reader is inside
+        size_t GetDepth() const { return Containers.size(); }
+
+    private:
+        EJsonToken Fail();
+        void SkipWhitespace();
+        bool ReadString(std::string_view& Out, std::string& Scratch);
+        bool ReadLiteral(std::string_view Literal);
+        bool ReadNumber();
+
+        std::string_view Text;
+        size_t Position = 0;
+        std::vector<char> Containers;
+        bool bNeedComma = false;
+        bool bDone = false;
+        bool bError = false;
+
+        std::string_view Key;
+        std::string_view Value;
+        double Number = 0.0;
+        std::string KeyScratch;
+        std::string ValueScratch;
+    };
+
+    // Appends one code point of a string's contents as UTF-8, escaped if it must be
+    void AppendJsonCodePoint(std::string& Out, uint32_t CodePoint);
+
+    // Appends compact JSON to a caller-owned string, which is never shrunk, so a string that is
+    // reused stops allocating once it fits the largest document.  UTF-8 strings are escaped but not
+    // validated.
+    class FJsonWriter
+    {
+    public:
+        explicit FJsonWriter(std::string& InOut)
+            : Out(InOut)
+        {
+        }
+
+        void BeginObject();
+        void EndObject();
+        void BeginArray();
+        void EndArray();
+
+        // field names are written as given and must not need escaping
+        void Key(std::string_view Name);
+
+        void String(std::string_view Text);
+
+        // Encodes UTF-16 or UTF-32 code units as UTF-8 straight into the output, so engine strings
+        // are written without a conversion buffer.  Unpaired surrogates become U+FFFD.
+        template <typename CharType>
+        void String(const CharType* Text, size_t Length)
+        {
+            static_assert(sizeof(CharType) >= 2, "UTF-8 text goes through String(std::string_view)");
+
+            BeginValue();
+            Out.push_back('"');
+            for (size_t Index = 0; Index < Length; ++Index)
+            {
+                uint32_t CodePoint = static_cast<uint32_t>(Text[Index]);
+                if (sizeof(CharType) == 2 && CodePoint >= 0xD800 && CodePoint <= 0xDBFF && Index + 1 < Length
+                    && static_cast<uint32_t>(Text[Index + 1]) >= 0xDC00 && static_cast<uint32_t>(Text[Index + 1]) <= 0xDFFF)
+                {
+                    CodePoint = 0x10000 + ((CodePoint - 0xD800) << 10) + (static_cast<uint32_t>(Text[Index + 1]) - 0xDC00);
+                    ++Index;
+                }
+                else if ((CodePoint >= 0xD800 && CodePoint <= 0xDFFF) || CodePoint > 0x10FFFF)
+                {
+                    CodePoint = 0xFFFD;
+                }
+                AppendJsonCodePoint(Out, CodePoint);
+            }
+            Out.push_back('"');
+            bNeedComma = true;
+        }
+        void Integer(int64_t Number);
+        void Bool(bool bValue);
+
+    private:
+        void BeginValue();
+
+        std::string& Out;
+        bool bNeedComma = false;
+        bool bAfterKey = false;
+    };
+
+    // Appends the string quoted and escaped
+    void AppendJsonString(std::string& Out, std::string_view Text);
+}
@@ -0,0 +1,125 @@
+#include "KidCorePolicy.h"
+#include <algorithm>
+
+namespace KidCore
+{
+    namespace
+    {
+        int32_t MakeMonthDay(int32_t Month, int32_t Day)
+        {
+            return Month * 100 + Day;
+        }
+    }
+
+    const char* ToString(EAgeBand Band)
+    {
+        switch (Band)
+        {
+        case EAgeBand::Invalid:                return "Invalid";
+        case EAgeBand::BelowMinimumAge:        return "BelowMinimumAge";
+        case EAgeBand::BelowDigitalConsentAge: return "BelowDigitalConsentAge";
+        case EAgeBand::BelowCivilAge:          return "BelowCivilAge";
+        case EAgeBand::Adult:                  return "Adult";
+        }
+        return "Unknown";
+    }
+
+    FAgeThresholds FAgeThresholds::Normalized() const
+    {
+        FAgeThresholds Result;
+        Result.MinimumAge = std::max(MinimumAge, 0);
+        Result.DigitalConsentAge = std::max(DigitalConsentAge, Result.MinimumAge);
+        Result.CivilAge = std::max(CivilAge, Result.DigitalConsentAge);
+        return Result;
+    }
+
+    ECheckStatus ParseCheckStatus(std::string_view Status)
+    {
+        if (Status == "PASS")
+        {
+            return ECheckStatus::Pass;
+        }
+        if (Status == "CHALLENGE")
+        {
+            return ECheckStatus::Challenge;
+        }
+        if (Status == "PROHIBITED")
+        {
+            return ECheckStatus::Prohibited;
+        }
+        return ECheckStatus::Unknown;
+    }
+
+    const char* ToString(ECheckStatus Status)
+    {
+        switch (Status)
+        {
+        case ECheckStatus::Unknown:    return "UNKNOWN";
+        case ECheckStatus::Pass:       return "PASS";
+        case ECheckStatus::Challenge:  return "CHALLENGE";
+        case ECheckStatus::Prohibited: return "PROHIBITED";
+        }
+        return "UNKNOWN";
+    }
+
+    EPermissionAction DecidePermissionAction(bool bEnabled, std::string_view ManagedBy)
+    {
+        if (bEnabled)
+        {
+            return EPermissionAction::AlreadyEnabled;
+        }
+        if (ManagedBy == "PLAYER" || ManagedBy == "GUARDIAN")
+        {
+            return EPermissionAction::Upgrade;
+        }
+        if (ManagedBy == "PROHIBITED")
+        {
+            return EPermissionAction::Prohibited;
+        }
+        return EPermissionAction::Unknown;
+    }
+
+    bool IsLeapYear(int32_t Year)
+    {
+        return (Year % 4 == 0 && Year % 100 != 0) || Year % 400 == 0;
+    }
+
+    int32_t DaysInMonth(int32_t Year, int32_t Month)
+    {
+        static const int32_t Days[] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+        if (Month < 1 || Month > 12)
+        {
+            return 0;
+        }
+        return Month == 2 && IsLeapYear(Year) ? 29 : Days[Month - 1];
+    }
+
+    int32_t CalculateAge(const FDate& DateOfBirth, const FDate& Today)
+    {
+        const bool bBirthdayPending = MakeMonthDay(DateOfBirth.Month, DateOfBirth.Day) > MakeMonthDay(Today.Month, Today.Day);
+        return Today.Year - DateOfBirth.Year - (bBirthdayPending ? 1 : 0);
+    }
+
+    EAgeBand ClassifyAge(int32_t Age, const FAgeThresholds& Thresholds)
+    {
+        if (Age < Thresholds.MinimumAge)
+        {
+            return EAgeBand::BelowMinimumAge;
+        }
+        if (Age < Thresholds.DigitalConsentAge)
+        {
+            return EAgeBand::BelowDigitalConsentAge;
+        }
+        return Age < Thresholds.CivilAge ? EAgeBand::BelowCivilAge : EAgeBand::Adult;
+    }
+
+    bool NeedsAgeAssurance(bool bAgeAssuranceRequired, int32_t Age, const FAgeThresholds& Thresholds)
+    {
+        return bAgeAssuranceRequired && Age >= Thresholds.DigitalConsentAge;
+    }
+
+    bool IsUnverifiedAdult(bool bAgeAssuranceRequired, int32_t Age, const FAgeThresholds& Thresholds)
+    {
+        return !NeedsAgeAssurance(bAgeAssuranceRequired, Age, Thresholds) && Age >= Thresholds.CivilAge;
+    }
+}
@@ -0,0 +1,163 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+// Age and permission policy of the kID flows, as plain functions with no engine dependencies, so
+// they can be benchmarked and fuzzed in a native binary.  The Unreal side only converts its
+// strings and calls in here.
+namespace KidCore
+{
+    struct FDate
+    {
+        int32_t Year = 0;
+        // zero when only the year is known
+        int32_t Month = 0;
+        int32_t Day = 0;
+    };
+
+    // Where an age falls relative to the thresholds of a jurisdiction
+    enum class EAgeBand : uint8_t
+    {
+        // the date of birth could not be parsed or the jurisdiction is unknown
+        Invalid,
+        BelowMinimumAge,
+        BelowDigitalConsentAge,
+        BelowCivilAge,
+        Adult,
+    };
+
+    const char* ToString(EAgeBand Band);
+
+    // The ages of a jurisdiction's age gate requirements
+    struct FAgeThresholds
+    {
+        int32_t MinimumAge = 0;
+        int32_t DigitalConsentAge = 0;
+        int32_t CivilAge = 0;
+
+        // made non-decreasing, minimum age first, so the bands never overlap
+        FAgeThresholds Normalized() const;
+    };
+
+    // Outcome of /age-gate/check
+    enum class ECheckStatus : uint8_t
+    {
+        Unknown,
+        Pass,
+        Challenge,
+        Prohibited,
+    };
+
+    ECheckStatus ParseCheckStatus(std::string_view Status);
+    const char* ToString(ECheckStatus Status);
+
+    // What turning on a disabled feature takes, from the permission's managedBy
+    enum class EPermissionAction : uint8_t
+    {
+        AlreadyEnabled,
+        Upgrade,
+        Prohibited,
+        Unknown,
+    };
+
+    EPermissionAction DecidePermissionAction(bool bEnabled, std::string_view ManagedBy);
+
+    bool IsLeapYear(int32_t Year);
+    int32_t DaysInMonth(int32_t Year, int32_t Month);
+
+    // Whole years between the two dates.  A birthday with only the year known counts as passed.
+    int32_t CalculateAge(const FDate& DateOfBirth, const FDate& Today);
+
+    EAgeBand ClassifyAge(int32_t Age, const FAgeThresholds& Thresholds);
+
+    // Age assurance is only asked of players who claim to be old enough to consent for themselves.
+    bool NeedsAgeAssurance(bool bAgeAssuranceRequired, int32_t Age, const FAgeThresholds& Thresholds);
+
+    // Players who go straight to /age-gate/check as adults, the only ones whose defaults can be
+    // known before the check returns.
+    bool IsUnverifiedAdult(bool bAgeAssuranceRequired, int32_t Age, const FAgeThresholds& Thresholds);
+
+    namespace Private
+    {
+        template <typename CharType>
+        bool IsWhitespace(CharType Char)
+        {
+            return Char == ' ' || Char == '\t' || Char == '\r' || Char == '\n';
+        }
+
+        // reads between MinDigits and MaxDigits decimal digits
+        template <typename CharType>
+        bool ReadNumber(const CharType*& It, const CharType* End, int32_t MinDigits, int32_t MaxDigits, int32_t& OutValue)
+        {
+            int32_t Value = 0;
+            int32_t NumDigits = 0;
+            while (It < End && NumDigits < MaxDigits && *It >= '0' && *It <= '9')
+            {
+                Value = Value * 10 + static_cast<int32_t>(*It - '0');
+                ++It;
+                ++NumDigits;
+            }
+            OutValue = Value;
+            return NumDigits >= MinDigits && (It == End || *It < '0' || *It > '9');
+        }
+    }
+
+    // Parses YYYY-MM-DD (also with '.' or '/' separators, optionally followed by a time) or a bare
+    // YYYY, without allocating.  Templated on the character type so engine strings are parsed in
+    // place.
+    template <typename CharType>
+    bool ParseDate(const CharType* Text, size_t Length, FDate& OutDate)
+    {
+        const CharType* It = Text;
+        const CharType* End = Text + Length;
+        while (It < End && Private::IsWhitespace(*It))
+        {
+            ++It;
+        }
+        while (End > It && Private::IsWhitespace(*(End - 1)))
+        {
+            --End;
+        }
+
+        FDate Date;
+        if (!Private::ReadNumber(It, End, 4, 4, Date.Year) || Date.Year == 0)
+        {
+            return false;
+        }
+
+        if (It == End)
+        {
+            OutDate = Date;
+            return true;
+        }
+
+        const CharType Separator = *It++;
+        if ((Separator != '-' && Separator != '.' && Separator != '/')
+            || !Private::ReadNumber(It, End, 1, 2, Date.Month)
+            || It == End || *It++ != Separator
+            || !Private::ReadNumber(It, End, 1, 2, Date.Day))
+        {
+            return false;
+        }
+
+        // anything after the day must be a time, as in 2010-05-01T00:00:00Z or 2010.05.01-00.00.00
+        if (It != End && *It != 'T' && *It != '-' && *It != ' ')
+        {
+            return false;
+        }
+
+        if (Date.Month < 1 || Date.Month > 12 || Date.Day < 1 || Date.Day > DaysInMonth(Date.Year, Date.Month))
+        {
+            return false;
+        }
+
+        OutDate = Date;
+        return true;
+    }
+
+    inline bool ParseDate(std::string_view Text, FDate& OutDate)
+    {
+        return ParseDate(Text.data(), Text.size(), OutDate);
+    }
+}
@@ -0,0 +1,429 @@
+#include "KidCorePolicyBundle.h"
+#include <algorithm>
+#include <limits>
+#include <unordered_map>
+
+namespace KidCore
+{
+    namespace
+    {
+        constexpr uint8_t Magic[] = { 'K', 'I', 'D', 'P' };
+
+        constexpr uint8_t ShouldDisplayFlag = 1 << 0;
+        constexpr uint8_t AgeAssuranceRequiredFlag = 1 << 1;
+
+        constexpr uint64_t MaxThresholdAge = static_cast<uint64_t>(std::numeric_limits<int32_t>::max());
+
+        void WriteVarint(std::vector<uint8_t>& Out, uint64_t Value)
+        {
+            while (Value >= 0x80)
+            {
+                Out.push_back(static_cast<uint8_t>(Value | 0x80));
+                Value >>= 7;
+            }
+            Out.push_back(static_cast<uint8_t>(Value));
+        }
+
+        // Hands out one index per distinct string, in the order they are first seen
+        class FStringTable
+        {
+        public:
+            uint64_t Add(const std::string& Text)
+            {
+                const auto Inserted = Indices.emplace(Text, Strings.size());
+                if (Inserted.second)
+                {
+                    Strings.push_back(&Inserted.first->first);
+                }
+                return Inserted.first->second;
+            }
+
+            void Write(std::vector<uint8_t>& Out) const
+            {
+                WriteVarint(Out, Strings.size());
+                for (const std::string* Text : Strings)
+                {
+                    WriteVarint(Out, Text->size());
+                    Out.insert(Out.end(), Text->begin(), Text->end());
+                }
+            }
+
+        private:
+            std::unordered_map<std::string, uint64_t> Indices;
+            std::vector<const std::string*> Strings;
+        };
+
+        class FBlobReader
+        {
+        public:
+            FBlobReader(const uint8_t* InData, size_t InSize)
+                : Data(InData)
+                , Size(InSize)
+            {
+            }
+
+            size_t GetRemaining() const { return Size - Position; }
+            bool IsAtEnd() const { return Position == Size; }
+
+            bool ReadByte(uint8_t& Out)
+            {
+                if (Position >= Size)
+                {
+                    return false;
+                }
+                Out = Data[Position++];
+                return true;
+            }
+
+            bool ReadBytes(size_t Count, std::string& Out)
+            {
+                if (Count > GetRemaining())
+                {
+                    return false;
+                }
+                Out.assign(reinterpret_cast<const char*>(Data + Position), Count);
+                Position += Count;
+                return true;
+            }
+
+            bool ReadVarint(uint64_t& Out)
+            {
+                Out = 0;
+                for (uint32_t Shift = 0; Shift < 64; Shift += 7)
+                {
+                    uint8_t Byte = 0;
+                    if (!ReadByte(Byte))
+                    {
+                        return false;
+                    }
+                    Out |= static_cast<uint64_t>(Byte & 0x7f) << Shift;
+                    if ((Byte & 0x80) == 0)
+                    {
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+            bool ReadVarint(uint64_t Max, uint64_t& Out)
+            {
+                return ReadVarint(Out) && Out <= Max;
+            }
+
+            // a count of items that each take at least MinBytes, so a corrupt count cannot
+            // reserve more than the blob could hold
+            bool ReadCount(size_t MinBytes, size_t& Out)
+            {
+                uint64_t Count = 0;
+                if (!ReadVarint(GetRemaining() / MinBytes, Count))
+                {
+                    return false;
+                }
+                Out = static_cast<size_t>(Count);
+                return true;
+            }
+
+            bool ReadString(const std::vector<std::string>& Strings, std::string& Out)
+            {
+                uint64_t Index = 0;
+                if (Strings.empty() || !ReadVarint(Strings.size() - 1, Index))
+                {
+                    return false;
+                }
+                Out = Strings[static_cast<size_t>(Index)];
+                return true;
+            }
+
+        private:
+            const uint8_t* Data;
+            size_t Size;
+            size_t Position = 0;
+        };
+
+        bool SamePermissions(const std::vector<FPermission>& A, const std::vector<FPermission>& B)
+        {
+            return std::equal(A.begin(), A.end(), B.begin(), B.end(), [](const FPermission& Left, const FPermission& Right)
+            {
+                return Left.Name == Right.Name && Left.bEnabled == Right.bEnabled && Left.ManagedBy == Right.ManagedBy;
+            });
+        }
+
+        bool SameThresholds(const FAgeThresholds& A, const FAgeThresholds& B)
+        {
+            return A.MinimumAge == B.MinimumAge && A.DigitalConsentAge == B.DigitalConsentAge && A.CivilAge == B.CivilAge;
+        }
+
+        bool IsBefore(const FJurisdictionPolicy& Policy, std::string_view Jurisdiction)
+        {
+            return Policy.Jurisdiction < Jurisdiction;
+        }
+    }
+
+    FPolicyPrediction PredictCheck(const FJurisdictionPolicy& Policy, int32_t Age)
+    {
+        FPolicyPrediction Prediction;
+        if (Age < 0)
+        {
+            return Prediction;
+        }
+
+        // without an age gate everyone plays with the defaults of an adult
+        Prediction.Band = Policy.bShouldDisplay ? ClassifyAge(Age, Policy.Thresholds) : EAgeBand::Adult;
+        if (Policy.bShouldDisplay && NeedsAgeAssurance(Policy.bAgeAssuranceRequired, Age, Policy.Thresholds))
+        {
+            return Prediction;
+        }
+
+        switch (Prediction.Band)
+        {
+        case EAgeBand::BelowMinimumAge:
+            Prediction.Status = ECheckStatus::Prohibited;
+            break;
+
+        case EAgeBand::BelowDigitalConsentAge:
+            Prediction.Status = ECheckStatus::Challenge;
+            break;
+
+        case EAgeBand::BelowCivilAge:
+        case EAgeBand::Adult:
+            Prediction.Status = ECheckStatus::Pass;
+            if (Policy.GetDefaults(Prediction.Band).bKnown)
+            {
+                Prediction.Defaults = &Policy.GetDefaults(Prediction.Band);
+            }
+            break;
+
+        case EAgeBand::Invalid:
+            break;
+        }
+        return Prediction;
+    }
+
+    const FJurisdictionPolicy* FPolicyBundle::Find(std::string_view Jurisdiction) const
+    {
+        const auto Found = std::lower_bound(Policies.begin(), Policies.end(), Jurisdiction, IsBefore);
+        return Found != Policies.end() && Found->Jurisdiction == Jurisdiction ? &*Found : nullptr;
+    }
+
+    FJurisdictionPolicy* FPolicyBundle::FindMutable(std::string_view Jurisdiction)
+    {
+        return const_cast<FJurisdictionPolicy*>(Find(Jurisdiction));
+    }
+
+    bool FPolicyBundle::SetRequirements(std::string_view Jurisdiction, bool bShouldDisplay, bool bAgeAssuranceRequired, const FAgeThresholds& Thresholds)
+    {
+        const FAgeThresholds Normalized = Thresholds.Normalized();
+
+        auto Found = std::lower_bound(Policies.begin(), Policies.end(), Jurisdiction, IsBefore);
+        if (Found == Policies.end() || Found->Jurisdiction != Jurisdiction)
+        {
+            Found = Policies.emplace(Found);
+            Found->Jurisdiction = std::string(Jurisdiction);
+        }
+        else if (Found->bShouldDisplay == bShouldDisplay && Found->bAgeAssuranceRequired == bAgeAssuranceRequired &&
+                    SameThresholds(Found->Thresholds, Normalized))
+        {
+            return false;
+        }
+
+        Found->bShouldDisplay = bShouldDisplay;
+        Found->bAgeAssuranceRequired = bAgeAssuranceRequired;
+        Found->Thresholds = Normalized;
+        for (FBandDefaults& Defaults : Found->Defaults)
+        {
+            Defaults = FBandDefaults();
+        }
+        ++Revision;
+        return true;
+    }
+
+    bool FPolicyBundle::SetDefaults(std::string_view Jurisdiction, EAgeBand Band, std::string_view AgeStatus, std::vector<FPermission> Permissions)
+    {
+        FJurisdictionPolicy* Policy = FindMutable(Jurisdiction);
+        if (!Policy || Band == EAgeBand::Invalid)
+        {
+            return false;
+        }
+
+        FBandDefaults& Defaults = Policy->Defaults[static_cast<size_t>(Band)];
+        if (Defaults.bKnown && Defaults.AgeStatus == AgeStatus && SamePermissions(Defaults.Permissions, Permissions))
+        {
+            return false;
+        }
+
+        Defaults.bKnown = true;
+        Defaults.AgeStatus = std::string(AgeStatus);
+        Defaults.Permissions = std::move(Permissions);
+        ++Revision;
+        return true;
+    }
+
+    bool FPolicyBundle::Remove(std::string_view Jurisdiction)
+    {
+        const auto Found = std::lower_bound(Policies.begin(), Policies.end(), Jurisdiction, IsBefore);
+        if (Found == Policies.end() || Found->Jurisdiction != Jurisdiction)
+        {
+            return false;
+        }
+
+        Policies.erase(Found);
+        ++Revision;
+        return true;
+    }
+
+    void FPolicyBundle::MergeMissing(const FPolicyBundle& Other)
+    {
+        for (const FJurisdictionPolicy& Policy : Other.Policies)
+        {
+            const auto Found = std::lower_bound(Policies.begin(), Policies.end(), Policy.Jurisdiction, IsBefore);
+            if (Found == Policies.end() || Found->Jurisdiction != Policy.Jurisdiction)
+            {
+                Policies.insert(Found, Policy);
+            }
+        }
+        Revision = std::max(Revision, Other.Revision);
+    }
+
+    void FPolicyBundle::Encode(std::vector<uint8_t>& Out) const
+    {
+        FStringTable Strings;
+        std::vector<uint8_t> Body;
+        for (const FJurisdictionPolicy& Policy : Policies)
+        {
+            WriteVarint(Body, Strings.Add(Policy.Jurisdiction));
+            Body.push_back(static_cast<uint8_t>((Policy.bShouldDisplay ? ShouldDisplayFlag : 0) |
+                        (Policy.bAgeAssuranceRequired ? AgeAssuranceRequiredFlag : 0)));
+            WriteVarint(Body, static_cast<uint64_t>(Policy.Thresholds.MinimumAge));
+            WriteVarint(Body, static_cast<uint64_t>(Policy.Thresholds.DigitalConsentAge));
+            WriteVarint(Body, static_cast<uint64_t>(Policy.Thresholds.CivilAge));
+
+            uint8_t KnownBands = 0;
+            for (size_t Band = 0; Band < NumAgeBands; ++Band)
+            {
+                KnownBands |= Policy.Defaults[Band].bKnown ? static_cast<uint8_t>(1 << Band) : 0;
+            }
+            Body.push_back(KnownBands);
+
+            for (const FBandDefaults& Defaults : Policy.Defaults)
+            {
+                if (!Defaults.bKnown)
+                {
+                    continue;
+                }
+
+                WriteVarint(Body, Strings.Add(Defaults.AgeStatus));
+                WriteVarint(Body, Defaults.Permissions.size());
+                for (const FPermission& Permission : Defaults.Permissions)
+                {
+                    WriteVarint(Body, Strings.Add(Permission.Name) << 1 | (Permission.bEnabled ? 1 : 0));
+                    WriteVarint(Body, Strings.Add(Permission.ManagedBy));
+                }
+            }
+        }
+
+        Out.assign(std::begin(Magic), std::end(Magic));
+        Out.push_back(FormatVersion);
+        WriteVarint(Out, Revision);
+        Strings.Write(Out);
+        WriteVarint(Out, Policies.size());
+        Out.insert(Out.end(), Body.begin(), Body.end());
+    }
+
+    bool FPolicyBundle::Decode(const uint8_t* Data, size_t Size)
+    {
+        if (!Data || Size < sizeof(Magic) + 1 || !std::equal(std::begin(Magic), std::end(Magic), Data) || Data[sizeof(Magic)] != FormatVersion)
+        {
+            return false;
+        }
+
+        FBlobReader Reader(Data + sizeof(Magic) + 1, Size - sizeof(Magic) - 1);
+        uint64_t DecodedRevision = 0;
+        size_t NumStrings = 0;
+        if (!Reader.ReadVarint(std::numeric_limits<uint32_t>::max(), DecodedRevision) || !Reader.ReadCount(1, NumStrings))
+        {
+            return false;
+        }
+
+        std::vector<std::string> Strings(NumStrings);
+        for (std::string& Text : Strings)
+        {
+            uint64_t Length = 0;
+            if (!Reader.ReadVarint(Reader.GetRemaining(), Length) || !Reader.ReadBytes(static_cast<size_t>(Length), Text))
+            {
+                return false;
+            }
+        }
+
+        // each policy takes at least its jurisdiction, flags, three ages and its band mask
+        size_t NumPolicies = 0;
+        if (!Reader.ReadCount(6, NumPolicies))
+        {
+            return false;
+        }
+
+        std::vector<FJurisdictionPolicy> DecodedPolicies(NumPolicies);
+        for (size_t Index = 0; Index < NumPolicies; ++Index)
+        {
+            FJurisdictionPolicy& Policy = DecodedPolicies[Index];
+            uint8_t Flags = 0;
+            uint64_t Ages[3] = {};
+            uint8_t KnownBands = 0;
+            if (!Reader.ReadString(Strings, Policy.Jurisdiction) || !Reader.ReadByte(Flags) ||
+                (Flags & ~(ShouldDisplayFlag | AgeAssuranceRequiredFlag)) != 0 ||
+                !Reader.ReadVarint(MaxThresholdAge, Ages[0]) || !Reader.ReadVarint(MaxThresholdAge, Ages[1]) ||
+                !Reader.ReadVarint(MaxThresholdAge, Ages[2]) || !Reader.ReadByte(KnownBands) || (KnownBands >> NumAgeBands) != 0)
+            {
+                return false;
+            }
+
+            // the lookup relies on the policies being sorted, and a jurisdiction appearing once
+            if (Index > 0 && !(DecodedPolicies[Index - 1].Jurisdiction < Policy.Jurisdiction))
+            {
+                return false;
+            }
+
+            Policy.bShouldDisplay = (Flags & ShouldDisplayFlag) != 0;
+            Policy.bAgeAssuranceRequired = (Flags & AgeAssuranceRequiredFlag) != 0;
+            Policy.Thresholds = FAgeThresholds{ static_cast<int32_t>(Ages[0]), static_cast<int32_t>(Ages[1]),
+                        static_cast<int32_t>(Ages[2]) }.Normalized();
+
+            for (size_t Band = 0; Band < NumAgeBands; ++Band)
+            {
+                if ((KnownBands & (1 << Band)) == 0)
+                {
+                    continue;
+                }
+
+                FBandDefaults& Defaults = Policy.Defaults[Band];
+                size_t NumPermissions = 0;
+                if (!Reader.ReadString(Strings, Defaults.AgeStatus) || !Reader.ReadCount(2, NumPermissions))
+                {
+                    return false;
+                }
+
+                Defaults.bKnown = true;
+                Defaults.Permissions.resize(NumPermissions);
+                for (FPermission& Permission : Defaults.Permissions)
+                {
+                    uint64_t NameAndEnabled = 0;
+                    if (!Reader.ReadVarint(NameAndEnabled) || (NameAndEnabled >> 1) >= Strings.size() ||
+                        !Reader.ReadString(Strings, Permission.ManagedBy))
+                    {
+                        return false;
+                    }
+                    Permission.Name = Strings[static_cast<size_t>(NameAndEnabled >> 1)];
+                    Permission.bEnabled = (NameAndEnabled & 1) != 0;
+                }
+            }
+        }
+
+        if (!Reader.IsAtEnd())
+        {
+            return false;
+        }
+
+        Revision = static_cast<uint32_t>(DecodedRevision);
+        Policies = std::move(DecodedPolicies);
+        return true;
+    }
+}
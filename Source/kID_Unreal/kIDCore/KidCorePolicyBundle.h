@@ -0,0 +1,88 @@
+#pragma once
+
+#include "KidCorePolicy.h"
+#include "KidCoreSession.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// The age gate policy of every jurisdiction the game has seen, kept so the outcome of the age gate
+// can be predicted without waiting on the network.  Whether a player passes, needs a challenge or
+// is prohibited follows from the jurisdiction's thresholds and the player's age band, and players
+// who pass start with the default permissions of their band.  Thresholds come from
+// /age-gate/get-requirements; defaults are learned from /age-gate/get-default-permissions and from
+// the sessions /age-gate/check returns, which also confirm every prediction.
+namespace KidCore
+{
+    constexpr size_t NumAgeBands = static_cast<size_t>(EAgeBand::Adult) + 1;
+
+    // What a player of one age band starts with after passing /age-gate/check
+    struct FBandDefaults
+    {
+        bool bKnown = false;
+        std::string AgeStatus;
+        std::vector<FPermission> Permissions;
+    };
+
+    struct FJurisdictionPolicy
+    {
+        std::string Jurisdiction;
+        bool bShouldDisplay = false;
+        bool bAgeAssuranceRequired = false;
+        FAgeThresholds Thresholds;
+        FBandDefaults Defaults[NumAgeBands];
+
+        const FBandDefaults& GetDefaults(EAgeBand Band) const { return Defaults[static_cast<size_t>(Band)]; }
+    };
+
+    struct FPolicyPrediction
+    {
+        // Unknown when only the server can tell, e.g. the player is going through age assurance
+        ECheckStatus Status = ECheckStatus::Unknown;
+        EAgeBand Band = EAgeBand::Invalid;
+
+        // set for a pass whose defaults have been learned
+        const FBandDefaults* Defaults = nullptr;
+    };
+
+    FPolicyPrediction PredictCheck(const FJurisdictionPolicy& Policy, int32_t Age);
+
+    // The policies, stored as a compact binary blob: a header, a table of every distinct string,
+    // then each policy with its strings as indices into the table, all integers as varints.  The
+    // revision goes up whenever a policy changes, so two copies can be told apart.
+    class FPolicyBundle
+    {
+    public:
+        // blobs of any other format version are rejected, and the bundle is learned again
+        static constexpr uint8_t FormatVersion = 1;
+
+        uint32_t GetRevision() const { return Revision; }
+        size_t Num() const { return Policies.size(); }
+        const FJurisdictionPolicy* Find(std::string_view Jurisdiction) const;
+
+        // Each returns whether the bundle changed.  New thresholds move the age bands, so they
+        // forget the defaults learned for the old ones.
+        bool SetRequirements(std::string_view Jurisdiction, bool bShouldDisplay, bool bAgeAssuranceRequired, const FAgeThresholds& Thresholds);
+        bool SetDefaults(std::string_view Jurisdiction, EAgeBand Band, std::string_view AgeStatus, std::vector<FPermission> Permissions);
+        bool Remove(std::string_view Jurisdiction);
+
+        // keeps the policies already here and takes the rest from Other
+        void MergeMissing(const FPolicyBundle& Other);
+
+        void Encode(std::vector<uint8_t>& Out) const;
+
+        // Accepts any bytes.  Leaves the bundle untouched and returns false unless the whole blob
+        // is a valid bundle of this format version.
+        bool Decode(const uint8_t* Data, size_t Size);
+
+    private:
+        FJurisdictionPolicy* FindMutable(std::string_view Jurisdiction);
+
+        uint32_t Revision = 0;
+
+        // sorted by jurisdiction
+        std::vector<FJurisdictionPolicy> Policies;
+    };
+}
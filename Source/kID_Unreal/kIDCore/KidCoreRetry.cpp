@@ -0,0 +1,72 @@
+#include "KidCoreRetry.h"
+#include <algorithm>
+#include <cmath>
+
+namespace KidCore
+{
+    FRetryDecision FRetryPolicy::Decide(bool bHasResponse, int32_t ResponseCode, std::string_view RetryAfter, int32_t RetriesLeft) const
+    {
+        FRetryDecision Decision;
+        if (!bHasResponse)
+        {
+            return Decision;
+        }
+
+        if (ResponseCode == 200 || ResponseCode == 304)
+        {
+            Decision.Action = ERetryAction::Succeed;
+        }
+        else if (ResponseCode == 429 && RetriesLeft > 0)
+        {
+            const float RetryAfterSeconds = ParseRetryAfterSeconds(RetryAfter);
+            Decision.Action = ERetryAction::Retry;
+            Decision.DelaySeconds = RetryAfterSeconds > 0.0f ? RetryAfterSeconds : DefaultRetryDelaySeconds;
+        }
+        return Decision;
+    }
+
+    float ParseRetryAfterSeconds(std::string_view RetryAfter)
+    {
+        size_t Position = 0;
+        while (Position < RetryAfter.size() && RetryAfter[Position] == ' ')
+        {
+            ++Position;
+        }
+
+        double Seconds = 0.0;
+        bool bHasDigits = false;
+        while (Position < RetryAfter.size() && RetryAfter[Position] >= '0' && RetryAfter[Position] <= '9')
+        {
+            Seconds = Seconds * 10.0 + (RetryAfter[Position++] - '0');
+            bHasDigits = true;
+        }
+        if (Position < RetryAfter.size() && RetryAfter[Position] == '.')
+        {
+            double Scale = 0.1;
+            for (++Position; Position < RetryAfter.size() && RetryAfter[Position] >= '0' && RetryAfter[Position] <= '9'; ++Position)
+            {
+                Seconds += (RetryAfter[Position] - '0') * Scale;
+                Scale *= 0.1;
+                bHasDigits = true;
+            }
+        }
+
+        // a date such as "Wed, 21 Oct 2015 07:28:00 GMT" stops at the first letter
+        while (Position < RetryAfter.size() && RetryAfter[Position] == ' ')
+        {
+            ++Position;
+        }
+        if (!bHasDigits || Position != RetryAfter.size())
+        {
+            return 0.0f;
+        }
+        return static_cast<float>(std::min(Seconds, 86400.0));
+    }
+
+    float GetBackoffDelay(float InitialSeconds, float MaxSeconds, int32_t ConsecutiveErrors, float Random)
+    {
+        const float Exponent = static_cast<float>(std::max(ConsecutiveErrors - 1, 0));
+        const float Backoff = std::min(InitialSeconds * std::pow(2.0f, std::min(Exponent, 30.0f)), MaxSeconds);
+        return Backoff * (0.5f + 0.5f * std::clamp(Random, 0.0f, 1.0f));
+    }
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+// When a kID request is retried, and after how long.  The engine side owns the timers and the
+// requests, and asks here what to do with each response.
+namespace KidCore
+{
+    enum class ERetryAction : uint8_t
+    {
+        Succeed,
+        Retry,
+        Fail,
+    };
+
+    struct FRetryDecision
+    {
+        ERetryAction Action = ERetryAction::Fail;
+        float DelaySeconds = 0.0f;
+    };
+
+    struct FRetryPolicy
+    {
+        int32_t MaxRetries = 3;
+
+        // used for 429 responses without a usable Retry-After
+        float DefaultRetryDelaySeconds = 5.0f;
+
+        // 200 and 304 succeed, 429 is retried after Retry-After seconds while retries are left, and
+        // anything else, including no response at all, fails.
+        FRetryDecision Decide(bool bHasResponse, int32_t ResponseCode, std::string_view RetryAfter, int32_t RetriesLeft) const;
+    };
+
+    // Delta-seconds form of Retry-After; zero for the HTTP-date form or anything unparseable
+    float ParseRetryAfterSeconds(std::string_view RetryAfter);
+
+    // Exponential backoff after ConsecutiveErrors failures in a row, capped at MaxSeconds and
+    // scaled into [0.5, 1] of itself by Random, a uniform number in [0, 1].
+    float GetBackoffDelay(float InitialSeconds, float MaxSeconds, int32_t ConsecutiveErrors, float Random);
+}
@@ -0,0 +1,435 @@
+#include "KidCoreSession.h"
+#include "KidCoreJson.h"
+#include <limits>
+
+namespace KidCore
+{
+    namespace
+    {
+        // Calls OnMember(Token) for each member of the object just begun, with the member's name in
+        // Reader.GetKey().  OnMember must consume the whole value, e.g. with SkipValue.
+        template <typename MemberFunc>
+        bool ReadMembers(FJsonReader& Reader, MemberFunc&& OnMember)
+        {
+            for (;;)
+            {
+                const EJsonToken Token = Reader.Next();
+                if (Token == EJsonToken::EndObject)
+                {
+                    return true;
+                }
+                if (Token == EJsonToken::Error || Token == EJsonToken::None || Token == EJsonToken::EndArray)
+                {
+                    return false;
+                }
+                if (!OnMember(Token))
+                {
+                    return false;
+                }
+            }
+        }
+
+        template <typename MemberFunc>
+        bool ReadRootObject(std::string_view Json, MemberFunc&& OnMember)
+        {
+            FJsonReader Reader(Json);
+            return Reader.Next() == EJsonToken::BeginObject
+                && ReadMembers(Reader, [&Reader, &OnMember](EJsonToken Token) { return OnMember(Reader, Token); })
+                && Reader.Next() == EJsonToken::None;
+        }
+
+        // strings are handed to the visitor, anything else is skipped
+        bool ReadString(FJsonReader& Reader, EJsonToken Token, IResponseVisitor& Visitor, EResponseField Field)
+        {
+            if (Token == EJsonToken::String)
+            {
+                Visitor.String(Field, Reader.GetString());
+                return true;
+            }
+            return Reader.SkipValue(Token);
+        }
+
+        // booleans and numbers are handed over when they have that type, anything else is skipped
+        bool ReadBool(FJsonReader& Reader, EJsonToken Token, IResponseVisitor& Visitor, EResponseField Field)
+        {
+            if (Token == EJsonToken::True || Token == EJsonToken::False)
+            {
+                Visitor.Bool(Field, Token == EJsonToken::True);
+                return true;
+            }
+            return Reader.SkipValue(Token);
+        }
+
+        bool ReadInt(FJsonReader& Reader, EJsonToken Token, IResponseVisitor& Visitor, EResponseField Field)
+        {
+            if (Token == EJsonToken::Number)
+            {
+                // out of range, including NaN, reads as zero rather than being undefined
+                const double Number = Reader.GetNumber();
+                Visitor.Integer(Field, Number >= std::numeric_limits<int32_t>::min() && Number <= std::numeric_limits<int32_t>::max() ? static_cast<int32_t>(Number) : 0);
+                return true;
+            }
+            return Reader.SkipValue(Token);
+        }
+
+        // Calls OnElement(Token) for each element of the array the token begins, or skips a value
+        // that is not an array.  OnElement must consume the whole element.
+        template <typename ElementFunc>
+        bool ReadArray(FJsonReader& Reader, EJsonToken Token, ElementFunc&& OnElement)
+        {
+            if (Token != EJsonToken::BeginArray)
+            {
+                return Reader.SkipValue(Token);
+            }
+
+            for (;;)
+            {
+                const EJsonToken ElementToken = Reader.Next();
+                if (ElementToken == EJsonToken::EndArray)
+                {
+                    return true;
+                }
+                if (ElementToken == EJsonToken::Error || ElementToken == EJsonToken::None)
+                {
+                    return false;
+                }
+                if (!OnElement(ElementToken))
+                {
+                    return false;
+                }
+            }
+        }
+
+        bool ReadPermissions(FJsonReader& Reader, EJsonToken Token, IResponseVisitor& Visitor)
+        {
+            return ReadArray(Reader, Token, [&Reader, &Visitor](EJsonToken ElementToken)
+            {
+                if (ElementToken != EJsonToken::BeginObject)
+                {
+                    return Reader.SkipValue(ElementToken);
+                }
+
+                Visitor.BeginPermission();
+                bool bHasName = false;
+                const bool bRead = ReadMembers(Reader, [&Reader, &Visitor, &bHasName](EJsonToken MemberToken)
+                {
+                    const std::string_view Field = Reader.GetKey();
+                    if (Field == "name")
+                    {
+                        bHasName = MemberToken == EJsonToken::String && !Reader.GetString().empty();
+                        return ReadString(Reader, MemberToken, Visitor, EResponseField::PermissionName);
+                    }
+                    if (Field == "managedBy")
+                    {
+                        return ReadString(Reader, MemberToken, Visitor, EResponseField::PermissionManagedBy);
+                    }
+                    if (Field == "enabled")
+                    {
+                        Visitor.Bool(EResponseField::PermissionEnabled, MemberToken == EJsonToken::True);
+                    }
+                    return Reader.SkipValue(MemberToken);
+                });
+                Visitor.EndPermission(bRead && bHasName);
+                return bRead;
+            });
+        }
+
+        bool ReadSession(FJsonReader& Reader, EJsonToken Token, IResponseVisitor& Visitor)
+        {
+            if (Token != EJsonToken::BeginObject)
+            {
+                return Reader.SkipValue(Token);
+            }
+
+            return ReadMembers(Reader, [&Reader, &Visitor](EJsonToken MemberToken)
+            {
+                const std::string_view Field = Reader.GetKey();
+                if (Field == "sessionId")
+                {
+                    return ReadString(Reader, MemberToken, Visitor, EResponseField::SessionId);
+                }
+                if (Field == "etag")
+                {
+                    return ReadString(Reader, MemberToken, Visitor, EResponseField::ETag);
+                }
+                if (Field == "ageStatus")
+                {
+                    return ReadString(Reader, MemberToken, Visitor, EResponseField::AgeStatus);
+                }
+                if (Field == "jurisdiction")
+                {
+                    return ReadString(Reader, MemberToken, Visitor, EResponseField::Jurisdiction);
+                }
+                if (Field == "permissions")
+                {
+                    return ReadPermissions(Reader, MemberToken, Visitor);
+                }
+                return Reader.SkipValue(MemberToken);
+            });
+        }
+
+        void Assign(std::string& Out, std::string_view Value)
+        {
+            Out.assign(Value.data(), Value.size());
+        }
+
+        // Fills in the core's own structs, for the benchmarks and code that works on std::string
+        class FSessionVisitor final : public IResponseVisitor
+        {
+        public:
+            explicit FSessionVisitor(FSession& InSession)
+                : Session(InSession)
+            {
+            }
+
+            virtual void String(EResponseField Field, std::string_view Value) override
+            {
+                switch (Field)
+                {
+                case EResponseField::SessionId:           Assign(Session.SessionId, Value); break;
+                case EResponseField::ETag:                Assign(Session.ETag, Value); break;
+                case EResponseField::AgeStatus:           Assign(Session.AgeStatus, Value); break;
+                case EResponseField::Jurisdiction:        Assign(Session.Jurisdiction, Value); break;
+                case EResponseField::PermissionName:      Assign(Session.Permissions.back().Name, Value); break;
+                case EResponseField::PermissionManagedBy: Assign(Session.Permissions.back().ManagedBy, Value); break;
+                default: break;
+                }
+            }
+
+            virtual void Bool(EResponseField Field, bool bValue) override
+            {
+                if (Field == EResponseField::PermissionEnabled)
+                {
+                    Session.Permissions.back().bEnabled = bValue;
+                }
+            }
+
+            virtual void BeginPermission() override
+            {
+                Session.Permissions.emplace_back();
+            }
+
+            virtual void EndPermission(bool bHasName) override
+            {
+                if (!bHasName)
+                {
+                    Session.Permissions.pop_back();
+                }
+            }
+
+        private:
+            FSession& Session;
+        };
+
+        class FChallengeStatusVisitor final : public IResponseVisitor
+        {
+        public:
+            explicit FChallengeStatusVisitor(FChallengeStatus& InStatus)
+                : Status(InStatus)
+            {
+            }
+
+            virtual void String(EResponseField Field, std::string_view Value) override
+            {
+                switch (Field)
+                {
+                case EResponseField::ChallengeId:   Assign(Status.ChallengeId, Value); break;
+                case EResponseField::Status:        Assign(Status.Status, Value); break;
+                case EResponseField::SessionId:     Assign(Status.SessionId, Value); break;
+                case EResponseField::ApproverEmail: Assign(Status.ApproverEmail, Value); break;
+                default: break;
+                }
+            }
+
+        private:
+            FChallengeStatus& Status;
+        };
+
+        class FRequirementsVisitor final : public IResponseVisitor
+        {
+        public:
+            explicit FRequirementsVisitor(FRequirements& InRequirements)
+                : Requirements(InRequirements)
+            {
+            }
+
+            virtual void String(EResponseField Field, std::string_view Value) override
+            {
+                if (Field == EResponseField::ApprovedAgeCollectionMethod)
+                {
+                    Requirements.ApprovedAgeCollectionMethods.emplace_back(Value);
+                }
+            }
+
+            virtual void Bool(EResponseField Field, bool bValue) override
+            {
+                switch (Field)
+                {
+                case EResponseField::ShouldDisplay:        Requirements.bShouldDisplay = bValue; break;
+                case EResponseField::AgeAssuranceRequired: Requirements.bAgeAssuranceRequired = bValue; break;
+                default: break;
+                }
+            }
+
+            virtual void Integer(EResponseField Field, int32_t Value) override
+            {
+                switch (Field)
+                {
+                case EResponseField::MinimumAge:        Requirements.Thresholds.MinimumAge = Value; break;
+                case EResponseField::DigitalConsentAge: Requirements.Thresholds.DigitalConsentAge = Value; break;
+                case EResponseField::CivilAge:          Requirements.Thresholds.CivilAge = Value; break;
+                default: break;
+                }
+            }
+
+        private:
+            FRequirements& Requirements;
+        };
+    }
+
+    const FPermission* FSession::FindPermission(std::string_view Name) const
+    {
+        for (const FPermission& Permission : Permissions)
+        {
+            if (Permission.Name == Name)
+            {
+                return &Permission;
+            }
+        }
+        return nullptr;
+    }
+
+    std::vector<FPermissionChange> DiffPermissions(const std::vector<FPermission>& OldPermissions,
+                const std::vector<FPermission>& NewPermissions)
+    {
+        // sessions carry a handful of permissions, so linear lookups beat building a map
+        std::vector<FPermissionChange> Changes;
+        std::vector<bool> OldMatched(OldPermissions.size(), false);
+
+        for (const FPermission& New : NewPermissions)
+        {
+            const FPermission* Old = nullptr;
+            for (size_t OldIndex = 0; OldIndex < OldPermissions.size(); ++OldIndex)
+            {
+                if (OldPermissions[OldIndex].Name == New.Name)
+                {
+                    Old = &OldPermissions[OldIndex];
+                    OldMatched[OldIndex] = true;
+                    break;
+                }
+            }
+            if (Old && Old->bEnabled == New.bEnabled && Old->ManagedBy == New.ManagedBy)
+            {
+                continue;
+            }
+
+            FPermissionChange& Change = Changes.emplace_back();
+            Change.Name = New.Name;
+            Change.bWasEnabled = Old && Old->bEnabled;
+            Change.bEnabled = New.bEnabled;
+            Change.PreviousManagedBy = Old ? Old->ManagedBy : std::string();
+            Change.ManagedBy = New.ManagedBy;
+        }
+
+        for (size_t OldIndex = 0; OldIndex < OldPermissions.size(); ++OldIndex)
+        {
+            if (!OldMatched[OldIndex])
+            {
+                FPermissionChange& Change = Changes.emplace_back();
+                Change.Name = OldPermissions[OldIndex].Name;
+                Change.bWasEnabled = OldPermissions[OldIndex].bEnabled;
+                Change.PreviousManagedBy = OldPermissions[OldIndex].ManagedBy;
+            }
+        }
+        return Changes;
+    }
+
+    bool DecodeSession(std::string_view Json, IResponseVisitor& Visitor)
+    {
+        FJsonReader Reader(Json);
+        return Reader.Next() == EJsonToken::BeginObject
+            && ReadSession(Reader, EJsonToken::BeginObject, Visitor)
+            && Reader.Next() == EJsonToken::None;
+    }
+
+    bool DecodeChallengeStatus(std::string_view Json, IResponseVisitor& Visitor)
+    {
+        return ReadRootObject(Json, [&Visitor](FJsonReader& Reader, EJsonToken Token)
+        {
+            const std::string_view Field = Reader.GetKey();
+            if (Field == "challengeId")
+            {
+                return ReadString(Reader, Token, Visitor, EResponseField::ChallengeId);
+            }
+            if (Field == "status")
+            {
+                return ReadString(Reader, Token, Visitor, EResponseField::Status);
+            }
+            if (Field == "sessionId")
+            {
+                return ReadString(Reader, Token, Visitor, EResponseField::SessionId);
+            }
+            if (Field == "approverEmail")
+            {
+                return ReadString(Reader, Token, Visitor, EResponseField::ApproverEmail);
+            }
+            return Reader.SkipValue(Token);
+        });
+    }
+
+    bool DecodeRequirements(std::string_view Json, IResponseVisitor& Visitor)
+    {
+        return ReadRootObject(Json, [&Visitor](FJsonReader& Reader, EJsonToken Token)
+        {
+            const std::string_view Field = Reader.GetKey();
+            if (Field == "shouldDisplay")
+            {
+                return ReadBool(Reader, Token, Visitor, EResponseField::ShouldDisplay);
+            }
+            if (Field == "ageAssuranceRequired")
+            {
+                return ReadBool(Reader, Token, Visitor, EResponseField::AgeAssuranceRequired);
+            }
+            if (Field == "minimumAge")
+            {
+                return ReadInt(Reader, Token, Visitor, EResponseField::MinimumAge);
+            }
+            if (Field == "digitalConsentAge")
+            {
+                return ReadInt(Reader, Token, Visitor, EResponseField::DigitalConsentAge);
+            }
+            if (Field == "civilAge")
+            {
+                return ReadInt(Reader, Token, Visitor, EResponseField::CivilAge);
+            }
+            if (Field == "approvedAgeCollectionMethods")
+            {
+                return ReadArray(Reader, Token, [&Reader, &Visitor](EJsonToken ElementToken)
+                {
+                    return ReadString(Reader, ElementToken, Visitor, EResponseField::ApprovedAgeCollectionMethod);
+                });
+            }
+            return Reader.SkipValue(Token);
+        });
+    }
+
+    bool DecodeSession(std::string_view Json, FSession& OutSession)
+    {
+        OutSession.Permissions.clear();
+        FSessionVisitor Visitor(OutSession);
+        return DecodeSession(Json, Visitor);
+    }
+
+    bool DecodeChallengeStatus(std::string_view Json, FChallengeStatus& OutStatus)
+    {
+        FChallengeStatusVisitor Visitor(OutStatus);
+        return DecodeChallengeStatus(Json, Visitor);
+    }
+
+    bool DecodeRequirements(std::string_view Json, FRequirements& OutRequirements)
+    {
+        OutRequirements.ApprovedAgeCollectionMethods.clear();
+        FRequirementsVisitor Visitor(OutRequirements);
+        return DecodeRequirements(Json, Visitor);
+    }
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "KidCorePolicy.h"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// The kID session model and the responses the client reads, decoded from UTF-8 JSON.  Decoding
+// accepts any bytes, and unknown fields are skipped, so these are safe to fuzz.
+namespace KidCore
+{
+    struct FPermission
+    {
+        std::string Name;
+        bool bEnabled = false;
+        std::string ManagedBy;
+    };
+
+    struct FSession
+    {
+        std::string SessionId;
+        std::string ETag;
+        std::string AgeStatus;
+        std::string Jurisdiction;
+        std::vector<FPermission> Permissions;
+
+        const FPermission* FindPermission(std::string_view Name) const;
+    };
+
+    // One permission whose state differs between two sessions.  A permission missing from a
+    // session counts as disabled and not managed by anyone.
+    struct FPermissionChange
+    {
+        std::string Name;
+        bool bWasEnabled = false;
+        bool bEnabled = false;
+        std::string PreviousManagedBy;
+        std::string ManagedBy;
+
+        bool IsEnabledChanged() const { return bWasEnabled != bEnabled; }
+    };
+
+    // Changes in the order the new permissions are listed, then any that were removed
+    std::vector<FPermissionChange> DiffPermissions(const std::vector<FPermission>& OldPermissions,
+                const std::vector<FPermission>& NewPermissions);
+
+    // /challenge/await and the push channel
+    struct FChallengeStatus
+    {
+        std::string ChallengeId;
+        std::string Status;
+        std::string SessionId;
+        std::string ApproverEmail;
+    };
+
+    // /age-gate/get-requirements
+    struct FRequirements
+    {
+        bool bShouldDisplay = false;
+        bool bAgeAssuranceRequired = false;
+        FAgeThresholds Thresholds;
+        std::vector<std::string> ApprovedAgeCollectionMethods;
+    };
+
+    // The fields of the responses above, as a visitor is handed them
+    enum class EResponseField : uint8_t
+    {
+        SessionId,
+        ETag,
+        AgeStatus,
+        Jurisdiction,
+        ChallengeId,
+        Status,
+        ApproverEmail,
+        ShouldDisplay,
+        AgeAssuranceRequired,
+        MinimumAge,
+        DigitalConsentAge,
+        CivilAge,
+        ApprovedAgeCollectionMethod,    // once per method
+        PermissionName,                 // the fields of the permission BeginPermission began
+        PermissionEnabled,
+        PermissionManagedBy,
+    };
+
+    // Receives the fields of a response in document order as it is decoded.  Strings are views into
+    // the document, or into the reader's buffer when they had escapes, and are only valid during
+    // the call, so a caller that keeps them as another string type converts each one once instead
+    // of going through std::string.
+    class IResponseVisitor
+    {
+    public:
+        virtual ~IResponseVisitor() = default;
+
+        virtual void String(EResponseField /*Field*/, std::string_view /*Value*/) {}
+        virtual void Bool(EResponseField /*Field*/, bool /*bValue*/) {}
+        virtual void Integer(EResponseField /*Field*/, int32_t /*Value*/) {}
+
+        // a permission without a name cannot be looked up, and is dropped when bHasName is false
+        virtual void BeginPermission() {}
+        virtual void EndPermission(bool /*bHasName*/) {}
+    };
+
+    // Each returns false for malformed JSON or a root that is not an object, leaving the output
+    // partly filled in.
+    bool DecodeSession(std::string_view Json, IResponseVisitor& Visitor);
+    bool DecodeChallengeStatus(std::string_view Json, IResponseVisitor& Visitor);
+    bool DecodeRequirements(std::string_view Json, IResponseVisitor& Visitor);
+
+    // the same, into the structs above
+    bool DecodeSession(std::string_view Json, FSession& OutSession);
+    bool DecodeChallengeStatus(std::string_view Json, FChallengeStatus& OutStatus);
+    bool DecodeRequirements(std::string_view Json, FRequirements& OutRequirements);
+}
@@ -1,5 +1,6 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
+using System.IO;
 using UnrealBuildTool;
 
 public class kID_Unreal : ModuleRules
@@ -9,7 +10,10 @@ public class kID_Unreal : ModuleRules
 		PCHUsage = PCHUsageMode.UseExplicitOrSharedPCHs;
 
 		PublicDependencyModuleNames.AddRange(new string[] { "UMG", "Core", "Json", "HTTP", "NetCommon", "NetCore", "CoreUObject", 
-						"Engine", "InputCore", "EnhancedInput", "Sockets", "Networking", "UnrealEd" });
+						"Engine", "InputCore", "EnhancedInput", "Sockets", "Networking", "UnrealEd", "WebSockets" });
 		PrivateDependencyModuleNames.AddRange(new string[] { "Slate", "SlateCore" });
+
+		// engine-agnostic kID core, also built on its own by Tools/kIDCore
+		PublicIncludePaths.Add(Path.Combine(ModuleDirectory, "kIDCore"));
 	}
 }
@@ -0,0 +1,328 @@
+#include "KidCoreFlowState.h"
+#include "KidCoreJson.h"
+#include "KidCorePolicy.h"
+#include "KidCorePolicyBundle.h"
+#include "KidCoreRetry.h"
+#include "KidCoreSession.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+// Microbenchmarks of the engine-agnostic kID core, the native counterpart of the kid.Benchmark.*
+// console commands.  Each benchmark checks its own result, and the exit code is non-zero if any
+// result is wrong.
+//
+//   KidCoreBenchmark [Scale=1]
+namespace
+{
+    // keeps results observable so the optimizer cannot drop the work
+    volatile size_t Sink = 0;
+    int32_t NumFailures = 0;
+
+    template <typename WorkFunc>
+    void Measure(const char* Name, int32_t NumIterations, WorkFunc&& Work)
+    {
+        const auto Start = std::chrono::steady_clock::now();
+        for (int32_t Iteration = 0; Iteration < NumIterations; ++Iteration)
+        {
+            Work();
+        }
+        const double Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();
+        std::printf("  %-28s %10.1f ns per iteration, %d iterations\n", Name, Seconds * 1e9 / NumIterations, NumIterations);
+    }
+
+    void Expect(bool bCondition, const char* What)
+    {
+        if (!bCondition)
+        {
+            std::printf("  FAILED: %s\n", What);
+            NumFailures++;
+        }
+    }
+
+    std::string MakeSessionJson(int32_t NumPermissions, int32_t DisabledEvery)
+    {
+        std::string Json = "{\"sessionId\":\"6d1f9a52-4c4e-4b0c-8a43-1f0e5b3c2d71\",\"etag\":\"W/\\\"42\\\"\","
+                    "\"status\":\"ACTIVE\",\"ageStatus\":\"LEGAL_ADULT\",\"jurisdiction\":\"US-CA\",\"dateOfBirth\":\"2012-05-17\","
+                    "\"player\":{\"displayName\":\"Player\",\"links\":[{\"rel\":\"self\",\"href\":\"/session/get\"}]},"
+                    "\"permissions\":[";
+        for (int32_t Index = 0; Index < NumPermissions; ++Index)
+        {
+            char Permission[160];
+            std::snprintf(Permission, sizeof(Permission), "%s{\"name\":\"feature-%d\",\"enabled\":%s,\"managedBy\":\"%s\",\"description\":\"Permission %d\"}",
+                        Index > 0 ? "," : "", Index, Index % DisabledEvery != 0 ? "true" : "false", Index % 2 == 0 ? "GUARDIAN" : "PLAYER", Index);
+            Json += Permission;
+        }
+        Json += "]}";
+        return Json;
+    }
+
+    void BenchmarkAgePolicy(int32_t Scale)
+    {
+        std::vector<std::string> Dates;
+        for (int32_t Index = 0; Index < 4096; ++Index)
+        {
+            char Date[16];
+            std::snprintf(Date, sizeof(Date), "%04d-%02d-%02d", 1950 + Index % 70, 1 + Index % 12, 1 + Index % 28);
+            Dates.push_back(Date);
+        }
+
+        const KidCore::FAgeThresholds Thresholds = KidCore::FAgeThresholds{ 7, 13, 18 }.Normalized();
+        const KidCore::FDate Today{ 2025, 6, 15 };
+        int32_t NumAdults = 0;
+        Measure("ParseDate + ClassifyAge", 200 * Scale, [&]()
+        {
+            NumAdults = 0;
+            for (const std::string& Text : Dates)
+            {
+                KidCore::FDate Date;
+                if (KidCore::ParseDate(Text, Date))
+                {
+                    NumAdults += KidCore::ClassifyAge(KidCore::CalculateAge(Date, Today), Thresholds) == KidCore::EAgeBand::Adult;
+                }
+            }
+            Sink = Sink + NumAdults;
+        });
+
+        KidCore::FDate Date;
+        Expect(KidCore::ParseDate("2010.05.01-00.00.00", Date) && Date.Year == 2010 && Date.Month == 5 && Date.Day == 1, "ParseDate with a time");
+        Expect(!KidCore::ParseDate("2011-02-29", Date), "ParseDate rejects 29 February outside leap years");
+        Expect(KidCore::CalculateAge({ 2007, 6, 16 }, Today) == 17, "CalculateAge before the birthday");
+        Expect(NumAdults > 0 && NumAdults < static_cast<int32_t>(Dates.size()), "ClassifyAge finds adults and minors");
+    }
+
+    void BenchmarkSessionDecode(int32_t Scale)
+    {
+        const std::string Json = MakeSessionJson(1000, 3);
+        KidCore::FSession Session;
+        bool bDecoded = true;
+        Measure("DecodeSession, 1000 perms", 50 * Scale, [&]()
+        {
+            bDecoded &= KidCore::DecodeSession(Json, Session);
+            Sink = Sink + Session.Permissions.size();
+        });
+
+        Expect(bDecoded && Session.Permissions.size() == 1000 && Session.ETag == "W/\"42\"", "DecodeSession reads every permission");
+        Expect(Session.FindPermission("feature-3") && !Session.FindPermission("feature-3")->bEnabled, "DecodeSession reads enabled");
+
+        KidCore::FChallengeStatus Status;
+        const std::string StatusJson = "{\"challengeId\":\"c-1\",\"status\":\"PASS\",\"sessionId\":\"s-1\",\"approverEmail\":\"parent@example.com\"}";
+        Measure("DecodeChallengeStatus", 100000 * Scale, [&]()
+        {
+            KidCore::DecodeChallengeStatus(StatusJson, Status);
+            Sink = Sink + Status.Status.size();
+        });
+        Expect(Status.Status == "PASS" && Status.ApproverEmail == "parent@example.com", "DecodeChallengeStatus");
+
+        KidCore::FRequirements Requirements;
+        const std::string RequirementsJson = "{\"shouldDisplay\":true,\"ageAssuranceRequired\":false,\"digitalConsentAge\":14,"
+                    "\"civilAge\":19,\"minimumAge\":0,\"approvedAgeCollectionMethods\":[\"date-of-birth\",7,\"age-slider\"],\"extra\":{\"a\":[1]}}";
+        Expect(KidCore::DecodeRequirements(RequirementsJson, Requirements) && Requirements.bShouldDisplay && !Requirements.bAgeAssuranceRequired &&
+                    Requirements.Thresholds.DigitalConsentAge == 14 && Requirements.Thresholds.CivilAge == 19 &&
+                    Requirements.ApprovedAgeCollectionMethods.size() == 2 && Requirements.ApprovedAgeCollectionMethods[1] == "age-slider",
+                    "DecodeRequirements");
+        Expect(KidCore::DecodeRequirements("{\"civilAge\":1e300}", Requirements) && Requirements.Thresholds.CivilAge == 0,
+                    "DecodeRequirements reads out of range ages as zero");
+
+        KidCore::FSession Malformed;
+        Expect(!KidCore::DecodeSession("{\"permissions\":[{\"name\":\"a\",}]}", Malformed), "DecodeSession rejects a trailing comma");
+        Expect(!KidCore::DecodeSession("[]", Malformed), "DecodeSession rejects a root that is not an object");
+
+        KidCore::FSession Unnamed;
+        Expect(KidCore::DecodeSession("{\"permissions\":[{\"enabled\":true},{\"name\":\"a\\nb\",\"enabled\":true}]}", Unnamed)
+                    && Unnamed.Permissions.size() == 1 && Unnamed.Permissions[0].Name == "a\nb" && Unnamed.Permissions[0].bEnabled,
+                    "DecodeSession drops permissions without a name and unescapes the others");
+    }
+
+    void BenchmarkPermissionDiff(int32_t Scale)
+    {
+        KidCore::FSession Old;
+        KidCore::FSession New;
+        KidCore::DecodeSession(MakeSessionJson(50, 3), Old);
+        KidCore::DecodeSession(MakeSessionJson(50, 5), New);
+
+        std::vector<KidCore::FPermissionChange> Changes;
+        Measure("DiffPermissions, 50 perms", 20000 * Scale, [&]()
+        {
+            Changes = KidCore::DiffPermissions(Old.Permissions, New.Permissions);
+            Sink = Sink + Changes.size();
+        });
+
+        // feature-N changes where exactly one of N % 3 and N % 5 is zero
+        size_t Expected = 0;
+        for (int32_t Index = 0; Index < 50; ++Index)
+        {
+            Expected += (Index % 3 == 0) != (Index % 5 == 0);
+        }
+        Expect(Changes.size() == Expected, "DiffPermissions finds every change");
+    }
+
+    void BenchmarkRequests(int32_t Scale)
+    {
+        // a /session/upgrade body, written the way FKidRequestWriter writes every request
+        const std::vector<std::string_view> Names = { "chat", "voice-chat", "user-generated-content", "text-chat-\"all\"" };
+        std::string Body;
+        Measure("FJsonWriter, /session/upgrade", 200000 * Scale, [&]()
+        {
+            Body.clear();
+            KidCore::FJsonWriter Writer(Body);
+            Writer.BeginObject();
+            Writer.Key("sessionId");
+            Writer.String("6d1f9a52-4c4e-4b0c-8a43-1f0e5b3c2d71");
+            Writer.Key("requestedPermissions");
+            Writer.BeginArray();
+            for (std::string_view Name : Names)
+            {
+                Writer.BeginObject();
+                Writer.Key("name");
+                Writer.String(Name);
+                Writer.EndObject();
+            }
+            Writer.EndArray();
+            Writer.EndObject();
+            Sink = Sink + Body.size();
+        });
+        Expect(Body == "{\"sessionId\":\"6d1f9a52-4c4e-4b0c-8a43-1f0e5b3c2d71\",\"requestedPermissions\":[{\"name\":\"chat\"},"
+                    "{\"name\":\"voice-chat\"},{\"name\":\"user-generated-content\"},{\"name\":\"text-chat-\\\"all\\\"\"}]}",
+                    "FJsonWriter separates members and elements and escapes strings");
+
+        Body.clear();
+        KidCore::FJsonWriter Writer(Body);
+        Writer.BeginObject();
+        Writer.Key("status");
+        Writer.String("PASS");
+        Writer.Key("age");
+        Writer.Integer(-2147483648LL);
+        Writer.Key("ok");
+        Writer.Bool(true);
+        Writer.EndObject();
+        Expect(Body == "{\"status\":\"PASS\",\"age\":-2147483648,\"ok\":true}", "FJsonWriter writes integers and booleans");
+
+        // engine strings are UTF-16 on Windows: a pair, an unpaired high surrogate, a quote and a tab
+        const char16_t Wide[] = { u'\u00e9', 0xD83D, 0xDE00, 0xD83D, u'"', u'\t' };
+        Body.clear();
+        KidCore::FJsonWriter WideWriter(Body);
+        WideWriter.String(Wide, sizeof(Wide) / sizeof(Wide[0]));
+        Expect(Body == "\"\xC3\xA9\xF0\x9F\x98\x80\xEF\xBF\xBD\\\"\\t\"", "FJsonWriter encodes UTF-16 as escaped UTF-8");
+    }
+
+    void BenchmarkPolicyBundle(int32_t Scale)
+    {
+        // every jurisdiction shares its permission names, as the games' features are the same everywhere
+        KidCore::FPolicyBundle Bundle;
+        std::vector<std::string> Jurisdictions;
+        for (int32_t Index = 0; Index < 250; ++Index)
+        {
+            char Jurisdiction[16];
+            std::snprintf(Jurisdiction, sizeof(Jurisdiction), "%c%c-%d", 'A' + Index % 26, 'A' + Index / 26, Index);
+            Jurisdictions.push_back(Jurisdiction);
+
+            Bundle.SetRequirements(Jurisdiction, Index % 10 != 0, Index % 7 == 0, KidCore::FAgeThresholds{ Index % 3, 13 + Index % 4, 18 + Index % 3 });
+            for (KidCore::EAgeBand Band : { KidCore::EAgeBand::BelowCivilAge, KidCore::EAgeBand::Adult })
+            {
+                std::vector<KidCore::FPermission> Permissions(20);
+                for (size_t Permission = 0; Permission < Permissions.size(); ++Permission)
+                {
+                    Permissions[Permission].Name = "feature-" + std::to_string(Permission);
+                    Permissions[Permission].bEnabled = Band == KidCore::EAgeBand::Adult || (Permission + Index) % 3 != 0;
+                    Permissions[Permission].ManagedBy = Permission % 2 == 0 ? "GUARDIAN" : "PLAYER";
+                }
+                Bundle.SetDefaults(Jurisdiction, Band, Band == KidCore::EAgeBand::Adult ? "LEGAL_ADULT" : "DIGITAL_YOUTH", std::move(Permissions));
+            }
+        }
+
+        std::vector<uint8_t> Blob;
+        Measure("FPolicyBundle::Encode, 250", 200 * Scale, [&]()
+        {
+            Bundle.Encode(Blob);
+            Sink = Sink + Blob.size();
+        });
+
+        KidCore::FPolicyBundle Decoded;
+        bool bDecoded = true;
+        Measure("FPolicyBundle::Decode, 250", 200 * Scale, [&]()
+        {
+            bDecoded &= Decoded.Decode(Blob.data(), Blob.size());
+            Sink = Sink + Decoded.Num();
+        });
+        std::printf("  %-28s %10zu bytes for %zu jurisdictions\n", "encoded bundle", Blob.size(), Bundle.Num());
+
+        int32_t NumPasses = 0;
+        Measure("PredictCheck", 10000 * Scale, [&]()
+        {
+            for (int32_t Age = 5; Age < 30; Age += 3)
+            {
+                const KidCore::FJurisdictionPolicy* Policy = Decoded.Find(Jurisdictions[static_cast<size_t>(Age) % Jurisdictions.size()]);
+                NumPasses += Policy && KidCore::PredictCheck(*Policy, Age).Defaults != nullptr;
+            }
+        });
+        Sink = Sink + NumPasses;
+
+        std::vector<uint8_t> Reencoded;
+        Decoded.Encode(Reencoded);
+        Expect(bDecoded && Decoded.GetRevision() == Bundle.GetRevision() && Reencoded == Blob, "FPolicyBundle round trips");
+
+        const KidCore::FJurisdictionPolicy* Policy = Decoded.Find(Jurisdictions[1]);
+        Expect(Policy && KidCore::PredictCheck(*Policy, 8).Status == KidCore::ECheckStatus::Challenge, "PredictCheck asks young players for consent");
+        Expect(Policy && KidCore::PredictCheck(*Policy, 40).Defaults && KidCore::PredictCheck(*Policy, 40).Defaults->AgeStatus == "LEGAL_ADULT",
+                    "PredictCheck gives adults the adult defaults");
+        Policy = Decoded.Find(Jurisdictions[7]);
+        Expect(Policy && KidCore::PredictCheck(*Policy, 40).Status == KidCore::ECheckStatus::Unknown, "PredictCheck leaves age assurance to the server");
+
+        // any truncated or damaged blob is rejected as a whole
+        bool bRejectsTruncated = true;
+        for (size_t Size = 0; Size < Blob.size(); Size += 1 + Size / 64)
+        {
+            KidCore::FPolicyBundle Truncated;
+            bRejectsTruncated &= !Truncated.Decode(Blob.data(), Size) && Truncated.Num() == 0;
+        }
+        Expect(bRejectsTruncated, "FPolicyBundle rejects truncated blobs");
+
+        std::vector<uint8_t> OtherVersion = Blob;
+        OtherVersion[4]++;
+        Expect(!Decoded.Decode(OtherVersion.data(), OtherVersion.size()) && Decoded.Num() == Bundle.Num(), "FPolicyBundle rejects other format versions");
+
+        const uint32_t Revision = Decoded.GetRevision();
+        Expect(Decoded.SetRequirements(Jurisdictions[1], true, false, KidCore::FAgeThresholds{ 0, 16, 18 }) && Decoded.GetRevision() == Revision + 1 &&
+                    !Decoded.Find(Jurisdictions[1])->GetDefaults(KidCore::EAgeBand::Adult).bKnown, "new thresholds forget the learned defaults");
+    }
+
+    void BenchmarkRetryPolicy(int32_t Scale)
+    {
+        const KidCore::FRetryPolicy Policy;
+        int32_t NumRetries = 0;
+        Measure("FRetryPolicy::Decide", 1000000 * Scale, [&]()
+        {
+            NumRetries += Policy.Decide(true, 429, "2.5", 2).Action == KidCore::ERetryAction::Retry;
+        });
+        Sink = Sink + NumRetries;
+
+        Expect(Policy.Decide(true, 429, "Wed, 21 Oct 2015 07:28:00 GMT", 1).DelaySeconds == Policy.DefaultRetryDelaySeconds, "Retry-After dates fall back to the default");
+        Expect(Policy.Decide(true, 429, "1", 0).Action == KidCore::ERetryAction::Fail, "no retries left");
+        Expect(!KidCore::CanTransition(KidCore::EFlowState::Completed, KidCore::EFlowState::CheckingAge), "finished flows stay finished");
+    }
+}
+
+int main(int ArgCount, char** Args)
+{
+    const int32_t Scale = ArgCount > 1 ? std::max(1, std::atoi(Args[1])) : 1;
+
+    std::printf("kID core microbenchmarks:\n");
+    BenchmarkAgePolicy(Scale);
+    BenchmarkSessionDecode(Scale);
+    BenchmarkPermissionDiff(Scale);
+    BenchmarkRequests(Scale);
+    BenchmarkPolicyBundle(Scale);
+    BenchmarkRetryPolicy(Scale);
+
+    if (NumFailures > 0)
+    {
+        std::printf("%d checks failed\n", NumFailures);
+        return 1;
+    }
+    return 0;
+}